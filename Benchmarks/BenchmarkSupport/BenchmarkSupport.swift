@@ -0,0 +1,16 @@
+import Foundation
+
+// Timing and statistics helpers shared by the benchmark executables
+
+// The value a fraction (0...1) of the way through sortedValues, by nearest rank; sortedValues mustn't be empty
+public func percentile(_ sortedValues: [Double], _ fraction: Double) -> Double {
+    sortedValues[min(sortedValues.count - 1, max(0, Int((fraction * Double(sortedValues.count)).rounded(.up)) - 1))]
+}
+
+public func seconds(since start: DispatchTime) -> Double {
+    Double(DispatchTime.now().uptimeNanoseconds - start.uptimeNanoseconds) / 1e9
+}
+
+public func milliseconds(since start: DispatchTime) -> Double {
+    seconds(since: start) * 1000
+}
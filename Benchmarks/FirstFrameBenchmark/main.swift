@@ -0,0 +1,358 @@
+import Foundation
+import BenchmarkSupport
+import PLYIO
+import SplatCompute
+import SplatGenerator
+import SplatMetrics
+
+// Measures time to first frame -- from opening a scene file to the first correctly sorted, rendered frame -- broken
+// into phases, across scene sizes and source formats:
+//   open        opening the file (PLYReader's ply.open)
+//   header      reading and parsing the header (ply.header)
+//   decode      reading the body into raw per-splat values
+//   activation  converting raw values into render-ready Splats (log scale, opacity logit, SH DC colour)
+//   growth      allocating the splat buffer and appending to it, as SplatRenderer does with its MetalBuffer
+//   sort        the first depth sort
+//   render      the first frame, with SplatReferenceRenderer standing in for the GPU
+//
+// Scenes are generated by SplatGenerator and written out before timing starts; the OS's file cache is likely warm.
+//
+// Usage: FirstFrameBenchmark [--splats N,N,...] [--formats ply,ascii,splat] [--strategy comparison|radix|...]
+//                            [--resolution WxH] [--repetitions N] [--output results.json]
+
+struct Options {
+    var splatCounts = [ 100_000, 1_000_000, 5_000_000 ]
+    var formats = SourceFormat.allCases
+    var strategy = DepthSorter.Strategy.comparison
+    var resolution = SIMD2<Int>(640, 360)
+    var repetitions = 3
+    var outputURL: URL?
+
+    init(_ arguments: [String]) {
+        var arguments = arguments[...]
+        while let argument = arguments.popFirst() {
+            guard let value = arguments.popFirst() else {
+                fatalError("Missing value for \(argument)")
+            }
+            let list = value.split(separator: ",").map(String.init)
+            switch argument {
+            case "--splats": splatCounts = list.compactMap { Int($0) }
+            case "--formats": formats = list.compactMap { SourceFormat(rawValue: $0) }
+            case "--strategy": strategy = DepthSorter.Strategy(rawValue: value) ?? strategy
+            case "--resolution":
+                let size = value.split(separator: "x").compactMap { Int($0) }
+                if size.count == 2 { resolution = SIMD2(size[0], size[1]) }
+            case "--repetitions": repetitions = max(1, Int(value) ?? repetitions)
+            case "--output": outputURL = URL(fileURLWithPath: value)
+            default: fatalError("Unknown argument \(argument)")
+            }
+        }
+    }
+}
+
+enum SourceFormat: String, CaseIterable {
+    case ply
+    case ascii
+    case splat
+
+    var fileExtension: String {
+        self == .splat ? "splat" : "ply"
+    }
+}
+
+struct Phases: Encodable {
+    var open: Double = 0
+    var header: Double = 0
+    var decode: Double = 0
+    var activation: Double = 0
+    var growth: Double = 0
+    var sort: Double = 0
+    var render: Double = 0
+
+    var total: Double {
+        open + header + decode + activation + growth + sort + render
+    }
+
+    static let names = [ "open", "header", "decode", "activation", "growth", "sort", "render" ]
+
+    var values: [Double] {
+        [ open, header, decode, activation, growth, sort, render ]
+    }
+
+    init() {}
+
+    // Phase by phase median
+    init(median runs: [Phases]) {
+        func median(_ value: (Phases) -> Double) -> Double {
+            runs.map(value).sorted()[runs.count / 2]
+        }
+        open = median(\.open)
+        header = median(\.header)
+        decode = median(\.decode)
+        activation = median(\.activation)
+        growth = median(\.growth)
+        sort = median(\.sort)
+        render = median(\.render)
+    }
+}
+
+// Raw values for a batch of splats, as a scene reader hands them over
+struct RawBatch {
+    var positions: [SIMD3<Float>] = []
+    var colors: [SIMD3<Float>] = []
+    var opacities: [Float] = []
+    var scales: [SIMD3<Float>] = []
+    var rotations: [SIMD4<Float>] = []
+    // True for 3DGS PLY values (SH DC, opacity logit, log scale); false for .splat's final values
+    var isTrained = true
+
+    var count: Int { positions.count }
+
+    mutating func removeAll() {
+        positions.removeAll(keepingCapacity: true)
+        colors.removeAll(keepingCapacity: true)
+        opacities.removeAll(keepingCapacity: true)
+        scales.removeAll(keepingCapacity: true)
+        rotations.removeAll(keepingCapacity: true)
+    }
+}
+
+// Activates raw batches and appends them to a buffer allocated up front from the point count, timing each
+final class SplatLoader {
+    static let batchSize = 65536
+
+    var phases = Phases()
+    private(set) var buffer: UnsafeMutableBufferPointer<Splat>?
+    private(set) var count = 0
+    private var batch = RawBatch()
+    private var activated: [Splat] = []
+
+    deinit {
+        buffer?.deallocate()
+    }
+
+    func start(pointCount: Int) {
+        let start = DispatchTime.now()
+        buffer = .allocate(capacity: max(pointCount, 1))
+        phases.growth += seconds(since: start)
+    }
+
+    func add(position: SIMD3<Float>, color: SIMD3<Float>, opacity: Float, scale: SIMD3<Float>, rotation: SIMD4<Float>, isTrained: Bool) {
+        batch.isTrained = isTrained
+        batch.positions.append(position)
+        batch.colors.append(color)
+        batch.opacities.append(opacity)
+        batch.scales.append(scale)
+        batch.rotations.append(rotation)
+        if batch.count == Self.batchSize {
+            flush()
+        }
+    }
+
+    func flush() {
+        guard batch.count > 0, let buffer else { return }
+
+        let activationStart = DispatchTime.now()
+        activated.removeAll(keepingCapacity: true)
+        for i in 0..<batch.count {
+            if batch.isTrained {
+                activated.append(Splat(position: batch.positions[i],
+                                       sphericalHarmonicsDC: batch.colors[i],
+                                       opacityLogit: batch.opacities[i],
+                                       logScale: batch.scales[i],
+                                       rotation: batch.rotations[i]))
+            } else {
+                let rotation = batch.rotations[i]
+                let length = (rotation * rotation).sum().squareRoot()
+                let color = batch.colors[i]
+                activated.append(Splat(position: batch.positions[i],
+                                       color: SIMD4<Float>(color.x, color.y, color.z, batch.opacities[i]),
+                                       scale: batch.scales[i],
+                                       rotation: length > 0 ? rotation / length : SIMD4<Float>(1, 0, 0, 0)))
+            }
+        }
+        phases.activation += seconds(since: activationStart)
+
+        let growthStart = DispatchTime.now()
+        let appendCount = min(activated.count, buffer.count - count)
+        _ = UnsafeMutableBufferPointer(rebasing: buffer[count ..< count + appendCount]).initialize(from: activated.prefix(appendCount))
+        count += appendCount
+        phases.growth += seconds(since: growthStart)
+
+        batch.removeAll()
+    }
+
+    var splats: UnsafeBufferPointer<Splat> {
+        UnsafeBufferPointer(rebasing: buffer![0..<count])
+    }
+}
+
+final class PLYLoader: PLYReaderDelegate {
+    let loader: SplatLoader
+    var indices: [Int] = []
+    var error: Swift.Error?
+
+    init(_ loader: SplatLoader) {
+        self.loader = loader
+    }
+
+    func didStartReading(withHeader header: PLYHeader) {
+        guard let vertexIndex = header.index(forElementNamed: "vertex") else { return }
+        let vertex = header.elements[vertexIndex]
+        indices = [ "x", "y", "z", "f_dc_0", "f_dc_1", "f_dc_2", "opacity", "scale_0", "scale_1", "scale_2", "rot_0", "rot_1", "rot_2", "rot_3" ]
+            .compactMap { vertex.index(forPropertyNamed: $0) }
+        loader.start(pointCount: Int(vertex.count))
+    }
+
+    func didRead(element: PLYElement, typeIndex: Int, withHeader elementHeader: PLYHeader.Element) {
+        guard elementHeader.name == "vertex", indices.count == 14 else { return }
+        func value(_ i: Int) -> Float {
+            if case .float32(let value) = element.properties[indices[i]] { return value }
+            return 0
+        }
+        loader.add(position: SIMD3(value(0), value(1), value(2)),
+                   color: SIMD3(value(3), value(4), value(5)),
+                   opacity: value(6),
+                   scale: SIMD3(value(7), value(8), value(9)),
+                   rotation: SIMD4(value(10), value(11), value(12), value(13)),
+                   isTrained: true)
+    }
+
+    func didFinishReading() {
+        loader.flush()
+    }
+
+    func didFailReading(withError error: Swift.Error?) {
+        self.error = error ?? PLYReader.Error.readError
+    }
+}
+
+func loadPLY(_ url: URL, into loader: SplatLoader) throws {
+    Metrics.shared.reset()
+    let plyLoader = PLYLoader(loader)
+    PLYReader(url).read(to: plyLoader)
+    if let error = plyLoader.error { throw error }
+
+    let snapshot = Metrics.shared.snapshot()
+    loader.phases.open = snapshot.histograms["ply.open"]?.sum ?? 0
+    loader.phases.header = snapshot.histograms["ply.header"]?.sum ?? 0
+    // Everything else in the read, including the delegate's own activation and growth, is decoding
+    let read = snapshot.histograms["ply.read"]?.sum ?? 0
+    loader.phases.decode = read - loader.phases.open - loader.phases.header - loader.phases.activation - loader.phases.growth
+}
+
+// .splat files have no header: 32 bytes per splat (see SplatSceneGenerator.dotSplatStride)
+func loadDotSplat(_ url: URL, into loader: SplatLoader) throws {
+    let openStart = DispatchTime.now()
+    let file = try FileHandle(forReadingFrom: url)
+    defer { try? file.close() }
+    let byteCount = Int(try file.seekToEnd())
+    try file.seek(toOffset: 0)
+    loader.phases.open = seconds(since: openStart)
+
+    let stride = SplatSceneGenerator.dotSplatStride
+    loader.start(pointCount: byteCount / stride)
+    let decodeStart = DispatchTime.now()
+    let chunkSize = SplatLoader.batchSize * stride
+    while let data = try file.read(upToCount: chunkSize), !data.isEmpty {
+        data.withUnsafeBytes { bytes in
+            for offset in Swift.stride(from: 0, to: bytes.count - stride + 1, by: stride) {
+                func float(_ i: Int) -> Float {
+                    Float(bitPattern: UInt32(littleEndian: bytes.loadUnaligned(fromByteOffset: offset + i * 4, as: UInt32.self)))
+                }
+                func byte(_ i: Int) -> Float {
+                    Float(bytes[offset + 24 + i])
+                }
+                loader.add(position: SIMD3(float(0), float(1), float(2)),
+                           color: SIMD3(byte(0), byte(1), byte(2)) / 255,
+                           opacity: byte(3) / 255,
+                           scale: SIMD3(float(3), float(4), float(5)),
+                           rotation: (SIMD4(byte(4), byte(5), byte(6), byte(7)) - 128) / 128,
+                           isTrained: false)
+            }
+        }
+    }
+    loader.flush()
+    loader.phases.decode = seconds(since: decodeStart) - loader.phases.activation - loader.phases.growth
+}
+
+func firstFrame(_ url: URL, format: SourceFormat, options: Options) throws -> Phases {
+    let loader = SplatLoader()
+    switch format {
+    case .ply, .ascii: try loadPLY(url, into: loader)
+    case .splat: try loadDotSplat(url, into: loader)
+    }
+    let splats = loader.splats
+
+    var bounds = Bounds.empty
+    splats.forEach { bounds.formUnion($0.position) }
+    let pose = CameraPath.orbit(around: bounds.center, radius: max(bounds.extent.x, bounds.extent.z) * 0.75, frameCount: 1).poses[0]
+    let size = SIMD2<Float>(Float(options.resolution.x), Float(options.resolution.y))
+    let projection = Float4x4.perspective(fovyRadians: .pi / 3, aspectRatio: size.x / size.y, nearZ: 0.1, farZ: 1000)
+    let viewpoint = Viewpoint((projection: projection, view: pose.view), screenSize: size)
+
+    let sortStart = DispatchTime.now()
+    var depths: [Float] = []
+    let positions = splats.map(\.position)
+    positions.withUnsafeBufferPointer { DepthSorter.depths(of: $0, from: pose, into: &depths) }
+    var order = Array(0..<UInt32(splats.count))
+    DepthSorter(strategy: options.strategy, backToFront: false).sort(&order, depths: depths)
+    loader.phases.sort = seconds(since: sortStart)
+
+    let (_, statistics) = SplatReferenceRenderer(frontToBack: true).render(splats: splats, order: order, viewpoint: viewpoint)
+    loader.phases.render = statistics.duration
+    return loader.phases
+}
+
+struct Result: Encodable {
+    var format: String
+    var splatCount: Int
+    var fileBytes: Int
+    // Medians over the repetitions, in seconds
+    var phases: Phases
+    var total: Double
+}
+
+struct Report: Encodable {
+    var benchmark = "FirstFrame"
+    var date = ISO8601DateFormatter().string(from: Date())
+    var platform = ProcessInfo.processInfo.operatingSystemVersionString
+    var processorCount = ProcessInfo.processInfo.activeProcessorCount
+    var sortStrategy: String
+    var resolution: [Int]
+    var results: [Result] = []
+}
+
+let options = Options(Array(CommandLine.arguments.dropFirst()))
+var report = Report(sortStrategy: options.strategy.rawValue, resolution: [ options.resolution.x, options.resolution.y ])
+let directory = FileManager.default.temporaryDirectory.appendingPathComponent("FirstFrameBenchmark-\(ProcessInfo.processInfo.processIdentifier)")
+try FileManager.default.createDirectory(at: directory, withIntermediateDirectories: true)
+
+print("\(ProcessInfo.processInfo.activeProcessorCount) cores, \(options.resolution.x)x\(options.resolution.y), \(options.strategy.rawValue) sort, times in seconds")
+print(([ "splats", "format" ] + Phases.names + [ "total" ]).joined(separator: "\t"))
+
+for splatCount in options.splatCounts {
+    let generator = SplatSceneGenerator(.init(splatCount: splatCount))
+    for format in options.formats {
+        let url = directory.appendingPathComponent("\(splatCount).\(format.rawValue).\(format.fileExtension)")
+        switch format {
+        case .ply: try generator.writePLY(to: url, format: .binaryLittleEndian)
+        case .ascii: try generator.writePLY(to: url, format: .ascii)
+        case .splat: try generator.writeDotSplat(to: url)
+        }
+        let fileBytes = (try FileManager.default.attributesOfItem(atPath: url.path)[.size] as? NSNumber)?.intValue ?? 0
+
+        let runs = try (0..<options.repetitions).map { _ in try firstFrame(url, format: format, options: options) }
+        let phases = Phases(median: runs)
+        report.results.append(Result(format: format.rawValue, splatCount: splatCount, fileBytes: fileBytes, phases: phases, total: phases.total))
+        print(([ "\(splatCount)", format.rawValue ] + (phases.values + [ phases.total ]).map { String(format: "%.4f", $0) }).joined(separator: "\t"))
+        try? FileManager.default.removeItem(at: url)
+    }
+}
+try? FileManager.default.removeItem(at: directory)
+
+if let outputURL = options.outputURL {
+    let encoder = JSONEncoder()
+    encoder.outputFormatting = [ .prettyPrinted, .sortedKeys ]
+    try encoder.encode(report).write(to: outputURL)
+}
@@ -0,0 +1,52 @@
+import Foundation
+import SplatGenerator
+import SplatKNN
+
+// Times KDTree against brute force for the all-points k-nearest-neighbour query used by floater removal and
+// density pruning, on clustered random points (splat scenes are far from uniform).
+//
+// Usage: KNNBenchmark [k] [maximum point count] [maximum brute force point count]
+
+let arguments = CommandLine.arguments.dropFirst().compactMap { Int($0) }
+let k = arguments.count > 0 ? arguments[0] : 16
+let maxPointCount = arguments.count > 1 ? arguments[1] : 4_000_000
+let maxBruteForcePointCount = arguments.count > 2 ? arguments[2] : 50_000
+
+func clusteredPoints(count: Int) -> [SIMD3<Float>] {
+    var generator = SplitMix64(seed: 1)
+    let centres = (0..<max(1, count / 1000)).map { _ in
+        SIMD3<Float>(generator.nextFloat(), generator.nextFloat(), generator.nextFloat()) * 100
+    }
+    return (0..<count).map { _ in
+        let centre = centres[Int(generator.next() % UInt64(centres.count))]
+        return centre + SIMD3<Float>(generator.nextGaussian(), generator.nextGaussian(), generator.nextGaussian())
+    }
+}
+
+func measure<T>(_ body: () -> T) -> (T, Double) {
+    let start = DispatchTime.now()
+    let result = body()
+    return (result, Double(DispatchTime.now().uptimeNanoseconds - start.uptimeNanoseconds) / 1e9)
+}
+
+print("k = \(k), \(ProcessInfo.processInfo.activeProcessorCount) cores")
+print("points\tbuild (s)\tquery (s)\tqueries/s\tbrute force (s)\tspeedup\tmatches")
+
+var pointCount = 10_000
+while pointCount <= maxPointCount {
+    let points = clusteredPoints(count: pointCount)
+    let (tree, buildTime) = measure { KDTree(points: points) }
+    let (result, queryTime) = measure { tree.neighborsOfEachPoint(count: k) }
+    let queriesPerSecond = Double(pointCount) / queryTime
+
+    var line = "\(pointCount)\t\(String(format: "%.4f", buildTime))\t\(String(format: "%.4f", queryTime))\t\(String(format: "%.0f", queriesPerSecond))"
+    if pointCount <= maxBruteForcePointCount {
+        let (expected, bruteForceTime) = measure { BruteForceKNN.neighborsOfEachPoint(points, count: k) }
+        let matches = expected.distancesSquared == result.distancesSquared
+        line += "\t\(String(format: "%.4f", bruteForceTime))\t\(String(format: "%.1f", bruteForceTime / (buildTime + queryTime)))x\t\(matches)"
+    } else {
+        line += "\t-\t-\t-"
+    }
+    print(line)
+    pointCount *= 4
+}
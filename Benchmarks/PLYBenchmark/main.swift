@@ -0,0 +1,231 @@
+import Foundation
+import PLYIO
+import SplatGenerator
+#if canImport(Darwin)
+import Darwin
+#elseif canImport(Glibc)
+import Glibc
+#endif
+
+// Measures PLYReader and PLYWriter throughput on synthetic files, for every combination of format (ASCII, binary
+// little- and big-endian) and schema (primitive-only vertices, or list-heavy faces), and reports the results as
+// JSON so they can be tracked across versions.
+//
+// Usage: PLYBenchmark [--elements N] [--repetitions N] [--schema primitive|list] [--format ascii|binary_little_endian|binary_big_endian] [--output path]
+
+struct Options {
+    var elementCount = 1_000_000
+    var repetitions = 3
+    var schemas = Schema.allCases
+    var formats: [PLYHeader.Format] = [ .ascii, .binaryLittleEndian, .binaryBigEndian ]
+    var outputURL: URL?
+
+    init(_ arguments: [String]) {
+        var arguments = arguments[...]
+        while let argument = arguments.popFirst() {
+            guard let value = arguments.popFirst() else {
+                fatalError("Missing value for \(argument)")
+            }
+            switch argument {
+            case "--elements": elementCount = Int(value) ?? elementCount
+            case "--repetitions": repetitions = max(1, Int(value) ?? repetitions)
+            case "--schema": schemas = [ Schema(rawValue: value) ].compactMap { $0 }
+            case "--format": formats = [ PLYHeader.Format(rawValue: value) ].compactMap { $0 }
+            case "--output": outputURL = URL(fileURLWithPath: value)
+            default: fatalError("Unknown argument \(argument)")
+            }
+        }
+    }
+}
+
+enum Schema: String, CaseIterable {
+    // A splat-like vertex: floats and a few colour bytes
+    case primitive
+    // Mesh-like: a few vertices, then many faces, each with an index list and a texture coordinate list
+    case list
+
+    func header(format: PLYHeader.Format, elementCount: Int) -> PLYHeader {
+        switch self {
+        case .primitive:
+            let floats = [ "x", "y", "z", "nx", "ny", "nz", "opacity", "scale_0", "scale_1", "scale_2", "rot_0", "rot_1", "rot_2", "rot_3" ]
+            let properties = floats.map { PLYHeader.Property(name: $0, type: .primitive(.float32)) } +
+                [ "red", "green", "blue" ].map { PLYHeader.Property(name: $0, type: .primitive(.uint8)) }
+            return PLYHeader(format: format, version: "1.0", elements: [
+                PLYHeader.Element(name: "vertex", count: UInt32(elementCount), properties: properties),
+            ])
+        case .list:
+            let vertexCount = max(1, elementCount / 10)
+            return PLYHeader(format: format, version: "1.0", elements: [
+                PLYHeader.Element(name: "vertex", count: UInt32(vertexCount), properties: [ "x", "y", "z" ].map {
+                    PLYHeader.Property(name: $0, type: .primitive(.float32))
+                }),
+                PLYHeader.Element(name: "face", count: UInt32(elementCount - vertexCount), properties: [
+                    PLYHeader.Property(name: "vertex_indices", type: .list(countType: .uint8, valueType: .int32)),
+                    PLYHeader.Property(name: "texcoord", type: .list(countType: .uint8, valueType: .float32)),
+                    PLYHeader.Property(name: "flags", type: .primitive(.int32)),
+                ]),
+            ])
+        }
+    }
+
+    func element(_ index: Int, typeIndex: Int, generator: inout SplitMix64) -> PLYElement {
+        switch (self, typeIndex) {
+        case (.primitive, _):
+            return PLYElement(properties: (0..<14).map { _ in .float32(generator.nextFloat()) } +
+                              (0..<3).map { _ in .uint8(UInt8(truncatingIfNeeded: generator.next())) })
+        case (.list, 0):
+            return PLYElement(properties: (0..<3).map { _ in .float32(generator.nextFloat()) })
+        case (.list, _):
+            let cornerCount = 3 + Int(generator.next() % 4)
+            return PLYElement(properties: [
+                .listInt32((0..<cornerCount).map { _ in Int32(truncatingIfNeeded: generator.next() % 100_000) }),
+                .listFloat32((0..<(cornerCount * 2)).map { _ in generator.nextFloat() }),
+                .int32(Int32(index)),
+            ])
+        }
+    }
+}
+
+struct Result: Encodable {
+    var operation: String
+    var schema: String
+    var format: String
+    var elementCount: Int
+    var fileBytes: Int
+    // Median over the repetitions
+    var seconds: Double
+    var megabytesPerSecond: Double
+    var elementsPerSecond: Double
+    // Peak resident memory during the operation where the platform can reset the high-water mark (Linux),
+    // otherwise the process's peak so far
+    var peakMemoryBytes: Int
+}
+
+struct Report: Encodable {
+    var benchmark = "PLYIO"
+    var date = ISO8601DateFormatter().string(from: Date())
+    var platform = ProcessInfo.processInfo.operatingSystemVersionString
+    var processorCount = ProcessInfo.processInfo.activeProcessorCount
+    var repetitions: Int
+    var results: [Result] = []
+}
+
+final class ElementCounter: PLYReaderDelegate {
+    var elementCount = 0
+    var failed = false
+
+    func didStartReading(withHeader header: PLYHeader) {}
+
+    func didRead(element: PLYElement, typeIndex: Int, withHeader elementHeader: PLYHeader.Element) {
+        elementCount += 1
+    }
+
+    func didFinishReading() {}
+
+    func didFailReading(withError error: Swift.Error?) {
+        failed = true
+    }
+}
+
+enum PeakMemory {
+    // On Linux, writing 5 to clear_refs resets the VmHWM high-water mark
+    static func reset() {
+        #if os(Linux)
+        try? "5".write(toFile: "/proc/self/clear_refs", atomically: false, encoding: .utf8)
+        #endif
+    }
+
+    static var bytes: Int {
+        #if os(Linux)
+        if let status = try? String(contentsOfFile: "/proc/self/status", encoding: .utf8),
+           let line = status.split(separator: "\n").first(where: { $0.hasPrefix("VmHWM:") }),
+           let kilobytes = Int(line.split(whereSeparator: \.isWhitespace).dropFirst().first ?? "") {
+            return kilobytes * 1024
+        }
+        #endif
+        var usage = rusage()
+        getrusage(RUSAGE_SELF, &usage)
+        #if canImport(Darwin)
+        return Int(usage.ru_maxrss)
+        #else
+        return Int(usage.ru_maxrss) * 1024
+        #endif
+    }
+}
+
+func measure(repetitions: Int, _ body: () throws -> Void) rethrows -> (seconds: Double, peakMemoryBytes: Int) {
+    var durations: [Double] = []
+    var peakMemoryBytes = 0
+    for _ in 0..<repetitions {
+        PeakMemory.reset()
+        let start = DispatchTime.now()
+        try body()
+        durations.append(Double(DispatchTime.now().uptimeNanoseconds - start.uptimeNanoseconds) / 1e9)
+        peakMemoryBytes = max(peakMemoryBytes, PeakMemory.bytes)
+    }
+    return (durations.sorted()[durations.count / 2], peakMemoryBytes)
+}
+
+func write(schema: Schema, format: PLYHeader.Format, elementCount: Int, to url: URL) throws {
+    let header = schema.header(format: format, elementCount: elementCount)
+    var generator = SplitMix64(seed: 1)
+    let writer = try PLYWriter(url)
+    try writer.write(header)
+    var index = 0
+    for (typeIndex, element) in header.elements.enumerated() {
+        for _ in 0..<element.count {
+            try writer.write(schema.element(index, typeIndex: typeIndex, generator: &generator))
+            index += 1
+        }
+    }
+    try writer.close()
+}
+
+let options = Options(Array(CommandLine.arguments.dropFirst()))
+var report = Report(repetitions: options.repetitions)
+let directory = FileManager.default.temporaryDirectory.appendingPathComponent("PLYBenchmark-\(ProcessInfo.processInfo.processIdentifier)")
+try FileManager.default.createDirectory(at: directory, withIntermediateDirectories: true)
+defer { try? FileManager.default.removeItem(at: directory) }
+
+for schema in options.schemas {
+    for format in options.formats {
+        let url = directory.appendingPathComponent("\(schema.rawValue)-\(format.rawValue).ply")
+
+        // Writing includes generating the elements, which is a fixed cost across versions
+        let writeMeasurement = try measure(repetitions: options.repetitions) {
+            try write(schema: schema, format: format, elementCount: options.elementCount, to: url)
+        }
+        let fileBytes = (try FileManager.default.attributesOfItem(atPath: url.path)[.size] as? NSNumber)?.intValue ?? 0
+
+        var elementsRead = 0
+        let readMeasurement = measure(repetitions: options.repetitions) {
+            let counter = ElementCounter()
+            PLYReader(url).read(to: counter)
+            precondition(!counter.failed, "Failed to read \(url.lastPathComponent)")
+            elementsRead = counter.elementCount
+        }
+        precondition(elementsRead == options.elementCount)
+
+        for (operation, measurement) in [ ("write", writeMeasurement), ("read", readMeasurement) ] {
+            report.results.append(Result(operation: operation,
+                                         schema: schema.rawValue,
+                                         format: format.rawValue,
+                                         elementCount: options.elementCount,
+                                         fileBytes: fileBytes,
+                                         seconds: measurement.seconds,
+                                         megabytesPerSecond: Double(fileBytes) / measurement.seconds / 1e6,
+                                         elementsPerSecond: Double(options.elementCount) / measurement.seconds,
+                                         peakMemoryBytes: measurement.peakMemoryBytes))
+        }
+        try? FileManager.default.removeItem(at: url)
+    }
+}
+
+let encoder = JSONEncoder()
+encoder.outputFormatting = [ .prettyPrinted, .sortedKeys ]
+let json = try encoder.encode(report)
+if let outputURL = options.outputURL {
+    try json.write(to: outputURL)
+} else {
+    print(String(decoding: json, as: UTF8.self))
+}
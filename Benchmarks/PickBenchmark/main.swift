@@ -0,0 +1,114 @@
+import Foundation
+import BenchmarkSupport
+import SplatCompute
+import SplatGenerator
+
+// Times SplatSpatialIndex: building it, and picking (the splat under a pixel, as a tap or hover would) along rays
+// through random pixels from viewpoints orbiting generated scenes, reporting per-pick latency percentiles against
+// the target of well under a millisecond at 5M splats. Headless and portable, so it runs on Linux.
+//
+// Usage: PickBenchmark [--splats N,N,...] [--views N] [--picks N] [--output results.json]
+
+struct Options {
+    var splatCounts = [ 100_000, 1_000_000, 5_000_000 ]
+    var viewCount = 8
+    // Per view
+    var pickCount = 500
+    var outputURL: URL?
+
+    init(_ arguments: [String]) {
+        var arguments = arguments[...]
+        while let argument = arguments.popFirst() {
+            guard let value = arguments.popFirst() else {
+                fatalError("Missing value for \(argument)")
+            }
+            switch argument {
+            case "--splats": splatCounts = value.split(separator: ",").compactMap { Int($0) }
+            case "--views": viewCount = max(1, Int(value) ?? viewCount)
+            case "--picks": pickCount = max(1, Int(value) ?? pickCount)
+            case "--output": outputURL = URL(fileURLWithPath: value)
+            default: fatalError("Unknown argument \(argument)")
+            }
+        }
+    }
+}
+
+struct Result: Encodable {
+    var splatCount: Int
+    // In seconds
+    var buildTime: Double
+    var pickCount: Int
+    // Fraction of picks which found a splat
+    var hitFraction: Double
+    // Pick latency, in milliseconds
+    var p50: Double
+    var p90: Double
+    var p99: Double
+    var max: Double
+}
+
+struct Report: Encodable {
+    var benchmark = "Pick"
+    var date = ISO8601DateFormatter().string(from: Date())
+    var platform = ProcessInfo.processInfo.operatingSystemVersionString
+    var processorCount = ProcessInfo.processInfo.activeProcessorCount
+    var results: [Result] = []
+}
+
+let options = Options(Array(CommandLine.arguments.dropFirst()))
+var report = Report()
+let screenSize = SIMD2<Float>(1920, 1080)
+let projection = Float4x4.perspective(fovyRadians: .pi / 3, aspectRatio: screenSize.x / screenSize.y, nearZ: 0.1, farZ: 1000)
+
+print("\(options.viewCount) views, \(options.pickCount) picks each")
+print("splats\tbuild (s)\thits\tp50 (ms)\tp90 (ms)\tp99 (ms)\tmax (ms)")
+
+for splatCount in options.splatCounts {
+    let splats = SplatSceneGenerator(.init(splatCount: splatCount)).splats()
+    let buildStart = DispatchTime.now()
+    let index = SplatSpatialIndex(splats: splats)
+    let buildTime = seconds(since: buildStart)
+
+    var bounds = Bounds.empty
+    splats.forEach { bounds.formUnion($0.position) }
+    let path = CameraPath.orbit(around: bounds.center,
+                                radius: max(bounds.extent.x, bounds.extent.z) * 0.75,
+                                height: bounds.extent.y / 4,
+                                frameCount: options.viewCount)
+    var random = SystemRandomNumberGenerator()
+    var durations: [Double] = []
+    var hits = 0
+    splats.withUnsafeBufferPointer { splats in
+        for pose in path.poses {
+            let viewpoint = Viewpoint((projection: projection, view: pose.view), screenSize: screenSize)
+            for _ in 0..<options.pickCount {
+                let pixel = SIMD2<Float>(Float.random(in: 0..<screenSize.x, using: &random),
+                                         Float.random(in: 0..<screenSize.y, using: &random))
+                let start = DispatchTime.now()
+                let hit = index.pick(ray: SplatSpatialIndex.Ray(viewpoint: viewpoint, pixel: pixel), splats: splats)
+                durations.append(seconds(since: start) * 1e3)
+                hits += hit == nil ? 0 : 1
+            }
+        }
+    }
+
+    durations.sort()
+    let result = Result(splatCount: splatCount,
+                        buildTime: buildTime,
+                        pickCount: durations.count,
+                        hitFraction: Double(hits) / Double(durations.count),
+                        p50: percentile(durations, 0.5),
+                        p90: percentile(durations, 0.9),
+                        p99: percentile(durations, 0.99),
+                        max: durations.last ?? 0)
+    report.results.append(result)
+    print([ "\(splatCount)", String(format: "%.3f", result.buildTime), String(format: "%.2f", result.hitFraction),
+            String(format: "%.4f", result.p50), String(format: "%.4f", result.p90),
+            String(format: "%.4f", result.p99), String(format: "%.4f", result.max) ].joined(separator: "\t"))
+}
+
+if let outputURL = options.outputURL {
+    let encoder = JSONEncoder()
+    encoder.outputFormatting = [ .prettyPrinted, .sortedKeys ]
+    try encoder.encode(report).write(to: outputURL)
+}
@@ -0,0 +1,205 @@
+import Foundation
+import BenchmarkSupport
+import PLYIO
+import SplatCompute
+import SplatGenerator
+
+// Times each DepthSorter strategy over camera paths through scenes of increasing size, reporting per-frame latency
+// percentiles and how far each result is from an exact sort. Headless and portable, so it runs on Linux.
+//
+// Strategies which reuse the previous frame's order (incremental, bucketed) carry it from frame to frame, as the
+// renderer would; every strategy starts from the identity order.
+//
+// With --table N, a DirectionalSortTable of N directions is built for each scene, and an extra "table" row starts
+// each frame's incremental sort from its nearest order where that's better than the previous frame's.
+//
+// Usage: SortBenchmark [--splats N,N,...] [--scene file.ply] [--path orbit|walk|pan|recorded.json] [--frames N]
+//                      [--strategies comparison,radix,...] [--table N] [--output results.json]
+
+struct Options {
+    var splatCounts = [ 100_000, 1_000_000, 5_000_000, 20_000_000 ]
+    var sceneURL: URL?
+    var paths = [ "orbit", "walk", "pan" ]
+    var frameCount = 120
+    var strategies = DepthSorter.Strategy.allCases
+    var tableDirectionCount = 0
+    var outputURL: URL?
+
+    init(_ arguments: [String]) {
+        var arguments = arguments[...]
+        while let argument = arguments.popFirst() {
+            guard let value = arguments.popFirst() else {
+                fatalError("Missing value for \(argument)")
+            }
+            let list = value.split(separator: ",").map(String.init)
+            switch argument {
+            case "--splats": splatCounts = list.compactMap { Int($0) }
+            case "--scene": sceneURL = URL(fileURLWithPath: value)
+            case "--path": paths = list
+            case "--frames": frameCount = max(1, Int(value) ?? frameCount)
+            case "--strategies": strategies = list.compactMap { DepthSorter.Strategy(rawValue: $0) }
+            case "--table": tableDirectionCount = max(0, Int(value) ?? 0)
+            case "--output": outputURL = URL(fileURLWithPath: value)
+            default: fatalError("Unknown argument \(argument)")
+            }
+        }
+    }
+}
+
+// Reads just the vertex positions of a PLY file
+final class PositionReader: PLYReaderDelegate {
+    var positions: [SIMD3<Float>] = []
+    var propertyIndices: [Int]?
+    var error: Swift.Error?
+
+    func didStartReading(withHeader header: PLYHeader) {
+        guard let vertexIndex = header.index(forElementNamed: "vertex") else { return }
+        let vertex = header.elements[vertexIndex]
+        propertyIndices = [ "x", "y", "z" ].compactMap { vertex.index(forPropertyNamed: $0) }
+        positions.reserveCapacity(Int(vertex.count))
+    }
+
+    func didRead(element: PLYElement, typeIndex: Int, withHeader elementHeader: PLYHeader.Element) {
+        guard elementHeader.name == "vertex", let propertyIndices, propertyIndices.count == 3 else { return }
+        func float(_ property: PLYElement.Property) -> Float {
+            switch property {
+            case .float32(let value): value
+            case .float64(let value): Float(value)
+            default: 0
+            }
+        }
+        positions.append(SIMD3<Float>(float(element.properties[propertyIndices[0]]),
+                                      float(element.properties[propertyIndices[1]]),
+                                      float(element.properties[propertyIndices[2]])))
+    }
+
+    func didFinishReading() {}
+
+    func didFailReading(withError error: Swift.Error?) {
+        self.error = error
+    }
+}
+
+func cameraPath(named name: String, positions: [SIMD3<Float>], frameCount: Int) throws -> CameraPath {
+    var bounds = Bounds.empty
+    positions.forEach { bounds.formUnion($0) }
+    let radius = max(bounds.extent.x, bounds.extent.z)
+    switch name {
+    case "orbit": return .orbit(around: bounds.center, radius: radius, height: bounds.extent.y / 4, frameCount: frameCount)
+    case "walk": return .walkThrough(bounds, frameCount: frameCount)
+    case "pan": return .fastPan(from: bounds.center, frameCount: frameCount)
+    default: return try CameraPath(jsonData: Data(contentsOf: URL(fileURLWithPath: name)))
+    }
+}
+
+struct Result: Encodable {
+    var strategy: String
+    var splatCount: Int
+    var path: String
+    var frameCount: Int
+    // Sort latency per frame, in milliseconds
+    var p50: Double
+    var p90: Double
+    var p99: Double
+    var max: Double
+    var meanInversionFraction: Double
+    var maxInversionFraction: Double
+    var maxDepthError: Float
+}
+
+struct Report: Encodable {
+    var benchmark = "Sort"
+    var date = ISO8601DateFormatter().string(from: Date())
+    var platform = ProcessInfo.processInfo.operatingSystemVersionString
+    var processorCount = ProcessInfo.processInfo.activeProcessorCount
+    var results: [Result] = []
+}
+
+let options = Options(Array(CommandLine.arguments.dropFirst()))
+var report = Report()
+
+var scenes: [(name: String, positions: () throws -> [SIMD3<Float>])] = options.splatCounts.map { count in
+    (name: "\(count) synthetic", positions: { SplatSceneGenerator(.init(splatCount: count)).positions() })
+}
+if let sceneURL = options.sceneURL {
+    scenes = [ (name: sceneURL.lastPathComponent, positions: {
+        let reader = PositionReader()
+        PLYReader(sceneURL).read(to: reader)
+        if let error = reader.error { throw error }
+        return reader.positions
+    }) ]
+}
+
+print("\(ProcessInfo.processInfo.activeProcessorCount) cores, \(options.frameCount) frames per path")
+print("scene\tpath\tstrategy\tp50 (ms)\tp90 (ms)\tp99 (ms)\tmax (ms)\tinversions (mean)\tinversions (max)\tmax depth error")
+
+for scene in scenes {
+    let positions = try scene.positions()
+    var table: DirectionalSortTable?
+    if options.tableDirectionCount > 0 {
+        let start = DispatchTime.now()
+        table = DirectionalSortTable(positions: positions, directionCount: options.tableDirectionCount)
+        print("Built a \(options.tableDirectionCount) direction sort table (\(table!.memorySize >> 20) MB) in " +
+              String(format: "%.2f s", Double(DispatchTime.now().uptimeNanoseconds - start.uptimeNanoseconds) / 1e9))
+    }
+
+    for pathName in options.paths {
+        let path = try cameraPath(named: pathName, positions: positions, frameCount: options.frameCount)
+        var names = options.strategies.map(\.rawValue)
+        var sorters = options.strategies.map { DepthSorter(strategy: $0) }
+        if table != nil {
+            names.append("table")
+            sorters.append(DepthSorter(strategy: .incremental))
+        }
+        var orders = Array(repeating: Array(0..<UInt32(positions.count)), count: sorters.count)
+        var durations = Array(repeating: [Double](), count: sorters.count)
+        var accuracies = Array(repeating: [DepthSorter.Accuracy](), count: sorters.count)
+        var depths: [Float] = []
+        var previousForward: SIMD3<Float>?
+
+        for pose in path.poses {
+            positions.withUnsafeBufferPointer { DepthSorter.depths(of: $0, from: pose, into: &depths) }
+            for (i, sorter) in sorters.enumerated() {
+                let start = DispatchTime.now()
+                if let table, names[i] == "table" {
+                    depths.withUnsafeBufferPointer {
+                        table.sort(&orders[i], along: pose.forward, previousForward: previousForward, depths: $0, sorter: sorter)
+                    }
+                } else {
+                    sorter.sort(&orders[i], depths: depths)
+                }
+                durations[i].append(Double(DispatchTime.now().uptimeNanoseconds - start.uptimeNanoseconds) / 1e6)
+                accuracies[i].append(DepthSorter.accuracy(of: orders[i], depths: depths))
+            }
+            previousForward = pose.forward
+        }
+
+        for i in sorters.indices {
+            let sortedDurations = durations[i].sorted()
+            let inversionFractions = accuracies[i].map(\.inversionFraction)
+            let result = Result(strategy: names[i],
+                                splatCount: positions.count,
+                                path: pathName,
+                                frameCount: path.poses.count,
+                                p50: percentile(sortedDurations, 0.5),
+                                p90: percentile(sortedDurations, 0.9),
+                                p99: percentile(sortedDurations, 0.99),
+                                max: sortedDurations.last ?? 0,
+                                meanInversionFraction: inversionFractions.reduce(0, +) / Double(max(1, inversionFractions.count)),
+                                maxInversionFraction: inversionFractions.max() ?? 0,
+                                maxDepthError: accuracies[i].map(\.maxDepthError).max() ?? 0)
+            report.results.append(result)
+            print([ scene.name, pathName, result.strategy,
+                    String(format: "%.2f", result.p50), String(format: "%.2f", result.p90),
+                    String(format: "%.2f", result.p99), String(format: "%.2f", result.max),
+                    String(format: "%.5f", result.meanInversionFraction), String(format: "%.5f", result.maxInversionFraction),
+                    String(format: "%.4f", result.maxDepthError) ].joined(separator: "\t"))
+        }
+    }
+}
+
+if let outputURL = options.outputURL {
+    let encoder = JSONEncoder()
+    encoder.outputFormatting = [ .prettyPrinted, .sortedKeys ]
+    try encoder.encode(report).write(to: outputURL)
+}
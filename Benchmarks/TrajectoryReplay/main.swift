@@ -0,0 +1,253 @@
+import Foundation
+import BenchmarkSupport
+import SplatCompute
+import SplatGenerator
+
+// Records and replays camera trajectories headlessly, so sort performance and popping can be compared between builds
+// and machines on exactly the motion the sample app recorded (with CAMERA_TRAJECTORY_RECORD), or on a synthesized one.
+//
+// Replay draws one recorded frame per step, whatever the timing, against a generated scene (the same for a given
+// size and seed). Each frame is depth sorted with the chosen strategy, carrying the order from frame to frame as the
+// renderer does. With --render, each frame is also drawn by SplatReferenceRenderer, both in that order and in an
+// exact order; the mean difference between the two is the popping the strategy's approximations cause, and the
+// checksum of the rendered image lets runs be compared frame by frame.
+//
+// With --blend weighted, frames aren't sorted at all, but rendered with SplatReferenceRenderer's weighted blended
+// transparency; the difference from the exactly sorted image is then that mode's error, for judging whether a scene
+// can do without sorting.
+//
+// With --occlusion-lag N, each frame is occlusion culled as SplatRenderer's occlusionCulling does, but the splats drawn
+// are those visible N frames earlier, as when the order lags the camera by a sort. The splats visible now but left
+// out are reported as the fraction missing; with --render, they're also missing from the image compared.
+//
+// Usage: TrajectoryReplay record --path orbit|walk|pan [--frames N] [--splats N] --output recording.trajectory
+//        TrajectoryReplay replay recording.trajectory [--splats N] [--seed N] [--strategy comparison|radix|...]
+//                                [--render WxH] [--blend sorted|weighted] [--occlusion-lag N] [--output results.json]
+
+struct Options {
+    var command = ""
+    var trajectoryURL: URL?
+    var path = "orbit"
+    var frameCount = 300
+    var splatCount = 200_000
+    var seed: UInt64 = 1
+    var strategy = DepthSorter.Strategy.incremental
+    var renderSize: SIMD2<Int>?
+    var weightedBlending = false
+    var occlusionLag: Int?
+    var outputURL: URL?
+
+    init(_ arguments: [String]) {
+        var arguments = arguments[...]
+        command = arguments.popFirst() ?? ""
+        if command == "replay", let path = arguments.popFirst() {
+            trajectoryURL = URL(fileURLWithPath: path)
+        }
+        while let argument = arguments.popFirst() {
+            guard let value = arguments.popFirst() else {
+                fatalError("Missing value for \(argument)")
+            }
+            switch argument {
+            case "--path": path = value
+            case "--frames": frameCount = max(1, Int(value) ?? frameCount)
+            case "--splats": splatCount = max(1, Int(value) ?? splatCount)
+            case "--seed": seed = UInt64(value) ?? seed
+            case "--strategy": strategy = DepthSorter.Strategy(rawValue: value) ?? strategy
+            case "--render":
+                let size = value.split(separator: "x").compactMap { Int($0) }
+                if size.count == 2 { renderSize = SIMD2(size[0], size[1]) }
+            case "--blend": weightedBlending = value == "weighted"
+            case "--occlusion-lag": occlusionLag = max(0, Int(value) ?? 0)
+            case "--output": outputURL = URL(fileURLWithPath: value)
+            default: fatalError("Unknown argument \(argument)")
+            }
+        }
+    }
+}
+
+struct FrameResult: Encodable {
+    var frame: Int
+    var timestamp: Double
+    var sortMilliseconds: Double
+    // nil with weighted blending, which doesn't sort
+    var inversionFraction: Double?
+    var renderMilliseconds: Double?
+    // Fragment shader invocations, i.e. the fill rate
+    var fragments: Int?
+    // Mean absolute difference per channel from the exactly sorted image, 0...1
+    var popping: Double?
+    var peakSignalToNoiseRatio: Double?
+    var imageChecksum: String?
+    // With --occlusion-lag: the fraction of the splats left out of the draw, and of those visible this frame, the
+    // fraction left out
+    var culledFraction: Double?
+    var missingFraction: Double?
+}
+
+struct Report: Encodable {
+    var benchmark = "TrajectoryReplay"
+    var date = ISO8601DateFormatter().string(from: Date())
+    var platform = ProcessInfo.processInfo.operatingSystemVersionString
+    var processorCount = ProcessInfo.processInfo.activeProcessorCount
+    var trajectory: String
+    var splatCount: Int
+    var seed: UInt64
+    var strategy: String
+    var blending: String
+    var occlusionLag: Int?
+    var frames: [FrameResult] = []
+}
+
+// FNV-1a over the image quantized to 8 bits per channel, as it would be displayed
+func checksum(_ image: SplatReferenceRenderer.Image) -> String {
+    var hash: UInt64 = 0xcbf29ce484222325
+    for pixel in image.pixels {
+        for i in 0..<4 {
+            hash = (hash ^ UInt64(min(max(pixel[i] * 255, 0), 255).rounded())) &* 0x100000001b3
+        }
+    }
+    return String(hash, radix: 16)
+}
+
+func record(_ options: Options) throws {
+    guard let outputURL = options.outputURL else {
+        fatalError("record needs --output")
+    }
+    var bounds = Bounds.empty
+    SplatSceneGenerator(.init(splatCount: options.splatCount, seed: options.seed)).positions().forEach { bounds.formUnion($0) }
+    let radius = max(bounds.extent.x, bounds.extent.z)
+    let path: CameraPath = switch options.path {
+    case "walk": .walkThrough(bounds, frameCount: options.frameCount)
+    case "pan": .fastPan(from: bounds.center, frameCount: options.frameCount)
+    default: .orbit(around: bounds.center, radius: radius, height: bounds.extent.y / 4, frameCount: options.frameCount)
+    }
+    let projection = Float4x4.perspective(fovyRadians: 65 * .pi / 180, aspectRatio: 16 / 9, nearZ: 0.1, farZ: 1000)
+    try CameraTrajectory(path, projection: projection).write(to: outputURL)
+    print("Recorded \(options.frameCount) frames of \(options.path) to \(outputURL.path)")
+}
+
+func replay(_ options: Options) throws {
+    guard let trajectoryURL = options.trajectoryURL else {
+        fatalError("replay needs a trajectory file")
+    }
+    let trajectory = try CameraTrajectory(contentsOf: trajectoryURL)
+    let splats = SplatSceneGenerator(.init(splatCount: options.splatCount, seed: options.seed)).splats()
+    let positions = splats.map(\.position)
+    var report = Report(trajectory: trajectoryURL.lastPathComponent,
+                        splatCount: splats.count,
+                        seed: options.seed,
+                        strategy: options.strategy.rawValue,
+                        blending: options.weightedBlending ? "weighted" : "sorted",
+                        occlusionLag: options.occlusionLag)
+
+    let sorter = DepthSorter(strategy: options.strategy, backToFront: false)
+    let exactSorter = DepthSorter(strategy: .radix, backToFront: false)
+    let renderer = SplatReferenceRenderer(frontToBack: true, blending: options.weightedBlending ? .weighted(.init()) : .sorted)
+    let exactRenderer = SplatReferenceRenderer(frontToBack: true)
+    var order = Array(0..<UInt32(splats.count))
+    var depths: [Float] = []
+    let chunks = options.occlusionLag == nil ? nil : SplatChunks(splats: splats)
+    let culler = OcclusionCuller()
+    let cullScreenSize = options.renderSize.map { SIMD2<Float>(Float($0.x), Float($0.y)) } ?? SIMD2<Float>(1920, 1080)
+    // The chunks visible in each of the last occlusionLag + 1 frames, oldest first
+    var visibleChunkHistory: [[Bool]] = []
+
+    print("frame\ttimestamp\tsort (ms)\tinversions\trender (ms)\tpopping\tPSNR (dB)\tchecksum\tculled\tmissing")
+    for (index, frame) in trajectory.frames.enumerated() {
+        guard let camera = frame.cameras.first else { continue }
+        positions.withUnsafeBufferPointer { DepthSorter.depths(of: $0, from: CameraPose(view: camera.view), into: &depths) }
+        var result = FrameResult(frame: index, timestamp: frame.timestamp, sortMilliseconds: 0)
+        if !options.weightedBlending {
+            let sortStart = DispatchTime.now()
+            sorter.sort(&order, depths: depths)
+            result.sortMilliseconds = milliseconds(since: sortStart)
+            result.inversionFraction = DepthSorter.accuracy(of: order, depths: depths, backToFront: false).inversionFraction
+        }
+
+        var drawnOrder = order
+        if let chunks, let occlusionLag = options.occlusionLag {
+            let visibleChunks = culler.cull(chunks: chunks, splats: splats, viewpoint: Viewpoint(camera, screenSize: cullScreenSize)).visible
+            visibleChunkHistory.append(visibleChunks)
+            if visibleChunkHistory.count > occlusionLag + 1 {
+                visibleChunkHistory.removeFirst()
+            }
+            let drawnChunks = visibleChunkHistory[0]
+            var isDrawn = Array(repeating: false, count: splats.count)
+            var visibleCount = 0, missingCount = 0, drawnCount = 0
+            for (chunkIndex, chunk) in chunks.chunks.enumerated() {
+                if visibleChunks[chunkIndex] {
+                    visibleCount += chunk.range.count
+                    if !drawnChunks[chunkIndex] {
+                        missingCount += chunk.range.count
+                    }
+                }
+                if drawnChunks[chunkIndex] {
+                    drawnCount += chunk.range.count
+                    for index in chunks.splatIndices(inChunk: chunkIndex) {
+                        isDrawn[Int(index)] = true
+                    }
+                }
+            }
+            result.culledFraction = 1 - Double(drawnCount) / Double(max(splats.count, 1))
+            result.missingFraction = Double(missingCount) / Double(max(visibleCount, 1))
+            drawnOrder = order.filter { isDrawn[Int($0)] }
+        }
+
+        if let renderSize = options.renderSize {
+            let viewpoint = Viewpoint(camera, screenSize: SIMD2<Float>(Float(renderSize.x), Float(renderSize.y)))
+            var exactOrder = order
+            exactSorter.sort(&exactOrder, depths: depths)
+            let (image, statistics) = splats.withUnsafeBufferPointer { renderer.render(splats: $0, order: drawnOrder, viewpoint: viewpoint) }
+            let exactImage = splats.withUnsafeBufferPointer { exactRenderer.render(splats: $0, order: exactOrder, viewpoint: viewpoint).image }
+            let difference = image.difference(from: exactImage)
+            result.renderMilliseconds = statistics.duration * 1000
+            result.fragments = statistics.fragments
+            result.popping = difference.meanAbsoluteError
+            result.peakSignalToNoiseRatio = difference.peakSignalToNoiseRatio
+            result.imageChecksum = checksum(image)
+        }
+
+        report.frames.append(result)
+        print([ "\(index)", String(format: "%.4f", result.timestamp),
+                String(format: "%.2f", result.sortMilliseconds),
+                result.inversionFraction.map { String(format: "%.5f", $0) } ?? "-",
+                result.renderMilliseconds.map { String(format: "%.1f", $0) } ?? "-",
+                result.popping.map { String(format: "%.6f", $0) } ?? "-",
+                result.peakSignalToNoiseRatio.map { String(format: "%.1f", $0) } ?? "-",
+                result.imageChecksum ?? "-",
+                result.culledFraction.map { String(format: "%.4f", $0) } ?? "-",
+                result.missingFraction.map { String(format: "%.5f", $0) } ?? "-" ].joined(separator: "\t"))
+    }
+
+    let sortTimes = report.frames.map(\.sortMilliseconds).sorted()
+    let errors = report.frames.compactMap(\.popping)
+    if !errors.isEmpty {
+        print("mean difference from the sorted image \(String(format: "%.6f", errors.reduce(0, +) / Double(errors.count))), " +
+              "worst \(String(format: "%.6f", errors.max()!)) over \(errors.count) frames")
+    }
+    let missing = report.frames.compactMap(\.missingFraction)
+    if !missing.isEmpty {
+        let culled = report.frames.compactMap(\.culledFraction)
+        print("occlusion culling \(options.occlusionLag ?? 0) frames behind: culled \(String(format: "%.4f", culled.reduce(0, +) / Double(culled.count))) " +
+              "of the splats on average; missing \(String(format: "%.5f", missing.reduce(0, +) / Double(missing.count))) of the visible ones " +
+              "on average, worst \(String(format: "%.5f", missing.max()!)), in \(missing.filter { $0 > 0 }.count) of \(missing.count) frames")
+    }
+    if !options.weightedBlending && !sortTimes.isEmpty {
+        print("sort p50 \(String(format: "%.2f", percentile(sortTimes, 0.5))) ms, " +
+              "p99 \(String(format: "%.2f", percentile(sortTimes, 0.99))) ms, " +
+              "max \(String(format: "%.2f", sortTimes.last!)) ms over \(sortTimes.count) frames")
+    }
+
+    if let outputURL = options.outputURL {
+        let encoder = JSONEncoder()
+        encoder.outputFormatting = [ .prettyPrinted, .sortedKeys ]
+        try encoder.encode(report).write(to: outputURL)
+    }
+}
+
+let options = Options(Array(CommandLine.arguments.dropFirst()))
+switch options.command {
+case "record": try record(options)
+case "replay": try replay(options)
+default: fatalError("Usage: TrajectoryReplay record|replay ...")
+}
@@ -5,13 +5,16 @@ using namespace metal;
 
 constant const int kMaxViewCount = 2;
 constant static const float kBoundsRadius = 2;
-constant static const float kBoundsRadiusSquared = kBoundsRadius*kBoundsRadius;
+// Fragments fainter than this couldn't change an 8-bit channel
+constant static const float kAlphaCutoff = 1.0 / 255.0;
 
 enum BufferIndex: int32_t
 {
     BufferIndexUniforms = 0,
     BufferIndexSplat    = 1,
     BufferIndexOrder    = 2,
+    BufferIndexInstance = 3,
+    BufferIndexPreprocessed = 4,
 };
 
 enum SplatAttribute: int32_t
@@ -27,6 +30,8 @@ typedef struct
     matrix_float4x4 projectionMatrix;
     matrix_float4x4 viewMatrix;
     uint2 screenSize;
+    uint instanceCount;
+    uint orderCount;
 } Uniforms;
 
 typedef struct
@@ -42,11 +47,32 @@ typedef struct
     float4 rotationQuat  [[attribute(SplatAttributeRotationQuat)]];
 } Splat;
 
+// Keep in sync with SplatCompute's SplatInstances.Placement
+typedef struct
+{
+    float4x4 transform;
+    uint splatOffset;
+    uint orderOffset;
+    uint count;
+} SplatInstance;
+
+// A splat in the draw order as splatPreprocessKernel projects it for one view: everything splatVertexShader needs to
+// place its quad. Keep in sync with SplatRenderer.Constants.preprocessedSplatStride
+typedef struct
+{
+    float2 center;          // In NDC
+    half2 axis1;            // The quad's half extent along each of the 2D gaussian's principal axes, in NDC
+    half2 axis2;
+    half4 color;
+    half boundsRadius;      // 0 for culled splats
+} PreprocessedSplat;
+
 typedef struct
 {
     float4 position [[position]];
     float2 textureCoordinates;
     float4 color;
+    float boundsRadius [[flat]];
 } ColorInOut;
 
 float3x3 quaternionToMatrix(float4 quaternion) {
@@ -77,8 +103,8 @@ float3x3 scaleToMatrix(float3 scale) {
     return scaleMatrix;
 }
 
-void calcCovariance3D(float3 scale, float4 quaternion, thread float3 &cov3Da, thread float3 &cov3Db) {
-    float3x3 transform = quaternionToMatrix(quaternion) * scaleToMatrix(scale);
+void calcCovariance3D(float3 scale, float4 quaternion, float3x3 model, thread float3 &cov3Da, thread float3 &cov3Db) {
+    float3x3 transform = model * quaternionToMatrix(quaternion) * scaleToMatrix(scale);
     float3x3 cov3D = transform * transpose(transform);
     cov3Da = float3(cov3D[0][0], cov3D[0][1], cov3D[0][2]);
     cov3Db = float3(cov3D[1][1], cov3D[1][2], cov3D[2][2]);
@@ -159,20 +185,73 @@ void decomposeCovariance(float3 cov2D, thread float2 &v1, thread float2 &v2) {
     v2 = eigenvector2 * sqrt(lambda2);
 }
 
-vertex ColorInOut splatVertexShader(uint vertexID [[vertex_id]],
-                                    uint instanceID [[instance_id]],
-                                    ushort amp_id [[amplification_id]],
-                                    constant Splat* splatArray [[ buffer(BufferIndexSplat) ]],
-                                    constant metal::uint32_t* orderArray [[ buffer(BufferIndexOrder) ]],
-                                    constant UniformsArray & uniformsArray [[ buffer(BufferIndexUniforms) ]]) {
-    ColorInOut out;
+// How far a splat reaches, in the fragment shader's units (where alpha = exp(-v·v) * opacity), before its alpha falls
+// below kAlphaCutoff: at most kBoundsRadius, and 0 for splats too faint to show at all. Faint splats get
+// correspondingly smaller quads, rather than every splat rasterizing the full kBoundsRadius.
+// Keep in sync with SplatCompute's SplatReferenceRenderer.tightBoundsRadius(opacity:)
+float splatBoundsRadius(float opacity) {
+    float logAlpha = log(opacity / kAlphaCutoff);
+    return logAlpha > 0 ? min(kBoundsRadius, sqrt(logAlpha)) : 0;
+}
+
+// Projects each splat in the draw order once per frame and view, into preprocessedArray (one block of
+// uniforms.orderCount splats per view), rather than splatVertexShader doing it for every one of each quad's four
+// vertices. Dispatched as a compute pass ahead of the render pass, over a grid of (at least) orderCount by view
+// count threads.
+kernel void splatPreprocessKernel(uint2 position [[thread_position_in_grid]],
+                                  constant Splat* splatArray [[ buffer(BufferIndexSplat) ]],
+                                  constant metal::uint32_t* orderArray [[ buffer(BufferIndexOrder) ]],
+                                  constant SplatInstance* instanceArray [[ buffer(BufferIndexInstance) ]],
+                                  constant UniformsArray & uniformsArray [[ buffer(BufferIndexUniforms) ]],
+                                  device PreprocessedSplat* preprocessedArray [[ buffer(BufferIndexPreprocessed) ]]) {
+    uint orderIndex = position.x;
+    uint viewIndex = min(position.y, uint(kMaxViewCount - 1));
+    Uniforms uniforms = uniformsArray.uniforms[viewIndex];
+    if (orderIndex >= uniforms.orderCount) {
+        return;
+    }
+    device PreprocessedSplat &out = preprocessedArray[viewIndex * uniforms.orderCount + orderIndex];
+    out.boundsRadius = 0;
+
+    // orderArray holds instanced splat indices; find the instance whose block contains this one
+    uint instancedIndex = orderArray[orderIndex];
+    uint lower = 0;
+    uint upper = uniforms.instanceCount;
+    while (upper - lower > 1) {
+        uint middle = (lower + upper) / 2;
+        if (instanceArray[middle].orderOffset <= instancedIndex) {
+            lower = middle;
+        } else {
+            upper = middle;
+        }
+    }
+    if (uniforms.instanceCount == 0 ||
+        instancedIndex - instanceArray[lower].orderOffset >= instanceArray[lower].count) {
+        // The order and the instances are momentarily out of step
+        return;
+    }
+    SplatInstance instance = instanceArray[lower];
 
-    Uniforms uniforms = uniformsArray.uniforms[min(int(amp_id), kMaxViewCount)];
+    Splat splat = splatArray[instance.splatOffset + instancedIndex - instance.orderOffset];
+    splat.position = (instance.transform * float4(splat.position, 1)).xyz;
+    float3x3 model = float3x3(instance.transform[0].xyz, instance.transform[1].xyz, instance.transform[2].xyz);
 
-    Splat splat = splatArray[orderArray[instanceID]];
+    float4 eyeCenter = uniforms.viewMatrix * float4(splat.position, 1.0);
+    float4 projectedCenter = uniforms.projectionMatrix * eyeCenter;
+
+    float boundsRadius = splatBoundsRadius(splat.color.a);
+    float bounds = 1.2 * projectedCenter.w;
+    if (boundsRadius <= 0 ||
+        projectedCenter.z < -projectedCenter.w ||
+        projectedCenter.x < -bounds ||
+        projectedCenter.x > bounds ||
+        projectedCenter.y < -bounds ||
+        projectedCenter.y > bounds) {
+        return;
+    }
 
     float3 cov3Da, cov3Db;
-    calcCovariance3D(splat.scale, splat.rotationQuat, cov3Da, cov3Db);
+    calcCovariance3D(splat.scale, splat.rotationQuat, model, cov3Da, cov3Db);
     float3 cov2D = calcCovariance2D(splat.position, cov3Da, cov3Db,
                                     uniforms.viewMatrix, uniforms.projectionMatrix, uniforms.screenSize);
 
@@ -180,15 +259,24 @@ vertex ColorInOut splatVertexShader(uint vertexID [[vertex_id]],
     float2 axis2;
     decomposeCovariance(cov2D, axis1, axis2);
 
-    float4 eyeCenter = uniforms.viewMatrix * float4(splat.position, 1.0);
-    float4 projectedCenter = uniforms.projectionMatrix * eyeCenter;
+    float2 screenSizeFloat = float2(uniforms.screenSize.x, uniforms.screenSize.y);
+    out.center = projectedCenter.xy / projectedCenter.w;
+    out.axis1 = half2(axis1 * 2 * boundsRadius / screenSizeFloat);
+    out.axis2 = half2(axis2 * 2 * boundsRadius / screenSizeFloat);
+    out.color = half4(splat.color);
+    out.boundsRadius = boundsRadius;
+}
 
-    float bounds = 1.2 * projectedCenter.w;
-    if (projectedCenter.z < -projectedCenter.w ||
-        projectedCenter.x < -bounds ||
-        projectedCenter.x > bounds ||
-        projectedCenter.y < -bounds ||
-        projectedCenter.y > bounds) {
+vertex ColorInOut splatVertexShader(uint vertexID [[vertex_id]],
+                                    uint instanceID [[instance_id]],
+                                    ushort amp_id [[amplification_id]],
+                                    constant PreprocessedSplat* preprocessedArray [[ buffer(BufferIndexPreprocessed) ]],
+                                    constant UniformsArray & uniformsArray [[ buffer(BufferIndexUniforms) ]]) {
+    ColorInOut out;
+
+    Uniforms uniforms = uniformsArray.uniforms[min(int(amp_id), kMaxViewCount - 1)];
+    PreprocessedSplat splat = preprocessedArray[amp_id * uniforms.orderCount + instanceID];
+    if (splat.boundsRadius <= 0) {
         out.position = float4(0, 0, 2, 1);
         return out;
     }
@@ -201,26 +289,21 @@ vertex ColorInOut splatVertexShader(uint vertexID [[vertex_id]],
         case 3: textureCoordinates = float2(1, 1); break;
     }
     float2 vertexRelativePosition = float2((textureCoordinates.x - 0.5) * 2, (textureCoordinates.y - 0.5) * 2);
-    float2 screenCenter = projectedCenter.xy / projectedCenter.w;
-    float2 screenSizeFloat = float2(uniforms.screenSize.x, uniforms.screenSize.y);
-    float2 screenDelta =
-        (vertexRelativePosition.x * axis1 +
-         vertexRelativePosition.y * axis2)
-        * 2
-        * kBoundsRadius
-        / screenSizeFloat;
-    float2 screenVertex = screenCenter + screenDelta;
+    float2 screenVertex = splat.center +
+        vertexRelativePosition.x * float2(splat.axis1) +
+        vertexRelativePosition.y * float2(splat.axis2);
 
     out.position = float4(screenVertex.x, screenVertex.y, 0, 1);
     out.textureCoordinates = textureCoordinates;
-    out.color = splat.color;
+    out.color = float4(splat.color);
+    out.boundsRadius = splat.boundsRadius;
     return out;
 }
 
 fragment float4 splatFragmentShader(ColorInOut in [[stage_in]]) {
-    float2 v = kBoundsRadius * float2(in.textureCoordinates.x * 2 - 1, in.textureCoordinates.y * 2 - 1);
+    float2 v = in.boundsRadius * float2(in.textureCoordinates.x * 2 - 1, in.textureCoordinates.y * 2 - 1);
     float negativeVSquared = -dot(v, v);
-    if (negativeVSquared < -kBoundsRadiusSquared) {
+    if (negativeVSquared < -in.boundsRadius * in.boundsRadius) {
         discard_fragment();
     }
 
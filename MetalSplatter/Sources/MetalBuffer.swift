@@ -1,11 +1,18 @@
 import Foundation
 import Metal
 import os
+import SplatMetrics
 
 fileprivate let log =
     Logger(subsystem: Bundle.module.bundleIdentifier!,
            category: "MetalBuffer")
 
+fileprivate enum Metric {
+    // Each reallocation, including the copy of existing values
+    static let growth = Metrics.shared.histogram("buffer.growth")
+    static let bytesAllocated = Metrics.shared.counter("buffer.bytesAllocated")
+}
+
 class MetalBuffer<T> {
     enum Error: Swift.Error {
         case capacityGreatedThanMaxCapacity
@@ -53,6 +60,8 @@ class MetalBuffer<T> {
         }
 
         log.info("Allocating a new buffer of size \(MemoryLayout<T>.stride) * \(newCapacity) = \(Float(MemoryLayout<T>.stride * newCapacity) / (1024.0 * 1024.0))mb")
+        let span = Metric.growth.begin()
+        defer { span.end() }
         guard let newBuffer = device.makeBuffer(length: MemoryLayout<T>.stride * newCapacity,
                                                 options: .storageModeShared) else {
             throw Error.bufferCreationFailed
@@ -62,6 +71,7 @@ class MetalBuffer<T> {
         if newCount > 0 {
             memcpy(newValues, values, MemoryLayout<T>.stride * newCount)
         }
+        Metric.bytesAllocated.increment(by: newBuffer.length)
 
         self.capacity = newCapacity
         self.count = newCount
@@ -2,7 +2,10 @@ import Accelerate
 import Foundation
 import Metal
 import MetalKit
+import PLYIO
+import SplatCompute
 import SplatIO
+import SplatMetrics
 
 public class SplatRenderer {
     enum Constants {
@@ -16,19 +19,90 @@ public class SplatRenderer {
         static let useAccelerateForSort = false
         static let renderFrontToBack = true
         static let screenWidth: UInt32 = 1024
+        // Re-evaluate a splat's spherical harmonics once its view direction has changed by more than this (radians)
+        static let sphericalHarmonicsAngularThreshold: Float = 2 * .pi / 180
+        static let sphericalHarmonicsBudget = SphericalHarmonicsColorCache.Budget.default
+        // Compact splatBuffer in the background once this fraction of it is deleted
+        static let compactionThreshold = 0.25
+        // Build a DirectionalSortTable in the background once a scene is loaded, and start each sort from its
+        // order nearest the view direction when that's nearer than the last sort's (CPU sort along the forward
+        // vector only). Tables are only built when at least DirectionalSortTable.minimumDirectionCount directions
+        // fit in the budget.
+        static let directionalSortTable = true
+        static let directionalSortTableMemoryBudget = 256 << 20
+        // Keep in sync with Shaders.metal : PreprocessedSplat
+        static let preprocessedSplatStride = 32
+        // Depths are computed for this many splats at a time, spread across SplatExecutor.shared
+        static let sortDepthChunkSize = 64 * 1024
+        // load(plyFrom:progress:) runs I/O, decoding, activation and upload as a pipeline, each stage on its own
+        // thread; these bound how far each stage can get ahead of the next, in 1MB chunks and then batches of points
+        static let loadReadAheadChunkCount = 4
+        static let loadBatchSize = SplatPipelinedSceneReader.defaultBatchSize
+        static let loadQueueCapacity = 4
     }
 
     private static let log =
         Logger(subsystem: Bundle.module.bundleIdentifier!,
                category: "SplatRenderer")
 
+    enum Metric {
+        static let frameEncode = Metrics.shared.histogram("frame.encode")
+        // The whole sort, from the start of its task to the swap; the three stages below make up most of it
+        static let sort = Metrics.shared.histogram("sort.total")
+        static let sortDepth = Metrics.shared.histogram("sort.depth")
+        static let sortSort = Metrics.shared.histogram("sort.sort")
+        static let sortCopy = Metrics.shared.histogram("sort.copy")
+        static let sortedSplats = Metrics.shared.gauge("sort.splats")
+        static let sortTableBuild = Metrics.shared.histogram("sort.table.build")
+        static let sortTableSeeds = Metrics.shared.counter("sort.table.seeds")
+        static let spatialIndexBuild = Metrics.shared.histogram("spatialIndex.build")
+        static let sortCacheHits = Metrics.shared.counter("sort.cache.hits")
+        static let sortCacheMisses = Metrics.shared.counter("sort.cache.misses")
+        static let sortCacheHitRate = Metrics.shared.gauge("sort.cache.hitRate")
+        static let sortCacheBytes = Metrics.shared.gauge("sort.cache.bytes")
+        static let lodUpdate = Metrics.shared.histogram("lod.update")
+        static let occlusionCull = Metrics.shared.histogram("cull.occlusion")
+        // A load(plyFrom:progress:), from its start to its return, whether it finished, failed or was cancelled
+        static let load = Metrics.shared.histogram("load.total")
+        static let loadsCancelled = Metrics.shared.counter("load.cancelled")
+        // The quality governor's state, when there is one, as of the latest render
+        static let qualityLevel = Metrics.shared.gauge("quality.level")
+        static let qualityLoad = Metrics.shared.gauge("quality.load")
+        static let qualityFrameDuration = Metrics.shared.gauge("quality.frameDuration")
+        static let qualitySortDuration = Metrics.shared.gauge("quality.sortDuration")
+        static let qualitySortInterval = Metrics.shared.gauge("quality.sortInterval")
+        static let qualityExactSort = Metrics.shared.gauge("quality.exactSort")
+        static let qualityLODErrorScale = Metrics.shared.gauge("quality.lodErrorScale")
+        static let qualitySphericalHarmonicsInterval = Metrics.shared.gauge("quality.sphericalHarmonicsInterval")
+        static let qualityThermalState = Metrics.shared.gauge("quality.thermalState")
+        // From a renderer's first request to the sort scheduler to its grant, and requests it refused
+        static let sortScheduleWait = Metrics.shared.histogram("sort.schedule.wait")
+        static let sortScheduleDeferrals = Metrics.shared.counter("sort.schedule.deferred")
+    }
+
     public typealias CameraMatrices = ( projection: simd_float4x4, view: simd_float4x4 )
 
+    public struct LoadProgress {
+        public var bytesRead = 0
+        // nil where the source's size isn't known
+        public var totalBytes: Int?
+        public var splatsRead = 0
+        // Known once the header's been read
+        public var totalSplats: Int?
+
+        // 0...1, by bytes, or nil where that's not known
+        public var fractionCompleted: Double? {
+            totalBytes.map { $0 == 0 ? 1 : min(1, Double(bytesRead) / Double($0)) }
+        }
+    }
+
     // Keep in sync with Shaders.metal : BufferIndex
     enum BufferIndex: NSInteger {
         case uniforms = 0
         case splat    = 1
         case order    = 2
+        case instance = 3
+        case preprocessed = 4
     }
 
     // Keep in sync with Shaders.metal : SplatAttribute
@@ -44,6 +118,8 @@ public class SplatRenderer {
         var projectionMatrix: matrix_float4x4
         var viewMatrix: matrix_float4x4
         var screenSize: SIMD2<UInt32> // Size of screen in pixels
+        var instanceCount: UInt32 // Number of entries in the instance buffer
+        var orderCount: UInt32 // Number of splats drawn, and so preprocessed for each view
     }
 
     // Keep in sync with Shaders.metal : UniformsArray
@@ -62,14 +138,11 @@ public class SplatRenderer {
             default: break
             }
         }
-    }
 
-    // Keep in sync with Shaders.metal : Vertex
-    struct Splat {
-        var position: SIMD3<Float>
-        var color: SIMD4<Float>
-        var scale: SIMD3<Float>
-        var rotation: simd_quatf
+        mutating func setOrderCount(_ orderCount: UInt32) {
+            uniforms0.orderCount = orderCount
+            uniforms1.orderCount = orderCount
+        }
     }
 
     struct SplatIndexAndDepth {
@@ -78,6 +151,9 @@ public class SplatRenderer {
     }
 
     var pipelineState: MTLRenderPipelineState
+    // Projects every splat in the order once per frame, in a compute pass ahead of the draw (see Shaders.metal :
+    // splatPreprocessKernel)
+    var preprocessPipelineState: MTLComputePipelineState
     var depthState: MTLDepthStencilState
     public let maxViewCount: Int
     public let maxSimultaneousRenders: Int
@@ -90,6 +166,15 @@ public class SplatRenderer {
     var uniformBufferIndex = 0
     var uniforms: UnsafeMutablePointer<UniformsArray>
 
+    // The preprocessing pass's output for the vertex shader: orderBuffer.count splats for each view. GPU-only, and
+    // grown (with some headroom, since the order grows along with the scene as it loads) to fit.
+    var preprocessedSplatBuffer: MTLBuffer?
+    // What willRender preprocessed, for the render which follows it to draw; nil if there's nothing to draw
+    var preprocessedFrame: (orderBuffer: MetalBuffer<IndexType>, preprocessedSplatBuffer: MTLBuffer, viewCount: Int)?
+    // Set by willRender, and cleared by the render which follows it, to catch callers which only call render
+    var willRenderCalled = false
+    var loggedRenderWithoutWillRender = false
+
     // cameraWorldPosition and Forward vectors are the latest mean camera position across all viewports
     var cameraWorldPosition: SIMD3<Float> = .zero
     var cameraWorldForward: SIMD3<Float> = .init(x: 0, y: 0, z: -1)
@@ -97,13 +182,23 @@ public class SplatRenderer {
     typealias IndexType = UInt32
     // splatBuffer contains one entry for each gaussian splat
     var splatBuffer: MetalBuffer<Splat>
-    // orderBuffer indexes into splatBuffer, and is sorted by distance
-    var orderBuffer: MetalBuffer<IndexType>
+    // The order drawn, and the instance layout it was sorted with. A sort publishes both at once, under
+    // drawOrderLock, and each frame reads both at once, so no frame pairs an order with another order's placement
+    // offsets.
+    struct DrawOrder {
+        // Indexes into splatBuffer (or instanced splat indices; see SplatInstances), sorted by distance
+        var buffer: MetalBuffer<IndexType>
+        var layout: SplatInstances.Layout
+        // World-space bounds of the splats sorted, where the sort worked them out, for the sort scheduler
+        var bounds: Bounds?
+    }
+    private let drawOrderLock = NSLock()
+    private var publishedDrawOrder: DrawOrder
 
     var sorting = false
-    // orderBufferPrime is a copy of orderBuffer, which is not currenly in use for rendering.
-    // We use this for sorting, and when we're done, swap it with orderBuffer.
-    // There's a good chance that we'll sometimes end up sorting an orderBuffer still in use for
+    // orderBufferPrime is the previous order's buffer, which is not currenly in use for rendering.
+    // We use this for sorting, and when we're done, publish it as the draw order and take the old one back.
+    // There's a good chance that we'll sometimes end up sorting an order still in use for
     // rendering;.
     // TODO: Replace this with a more robust multiple-buffer scheme to guarantee we're never actively sorting a buffer still in use for rendering
     var orderBufferPrime: MetalBuffer<IndexType>
@@ -117,8 +212,102 @@ public class SplatRenderer {
     // Sorting on CPU
     // While not sorting, we guarantee that orderAndDepthTempSort remains valid: the count may not match splatCount, but the array should contain all indices.
     // So for every i in 0..<orderAndDepthTempSort.count, orderAndDepthTempSort should contain exactly one element with .index = i
+    // (With occlusionCulling or an LOD hierarchy, it instead holds only the indices to draw, and is rebuilt on every sort.)
     var orderAndDepthTempSort: [SplatIndexAndDepth] = []
 
+    // Precomputed orders along sampled view directions, built in the background for the current splats (or set from
+    // a saved table), and the direction the last sort was along
+    public var directionalSortTable: DirectionalSortTable?
+    // Only read and written on the render thread; the build hands the table back through pendingDirectionalSortTable,
+    // tagged with the directionalSortTableGeneration it was started in, so one finished after a reset is dropped
+    var buildingDirectionalSortTable = false
+    var directionalSortTableGeneration = 0
+    private let pendingDirectionalSortTable = Handoff<(generation: Int, table: DirectionalSortTable)>()
+    var lastSortForward: SIMD3<Float>?
+    // The table is only built once the splat count is the same for two sorts in a row, rather than over and over
+    // while a scene loads
+    var lastSortSplatCount = 0
+
+    // Finished orders by camera pose, for scenes shown along the same camera paths over and over; off unless set
+    public var sortOrderCache: SortOrderCache?
+
+    // Trades how often and how exactly to sort, the level of detail and how often to update spherical harmonics for
+    // frame time; off unless set. The renderer tells it how long its sorts take and the device's thermal state, but
+    // frame durations are up to the caller (ideally the GPU's, from each command buffer's gpuStartTime and
+    // gpuEndTime), through recordFrame(duration:).
+    public var qualityGovernor: QualityGovernor?
+    // The governor's settings as of the latest render
+    var qualitySettings: QualityGovernor.Settings?
+    var framesSinceSort = 0
+    var framesSinceSphericalHarmonicsUpdate = 0
+    // For sorts the governor has made approximate; only used by the sort task
+    let bucketedSorter = DepthSorter(strategy: .bucketed, backToFront: !Constants.renderFrontToBack)
+
+    // Shared with the other renderers, so that when several are live, the ones a fresh order helps most sort first,
+    // and only a few at once; set to nil to sort whenever the last sort's done
+    public var sortScheduler: SortScheduler? = .shared
+    var sortSchedulerClient: (scheduler: SortScheduler, client: SortScheduler.Client)?
+    // The camera when the scheduler last granted a sort; with the draw order's bounds, the next request's screen
+    // coverage and view change are worked out from it
+    var lastScheduledSortPose: CameraPose?
+
+    // The viewpoints of the most recent frame, used by the next sort for occlusion culling and LOD selection
+    var viewpoints: [Viewpoint] = []
+
+    // Leaves chunks of splats hidden behind nearer, opaque ones out of the sort and the draw. Only applies to the CPU
+    // sort of a whole, uninstanced scene without a level of detail hierarchy. Off by default: the order lags the
+    // camera by a sort, so a chunk which comes into view may be missing until the next one; TrajectoryReplay's
+    // --occlusion-lag measures how much goes missing along a recorded trajectory.
+    public var occlusionCulling = false
+    // splatChunks is built by the sort task on first use, and rebuilt whenever the splat count changes or splats are
+    // edited
+    var splatChunks: SplatChunks?
+    // One per view, so views are culled in parallel
+    let occlusionCullers = (0..<Constants.maxViewCount).map { _ in OcclusionCuller() }
+    // Whether orderAndDepthTempSort holds only the last culling sort's visible splats, rather than all of them
+    var orderHoldsVisibleSplatsOnly = false
+
+    // Multiple instances of splat assets. Until any instance is added, the whole of splatBuffer is drawn once,
+    // untransformed; after that, only instances are drawn. The draw order then holds instanced splat indices (see
+    // SplatInstances), laid out as in its layout.
+    var instances = SplatInstances()
+    // maxSimultaneousRenders regions of instanceRegionCapacity placements each, one per render, like dynamicUniformBuffers
+    var instanceBuffer: MetalBuffer<SplatInstances.Placement>
+    var instanceRegionCapacity = 0
+    var instanceBufferOffset = 0
+
+    // Picking and selection; built in the background after a load (or the first query), refit after edits, and
+    // rebuilt whenever the splat count changes. Like directionalSortTable, a build hands the index back through
+    // pendingSpatialIndex, tagged with spatialIndexGeneration, and it's installed by the next query or edit. Edits
+    // made meanwhile are kept in spatialIndexDirtyRanges, and refit once it's installed.
+    var spatialIndex: SplatSpatialIndex?
+    var buildingSpatialIndex = false
+    var spatialIndexGeneration = 0
+    var spatialIndexDirtyRanges: [Range<Int>] = []
+    private let pendingSpatialIndex = Handoff<(generation: Int, index: SplatSpatialIndex)>()
+
+    // Level of detail: when set, splatBuffer holds every node of the hierarchy, and only the selected cut is sorted and drawn
+    var lodSelector: SplatLODSelector?
+    // The configuration it was set with, before the quality governor's scaling
+    var lodConfiguration = SplatLODSelector.Configuration()
+
+    // Editing: tombstones, hidden splats and dirty ranges, indexed like splatBuffer. It's extended lazily, so may be
+    // shorter than splatBuffer; splats beyond its end are unedited.
+    var editState = SplatEditState()
+    // Edits waiting to be written to splatBuffer, by splat index; the sort reads splatBuffer, so they're only written
+    // while it isn't running (see applyPendingSplatEdits())
+    private var pendingSplatEdits: [Int: PendingSplatEdit] = [:]
+    // Only read and written on the render thread; the background task hands its result back through pendingCompaction
+    var compacting = false
+    // A compacted copy of splatBuffer prepared in the background, applied between sorts if nothing was edited or added meanwhile
+    private let pendingCompaction = Handoff<Result<(generation: Int, splats: MetalBuffer<Splat>, remap: [Int32]), Swift.Error>>()
+
+    // View-dependent colours, for scenes with spherical harmonics beyond the DC term; indexed like splatBuffer.
+    // Each frame, a bounded number of colours are re-baked and copied into splatBuffer. Once it exists, every splat
+    // appended gets an entry: DC-only for points added without higher-order coefficients, and a fixed colour for
+    // splats appended without their points (see appendFixedSphericalHarmonicsColors()).
+    var sphericalHarmonicsColorCache: SphericalHarmonicsColorCache?
+
     public init(device: MTLDevice,
                 colorFormat: MTLPixelFormat,
                 depthFormat: MTLPixelFormat,
@@ -136,10 +325,11 @@ public class SplatRenderer {
         self.uniforms = UnsafeMutableRawPointer(dynamicUniformBuffers.contents()).bindMemory(to: UniformsArray.self, capacity: 1)
 
         self.splatBuffer = try MetalBuffer(device: device)
-        self.orderBuffer = try MetalBuffer(device: device)
+        self.publishedDrawOrder = DrawOrder(buffer: try MetalBuffer(device: device), layout: .identity(splatCount: 0), bounds: nil)
         self.orderBufferPrime = try MetalBuffer(device: device)
         self.orderBufferTempSort = try MetalBuffer(device: device)
         self.depthBufferTempSort = try MetalBuffer(device: device)
+        self.instanceBuffer = try MetalBuffer(device: device)
 
         do {
             pipelineState = try Self.buildRenderPipelineWithDevice(device: device,
@@ -148,6 +338,7 @@ public class SplatRenderer {
                                                                    stencilFormat: stencilFormat,
                                                                    sampleCount: sampleCount,
                                                                    maxViewCount: self.maxViewCount)
+            preprocessPipelineState = try Self.buildPreprocessPipelineWithDevice(device: device)
         } catch {
             fatalError("Unable to compile render pipeline state.  Error info: \(error)")
         }
@@ -158,19 +349,208 @@ public class SplatRenderer {
         self.depthState = device.makeDepthStencilState(descriptor:depthStateDescriptor)!
     }
 
+    deinit {
+        if let sortSchedulerClient {
+            sortSchedulerClient.scheduler.removeClient(sortSchedulerClient.client)
+        }
+    }
+
     public func reset() {
         splatBuffer.count = 0
-        orderBuffer.count = 0
+        // Publish an empty order, then empty the one it replaces
+        orderBufferPrime.count = 0
+        orderBufferPrime = publishDrawOrder(orderBufferPrime, layout: .identity(splatCount: 0), bounds: nil)
         orderBufferPrime.count = 0
         orderBufferTempSort.count = 0
         depthBufferTempSort.count = 0
         orderAndDepthTempSort = []
+        orderHoldsVisibleSplatsOnly = false
+        directionalSortTable = nil
+        directionalSortTableGeneration += 1
+        lastSortForward = nil
+        lastSortSplatCount = 0
+        sphericalHarmonicsColorCache = nil
+        splatChunks = nil
+        spatialIndex = nil
+        spatialIndexGeneration += 1
+        spatialIndexDirtyRanges = []
+        lodSelector = nil
+        lodConfiguration = SplatLODSelector.Configuration()
+        lastScheduledSortPose = nil
+        editState.removeAll()
+        pendingSplatEdits = [:]
+        _ = pendingCompaction.take()
+        instances.removeAll()
     }
 
     public func readPLY(from url: URL) {
         SplatPLYSceneReader(url).read(to: self)
     }
 
+    // Reads a PLY file into the store in the background, calling progress (from a background thread) as it goes.
+    // Reading runs as a pipeline of stages, each on its own thread and a bounded number of batches ahead of the
+    // next: I/O, decoding points, activating them into Splats, and appending those to the store's buffers. The
+    // whole load then takes about as long as its slowest stage, rather than all of them added up.
+    //
+    // Cancelling the calling task stops every stage at its next chunk or batch; the splats read so far are then
+    // dropped, their memory freed, and this throws CancellationError. It throws the reader's error if the read fails,
+    // after dropping the partial splats the same way. Don't render or otherwise use the renderer until this returns.
+    public func load(plyFrom url: URL, progress: (@Sendable (LoadProgress) -> Void)? = nil) async throws {
+        let span = Metric.load.begin()
+        defer { span.end() }
+        let start = splatBuffer.count
+        let startCapacity = splatBuffer.capacity
+        let hadSphericalHarmonics = sphericalHarmonicsColorCache != nil
+
+        let reader = SplatPipelinedSceneReader(SplatPLYSceneReader(PLYReader(url, readAheadChunkCount: Constants.loadReadAheadChunkCount)),
+                                               batchSize: Constants.loadBatchSize,
+                                               queueCapacity: Constants.loadQueueCapacity)
+        let batches = BoundedQueue<SplatLoadEvent>(capacity: Constants.loadQueueCapacity, metricName: "load.activate")
+        let activated = DispatchSemaphore(value: 0)
+        let activation = Thread {
+            reader.read(to: SplatActivator(batches, reader: reader))
+            batches.close()
+            activated.signal()
+        }
+        activation.name = "SplatRenderer activation"
+        activation.start()
+
+        let uploading = Task.detached(priority: .userInitiated) {
+            let error = self.upload(batches, progress: progress)
+            if error != nil {
+                // Upload can fail on its own (growing the buffers), with the earlier stages still going
+                reader.cancel()
+                batches.cancel()
+            }
+            // The activation thread is done with the reader, and the splats, by the time this finishes, so that
+            // dropping them below can't race with it
+            Self.join(activated)
+            return error
+        }
+        let error = await withTaskCancellationHandler {
+            await uploading.value
+        } onCancel: {
+            reader.cancel()
+            batches.cancel()
+        }
+
+        if let error {
+            if error is CancellationError {
+                Metric.loadsCancelled.increment()
+            } else {
+                Self.log.error("Failed to read points: \(error)")
+            }
+            removeSplats(from: start, hadSphericalHarmonics: hadSphericalHarmonics, capacity: startCapacity)
+            throw error
+        }
+        // Ready for the first pick, rather than built then
+        buildSpatialIndexIfNeeded()
+    }
+
+    // Waits for a thread which signals as it finishes. Cancelled stages stop at their next chunk or batch, so this
+    // is brief.
+    private static func join(_ finished: DispatchSemaphore) {
+        finished.wait()
+    }
+
+    // The last stage of load(plyFrom:progress:): appends each batch to the store as it arrives. Returns the error the
+    // load failed with, if it did.
+    private func upload(_ events: BoundedQueue<SplatLoadEvent>, progress: (@Sendable (LoadProgress) -> Void)?) -> Swift.Error? {
+        while let event = events.pop() {
+            switch event {
+            case .start(let loadProgress):
+                Self.log.info("Will read \(loadProgress.totalSplats ?? 0) points")
+                do {
+                    try ensureAdditionalCapacity(loadProgress.totalSplats ?? 0)
+                } catch {
+                    events.cancel()
+                    return error
+                }
+                progress?(loadProgress)
+            case .splats(let splats, let pointsWithSphericalHarmonics, let loadProgress):
+                do {
+                    try ensureAdditionalCapacity(splats.count)
+                } catch {
+                    events.cancel()
+                    return error
+                }
+                // Points in a file either all have higher-order coefficients or none do
+                for point in pointsWithSphericalHarmonics ?? [] {
+                    appendSphericalHarmonics(point.sphericalHarmonics ?? [], dc: point.color, position: point.position)
+                }
+                splatBuffer.append(splats)
+                appendFixedSphericalHarmonicsColors()
+                progress?(loadProgress)
+            case .finish(let loadProgress):
+                Self.log.info("Finished reading points")
+                progress?(loadProgress)
+                return nil
+            case .fail(let error):
+                return error
+            }
+        }
+        // The queue only ends early when the load's cancelled
+        return CancellationError()
+    }
+
+    // Drops splats from index start on, which were appended since the store held start splats (and, if not
+    // hadSphericalHarmonics, no higher-order coefficients), and returns the splat buffer to the given capacity
+    private func removeSplats(from start: Int, hadSphericalHarmonics: Bool, capacity: Int) {
+        if splatBuffer.count > start {
+            splatBuffer.count = start
+            if !hadSphericalHarmonics {
+                sphericalHarmonicsColorCache = nil
+            } else if let cache = sphericalHarmonicsColorCache {
+                cache.compact(remap: (0..<cache.count).map { Int32($0 < start ? $0 : -1) })
+            }
+        }
+        do {
+            try splatBuffer.setCapacity(capacity)
+        } catch {
+            Self.log.error("Failed to shrink buffers: \(error)")
+        }
+    }
+
+    // Reads a PLY file into the store as an asset, which is drawn once an instance of it is added
+    public func addAsset(readingPLYFrom url: URL) -> Int {
+        let start = splatBuffer.count
+        readPLY(from: url)
+        return instances.addAsset(start..<splatBuffer.count)
+    }
+
+    public func addAsset(_ points: [SplatScenePoint]) throws -> Int {
+        let start = splatBuffer.count
+        try ensureAdditionalCapacity(points.count)
+        for point in points {
+            try add(point)
+        }
+        return instances.addAsset(start..<splatBuffer.count)
+    }
+
+    // Instances are sorted together with every other instance; they aren't supported with an LOD hierarchy, and
+    // picking, selection and culling ignore them (working on the untransformed store)
+    public func addInstance(of asset: Int, transform: simd_float4x4 = matrix_identity_float4x4) -> Int {
+        instances.addInstance(of: asset, transform: transform)
+    }
+
+    public func setTransform(_ transform: simd_float4x4, ofInstance instance: Int) {
+        instances.setTransform(transform, ofInstance: instance)
+    }
+
+    public func setHidden(_ isHidden: Bool, ofInstance instance: Int) {
+        instances.setHidden(isHidden, ofInstance: instance)
+    }
+
+    // Replace the scene with an LOD hierarchy; each frame's sort then works on a cut through it
+    public func setLODHierarchy(_ hierarchy: SplatLODHierarchy,
+                                configuration: SplatLODSelector.Configuration = .init()) throws {
+        reset()
+        try splatBuffer.ensureCapacity(hierarchy.splats.count)
+        splatBuffer.append(hierarchy.splats)
+        lodSelector = SplatLODSelector(hierarchy: hierarchy, configuration: configuration)
+        lodConfiguration = configuration
+    }
+
     private class func buildRenderPipelineWithDevice(device: MTLDevice,
                                                      colorFormat: MTLPixelFormat,
                                                      depthFormat: MTLPixelFormat,
@@ -215,6 +595,18 @@ public class SplatRenderer {
         return try device.makeRenderPipelineState(descriptor: pipelineDescriptor)
     }
 
+    // A compute pipeline writing preprocessedSplatBuffer, run in its own pass before the splats' render pass: within
+    // a render pass, a vertex-to-vertex barrier doesn't reliably order one draw's writes before the next's reads on
+    // tile-based GPUs
+    private class func buildPreprocessPipelineWithDevice(device: MTLDevice) throws -> MTLComputePipelineState {
+        let library = try device.makeDefaultLibrary(bundle: Bundle.module)
+
+        let pipelineDescriptor = MTLComputePipelineDescriptor()
+        pipelineDescriptor.label = "PreprocessPipeline"
+        pipelineDescriptor.computeFunction = library.makeFunction(name: "splatPreprocessKernel")
+        return try device.makeComputePipelineState(descriptor: pipelineDescriptor, options: [], reflection: nil)
+    }
+
     public func ensureAdditionalCapacity(_ pointCount: Int) throws {
         try splatBuffer.ensureCapacity(splatBuffer.count + pointCount)
     }
@@ -227,24 +619,372 @@ public class SplatRenderer {
             return
         }
 
-        let scale = SIMD3<Float>(exp(point.scale.x),
-                                 exp(point.scale.y),
-                                 exp(point.scale.z))
-        let rotation = point.rotation.normalized
-        let SH_C0: Float = 0.28209479177387814
-        let color = SIMD3<Float>(x: max(0, min(1, 0.5 + SH_C0 * point.color.x)),
-                                 y: max(0, min(1, 0.5 + SH_C0 * point.color.y)),
-                                 z: max(0, min(1, 0.5 + SH_C0 * point.color.z)))
-        let opacity = 1 / (1 + exp(-point.opacity))
         let splat = Splat(position: point.position,
-                          color: .init(x: color.x, y: color.y, z: color.z, w: opacity),
-                          scale: scale,
-                          rotation: rotation)
+                          sphericalHarmonicsDC: point.color,
+                          opacityLogit: point.opacity,
+                          logScale: point.scale,
+                          rotation: point.rotation.vector)
+
+        if let sphericalHarmonics = point.sphericalHarmonics {
+            appendSphericalHarmonics(sphericalHarmonics, dc: point.color, position: point.position)
+        } else {
+            sphericalHarmonicsColorCache?.append(position: point.position, dc: point.color, rest: [])
+        }
 
         splatBuffer.append([ splat ])
     }
 
-    public func willRender(viewportCameras: [CameraMatrices]) {}
+    // sphericalHarmonics holds the channel-major f_rest_* values
+    private func appendSphericalHarmonics(_ sphericalHarmonics: [Float], dc: SIMD3<Float>, position: SIMD3<Float>) {
+        if sphericalHarmonicsColorCache == nil {
+            guard let degree = SphericalHarmonics.degree(restCoefficientCount: sphericalHarmonics.count / 3), degree > 0 else {
+                return
+            }
+            let cache = SphericalHarmonicsColorCache(degree: degree,
+                                                     angularThreshold: Constants.sphericalHarmonicsAngularThreshold,
+                                                     budget: Constants.sphericalHarmonicsBudget)
+            sphericalHarmonicsColorCache = cache
+            // Any splats added before this one had no higher-order coefficients
+            appendFixedSphericalHarmonicsColors()
+        }
+
+        sphericalHarmonicsColorCache?.append(position: position,
+                                             dc: dc,
+                                             rest: SphericalHarmonics.interleave(channelMajorRest: sphericalHarmonics))
+    }
+
+    // Gives any splats in splatBuffer beyond the cache's count an entry with the colour they already have. Their
+    // DC terms are gone by now, and recovering them from the (clamped) colours would lose whatever was clamped.
+    private func appendFixedSphericalHarmonicsColors() {
+        guard let cache = sphericalHarmonicsColorCache, cache.count < splatBuffer.count else { return }
+        for i in cache.count..<splatBuffer.count {
+            let splat = splatBuffer.values[i]
+            cache.append(position: splat.position, color: SIMD3<Float>(splat.color.x, splat.color.y, splat.color.z))
+        }
+    }
+
+    // Updates this frame's uniforms (starting a sort, if one's due) and encodes its preprocessing into
+    // commandBuffer, as a compute pass of its own. Call once per frame, before creating the render encoder passed
+    // to render(viewportCameras:to:).
+    public func willRender(viewportCameras: [CameraMatrices], commandBuffer: MTLCommandBuffer) {
+        preprocessedFrame = nil
+        willRenderCalled = true
+        guard splatBuffer.count != 0 else { return }
+        let span = Metric.frameEncode.begin()
+        defer { span.end() }
+
+        // The order may hold fewer indices than there are splats: either culled, or not yet sorted after being added.
+        // A sort may publish a new order at any time, so this one (and its layout) is used throughout the frame.
+        let drawOrder = drawOrder
+        let orderBuffer = drawOrder.buffer
+
+        switchToNextDynamicBuffer()
+        updateQualitySettings()
+        updateUniforms(forViewportCameras: viewportCameras, layout: drawOrder.layout)
+
+        guard orderBuffer.count != 0,
+              let preprocessedSplatBuffer = ensurePreprocessedSplatCapacity(orderBuffer.count),
+              let computeEncoder = commandBuffer.makeComputeCommandEncoder() else { return }
+        uniforms.pointee.setOrderCount(UInt32(orderBuffer.count))
+
+        // Project each splat once, rather than once for each of its quad's vertices
+        computeEncoder.label = "Preprocess Splats"
+        computeEncoder.setComputePipelineState(preprocessPipelineState)
+        computeEncoder.setBuffer(dynamicUniformBuffers, offset: uniformBufferOffset, index: BufferIndex.uniforms.rawValue)
+        computeEncoder.setBuffer(splatBuffer.buffer, offset: 0, index: BufferIndex.splat.rawValue)
+        computeEncoder.setBuffer(orderBuffer.buffer, offset: 0, index: BufferIndex.order.rawValue)
+        computeEncoder.setBuffer(instanceBuffer.buffer, offset: instanceBufferOffset, index: BufferIndex.instance.rawValue)
+        computeEncoder.setBuffer(preprocessedSplatBuffer, offset: 0, index: BufferIndex.preprocessed.rawValue)
+        let viewCount = max(1, min(viewportCameras.count, maxViewCount))
+        let threadWidth = preprocessPipelineState.threadExecutionWidth
+        computeEncoder.dispatchThreadgroups(MTLSize(width: (orderBuffer.count + threadWidth - 1) / threadWidth, height: viewCount, depth: 1),
+                                            threadsPerThreadgroup: MTLSize(width: threadWidth, height: 1, depth: 1))
+        computeEncoder.endEncoding()
+
+        preprocessedFrame = (orderBuffer, preprocessedSplatBuffer, viewCount)
+    }
+
+    // The index for the current splats, or nil (having started building one) if it isn't ready yet
+    private func currentSpatialIndex() -> SplatSpatialIndex? {
+        installPendingSpatialIndex()
+        if let spatialIndex, spatialIndex.splatCount == splatBuffer.count {
+            return spatialIndex
+        }
+        buildSpatialIndexIfNeeded()
+        return nil
+    }
+
+    private func buildSpatialIndexIfNeeded() {
+        let splatCount = splatBuffer.count
+        guard !buildingSpatialIndex, splatCount > 0, spatialIndex?.splatCount != splatCount else { return }
+        buildingSpatialIndex = true
+        spatialIndexDirtyRanges = []
+
+        // Splats are copied, since splatBuffer may grow (and move) meanwhile; edits are caught up on at install
+        let splats = Array(UnsafeBufferPointer(start: splatBuffer.values, count: splatCount))
+        let generation = spatialIndexGeneration
+        let pendingSpatialIndex = pendingSpatialIndex
+        SplatExecutor.shared.async(priority: .background) {
+            let span = Metric.spatialIndexBuild.begin()
+            let index = SplatSpatialIndex(splats: splats)
+            let duration = span.end()
+            Self.log.info("Built a spatial index for \(splatCount) splats in \(duration) seconds")
+            pendingSpatialIndex.put((generation: generation, index: index))
+        }
+    }
+
+    private func installPendingSpatialIndex() {
+        guard let pending = pendingSpatialIndex.take() else { return }
+        buildingSpatialIndex = false
+        // Built for splats since reset, renumbered or added to: start again
+        guard pending.generation == spatialIndexGeneration, pending.index.splatCount == splatBuffer.count else {
+            buildSpatialIndexIfNeeded()
+            return
+        }
+        var index = pending.index
+        if !spatialIndexDirtyRanges.isEmpty {
+            index.refit(splats: UnsafeBufferPointer(start: splatBuffer.values, count: splatBuffer.count), dirtyRanges: spatialIndexDirtyRanges)
+        }
+        spatialIndex = index
+        spatialIndexDirtyRanges = []
+    }
+
+    // The splat under the given pixel of a viewport (see SplatSpatialIndex.pick); nil while the spatial index is
+    // still being built
+    public func pick(pixel: SIMD2<Float>,
+                     viewportCamera: CameraMatrices,
+                     screenSize: SIMD2<Float>,
+                     opacityThreshold: Float = SplatSpatialIndex.defaultOpacityThreshold) -> SplatSpatialIndex.RayHit? {
+        let ray = SplatSpatialIndex.Ray(viewpoint: Viewpoint(viewportCamera, screenSize: screenSize), pixel: pixel)
+        return pick(ray: ray, opacityThreshold: opacityThreshold)
+    }
+
+    public func pick(ray: SplatSpatialIndex.Ray,
+                     opacityThreshold: Float = SplatSpatialIndex.defaultOpacityThreshold) -> SplatSpatialIndex.RayHit? {
+        currentSpatialIndex()?.pick(ray: ray,
+                                    splats: UnsafeBufferPointer(start: splatBuffer.values, count: splatBuffer.count),
+                                    opacityThreshold: opacityThreshold)
+    }
+
+    // Indices of the (drawn) splats whose centres lie in the box; empty while the spatial index is still being built
+    public func selectSplats(in box: Bounds) -> [Int] {
+        guard let spatialIndex = currentSpatialIndex() else { return [] }
+        let indices = spatialIndex.indices(in: box, splats: UnsafeBufferPointer(start: splatBuffer.values, count: splatBuffer.count))
+        return excludingUndrawnSplats(indices)
+    }
+
+    // Indices of the (drawn) splats whose centres project inside the polygon (pixel coordinates, with the origin at
+    // the bottom-left); empty while the spatial index is still being built
+    public func selectSplats(inScreenPolygon polygon: [SIMD2<Float>],
+                             viewportCamera: CameraMatrices,
+                             screenSize: SIMD2<Float>) -> [Int] {
+        guard let spatialIndex = currentSpatialIndex() else { return [] }
+        let indices = spatialIndex.indices(inScreenPolygon: polygon,
+                                           viewpoint: Viewpoint(viewportCamera, screenSize: screenSize),
+                                           splats: UnsafeBufferPointer(start: splatBuffer.values, count: splatBuffer.count))
+        return excludingUndrawnSplats(indices)
+    }
+
+    private func excludingUndrawnSplats(_ indices: [Int]) -> [Int] {
+        guard editState.hasUndrawnSplats else { return indices }
+        return indices.filter { $0 >= editState.count || editState.isDrawn($0) }
+    }
+
+    // Editing. Edits are queued, and written to splatBuffer by the next frame that isn't waiting on a sort (the sort
+    // reads splatBuffer on the executor, so it mustn't be written meanwhile); to edit by spatial query, pass in the
+    // results of selectSplats(...). Picking and selection see edits once they're written.
+    // Deleted splats are made transparent, left out of the order by the next sort, and removed for good by a
+    // background compaction once enough have accumulated; compaction renumbers the remaining splats, so indices held
+    // from before it are invalid afterwards.
+
+    public func deleteSplats<Indices: Sequence>(_ indices: Indices) where Indices.Element == Int {
+        syncEditState()
+        for index in indices where editState.markDeleted(index) {
+            pendingSplatEdits[index, default: PendingSplatEdit()].opacity = 0
+        }
+    }
+
+    public func hideSplats<Indices: Sequence>(_ indices: Indices) where Indices.Element == Int {
+        syncEditState()
+        for index in indices where editState.markHidden(index, opacity: pendingOpacity(ofSplat: index)) {
+            pendingSplatEdits[index, default: PendingSplatEdit()].opacity = 0
+        }
+    }
+
+    public func showSplats<Indices: Sequence>(_ indices: Indices) where Indices.Element == Int {
+        syncEditState()
+        for index in indices {
+            if let opacity = editState.markShown(index) {
+                pendingSplatEdits[index, default: PendingSplatEdit()].opacity = opacity
+            }
+        }
+    }
+
+    // Replaces the splats' colour (linear RGB), including any view-dependent part; opacity is unchanged
+    public func setColor<Indices: Sequence>(_ color: SIMD3<Float>, ofSplats indices: Indices) where Indices.Element == Int {
+        syncEditState()
+        for index in indices where !editState.flags[index].contains(.deleted) {
+            pendingSplatEdits[index, default: PendingSplatEdit()].color = color
+            editState.markDirty(index)
+        }
+    }
+
+    public func moveSplats<Indices: Sequence>(_ indices: Indices, by translation: SIMD3<Float>) where Indices.Element == Int {
+        syncEditState()
+        for index in indices where !editState.flags[index].contains(.deleted) {
+            pendingSplatEdits[index, default: PendingSplatEdit()].translation += translation
+            editState.markDirty(index)
+        }
+    }
+
+    // The splat's opacity once its queued edits are written
+    private func pendingOpacity(ofSplat index: Int) -> Float {
+        pendingSplatEdits[index]?.opacity ?? splatBuffer.values[index].opacity
+    }
+
+    private func syncEditState() {
+        if editState.count < splatBuffer.count {
+            editState.append(count: splatBuffer.count - editState.count)
+        }
+    }
+
+    // Writes the queued edits to splatBuffer. Only called while not sorting, since the sort reads splatBuffer.
+    private func applyPendingSplatEdits() {
+        guard !pendingSplatEdits.isEmpty else { return }
+        let cache = sphericalHarmonicsColorCache?.count == splatBuffer.count ? sphericalHarmonicsColorCache : nil
+        for (index, edit) in pendingSplatEdits {
+            var splat = splatBuffer.values[index]
+            if let color = edit.color {
+                splat.color = .init(x: color.x, y: color.y, z: color.z, w: splat.opacity)
+                cache?.setColor(color, at: index)
+            }
+            if let opacity = edit.opacity {
+                splat.opacity = opacity
+            }
+            if edit.translation != .zero {
+                splat.position += edit.translation
+                cache?.setPosition(splat.position, at: index)
+            }
+            splatBuffer.values[index] = splat
+        }
+        pendingSplatEdits = [:]
+        // Compaction copies splatBuffer, so only once it's up to date
+        scheduleCompactionIfNeeded()
+    }
+
+    // Brings splatBuffer and derived structures up to date with the edits since the last call. Only called while not
+    // sorting, since the sort reads them.
+    private func applyEdits() {
+        applyPendingSplatEdits()
+        applyPendingCompaction()
+
+        installPendingSpatialIndex()
+        let dirtyRanges = editState.dirtyRanges.take()
+        guard !dirtyRanges.isEmpty else { return }
+        spatialIndex?.refit(splats: UnsafeBufferPointer(start: splatBuffer.values, count: splatBuffer.count), dirtyRanges: dirtyRanges)
+        if buildingSpatialIndex {
+            spatialIndexDirtyRanges.append(contentsOf: dirtyRanges)
+        }
+        // Chunks are rebuilt wholesale by the next culling sort
+        splatChunks = nil
+    }
+
+    private func scheduleCompactionIfNeeded() {
+        // Compaction renumbers splats, which would move them out from under assets' ranges
+        guard !compacting, lodSelector == nil, instances.isEmpty, editState.deletedFraction >= Constants.compactionThreshold else { return }
+        compacting = true
+
+        let generation = editState.generation
+        let remap = editState.compactionRemap()
+        // The live splats are copied here, since splatBuffer may be edited, grown or reallocated while the task runs
+        var liveSplats: [Splat] = []
+        liveSplats.reserveCapacity(editState.count - editState.deletedCount)
+        for (oldIndex, newIndex) in remap.enumerated() where newIndex >= 0 {
+            liveSplats.append(splatBuffer.values[oldIndex])
+        }
+        let device = splatBuffer.device
+        let pendingCompaction = pendingCompaction
+        SplatExecutor.shared.async(priority: .background) {
+            do {
+                let compacted = try MetalBuffer<Splat>(device: device, capacity: liveSplats.count)
+                compacted.append(liveSplats)
+                pendingCompaction.put(.success((generation: generation, splats: compacted, remap: remap)))
+            } catch {
+                pendingCompaction.put(.failure(error))
+            }
+        }
+    }
+
+    private func applyPendingCompaction() {
+        guard let result = pendingCompaction.take() else { return }
+        compacting = false
+        let compaction: (generation: Int, splats: MetalBuffer<Splat>, remap: [Int32])
+        switch result {
+        case .success(let result):
+            compaction = result
+        case .failure(let error):
+            Self.log.error("Failed to compact splats: \(error)")
+            return
+        }
+
+        guard compaction.generation == editState.generation,
+              compaction.remap.count == splatBuffer.count else {
+            scheduleCompactionIfNeeded()
+            return
+        }
+
+        let remap = compaction.remap
+        splatBuffer = compaction.splats
+        editState.compact(remap: remap)
+        if sphericalHarmonicsColorCache?.count == remap.count {
+            sphericalHarmonicsColorCache?.compact(remap: remap)
+        } else {
+            sphericalHarmonicsColorCache = nil
+        }
+        // Renumbered splats need a new index, and one already being built is for the old numbering
+        spatialIndex = nil
+        spatialIndexGeneration += 1
+        buildSpatialIndexIfNeeded()
+        splatChunks = nil
+
+        // Renumber the existing orders rather than starting over, so they stay (nearly) sorted
+        orderAndDepthTempSort = orderAndDepthTempSort.compactMap {
+            let newIndex = remap[Int($0.index)]
+            return newIndex >= 0 ? SplatIndexAndDepth(index: UInt32(newIndex), depth: $0.depth) : nil
+        }
+        let drawOrder = drawOrder
+        let orderBuffer = drawOrder.buffer
+        do {
+            orderBufferPrime.count = 0
+            try orderBufferPrime.ensureCapacity(orderBuffer.count)
+            for i in 0..<orderBuffer.count {
+                let newIndex = remap[Int(orderBuffer.values[i])]
+                if newIndex >= 0 {
+                    orderBufferPrime.append(IndexType(newIndex))
+                }
+            }
+            orderBufferPrime = publishDrawOrder(orderBufferPrime, layout: .identity(splatCount: splatBuffer.count), bounds: drawOrder.bounds)
+        } catch {
+            Self.log.error("Failed to grow buffers: \(error)")
+            orderBuffer.count = 0
+        }
+    }
+
+    var drawOrder: DrawOrder {
+        drawOrderLock.lock()
+        defer { drawOrderLock.unlock() }
+        return publishedDrawOrder
+    }
+
+    // Makes order, sorted with layout, the one drawn, and returns the previous order's buffer for the next sort to
+    // write into
+    func publishDrawOrder(_ order: MetalBuffer<IndexType>, layout: SplatInstances.Layout, bounds: Bounds?) -> MetalBuffer<IndexType> {
+        drawOrderLock.lock()
+        defer { drawOrderLock.unlock() }
+        let previous = publishedDrawOrder.buffer
+        publishedDrawOrder = DrawOrder(buffer: order, layout: layout, bounds: bounds)
+        return previous
+    }
 
     private func switchToNextDynamicBuffer() {
         uniformBufferIndex = (uniformBufferIndex + 1) % maxSimultaneousRenders
@@ -252,20 +992,140 @@ public class SplatRenderer {
         uniforms = UnsafeMutableRawPointer(dynamicUniformBuffers.contents() + uniformBufferOffset).bindMemory(to: UniformsArray.self, capacity: 1)
     }
 
-    private func updateUniforms(forViewportCameras viewportCameras: [CameraMatrices]) {
+    private func updateUniforms(forViewportCameras viewportCameras: [CameraMatrices], layout: SplatInstances.Layout) {
+        let instanceCount = updateInstanceBuffer(layout: layout)
+        viewpoints = []
         for (i, viewportCamera) in viewportCameras.enumerated() where i <= maxViewCount {
             let screenWidth = Constants.screenWidth
             let screenHeight = UInt32(round(Float(screenWidth) * viewportCamera.projection[0][0] / viewportCamera.projection[1][1]))
             let screenSize = SIMD2<UInt32>(x: screenWidth, y: screenHeight)
-            let uniforms = Uniforms(projectionMatrix: viewportCamera.projection, viewMatrix: viewportCamera.view, screenSize: screenSize)
+            let uniforms = Uniforms(projectionMatrix: viewportCamera.projection,
+                                    viewMatrix: viewportCamera.view,
+                                    screenSize: screenSize,
+                                    instanceCount: instanceCount,
+                                    orderCount: 0)
             self.uniforms.pointee.setUniforms(index: i, uniforms)
+            viewpoints.append(Viewpoint(viewportCamera, screenSize: SIMD2<Float>(screenSize)))
         }
 
         cameraWorldPosition = viewportCameras.map { Self.cameraWorldPosition(forViewMatrix: $0.view) }.mean ?? .zero
         cameraWorldForward = viewportCameras.map { Self.cameraWorldForward(forViewMatrix: $0.view) }.mean?.normalized ?? .init(x: 0, y: 0, z: -1)
 
+        framesSinceSphericalHarmonicsUpdate += 1
+        if framesSinceSphericalHarmonicsUpdate >= qualitySettings?.sphericalHarmonicsInterval ?? 1 {
+            framesSinceSphericalHarmonicsUpdate = 0
+            updateSphericalHarmonicsColors()
+        }
+
+        framesSinceSort += 1
         if !sorting {
+            applyPendingSplatEdits()
+        }
+        if !sorting && framesSinceSort >= qualitySettings?.sortInterval ?? 1 && isSortGranted() {
+            framesSinceSort = 0
+            applyEdits()
+            applyLODConfiguration()
             resortIndices()
+            // Done already (from the sort order cache), or given up on
+            if !sorting, let sortSchedulerClient {
+                sortSchedulerClient.scheduler.didFinishSort(sortSchedulerClient.client)
+            }
+        }
+    }
+
+    // Asks the sort scheduler, if there is one, whether this renderer may start a sort now
+    private func isSortGranted() -> Bool {
+        guard let sortScheduler else { return true }
+        if sortSchedulerClient?.scheduler !== sortScheduler {
+            if let sortSchedulerClient {
+                sortSchedulerClient.scheduler.removeClient(sortSchedulerClient.client)
+            }
+            sortSchedulerClient = (sortScheduler, sortScheduler.addClient())
+        }
+        guard let client = sortSchedulerClient?.client else { return true }
+
+        var request = SortScheduler.Request()
+        let sortedBounds = drawOrder.bounds
+        if let sortedBounds, !viewpoints.isEmpty {
+            request.screenCoverage = viewpoints.map { $0.screenCoverage(sortedBounds) }.max() ?? 0
+            request.isVisible = request.screenCoverage > 0
+        }
+        if let lastScheduledSortPose {
+            let turn = acos(min(max(dot(cameraWorldForward, lastScheduledSortPose.forward), -1), 1))
+            let distance = sortedBounds.map { (cameraWorldPosition - $0.center).lengthSquared.squareRoot() } ?? 1
+            let move = (cameraWorldPosition - lastScheduledSortPose.position).lengthSquared.squareRoot() / max(distance, 1e-3)
+            request.viewChange = turn + move
+        }
+
+        guard let grant = sortScheduler.requestSort(client, request, now: ProcessInfo.processInfo.systemUptime) else {
+            Metric.sortScheduleDeferrals.increment()
+            return false
+        }
+        Metric.sortScheduleWait.record(grant.waited)
+        lastScheduledSortPose = CameraPose(position: cameraWorldPosition, forward: cameraWorldForward)
+        return true
+    }
+
+    // Takes up the quality governor's latest settings, and publishes its state
+    private func updateQualitySettings() {
+        guard let qualityGovernor else {
+            qualitySettings = nil
+            return
+        }
+        qualityGovernor.setThermalState(QualityGovernor.ThermalState(ProcessInfo.processInfo.thermalState))
+        let state = qualityGovernor.state
+        qualitySettings = state.settings
+
+        Metric.qualityLevel.set(Double(state.level))
+        Metric.qualityLoad.set(state.load)
+        Metric.qualityFrameDuration.set(state.smoothedFrameDuration ?? 0)
+        Metric.qualitySortDuration.set(state.smoothedSortDuration ?? 0)
+        Metric.qualitySortInterval.set(Double(state.settings.sortInterval))
+        Metric.qualityExactSort.set(state.settings.exactSort ? 1 : 0)
+        Metric.qualityLODErrorScale.set(Double(state.settings.lodErrorScale))
+        Metric.qualitySphericalHarmonicsInterval.set(Double(state.settings.sphericalHarmonicsInterval))
+        Metric.qualityThermalState.set(Double(state.thermalState.rawValue))
+    }
+
+    // Only called while not sorting, since the sort task reads the LOD selector's configuration
+    private func applyLODConfiguration() {
+        guard let lodSelector else { return }
+        var configuration = lodConfiguration
+        if let qualitySettings {
+            configuration.maxPixelError *= qualitySettings.lodErrorScale
+            configuration.splatBudget = Int(Float(configuration.splatBudget) * qualitySettings.splatBudgetScale)
+        }
+        lodSelector.configuration = configuration
+    }
+
+    // Writes this render's placements, with the offsets of the layout its order was sorted with, and returns their count
+    private func updateInstanceBuffer(layout: SplatInstances.Layout) -> UInt32 {
+        let placements = instances.placements(refreshing: layout)
+        if placements.count > instanceRegionCapacity {
+            do {
+                try instanceBuffer.setCapacity(placements.count * maxSimultaneousRenders)
+                instanceRegionCapacity = placements.count
+            } catch {
+                Self.log.error("Failed to grow buffers: \(error)")
+                return 0
+            }
+        }
+        instanceBufferOffset = MemoryLayout<SplatInstances.Placement>.stride * instanceRegionCapacity * uniformBufferIndex
+        let region = instanceBuffer.values + instanceRegionCapacity * uniformBufferIndex
+        for (i, placement) in placements.enumerated() {
+            region[i] = placement
+        }
+        return UInt32(placements.count)
+    }
+
+    private func updateSphericalHarmonicsColors() {
+        guard let sphericalHarmonicsColorCache, sphericalHarmonicsColorCache.count == splatBuffer.count else { return }
+        let updatedIndices = sphericalHarmonicsColorCache.update(viewPosition: cameraWorldPosition)
+        guard !updatedIndices.isEmpty else { return }
+        let colors = sphericalHarmonicsColorCache.colors
+        for index in updatedIndices {
+            let color = colors[index]
+            splatBuffer.values[index].color = .init(x: color.x, y: color.y, z: color.z, w: splatBuffer.values[index].color.w)
         }
     }
 
@@ -277,33 +1137,58 @@ public class SplatRenderer {
         (view.inverse * SIMD4<Float>(x: 0, y: 0, z: 0, w: 1)).xyz
     }
 
+    // Draws what willRender(viewportCameras:commandBuffer:) preprocessed; without that call first, this draws nothing.
+    // The cameras were all taken up by willRender, and must be the same ones; they're still passed here so that
+    // existing calls keep compiling, and to check the view count against.
     public func render(viewportCameras: [CameraMatrices], to renderEncoder: MTLRenderCommandEncoder) {
-        guard splatBuffer.count != 0 else { return }
-
-        switchToNextDynamicBuffer()
-        updateUniforms(forViewportCameras: viewportCameras)
+        guard willRenderCalled else {
+            if !loggedRenderWithoutWillRender {
+                loggedRenderWithoutWillRender = true
+                Self.log.error("render(viewportCameras:to:) called without willRender(viewportCameras:commandBuffer:) first; nothing will be drawn")
+            }
+            return
+        }
+        willRenderCalled = false
+        guard let preprocessedFrame else { return }
+        self.preprocessedFrame = nil
+        assert(max(1, min(viewportCameras.count, maxViewCount)) == preprocessedFrame.viewCount,
+               "render(viewportCameras:to:) must be passed the cameras passed to willRender(viewportCameras:commandBuffer:)")
 
         renderEncoder.pushDebugGroup("Draw Splat Model")
 
+        renderEncoder.setVertexBuffer(dynamicUniformBuffers, offset: uniformBufferOffset, index: BufferIndex.uniforms.rawValue)
+        renderEncoder.setVertexBuffer(preprocessedFrame.preprocessedSplatBuffer, offset: 0, index: BufferIndex.preprocessed.rawValue)
+
         renderEncoder.setRenderPipelineState(pipelineState)
 
         renderEncoder.setDepthStencilState(depthState)
 
-        renderEncoder.setVertexBuffer(dynamicUniformBuffers, offset: uniformBufferOffset, index: BufferIndex.uniforms.rawValue)
-        renderEncoder.setVertexBuffer(splatBuffer.buffer, offset: 0, index: BufferIndex.splat.rawValue)
-        renderEncoder.setVertexBuffer(orderBuffer.buffer, offset: 0, index: BufferIndex.order.rawValue)
-
         renderEncoder.drawPrimitives(type: .triangleStrip,
                                      vertexStart: 0,
                                      vertexCount: 4,
-                                     instanceCount: splatBuffer.count)
+                                     instanceCount: preprocessedFrame.orderBuffer.count)
 
         renderEncoder.popDebugGroup()
     }
 
+    private func ensurePreprocessedSplatCapacity(_ orderCount: Int) -> MTLBuffer? {
+        let length = orderCount * maxViewCount * Constants.preprocessedSplatStride
+        if let preprocessedSplatBuffer, preprocessedSplatBuffer.length >= length {
+            return preprocessedSplatBuffer
+        }
+        guard let buffer = splatBuffer.device.makeBuffer(length: length + length / 2, options: .storageModePrivate) else {
+            Self.log.error("Failed to grow buffers: unable to allocate \(length) bytes for preprocessed splats")
+            return nil
+        }
+        buffer.label = "Preprocessed Splats"
+        preprocessedSplatBuffer = buffer
+        return buffer
+    }
+
     // Set indicesPrime to a depth-sorted version of indices, then swap indices and indicesPrime
     public func resortIndices() {
-        if Constants.useAccelerateForSort {
+        // Only the CPU sort supports sorting a subset of the splats, or instances
+        if Constants.useAccelerateForSort && lodSelector == nil && instances.isEmpty && !occlusionCulling {
             resortIndicesViaAccelerate()
         } else {
             resortIndicesOnCPU()
@@ -315,58 +1200,251 @@ public class SplatRenderer {
         sorting = true
 
         let splatCount = splatBuffer.count
-
-        if orderAndDepthTempSort.count != splatCount {
-            orderAndDepthTempSort = Array(repeating: SplatIndexAndDepth(index: .max, depth: 0), count: splatCount)
-            for i in 0..<splatCount {
-                orderAndDepthTempSort[i].index = UInt32(i)
+        let viewpoints = viewpoints
+        let lodSelector = lodSelector
+        // With instances, every index below is an instanced splat index; otherwise it's an index into splatBuffer
+        let layout = lodSelector == nil && !instances.isEmpty ? instances.layout : .identity(splatCount: splatCount)
+        let drawCount = layout.instancedSplatCount
+        let cullsOcclusion = occlusionCulling && lodSelector == nil && layout.isIdentity && !viewpoints.isEmpty
+        let qualityGovernor = qualityGovernor
+        let exactSort = qualitySettings?.exactSort ?? true
+        let sortSchedulerClient = sortSchedulerClient
+
+        if lodSelector == nil && !cullsOcclusion && (orderAndDepthTempSort.count != drawCount || orderHoldsVisibleSplatsOnly) {
+            if orderAndDepthTempSort.count > drawCount || orderHoldsVisibleSplatsOnly {
+                orderAndDepthTempSort = []
             }
+            // Keep the existing order, and add any new splats at the end for the sort to move into place
+            orderAndDepthTempSort.append(contentsOf: (orderAndDepthTempSort.count..<drawCount).map {
+                SplatIndexAndDepth(index: UInt32($0), depth: 0)
+            })
         }
+        // Deleted and hidden splats are sorted along with the rest (keeping the order intact for when they're shown
+        // again), but left out of the order buffer
+        let editFlags = editState.hasUndrawnSplats ? editState.flags : nil
 
         let cameraWorldForward = cameraWorldForward
         let cameraWorldPosition = cameraWorldPosition
 
-        let t0 = Date()
-        Task(priority: .high) {
+        // With the whole, uninstanced scene in the order, start from the table's nearest order if it's a better
+        // start than the last sort's
+        orderHoldsVisibleSplatsOnly = cullsOcclusion
+        let sortsWholeScene = lodSelector == nil && !cullsOcclusion && layout.isIdentity
+        if sortsWholeScene && !Constants.sortByDistance {
+            installPendingDirectionalSortTable()
+            if let directionalSortTable,
+               directionalSortTable.splatCount == drawCount,
+               directionalSortTable.backToFront == !Constants.renderFrontToBack,
+               let order = directionalSortTable.order(nearestTo: cameraWorldForward, unlessNearer: lastSortForward) {
+                orderAndDepthTempSort = order.map { SplatIndexAndDepth(index: $0, depth: 0) }
+                Metric.sortTableSeeds.increment()
+            }
+            lastSortForward = cameraWorldForward
+            if drawCount == lastSortSplatCount {
+                buildDirectionalSortTableIfNeeded(splatCount: drawCount)
+            }
+        } else {
+            lastSortForward = nil
+        }
+        lastSortSplatCount = drawCount
+
+        // An order cached for (nearly) this pose is drawn straight away; the sort then refines it, unless it was sorted
+        // for exactly this pose. Position doesn't affect the order when sorting along the forward vector.
+        let cachePose = CameraPose(position: Constants.sortByDistance ? cameraWorldPosition : .zero, forward: cameraWorldForward)
+        let cacheKey = sortsWholeScene ? sortOrderCache?.key(for: cachePose, splatCount: drawCount, generation: editState.generation) : nil
+        if let sortOrderCache, let cacheKey {
+            let entry = sortOrderCache.lookUp(cacheKey)
+            let statistics = sortOrderCache.statistics
+            (entry == nil ? Metric.sortCacheMisses : Metric.sortCacheHits).increment()
+            Metric.sortCacheHitRate.set(statistics.hitRate)
+            Metric.sortCacheBytes.set(Double(statistics.memorySize))
+
+            if let entry {
+                do {
+                    orderBufferPrime.count = 0
+                    try orderBufferPrime.ensureCapacity(entry.order.count)
+                    orderBufferPrime.append(entry.order)
+                    orderBufferPrime = publishDrawOrder(orderBufferPrime, layout: layout, bounds: drawOrder.bounds)
+                    // Without undrawn splats, the cached order holds every index, so it's also the best start for the sort
+                    if editFlags == nil {
+                        orderAndDepthTempSort = entry.order.map { SplatIndexAndDepth(index: $0, depth: 0) }
+                    }
+                    if entry.pose == cachePose {
+                        sorting = false
+                        return
+                    }
+                } catch {
+                    Self.log.error("Failed to grow buffers: \(error)")
+                }
+            }
+        }
+
+        SplatExecutor.shared.async(priority: .frame) { [self] in
+            let totalSpan = Metric.sort.begin()
             defer {
+                qualityGovernor?.recordSort(duration: totalSpan.end())
                 sorting = false
+                if let sortSchedulerClient {
+                    sortSchedulerClient.scheduler.didFinishSort(sortSchedulerClient.client)
+                }
             }
 
-            // We maintain the old order in indicesAndDepthTempSort in order to provide the opportunity to optimize the sort performance
-            for i in 0..<splatCount {
-                let index = orderAndDepthTempSort[i].index
-                let splatPosition = splatBuffer.values[Int(index)].position
-                if Constants.sortByDistance {
-                    orderAndDepthTempSort[i].depth = (splatPosition - cameraWorldPosition).lengthSquared
-                } else {
-                    orderAndDepthTempSort[i].depth = dot(splatPosition, cameraWorldForward)
+            if let lodSelector {
+                let statistics = lodSelector.update(viewpoints: viewpoints)
+                Metric.lodUpdate.record(statistics.duration)
+                Self.log.debug("Selected \(statistics.cutSize) LOD nodes (\(statistics.refinedNodes) refined, \(statistics.coarsenedNodes) coarsened, max error \(statistics.maxPixelError) pixels) in \(statistics.duration) seconds")
+                orderAndDepthTempSort = lodSelector.splatIndices.map { SplatIndexAndDepth(index: $0, depth: 0) }
+            } else if cullsOcclusion {
+                orderAndDepthTempSort = visibleSplatIndices(splatCount: splatCount, viewpoints: viewpoints).map {
+                    SplatIndexAndDepth(index: $0, depth: 0)
                 }
             }
+            let sortCount = orderAndDepthTempSort.count
 
-            let t1 = Date()
-            if Constants.renderFrontToBack {
+            // We maintain the old order in indicesAndDepthTempSort in order to provide the opportunity to optimize the sort performance
+            let depthSpan = Metric.sortDepth.begin()
+            let splats = UnsafeBufferPointer(start: splatBuffer.values, count: splatCount)
+            let chunkSize = Constants.sortDepthChunkSize
+            let chunkCount = (sortCount + chunkSize - 1) / chunkSize
+            // Bounds of the positions, for the sort scheduler
+            var chunkBounds = Array(repeating: Bounds.empty, count: chunkCount)
+            orderAndDepthTempSort.withUnsafeMutableBufferPointer { orderAndDepth in
+                chunkBounds.withUnsafeMutableBufferPointer { chunkBounds in
+                    SplatExecutor.shared.parallelFor(iterations: chunkCount, priority: .frame) { chunk in
+                        var bounds = Bounds.empty
+                        for i in (chunk * chunkSize)..<min(sortCount, (chunk + 1) * chunkSize) {
+                            let index = orderAndDepth[i].index
+                            let splatPosition = layout.worldPosition(ofInstancedSplat: Int(index), splats: splats)
+                            bounds.formUnion(splatPosition)
+                            if Constants.sortByDistance {
+                                orderAndDepth[i].depth = (splatPosition - cameraWorldPosition).lengthSquared
+                            } else {
+                                orderAndDepth[i].depth = dot(splatPosition, cameraWorldForward)
+                            }
+                        }
+                        chunkBounds[chunk] = bounds
+                    }
+                }
+            }
+            let sortedBounds = chunkBounds.reduce(into: Bounds.empty) { $0.formUnion($1) }
+
+            let depthDuration = depthSpan.end()
+
+            // Array.sort takes advantage of existing runs, so starting from a nearly sorted order (the last sort's, or
+            // the sort table's) is much faster than from scratch
+            let sortSpan = Metric.sortSort.begin()
+            if !exactSort {
+                // One counting pass over depth buckets, with each bucket left in the last sort's order
+                var positions = Array(0..<UInt32(sortCount))
+                bucketedSorter.sort(&positions, depths: orderAndDepthTempSort.map(\.depth))
+                orderAndDepthTempSort = positions.map { orderAndDepthTempSort[Int($0)] }
+            } else if Constants.renderFrontToBack {
                 orderAndDepthTempSort.sort { $0.depth < $1.depth }
             } else {
                 orderAndDepthTempSort.sort { $0.depth > $1.depth }
             }
-            let t2 = Date()
+            let sortDuration = sortSpan.end()
 
             do {
+                let copySpan = Metric.sortCopy.begin()
                 orderBufferPrime.count = 0
-                try orderBufferPrime.ensureCapacity(splatCount)
-                for i in 0..<splatCount {
-                    orderBufferPrime.append(orderAndDepthTempSort[i].index)
+                try orderBufferPrime.ensureCapacity(sortCount)
+                for i in 0..<sortCount {
+                    let index = orderAndDepthTempSort[i].index
+                    if let editFlags {
+                        let splatIndex = layout.splatIndex(ofInstancedSplat: Int(index))
+                        if splatIndex < editFlags.count && !editFlags[splatIndex].isEmpty {
+                            continue
+                        }
+                    }
+                    orderBufferPrime.append(index)
+                }
+                let copyDuration = copySpan.end()
+                Metric.sortedSplats.set(Double(sortCount))
+                // An approximate order would be drawn as is at this exact pose, even after the governor's back to
+                // exact sorts, so only exact ones are cached
+                if exactSort, let sortOrderCache, let cacheKey {
+                    sortOrderCache.insert(Array(UnsafeBufferPointer(start: orderBufferPrime.values, count: orderBufferPrime.count)),
+                                          for: cachePose,
+                                          key: cacheKey)
+                    Metric.sortCacheBytes.set(Double(sortOrderCache.statistics.memorySize))
                 }
-                let t3 = Date()
-                Self.log.info("Sorted \(self.orderAndDepthTempSort.count) elements via Array.sort in \(t3.timeIntervalSince(t0)) seconds (\(t2.timeIntervalSince(t1)) in sort itself)")
-                
-                swap(&orderBuffer, &orderBufferPrime)
+                Self.log.debug("Sorted \(sortCount) elements via Array.sort: \(depthDuration) seconds in depth, \(sortDuration) in sort, \(copyDuration) in copy")
+
+                orderBufferPrime = publishDrawOrder(orderBufferPrime, layout: layout, bounds: sortedBounds)
             } catch {
                 // TODO: report error
             }
         }
     }
     
+    private func buildDirectionalSortTableIfNeeded(splatCount: Int) {
+        guard Constants.directionalSortTable,
+              !buildingDirectionalSortTable,
+              splatCount > 0,
+              directionalSortTable?.splatCount != splatCount else { return }
+        let directionCount = DirectionalSortTable.directionCount(splatCount: splatCount,
+                                                                 memoryBudget: Constants.directionalSortTableMemoryBudget)
+        guard directionCount > 0 else { return }
+        buildingDirectionalSortTable = true
+
+        // Positions are copied, since splatBuffer may grow (and move) or be edited meanwhile. Edits only make the
+        // table's orders a less good start; the sort itself is always exact.
+        let positions = (0..<splatCount).map { splatBuffer.values[$0].position }
+        let generation = directionalSortTableGeneration
+        let pendingDirectionalSortTable = pendingDirectionalSortTable
+        SplatExecutor.shared.async(priority: .background) {
+            let span = Metric.sortTableBuild.begin()
+            let table = DirectionalSortTable(positions: positions,
+                                             directionCount: directionCount,
+                                             backToFront: !Constants.renderFrontToBack)
+            let duration = span.end()
+            Self.log.info("Built a sort table of \(directionCount) directions for \(splatCount) splats in \(duration) seconds")
+            pendingDirectionalSortTable.put((generation: generation, table: table))
+        }
+    }
+
+    private func installPendingDirectionalSortTable() {
+        guard let pending = pendingDirectionalSortTable.take() else { return }
+        buildingDirectionalSortTable = false
+        if pending.generation == directionalSortTableGeneration {
+            directionalSortTable = pending.table
+        }
+    }
+
+    // Indices of the splats in chunks visible from any of the viewpoints
+    private func visibleSplatIndices(splatCount: Int, viewpoints: [Viewpoint]) -> [UInt32] {
+        let splats = UnsafeBufferPointer(start: splatBuffer.values, count: splatCount)
+        if splatChunks?.splatCount != splatCount {
+            splatChunks = SplatChunks(splats: splats)
+        }
+        guard let splatChunks else { return [] }
+
+        let viewpoints = Array(viewpoints.prefix(occlusionCullers.count))
+        var culled = [(visible: [Bool], statistics: OcclusionCuller.Statistics)?](repeating: nil, count: viewpoints.count)
+        culled.withUnsafeMutableBufferPointer { culled in
+            SplatExecutor.shared.parallelFor(iterations: viewpoints.count, priority: .culling) { i in
+                culled[i] = occlusionCullers[i].cull(chunks: splatChunks, splats: splats, viewpoint: viewpoints[i])
+            }
+        }
+
+        var visible = Array(repeating: false, count: splatChunks.chunks.count)
+        for case let (visibleFromViewpoint, statistics)? in culled {
+            for chunkIndex in visible.indices where visibleFromViewpoint[chunkIndex] {
+                visible[chunkIndex] = true
+            }
+            Metric.occlusionCull.record(statistics.duration)
+            Self.log.debug("Culled \(statistics.frustumCulledSplats) splats outside the frustum and \(statistics.occludedSplats) occluded splats in \(statistics.duration) seconds")
+        }
+
+        var indices: [UInt32] = []
+        indices.reserveCapacity(splatCount)
+        for chunkIndex in visible.indices where visible[chunkIndex] {
+            indices.append(contentsOf: splatChunks.splatIndices(inChunk: chunkIndex))
+        }
+        return indices
+    }
+
     public func resortIndicesViaAccelerate() {
         guard !sorting else { return }
         sorting = true
@@ -392,15 +1470,22 @@ public class SplatRenderer {
 
         let cameraWorldForward = cameraWorldForward
         let cameraWorldPosition = cameraWorldPosition
+        let qualityGovernor = qualityGovernor
+        let sortSchedulerClient = sortSchedulerClient
 
-        let t0 = Date()
-        Task(priority: .high) {
+        SplatExecutor.shared.async(priority: .frame) { [self] in
+            let totalSpan = Metric.sort.begin()
             defer {
+                qualityGovernor?.recordSort(duration: totalSpan.end())
                 sorting = false
+                if let sortSchedulerClient {
+                    sortSchedulerClient.scheduler.didFinishSort(sortSchedulerClient.client)
+                }
             }
 
             // TODO: use Accelerate to calculate the depth
             // We maintain the old order in indicesTempSort in order to provide the opportunity to optimize the sort performance
+            let depthSpan = Metric.sortDepth.begin()
             for index in 0..<splatCount {
                 let splatPosition = splatBuffer.values[Int(index)].position
                 if Constants.sortByDistance {
@@ -410,24 +1495,28 @@ public class SplatRenderer {
                 }
             }
 
-            let t1 = Date()
+            let depthDuration = depthSpan.end()
+
+            let sortSpan = Metric.sortSort.begin()
             vDSP_vsorti(depthBufferTempSort.values,
                         orderBufferTempSort.values,
                         nil,
                         vDSP_Length(splatCount),
                         Constants.renderFrontToBack ? 1 : -1)
-            let t2 = Date()
+            let sortDuration = sortSpan.end()
 
             do {
+                let copySpan = Metric.sortCopy.begin()
                 orderBufferPrime.count = 0
                 try orderBufferPrime.ensureCapacity(splatCount)
                 for i in 0..<splatCount {
                     orderBufferPrime.append(UInt32(orderBufferTempSort.values[i]))
                 }
-                let t3 = Date()
-                Self.log.info("Sorted via Accelerate.vDSP_vsorti in \(t3.timeIntervalSince(t0)) seconds (\(t2.timeIntervalSince(t1)) in sort itself)")
+                let copyDuration = copySpan.end()
+                Metric.sortedSplats.set(Double(splatCount))
+                Self.log.debug("Sorted \(splatCount) elements via Accelerate.vDSP_vsorti: \(depthDuration) seconds in depth, \(sortDuration) in sort, \(copyDuration) in copy")
 
-                swap(&orderBuffer, &orderBufferPrime)
+                orderBufferPrime = publishDrawOrder(orderBufferPrime, layout: .identity(splatCount: splatCount), bounds: nil)
             } catch {
                 // TODO: report error
             }
@@ -455,6 +1544,80 @@ extension SplatRenderer: SplatSceneReaderDelegate {
     }
 }
 
+private enum SplatLoadEvent {
+    case start(SplatRenderer.LoadProgress)
+    case splats([Splat], pointsWithSphericalHarmonics: [SplatScenePoint]?, SplatRenderer.LoadProgress)
+    case finish(SplatRenderer.LoadProgress)
+    case fail(Swift.Error)
+}
+
+// The activation stage of SplatRenderer.load(plyFrom:progress:): converts each batch of decoded points into
+// render-ready Splats, on a thread of its own, and queues them for upload
+private class SplatActivator: SplatSceneReaderDelegate {
+    enum Error: Swift.Error {
+        case readFailed
+    }
+
+    // Points activated per piece of executor work
+    static let chunkSize = 4096
+
+    private let events: BoundedQueue<SplatLoadEvent>
+    private let reader: SplatSceneReader
+    private var progress = SplatRenderer.LoadProgress()
+
+    init(_ events: BoundedQueue<SplatLoadEvent>, reader: SplatSceneReader) {
+        self.events = events
+        self.reader = reader
+    }
+
+    func didStartReading(withPointCount pointCount: UInt32) {
+        progress.totalSplats = Int(pointCount)
+        push(.start(progress))
+    }
+
+    func didReadBytes(_ bytesRead: Int, of totalBytes: Int?) {
+        progress.bytesRead = bytesRead
+        progress.totalBytes = totalBytes
+    }
+
+    func didRead(points: [SplatScenePoint]) {
+        // Spread across SplatExecutor.shared as background work, so loading never holds up a frame's sort
+        let splats = [Splat](unsafeUninitializedCapacity: points.count) { buffer, initializedCount in
+            let chunkCount = (points.count + Self.chunkSize - 1) / Self.chunkSize
+            SplatExecutor.shared.parallelFor(iterations: chunkCount, priority: .background) { chunk in
+                for i in (chunk * Self.chunkSize)..<min(points.count, (chunk + 1) * Self.chunkSize) {
+                    let point = points[i]
+                    (buffer.baseAddress! + i).initialize(to: Splat(position: point.position,
+                                                                   sphericalHarmonicsDC: point.color,
+                                                                   opacityLogit: point.opacity,
+                                                                   logScale: point.scale,
+                                                                   rotation: point.rotation.vector))
+                }
+            }
+            initializedCount = points.count
+        }
+        progress.splatsRead += points.count
+        push(.splats(splats,
+                     pointsWithSphericalHarmonics: points.first?.sphericalHarmonics == nil ? nil : points,
+                     progress))
+    }
+
+    func didFinishReading() {
+        push(.finish(progress))
+    }
+
+    func didFailReading(withError error: Swift.Error?) {
+        push(.fail(error ?? Error.readFailed))
+    }
+
+    // Once upload's stopped, so does reading
+    private func push(_ event: SplatLoadEvent) {
+        if !events.push(event) {
+            reader.cancel()
+        }
+    }
+}
+
 protocol MTLIndexTypeProvider {
     static var asMTLIndexType: MTLIndexType { get }
 }
@@ -474,14 +1637,6 @@ extension Array where Element == SIMD3<Float> {
 }
 
 private extension SIMD3 where Scalar: BinaryFloatingPoint, Scalar.RawSignificand: FixedWidthInteger {
-    var normalized: SIMD3<Scalar> {
-        self / Scalar(sqrt(lengthSquared))
-    }
-
-    var lengthSquared: Scalar {
-        x*x + y*y + z*z
-    }
-
     func vector4(w: Scalar) -> SIMD4<Scalar> {
         SIMD4<Scalar>(x: x, y: y, z: z, w: w)
     }
@@ -491,8 +1646,40 @@ private extension SIMD3 where Scalar: BinaryFloatingPoint, Scalar.RawSignificand
     }
 }
 
-private extension SIMD4 where Scalar: BinaryFloatingPoint {
-    var xyz: SIMD3<Scalar> {
-        .init(x: x, y: y, z: z)
+// Queued changes to one splat; opacity is applied after color, so a recoloured splat keeps a pending hide or delete
+private struct PendingSplatEdit {
+    var opacity: Float?
+    var color: SIMD3<Float>?
+    var translation = SIMD3<Float>.zero
+}
+
+// A value handed from a background task to the render thread, which takes it when it's ready for it
+private final class Handoff<Value> {
+    private let lock = NSLock()
+    private var value: Value?
+
+    func put(_ value: Value) {
+        lock.lock()
+        defer { lock.unlock() }
+        self.value = value
+    }
+
+    func take() -> Value? {
+        lock.lock()
+        defer { lock.unlock() }
+        defer { value = nil }
+        return value
+    }
+}
+
+private extension QualityGovernor.ThermalState {
+    init(_ thermalState: ProcessInfo.ThermalState) {
+        switch thermalState {
+        case .nominal: self = .nominal
+        case .fair: self = .fair
+        case .serious: self = .serious
+        case .critical: self = .critical
+        @unknown default: self = .nominal
+        }
     }
 }
@@ -0,0 +1,104 @@
+import Foundation
+import SplatMetrics
+
+// A first-in, first-out queue of at most capacity elements, for handing batches from one stage of a pipeline to the
+// next, each on its own thread: push waits while the queue is full and pop while it's empty, so a fast stage can get
+// no more than capacity batches ahead of a slow one. Safe to use from any thread.
+//
+// The producer closes the queue when it's done; the consumer then drains what's left, and pop returns nil. The
+// consumer cancels it to stop early, which drops what's queued and makes every later push fail, so the producer
+// knows to stop too.
+//
+// Given a metric name, the time each side spends waiting on the other is recorded, as "<name>.pushWait" and
+// "<name>.popWait": a stage whose pushes wait is faster than the one after it, and one whose pops wait is faster
+// than the one before.
+public final class BoundedQueue<Element> {
+    public let capacity: Int
+
+    private let condition = NSCondition()
+    // Popped slots are set to nil, so batches are released as soon as they're taken
+    private var elements: [Element?] = []
+    private var head = 0
+    private var closed = false
+    private let pushWait: Histogram?
+    private let popWait: Histogram?
+
+    public init(capacity: Int, metricName: String? = nil) {
+        precondition(capacity > 0)
+        self.capacity = capacity
+        pushWait = metricName.map { Metrics.shared.histogram("\($0).pushWait") }
+        popWait = metricName.map { Metrics.shared.histogram("\($0).popWait") }
+    }
+
+    // Waits for room, then adds element; returns false, dropping element, if the queue is or becomes closed first
+    @discardableResult
+    public func push(_ element: Element) -> Bool {
+        condition.lock()
+        defer { condition.unlock() }
+        if !closed && elements.count - head >= capacity {
+            let span = pushWait?.begin()
+            while !closed && elements.count - head >= capacity {
+                condition.wait()
+            }
+            span?.end()
+        }
+        guard !closed else { return false }
+        elements.append(element)
+        condition.broadcast()
+        return true
+    }
+
+    // Waits for an element and removes it, or returns nil once the queue is closed and empty
+    public func pop() -> Element? {
+        condition.lock()
+        defer { condition.unlock() }
+        if !closed && elements.count == head {
+            let span = popWait?.begin()
+            while !closed && elements.count == head {
+                condition.wait()
+            }
+            span?.end()
+        }
+        guard head < elements.count else { return nil }
+        let element = elements[head]!
+        elements[head] = nil
+        head += 1
+        // Reclaim the consumed slots once they're the bulk of the array, so it stays around capacity in size
+        if head >= capacity {
+            elements.removeFirst(head)
+            head = 0
+        }
+        condition.broadcast()
+        return element
+    }
+
+    // No more elements will be pushed; those already queued can still be popped
+    public func close() {
+        condition.lock()
+        defer { condition.unlock() }
+        closed = true
+        condition.broadcast()
+    }
+
+    // Closes the queue and drops whatever's in it
+    public func cancel() {
+        condition.lock()
+        defer { condition.unlock() }
+        closed = true
+        elements = []
+        head = 0
+        condition.broadcast()
+    }
+
+    public var count: Int {
+        condition.lock()
+        defer { condition.unlock() }
+        return elements.count - head
+    }
+
+    public var isClosed: Bool {
+        condition.lock()
+        defer { condition.unlock() }
+        return closed
+    }
+}
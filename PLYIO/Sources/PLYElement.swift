@@ -33,4 +33,8 @@ public struct PLYElement {
     }
 
     public var properties: [Property]
+
+    public init(properties: [Property]) {
+        self.properties = properties
+    }
 }
@@ -12,6 +12,12 @@ public struct PLYHeader: Equatable {
         public var count: UInt32
         public var properties: [Property]
 
+        public init(name: String, count: UInt32, properties: [Property]) {
+            self.name = name
+            self.count = count
+            self.properties = properties
+        }
+
         public func index(forPropertyNamed name: String) -> Int? {
             properties.firstIndex { $0.name == name }
         }
@@ -96,12 +102,23 @@ public struct PLYHeader: Equatable {
     public struct Property: Equatable {
         public var name: String
         public var type: PropertyType
+
+        public init(name: String, type: PropertyType) {
+            self.name = name
+            self.type = type
+        }
     }
 
     public var format: Format
     public var version: String
     public var elements: [Element]
 
+    public init(format: Format, version: String, elements: [Element]) {
+        self.format = format
+        self.version = version
+        self.elements = elements
+    }
+
     public func index(forElementNamed name: String) -> Int? {
         elements.firstIndex { $0.name == name }
     }
@@ -132,7 +149,7 @@ extension PLYHeader.PropertyType: CustomStringConvertible {
     public var description: String {
         switch self {
         case .primitive(let primitiveType): primitiveType.description
-        case .list(let countType, let valueType): "\(countType) \(valueType)"
+        case .list(let countType, let valueType): "list \(countType) \(valueType)"
         }
     }
 }
@@ -1,10 +1,17 @@
 import Foundation
+import SplatMetrics
 
 public protocol PLYReaderDelegate {
     func didStartReading(withHeader header: PLYHeader)
     func didRead(element: PLYElement, typeIndex: Int, withHeader elementHeader: PLYHeader.Element)
     func didFinishReading()
     func didFailReading(withError error: Swift.Error?)
+    // Called after each chunk of the file is read; totalBytes is the file's size, where known
+    func didReadBytes(_ bytesRead: Int, of totalBytes: Int?)
+}
+
+extension PLYReaderDelegate {
+    public func didReadBytes(_ bytesRead: Int, of totalBytes: Int?) {}
 }
 
 public class PLYReader {
@@ -39,6 +46,18 @@ public class PLYReader {
         static let lf = UInt8(ascii: "\n")
         static let space = UInt8(ascii: " ")
         static let isLittleEndian = 14 == 14.littleEndian
+        // Reading ahead, the file is read in chunks of this size
+        static let readAheadChunkSize = 1024*1024
+    }
+
+    fileprivate enum Metric {
+        static let read = Metrics.shared.histogram("ply.read")
+        // The parts of a read before the body: opening the file, and reading and parsing the header
+        static let open = Metrics.shared.histogram("ply.open")
+        static let header = Metrics.shared.histogram("ply.header")
+        static let bytesRead = Metrics.shared.counter("ply.bytesRead")
+        // Of the most recent read, in bytes per second
+        static let throughput = Metrics.shared.gauge("ply.throughput")
     }
 
     fileprivate enum HeaderKeyword: String {
@@ -51,13 +70,88 @@ public class PLYReader {
     }
 
     let url: URL
+    // With more than 0, the file is read on a thread of its own, up to this many chunks ahead of parsing, so I/O
+    // overlaps parsing and whatever the delegate does
+    let readAheadChunkCount: Int
+    private let cancelLock = NSLock()
+    private var cancelled = false
 
-    public init(_ url: URL) {
+    public init(_ url: URL, readAheadChunkCount: Int = 0) {
         self.url = url
+        self.readAheadChunkCount = readAheadChunkCount
     }
 
     public func read(to delegate: PLYReaderDelegate) {
-        PLYReaderStream().read(url, to: delegate)
+        PLYReaderStream().read(self, to: delegate)
+    }
+
+    // Stops a read in progress, from any thread, once it's done with the current chunk; the delegate is then told
+    // it failed, with CancellationError. (A read within a task also stops when the task is cancelled.)
+    public func cancel() {
+        cancelLock.lock()
+        defer { cancelLock.unlock() }
+        cancelled = true
+    }
+
+    var isCancelled: Bool {
+        cancelLock.lock()
+        defer { cancelLock.unlock() }
+        return cancelled || Task.isCancelled
+    }
+}
+
+// Reads a stream in large chunks on a thread of its own, a bounded number of chunks ahead of the parser
+fileprivate class PLYReadAhead {
+    private let queue: BoundedQueue<Data>
+    private let finished = DispatchSemaphore(value: 0)
+    // Set by the reading thread before it closes the queue
+    private var failed = false
+    private var chunk = Data()
+    private var chunkOffset = 0
+
+    init(_ inputStream: InputStream, chunkCount: Int) {
+        queue = BoundedQueue(capacity: chunkCount, metricName: "ply.readAhead")
+        let thread = Thread { [self] in
+            defer {
+                queue.close()
+                finished.signal()
+            }
+            while true {
+                var data = Data(count: PLYReader.Constants.readAheadChunkSize)
+                let readResult = data.withUnsafeMutableBytes {
+                    inputStream.read($0.bindMemory(to: UInt8.self).baseAddress!, maxLength: $0.count)
+                }
+                if readResult < 0 {
+                    failed = true
+                }
+                guard readResult > 0 else { return }
+                data.count = readResult
+                guard queue.push(data) else { return }
+            }
+        }
+        thread.name = "PLYReader read-ahead"
+        thread.start()
+    }
+
+    // Like InputStream.read(_:maxLength:): the number of bytes read into buffer, 0 at the end, or -1 on error
+    func read(_ buffer: UnsafeMutablePointer<UInt8>, maxLength: Int) -> Int {
+        while chunkOffset == chunk.count {
+            guard let next = queue.pop() else {
+                return failed ? -1 : 0
+            }
+            chunk = next
+            chunkOffset = 0
+        }
+        let count = min(maxLength, chunk.count - chunkOffset)
+        chunk.copyBytes(to: buffer, from: chunkOffset..<(chunkOffset + count))
+        chunkOffset += count
+        return count
+    }
+
+    // Stops the reading thread, waiting until it's no longer using the stream
+    func stop() {
+        queue.cancel()
+        finished.wait()
     }
 }
 
@@ -75,18 +169,32 @@ fileprivate class PLYReaderStream {
     private var currentElementCountInGroup: Int = 0
     private var reusableElement = PLYElement(properties: [])
 
-    public func read(_ url: URL, to delegate: PLYReaderDelegate) {
+    public func read(_ reader: PLYReader, to delegate: PLYReaderDelegate) {
+        let url = reader.url
         header = nil
         body = Data()
         bodyOffset = 0
         currentElementGroup = 0
         currentElementCountInGroup = 0
 
+        let span = PLYReader.Metric.read.begin()
+        let openSpan = PLYReader.Metric.open.begin()
         guard let inputStream = InputStream(url: url) else {
+            openSpan.end()
             delegate.didFailReading(withError: PLYReader.Error.cannotOpenSource)
             return
         }
 
+        let totalBytes = (try? FileManager.default.attributesOfItem(atPath: url.path))?[.size] as? Int
+        var totalBytesRead = 0
+        defer {
+            let duration = span.end()
+            PLYReader.Metric.bytesRead.increment(by: totalBytesRead)
+            if duration > 0 {
+                PLYReader.Metric.throughput.set(Double(totalBytesRead) / duration)
+            }
+        }
+
         let bufferSize = 8*1024
         let buffer = UnsafeMutablePointer<UInt8>.allocate(capacity: bufferSize)
         defer { buffer.deallocate() }
@@ -94,11 +202,20 @@ fileprivate class PLYReaderStream {
 
         inputStream.open()
         defer { inputStream.close() }
+        let readAhead = reader.readAheadChunkCount > 0 ? PLYReadAhead(inputStream, chunkCount: reader.readAheadChunkCount) : nil
+        defer { readAhead?.stop() }
+        openSpan.end()
+        let headerSpan = PLYReader.Metric.header.begin()
 
         var phase: Phase = .unstarted
 
         while true {
-            let readResult = inputStream.read(buffer, maxLength: bufferSize)
+            if reader.isCancelled {
+                delegate.didFailReading(withError: CancellationError())
+                return
+            }
+
+            let readResult = readAhead?.read(buffer, maxLength: bufferSize) ?? inputStream.read(buffer, maxLength: bufferSize)
             let bytesRead: Int
             switch readResult {
             case -1:
@@ -125,6 +242,8 @@ fileprivate class PLYReaderStream {
                 return
             default:
                 bytesRead = readResult
+                totalBytesRead += readResult
+                delegate.didReadBytes(totalBytesRead, of: totalBytes)
             }
 
             var bufferIndex = 0
@@ -151,6 +270,7 @@ fileprivate class PLYReaderStream {
                             let header = try parseHeader(headerData)
                             self.header = header
                             phase = .body
+                            headerSpan.end()
                             delegate.didStartReading(withHeader: header)
                         } catch {
                             delegate.didFailReading(withError: error)
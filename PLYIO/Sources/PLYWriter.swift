@@ -0,0 +1,272 @@
+import Foundation
+
+// Writes a PLY file as a stream: the header first, then each element in header order. Elements are buffered and
+// flushed in blocks, so arbitrarily large files can be written with constant memory.
+public class PLYWriter {
+    public enum Error: Swift.Error {
+        case cannotOpenDestination
+        case writeError
+        case headerAlreadyWritten
+        case headerNotWritten
+        case unexpectedElement
+        case elementPropertyCountMismatch(PLYHeader.Element, Int)
+        case elementPropertyTypeMismatch(PLYHeader.Element, PLYHeader.Property)
+        case listCountOutOfRange(PLYHeader.Element, PLYHeader.Property)
+        case missingElements
+        case alreadyClosed
+    }
+
+    fileprivate enum Constants {
+        static let headerEndToken = "end_header\n"
+        // Flush once this much has been buffered
+        static let bufferSizeForFlush = 64*1024
+    }
+
+    private let outputStream: OutputStream
+    private var header: PLYHeader?
+    private var buffer = Data()
+    private var currentElementGroup = 0
+    private var currentElementCountInGroup = 0
+    private var closed = false
+
+    public convenience init(_ url: URL) throws {
+        guard let outputStream = OutputStream(url: url, append: false) else {
+            throw Error.cannotOpenDestination
+        }
+        self.init(outputStream)
+    }
+
+    // The stream is opened here, and closed by close()
+    public init(_ outputStream: OutputStream) {
+        self.outputStream = outputStream
+        outputStream.open()
+        buffer.reserveCapacity(Constants.bufferSizeForFlush * 2)
+    }
+
+    deinit {
+        if !closed {
+            outputStream.close()
+        }
+    }
+
+    public func write(_ header: PLYHeader) throws {
+        guard !closed else { throw Error.alreadyClosed }
+        guard self.header == nil else { throw Error.headerAlreadyWritten }
+        self.header = header
+        buffer.append(contentsOf: "\(header)\(Constants.headerEndToken)".utf8)
+        skipEmptyElementGroups()
+        try flushIfNeeded()
+    }
+
+    // Elements must be written in the order given by the header: all of the first element type, then all of the
+    // second, and so on
+    public func write(_ element: PLYElement) throws {
+        guard !closed else { throw Error.alreadyClosed }
+        guard let header else { throw Error.headerNotWritten }
+        guard currentElementGroup < header.elements.count else { throw Error.unexpectedElement }
+
+        let elementHeader = header.elements[currentElementGroup]
+        guard element.properties.count == elementHeader.properties.count else {
+            throw Error.elementPropertyCountMismatch(elementHeader, element.properties.count)
+        }
+        switch header.format {
+        case .ascii:
+            for (i, (property, propertyHeader)) in zip(element.properties, elementHeader.properties).enumerated() {
+                if i > 0 {
+                    buffer.append(UInt8(ascii: " "))
+                }
+                try property.appendASCII(to: &buffer, type: propertyHeader.type, elementHeader: elementHeader, propertyHeader: propertyHeader)
+            }
+            buffer.append(UInt8(ascii: "\n"))
+        case .binaryLittleEndian, .binaryBigEndian:
+            let bigEndian = header.format == .binaryBigEndian
+            for (property, propertyHeader) in zip(element.properties, elementHeader.properties) {
+                try property.appendBinary(to: &buffer, type: propertyHeader.type, bigEndian: bigEndian, elementHeader: elementHeader, propertyHeader: propertyHeader)
+            }
+        }
+
+        currentElementCountInGroup += 1
+        skipEmptyElementGroups()
+        try flushIfNeeded()
+    }
+
+    // Flushes and closes the stream; fails if fewer elements were written than the header promised
+    public func close() throws {
+        guard !closed else { return }
+        defer {
+            outputStream.close()
+            closed = true
+        }
+        try flush()
+        guard let header, currentElementGroup == header.elements.count else {
+            throw Error.missingElements
+        }
+    }
+
+    private func skipEmptyElementGroups() {
+        guard let header else { return }
+        while currentElementGroup < header.elements.count && currentElementCountInGroup == header.elements[currentElementGroup].count {
+            currentElementGroup += 1
+            currentElementCountInGroup = 0
+        }
+    }
+
+    private func flushIfNeeded() throws {
+        if buffer.count >= Constants.bufferSizeForFlush {
+            try flush()
+        }
+    }
+
+    private func flush() throws {
+        try buffer.withUnsafeBytes { (bytes: UnsafeRawBufferPointer) in
+            guard let base = bytes.bindMemory(to: UInt8.self).baseAddress else { return }
+            var offset = 0
+            while offset < bytes.count {
+                let written = outputStream.write(base + offset, maxLength: bytes.count - offset)
+                guard written > 0 else { throw Error.writeError }
+                offset += written
+            }
+        }
+        buffer.removeAll(keepingCapacity: true)
+    }
+}
+
+fileprivate extension Data {
+    mutating func append<T: FixedWidthInteger>(integer value: T, bigEndian: Bool) {
+        withUnsafeBytes(of: bigEndian ? value.bigEndian : value.littleEndian) { append(contentsOf: $0) }
+    }
+}
+
+fileprivate extension PLYHeader.PrimitivePropertyType {
+    func fits(count: Int) -> Bool {
+        switch self {
+        case .int8: Int8(exactly: count) != nil
+        case .uint8: UInt8(exactly: count) != nil
+        case .int16: Int16(exactly: count) != nil
+        case .uint16: UInt16(exactly: count) != nil
+        case .int32: Int32(exactly: count) != nil
+        case .uint32: UInt32(exactly: count) != nil
+        case .float32, .float64: false
+        }
+    }
+
+    // Appends a list count, converted to this (integer) type; assumes fits(count:)
+    func appendCount(_ count: Int, to data: inout Data, bigEndian: Bool) {
+        switch self {
+        case .int8: data.append(integer: Int8(count), bigEndian: bigEndian)
+        case .uint8: data.append(integer: UInt8(count), bigEndian: bigEndian)
+        case .int16: data.append(integer: Int16(count), bigEndian: bigEndian)
+        case .uint16: data.append(integer: UInt16(count), bigEndian: bigEndian)
+        case .int32: data.append(integer: Int32(count), bigEndian: bigEndian)
+        case .uint32: data.append(integer: UInt32(count), bigEndian: bigEndian)
+        case .float32, .float64: preconditionFailure("List counts must be integers")
+        }
+    }
+}
+
+fileprivate extension PLYElement.Property {
+    var listCount: Int? {
+        switch self {
+        case .int8, .uint8, .int16, .uint16, .int32, .uint32, .float32, .float64: nil
+        case .listInt8(let values): values.count
+        case .listUInt8(let values): values.count
+        case .listInt16(let values): values.count
+        case .listUInt16(let values): values.count
+        case .listInt32(let values): values.count
+        case .listUInt32(let values): values.count
+        case .listFloat32(let values): values.count
+        case .listFloat64(let values): values.count
+        }
+    }
+
+    // Whether this value can be written as a property of the given type
+    func matches(_ type: PLYHeader.PropertyType) -> Bool {
+        switch (self, type) {
+        case (.int8, .primitive(.int8)),
+             (.uint8, .primitive(.uint8)),
+             (.int16, .primitive(.int16)),
+             (.uint16, .primitive(.uint16)),
+             (.int32, .primitive(.int32)),
+             (.uint32, .primitive(.uint32)),
+             (.float32, .primitive(.float32)),
+             (.float64, .primitive(.float64)),
+             (.listInt8, .list(_, .int8)),
+             (.listUInt8, .list(_, .uint8)),
+             (.listInt16, .list(_, .int16)),
+             (.listUInt16, .list(_, .uint16)),
+             (.listInt32, .list(_, .int32)),
+             (.listUInt32, .list(_, .uint32)),
+             (.listFloat32, .list(_, .float32)),
+             (.listFloat64, .list(_, .float64)):
+            true
+        default:
+            false
+        }
+    }
+
+    func appendBinary(to data: inout Data,
+                      type: PLYHeader.PropertyType,
+                      bigEndian: Bool,
+                      elementHeader: PLYHeader.Element,
+                      propertyHeader: PLYHeader.Property) throws {
+        guard matches(type) else { throw PLYWriter.Error.elementPropertyTypeMismatch(elementHeader, propertyHeader) }
+        if case .list(let countType, _) = type, let listCount {
+            guard countType.fits(count: listCount) else {
+                throw PLYWriter.Error.listCountOutOfRange(elementHeader, propertyHeader)
+            }
+            countType.appendCount(listCount, to: &data, bigEndian: bigEndian)
+        }
+
+        switch self {
+        case .int8(let value): data.append(integer: value, bigEndian: bigEndian)
+        case .uint8(let value): data.append(integer: value, bigEndian: bigEndian)
+        case .int16(let value): data.append(integer: value, bigEndian: bigEndian)
+        case .uint16(let value): data.append(integer: value, bigEndian: bigEndian)
+        case .int32(let value): data.append(integer: value, bigEndian: bigEndian)
+        case .uint32(let value): data.append(integer: value, bigEndian: bigEndian)
+        case .float32(let value): data.append(integer: value.bitPattern, bigEndian: bigEndian)
+        case .float64(let value): data.append(integer: value.bitPattern, bigEndian: bigEndian)
+        case .listInt8(let values): for value in values { data.append(integer: value, bigEndian: bigEndian) }
+        case .listUInt8(let values): for value in values { data.append(integer: value, bigEndian: bigEndian) }
+        case .listInt16(let values): for value in values { data.append(integer: value, bigEndian: bigEndian) }
+        case .listUInt16(let values): for value in values { data.append(integer: value, bigEndian: bigEndian) }
+        case .listInt32(let values): for value in values { data.append(integer: value, bigEndian: bigEndian) }
+        case .listUInt32(let values): for value in values { data.append(integer: value, bigEndian: bigEndian) }
+        case .listFloat32(let values): for value in values { data.append(integer: value.bitPattern, bigEndian: bigEndian) }
+        case .listFloat64(let values): for value in values { data.append(integer: value.bitPattern, bigEndian: bigEndian) }
+        }
+    }
+
+    func appendASCII(to data: inout Data,
+                     type: PLYHeader.PropertyType,
+                     elementHeader: PLYHeader.Element,
+                     propertyHeader: PLYHeader.Property) throws {
+        guard matches(type) else { throw PLYWriter.Error.elementPropertyTypeMismatch(elementHeader, propertyHeader) }
+        if case .list(let countType, _) = type, let listCount {
+            guard countType.fits(count: listCount) else {
+                throw PLYWriter.Error.listCountOutOfRange(elementHeader, propertyHeader)
+            }
+        }
+
+        // Swift's descriptions of numbers are the shortest strings which parse back to the same value
+        let strings: [String] = switch self {
+        case .int8(let value): [ value.description ]
+        case .uint8(let value): [ value.description ]
+        case .int16(let value): [ value.description ]
+        case .uint16(let value): [ value.description ]
+        case .int32(let value): [ value.description ]
+        case .uint32(let value): [ value.description ]
+        case .float32(let value): [ value.description ]
+        case .float64(let value): [ value.description ]
+        case .listInt8(let values): [ values.count.description ] + values.map(\.description)
+        case .listUInt8(let values): [ values.count.description ] + values.map(\.description)
+        case .listInt16(let values): [ values.count.description ] + values.map(\.description)
+        case .listUInt16(let values): [ values.count.description ] + values.map(\.description)
+        case .listInt32(let values): [ values.count.description ] + values.map(\.description)
+        case .listUInt32(let values): [ values.count.description ] + values.map(\.description)
+        case .listFloat32(let values): [ values.count.description ] + values.map(\.description)
+        case .listFloat64(let values): [ values.count.description ] + values.map(\.description)
+        }
+        data.append(contentsOf: strings.joined(separator: " ").utf8)
+    }
+}
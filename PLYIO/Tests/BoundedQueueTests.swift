@@ -0,0 +1,54 @@
+import XCTest
+import PLYIO
+
+final class BoundedQueueTests: XCTestCase {
+    func testCloseDrainsQueue() {
+        let queue = BoundedQueue<Int>(capacity: 4)
+        XCTAssertTrue(queue.push(1))
+        XCTAssertTrue(queue.push(2))
+        queue.close()
+        XCTAssertFalse(queue.push(3))
+        XCTAssertEqual(queue.pop(), 1)
+        XCTAssertEqual(queue.pop(), 2)
+        XCTAssertNil(queue.pop())
+    }
+
+    func testProducerStaysWithinCapacity() {
+        let queue = BoundedQueue<Int>(capacity: 3)
+        let count = 10_000
+        let producer = Thread {
+            for i in 0..<count {
+                queue.push(i)
+            }
+            queue.close()
+        }
+        producer.start()
+
+        var popped: [Int] = []
+        while let value = queue.pop() {
+            XCTAssertLessThanOrEqual(queue.count, queue.capacity)
+            popped.append(value)
+        }
+        XCTAssertEqual(popped, Array(0..<count))
+    }
+
+    func testCancelStopsProducer() {
+        let queue = BoundedQueue<Int>(capacity: 2)
+        let stopped = expectation(description: "producer stopped")
+        let producer = Thread {
+            var i = 0
+            while queue.push(i) {
+                i += 1
+            }
+            stopped.fulfill()
+        }
+        producer.start()
+
+        XCTAssertEqual(queue.pop(), 0)
+        XCTAssertEqual(queue.pop(), 1)
+        queue.cancel()
+        wait(for: [ stopped ], timeout: 10)
+        XCTAssertNil(queue.pop())
+        XCTAssertEqual(queue.count, 0)
+    }
+}
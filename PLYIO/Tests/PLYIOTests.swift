@@ -101,6 +101,73 @@ final class PLYIOTests: XCTestCase {
         try testEqual(asciiURL, binaryURL)
     }
 
+    func testReadAheadEqual() throws {
+        for url in [ asciiURL, binaryURL ] {
+            let direct = ContentStorage()
+            PLYReader(url).read(to: direct)
+            let readAhead = ContentStorage()
+            PLYReader(url, readAheadChunkCount: 2).read(to: readAhead)
+            XCTAssertTrue(readAhead.didFinish)
+            ContentStorage.testApproximatelyEqual(lhs: direct, rhs: readAhead)
+        }
+    }
+
+    func testCancel() throws {
+        for readAheadChunkCount in [ 0, 2 ] {
+            let reader = PLYReader(binaryURL, readAheadChunkCount: readAheadChunkCount)
+            reader.cancel()
+            let content = ContentCounter()
+            reader.read(to: content)
+            XCTAssertTrue(content.didFail)
+            XCTAssertFalse(content.didFinish)
+            XCTAssertNil(content.header)
+        }
+    }
+
+    func testWriteRoundTrip() throws {
+        let original = ContentStorage()
+        PLYReader(binaryURL).read(to: original)
+        let header = try XCTUnwrap(original.header)
+
+        for format in [ PLYHeader.Format.ascii, .binaryLittleEndian, .binaryBigEndian ] {
+            let url = FileManager.default.temporaryDirectory.appendingPathComponent("PLYIOTests-\(format.rawValue).ply")
+            defer { try? FileManager.default.removeItem(at: url) }
+
+            var writtenHeader = header
+            writtenHeader.format = format
+            let writer = try PLYWriter(url)
+            try writer.write(writtenHeader)
+            for elements in original.elements {
+                for element in elements {
+                    try writer.write(element)
+                }
+            }
+            try writer.close()
+
+            let roundTripped = ContentStorage()
+            PLYReader(url).read(to: roundTripped)
+            XCTAssertTrue(roundTripped.didFinish)
+            XCTAssertEqual(roundTripped.header?.format, format)
+            ContentStorage.testApproximatelyEqual(lhs: original, rhs: roundTripped)
+        }
+    }
+
+    func testWriteRejectsMismatchedElements() throws {
+        let url = FileManager.default.temporaryDirectory.appendingPathComponent("PLYIOTests-mismatched.ply")
+        defer { try? FileManager.default.removeItem(at: url) }
+
+        let header = PLYHeader(format: .binaryLittleEndian, version: "1.0", elements: [
+            PLYHeader.Element(name: "vertex", count: 2, properties: [ PLYHeader.Property(name: "x", type: .primitive(.float32)) ])
+        ])
+        let writer = try PLYWriter(url)
+        XCTAssertThrowsError(try writer.write(PLYElement(properties: [ .float32(1) ])))
+        try writer.write(header)
+        XCTAssertThrowsError(try writer.write(PLYElement(properties: [ .float64(1) ])))
+        XCTAssertThrowsError(try writer.write(PLYElement(properties: [ .float32(1), .float32(2) ])))
+        try writer.write(PLYElement(properties: [ .float32(1) ]))
+        XCTAssertThrowsError(try writer.close())
+    }
+
     func testEqual(_ urlA: URL, _ urlB: URL) throws {
         let readerA = PLYReader(urlA)
         let contentA = ContentStorage()
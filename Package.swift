@@ -10,6 +10,10 @@ let package = Package(
         .visionOS(.v1),
     ],
     products: [
+        .library(
+            name: "SplatMetrics",
+            targets: [ "SplatMetrics" ]
+        ),
         .library(
             name: "PLYIO",
             targets: [ "PLYIO" ]
@@ -18,6 +22,18 @@ let package = Package(
             name: "SplatIO",
             targets: [ "SplatIO" ]
         ),
+        .library(
+            name: "SplatKNN",
+            targets: [ "SplatKNN" ]
+        ),
+        .library(
+            name: "SplatGenerator",
+            targets: [ "SplatGenerator" ]
+        ),
+        .library(
+            name: "SplatCompute",
+            targets: [ "SplatCompute" ]
+        ),
         .library(
             name: "MetalSplatter",
             targets: [ "MetalSplatter" ]
@@ -28,8 +44,20 @@ let package = Package(
         ),
     ],
     targets: [
+        .target(
+            name: "SplatMetrics",
+            path: "SplatMetrics",
+            sources: [ "Sources" ]
+        ),
+        .testTarget(
+            name: "SplatMetricsTests",
+            dependencies: [ "SplatMetrics" ],
+            path: "SplatMetrics",
+            sources: [ "Tests" ]
+        ),
         .target(
             name: "PLYIO",
+            dependencies: [ "SplatMetrics" ],
             path: "PLYIO",
             sources: [ "Sources" ]
         ),
@@ -42,7 +70,7 @@ let package = Package(
         ),
         .target(
             name: "SplatIO",
-            dependencies: [ "PLYIO" ],
+            dependencies: [ "PLYIO", "SplatKNN", "SplatMetrics" ],
             path: "SplatIO",
             sources: [ "Sources" ]
         ),
@@ -53,9 +81,43 @@ let package = Package(
             sources: [ "Tests" ],
             resources: [ .copy("TestData") ]
         ),
+        .target(
+            name: "SplatKNN",
+            path: "SplatKNN",
+            sources: [ "Sources" ]
+        ),
+        .testTarget(
+            name: "SplatKNNTests",
+            dependencies: [ "SplatKNN" ],
+            path: "SplatKNN",
+            sources: [ "Tests" ]
+        ),
+        .target(
+            name: "SplatCompute",
+            path: "SplatCompute",
+            sources: [ "Sources" ]
+        ),
+        .testTarget(
+            name: "SplatComputeTests",
+            dependencies: [ "SplatCompute" ],
+            path: "SplatCompute",
+            sources: [ "Tests" ]
+        ),
+        .target(
+            name: "SplatGenerator",
+            dependencies: [ "PLYIO", "SplatCompute" ],
+            path: "SplatGenerator",
+            sources: [ "Sources" ]
+        ),
+        .testTarget(
+            name: "SplatGeneratorTests",
+            dependencies: [ "SplatGenerator", "PLYIO", "SplatCompute" ],
+            path: "SplatGenerator",
+            sources: [ "Tests" ]
+        ),
         .target(
             name: "MetalSplatter",
-            dependencies: [ "PLYIO", "SplatIO" ],
+            dependencies: [ "PLYIO", "SplatIO", "SplatCompute", "SplatMetrics" ],
             path: "MetalSplatter",
             sources: [ "Sources" ],
             resources: [ .process("Resources") ]
@@ -66,5 +128,39 @@ let package = Package(
             sources: [ "Sources" ],
             resources: [ .process("Resources") ]
         ),
+        .target(
+            name: "BenchmarkSupport",
+            path: "Benchmarks/BenchmarkSupport"
+        ),
+        .executableTarget(
+            name: "KNNBenchmark",
+            dependencies: [ "SplatGenerator", "SplatKNN" ],
+            path: "Benchmarks/KNNBenchmark"
+        ),
+        .executableTarget(
+            name: "PLYBenchmark",
+            dependencies: [ "PLYIO", "SplatGenerator" ],
+            path: "Benchmarks/PLYBenchmark"
+        ),
+        .executableTarget(
+            name: "SortBenchmark",
+            dependencies: [ "BenchmarkSupport", "PLYIO", "SplatCompute", "SplatGenerator" ],
+            path: "Benchmarks/SortBenchmark"
+        ),
+        .executableTarget(
+            name: "FirstFrameBenchmark",
+            dependencies: [ "BenchmarkSupport", "PLYIO", "SplatCompute", "SplatGenerator", "SplatMetrics" ],
+            path: "Benchmarks/FirstFrameBenchmark"
+        ),
+        .executableTarget(
+            name: "PickBenchmark",
+            dependencies: [ "BenchmarkSupport", "SplatCompute", "SplatGenerator" ],
+            path: "Benchmarks/PickBenchmark"
+        ),
+        .executableTarget(
+            name: "TrajectoryReplay",
+            dependencies: [ "BenchmarkSupport", "SplatCompute", "SplatGenerator" ],
+            path: "Benchmarks/TrajectoryReplay"
+        ),
     ]
 )
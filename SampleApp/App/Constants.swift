@@ -9,5 +9,13 @@ enum Constants {
     static let fovy = Angle(degrees: 65)
 #endif
     static let modelCenterZ: Float = -8
+
+    // Set CAMERA_TRAJECTORY_RECORD to a file path in the scheme's environment to record every frame's cameras there
+    // (see CameraTrajectory), or CAMERA_TRAJECTORY_REPLAY to draw a recording's cameras, one per frame and looping,
+    // instead of the automatic rotation
+    static let cameraTrajectoryRecordURL = ProcessInfo.processInfo.environment["CAMERA_TRAJECTORY_RECORD"].map { URL(fileURLWithPath: $0) }
+    static let cameraTrajectoryReplayURL = ProcessInfo.processInfo.environment["CAMERA_TRAJECTORY_REPLAY"].map { URL(fileURLWithPath: $0) }
+    // Rewrite the recording every this many frames, since the app has no clean point at which to save it
+    static let cameraTrajectorySaveInterval = 300
 }
 
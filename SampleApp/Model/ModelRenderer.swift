@@ -4,6 +4,6 @@ import simd
 
 public protocol ModelRenderer {
     typealias CameraMatrices = ( projection: simd_float4x4, view: simd_float4x4 )
-    func willRender(viewportCameras: [CameraMatrices])
+    func willRender(viewportCameras: [CameraMatrices], commandBuffer: MTLCommandBuffer)
     func render(viewportCameras: [CameraMatrices], to renderEncoder: MTLRenderCommandEncoder)
 }
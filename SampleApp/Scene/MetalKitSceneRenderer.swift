@@ -3,17 +3,25 @@
 import Metal
 import MetalKit
 import MetalSplatter
+import os
 import SampleBoxRenderer
 import simd
+import SplatCompute
 import SwiftUI
 
 class MetalKitSceneRenderer: NSObject, MTKViewDelegate {
+    private static let log =
+        Logger(subsystem: Bundle.main.bundleIdentifier!,
+               category: "MetalKitSceneRenderer")
+
     let metalKitView: MTKView
     let device: MTLDevice
     let commandQueue: MTLCommandQueue
 
     var model: ModelIdentifier?
     var modelRenderer: (any ModelRenderer)?
+    // Reading the current model, if it's still loading
+    var loadTask: Task<Void, Never>?
 
     let inFlightSemaphore = DispatchSemaphore(value: Constants.maxSimultaneousRenders)
 
@@ -22,6 +30,11 @@ class MetalKitSceneRenderer: NSObject, MTKViewDelegate {
 
     var drawableSize: CGSize = .zero
 
+    let trajectoryRecorder = Constants.cameraTrajectoryRecordURL.map { _ in CameraTrajectoryRecorder() }
+    let trajectoryPlayer = MetalKitSceneRenderer.loadTrajectoryPlayer()
+    // Saves run one at a time, in order, so an older snapshot never overwrites a newer one
+    let trajectorySaveQueue = DispatchQueue(label: "MetalKitSceneRenderer.trajectorySave", qos: .utility)
+
     init?(_ metalKitView: MTKView) {
         self.device = metalKitView.device!
         guard let queue = self.device.makeCommandQueue() else { return nil }
@@ -39,6 +52,8 @@ class MetalKitSceneRenderer: NSObject, MTKViewDelegate {
         guard model != self.model else { return }
         self.model = model
 
+        loadTask?.cancel()
+        loadTask = nil
         modelRenderer = nil
         switch model {
         case .gaussianSplat(let url):
@@ -49,8 +64,21 @@ class MetalKitSceneRenderer: NSObject, MTKViewDelegate {
                                            sampleCount: metalKitView.sampleCount,
                                            maxViewCount: 1,
                                            maxSimultaneousRenders: Constants.maxSimultaneousRenders)
-            splat.readPLY(from: url)
-            modelRenderer = splat
+            splat.qualityGovernor = QualityGovernor()
+            // Read off the main thread, and only draw once the whole model is in
+            loadTask = Task { @MainActor in
+                do {
+                    try await splat.load(plyFrom: url)
+                } catch is CancellationError {
+                    return
+                } catch {
+                    Self.log.error("Failed to load \(url): \(error)")
+                    return
+                }
+                guard self.model == model else { return }
+                self.modelRenderer = splat
+                self.loadTask = nil
+            }
         case .sampleBox:
             modelRenderer = try! SampleBoxRenderer(device: device,
                                                    colorFormat: metalKitView.colorPixelFormat,
@@ -91,6 +119,33 @@ class MetalKitSceneRenderer: NSObject, MTKViewDelegate {
         rotation += Constants.rotationPerSecond * now.timeIntervalSince(lastRotationUpdateTimestamp)
     }
 
+    // The trajectory to replay, if one's set and was recorded with one camera per frame, as this view draws
+    private static func loadTrajectoryPlayer() -> CameraTrajectoryPlayer? {
+        guard let url = Constants.cameraTrajectoryReplayURL else { return nil }
+        do {
+            let trajectory = try CameraTrajectory(contentsOf: url)
+            guard trajectory.frames.allSatisfy({ $0.cameras.count == 1 }) else {
+                log.error("Not replaying \(url): it wasn't recorded with one camera per frame, and this view draws one")
+                return nil
+            }
+            return CameraTrajectoryPlayer(trajectory, loops: true)
+        } catch {
+            log.error("Failed to load camera trajectory \(url): \(error)")
+            return nil
+        }
+    }
+
+    private func recordTrajectory(_ viewportCameras: [ModelRenderer.CameraMatrices], at time: TimeInterval) {
+        guard let trajectoryRecorder, let url = Constants.cameraTrajectoryRecordURL else { return }
+        trajectoryRecorder.record(viewportCameras, at: time)
+        if trajectoryRecorder.frameCount % Constants.cameraTrajectorySaveInterval == 0 {
+            let trajectory = trajectoryRecorder.trajectory
+            trajectorySaveQueue.async {
+                try? trajectory.write(to: url)
+            }
+        }
+    }
+
     func draw(in view: MTKView) {
         guard let modelRenderer else { return }
 
@@ -102,20 +157,25 @@ class MetalKitSceneRenderer: NSObject, MTKViewDelegate {
         }
 
         let semaphore = inFlightSemaphore
+        let qualityGovernor = (modelRenderer as? SplatRenderer)?.qualityGovernor
         commandBuffer.addCompletedHandler { (_ commandBuffer)-> Swift.Void in
+            qualityGovernor?.recordFrame(duration: commandBuffer.gpuEndTime - commandBuffer.gpuStartTime)
             semaphore.signal()
         }
 
         updateRotation()
 
-        modelRenderer.willRender(viewportCameras: [viewportCamera])
+        let viewportCameras = trajectoryPlayer?.nextFrame()?.cameras ?? [ viewportCamera ]
+        recordTrajectory(viewportCameras, at: ProcessInfo.processInfo.systemUptime)
+
+        modelRenderer.willRender(viewportCameras: viewportCameras, commandBuffer: commandBuffer)
 
         let renderPassDescriptor = view.currentRenderPassDescriptor
 
         if let renderPassDescriptor = renderPassDescriptor,
            let renderEncoder = commandBuffer.makeRenderCommandEncoder(descriptor: renderPassDescriptor) {
 
-            modelRenderer.render(viewportCameras: [viewportCamera], to: renderEncoder)
+            modelRenderer.render(viewportCameras: viewportCameras, to: renderEncoder)
 
             renderEncoder.endEncoding()
 
@@ -7,6 +7,7 @@ import os
 import SampleBoxRenderer
 import simd
 import Spatial
+import SplatCompute
 import SwiftUI
 
 extension LayerRenderer.Clock.Instant.Duration {
@@ -27,6 +28,8 @@ class VisionSceneRenderer {
 
     var model: ModelIdentifier?
     var modelRenderer: (any ModelRenderer)?
+    // Reading the current model, if it's still loading
+    var loadTask: Task<Void, Never>?
 
     let inFlightSemaphore = DispatchSemaphore(value: Constants.maxSimultaneousRenders)
 
@@ -36,6 +39,12 @@ class VisionSceneRenderer {
     let arSession: ARKitSession
     let worldTracking: WorldTrackingProvider
 
+    let trajectoryRecorder = Constants.cameraTrajectoryRecordURL.map { _ in CameraTrajectoryRecorder() }
+    // Dropped if the trajectory's camera count turns out not to match the drawable's view count
+    var trajectoryPlayer = VisionSceneRenderer.loadTrajectoryPlayer()
+    // Saves run one at a time, in order, so an older snapshot never overwrites a newer one
+    let trajectorySaveQueue = DispatchQueue(label: "VisionSceneRenderer.trajectorySave", qos: .utility)
+
     init(_ layerRenderer: LayerRenderer) {
         self.layerRenderer = layerRenderer
         self.device = layerRenderer.device
@@ -49,6 +58,8 @@ class VisionSceneRenderer {
         guard model != self.model else { return }
         self.model = model
 
+        loadTask?.cancel()
+        loadTask = nil
         modelRenderer = nil
         switch model {
         case .gaussianSplat(let url):
@@ -59,8 +70,20 @@ class VisionSceneRenderer {
                                            sampleCount: 1,
                                            maxViewCount: layerRenderer.properties.viewCount,
                                            maxSimultaneousRenders: Constants.maxSimultaneousRenders)
-            splat.readPLY(from: url)
-            modelRenderer = splat
+            // Read off the main thread, and only draw once the whole model is in
+            loadTask = Task { @MainActor in
+                do {
+                    try await splat.load(plyFrom: url)
+                } catch is CancellationError {
+                    return
+                } catch {
+                    Self.log.error("Failed to load \(url): \(error)")
+                    return
+                }
+                guard self.model == model else { return }
+                self.modelRenderer = splat
+                self.loadTask = nil
+            }
         case .sampleBox:
             modelRenderer = try! SampleBoxRenderer(device: device,
                                                    colorFormat: layerRenderer.configuration.colorFormat,
@@ -124,6 +147,40 @@ class VisionSceneRenderer {
         rotation += Constants.rotationPerSecond * now.timeIntervalSince(lastRotationUpdateTimestamp)
     }
 
+    private static func loadTrajectoryPlayer() -> CameraTrajectoryPlayer? {
+        guard let url = Constants.cameraTrajectoryReplayURL else { return nil }
+        do {
+            return CameraTrajectoryPlayer(try CameraTrajectory(contentsOf: url), loops: true)
+        } catch {
+            log.error("Failed to load camera trajectory \(url): \(error)")
+            return nil
+        }
+    }
+
+    // The next replayed frame's cameras, or nil to use the live ones. A trajectory recorded with a different number
+    // of cameras than the drawable has views (one recorded in the MetalKit app, say) would draw the wrong views, so
+    // replay stops at the first such frame.
+    private func replayedCameras(viewCount: Int) -> [ModelRenderer.CameraMatrices]? {
+        guard let frame = trajectoryPlayer?.nextFrame() else { return nil }
+        guard frame.cameras.count == viewCount else {
+            Self.log.error("Stopped replaying the camera trajectory: it has \(frame.cameras.count) cameras per frame, but the drawable has \(viewCount) views")
+            trajectoryPlayer = nil
+            return nil
+        }
+        return frame.cameras
+    }
+
+    private func recordTrajectory(_ viewportCameras: [ModelRenderer.CameraMatrices], at time: TimeInterval) {
+        guard let trajectoryRecorder, let url = Constants.cameraTrajectoryRecordURL else { return }
+        trajectoryRecorder.record(viewportCameras, at: time)
+        if trajectoryRecorder.frameCount % Constants.cameraTrajectorySaveInterval == 0 {
+            let trajectory = trajectoryRecorder.trajectory
+            trajectorySaveQueue.async {
+                try? trajectory.write(to: url)
+            }
+        }
+    }
+
     func renderFrame() {
         guard let frame = layerRenderer.queryNextFrame() else { return }
 
@@ -155,8 +212,9 @@ class VisionSceneRenderer {
 
         updateRotation()
 
-        let viewportCameras = self.viewportCameras(drawable: drawable, deviceAnchor: deviceAnchor)
-        modelRenderer?.willRender(viewportCameras: viewportCameras)
+        let viewportCameras = replayedCameras(viewCount: drawable.views.count) ?? self.viewportCameras(drawable: drawable, deviceAnchor: deviceAnchor)
+        recordTrajectory(viewportCameras, at: time)
+        modelRenderer?.willRender(viewportCameras: viewportCameras, commandBuffer: commandBuffer)
 
         let renderPassDescriptor = MTLRenderPassDescriptor()
         renderPassDescriptor.colorAttachments[0].texture = drawable.colorTextures[0]
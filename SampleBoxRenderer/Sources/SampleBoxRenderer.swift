@@ -127,7 +127,7 @@ public class SampleBoxRenderer {
         }
     }
 
-    public func willRender(viewportCameras: [CameraMatrices]) {}
+    public func willRender(viewportCameras: [CameraMatrices], commandBuffer: MTLCommandBuffer) {}
 
     private func updateDynamicBufferState() {
         uniformBufferIndex = (uniformBufferIndex + 1) % maxSimultaneousRenders
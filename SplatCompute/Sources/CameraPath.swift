@@ -0,0 +1,101 @@
+import Foundation
+#if canImport(simd)
+import simd
+#endif
+
+// A camera position and orientation, without the projection
+public struct CameraPose: Codable, Equatable {
+    public var position: SIMD3<Float>
+    // Normalized
+    public var forward: SIMD3<Float>
+    public var up: SIMD3<Float>
+
+    public init(position: SIMD3<Float>, forward: SIMD3<Float>, up: SIMD3<Float> = SIMD3<Float>(0, 1, 0)) {
+        self.position = position
+        self.forward = forward.normalized
+        self.up = up
+    }
+
+    public init(position: SIMD3<Float>, lookingAt target: SIMD3<Float>, up: SIMD3<Float> = SIMD3<Float>(0, 1, 0)) {
+        self.init(position: position, forward: target - position, up: up)
+    }
+
+    // The pose of a view matrix (right-handed, looking down -z)
+    public init(view: Float4x4) {
+        let inverseView = view.inverse
+        self.init(position: (inverseView * SIMD4<Float>(0, 0, 0, 1)).xyz,
+                  forward: (inverseView * SIMD4<Float>(0, 0, -1, 0)).xyz,
+                  up: (inverseView * SIMD4<Float>(0, 1, 0, 0)).xyz.normalized)
+    }
+
+    // Right-handed look-at view matrix
+    public var view: Float4x4 {
+        let z = -forward
+        let x = up.cross(z).normalized
+        let y = z.cross(x)
+        return Float4x4(columns: (SIMD4<Float>(x.x, y.x, z.x, 0),
+                                  SIMD4<Float>(x.y, y.y, z.y, 0),
+                                  SIMD4<Float>(x.z, y.z, z.z, 0),
+                                  SIMD4<Float>(-x.dot(position), -y.dot(position), -z.dot(position), 1)))
+    }
+}
+
+// A sequence of camera poses at a fixed frame rate, recorded from an app or synthesized, for benchmarks and
+// repeatable tests. Stored as JSON.
+public struct CameraPath: Codable, Equatable {
+    public var framesPerSecond: Double
+    public var poses: [CameraPose]
+
+    public init(framesPerSecond: Double = 60, poses: [CameraPose]) {
+        self.framesPerSecond = framesPerSecond
+        self.poses = poses
+    }
+
+    public init(jsonData: Data) throws {
+        self = try JSONDecoder().decode(CameraPath.self, from: jsonData)
+    }
+
+    public func jsonData() throws -> Data {
+        try JSONEncoder().encode(self)
+    }
+
+    public var duration: TimeInterval {
+        Double(poses.count) / framesPerSecond
+    }
+
+    // Circles the center at the given radius and height above it, looking at it
+    public static func orbit(around center: SIMD3<Float>,
+                             radius: Float,
+                             height: Float = 0,
+                             frameCount: Int,
+                             revolutions: Float = 1) -> CameraPath {
+        CameraPath(poses: (0..<frameCount).map { frame in
+            let angle = 2 * .pi * revolutions * Float(frame) / Float(max(frameCount, 1))
+            let position = center + SIMD3<Float>(radius * sin(angle), height, radius * cos(angle))
+            return CameraPose(position: position, lookingAt: center)
+        })
+    }
+
+    // Moves in a straight line through the bounds, from the middle of one end to the other, looking ahead and
+    // weaving gently from side to side
+    public static func walkThrough(_ bounds: Bounds, frameCount: Int) -> CameraPath {
+        let start = SIMD3<Float>(bounds.center.x, bounds.center.y, bounds.max.z)
+        let end = SIMD3<Float>(bounds.center.x, bounds.center.y, bounds.min.z)
+        return CameraPath(poses: (0..<frameCount).map { frame in
+            let t = Float(frame) / Float(max(frameCount - 1, 1))
+            let sway = 0.3 * sin(4 * .pi * t)
+            let position = start + (end - start) * t
+            return CameraPose(position: position, forward: SIMD3<Float>(sin(sway), 0, -cos(sway)))
+        })
+    }
+
+    // Stays put and turns quickly, the worst case for reusing the previous frame's order
+    public static func fastPan(from position: SIMD3<Float>,
+                               frameCount: Int,
+                               degreesPerFrame: Float = 6) -> CameraPath {
+        CameraPath(poses: (0..<frameCount).map { frame in
+            let angle = Float(frame) * degreesPerFrame * .pi / 180
+            return CameraPose(position: position, forward: SIMD3<Float>(-sin(angle), 0, -cos(angle)))
+        })
+    }
+}
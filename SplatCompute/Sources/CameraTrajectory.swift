@@ -0,0 +1,230 @@
+import Foundation
+#if canImport(simd)
+import simd
+#endif
+
+// The cameras a renderer drew each frame with, and when, recorded from an app and replayed by it or by a headless
+// harness, so sort and render performance (and popping) can be compared between builds and devices on identical
+// motion. Unlike CameraPath, frames keep their projections and their own timestamps, and may have several views
+// (one per eye on visionOS).
+//
+// Stored in a compact little-endian binary form: the magic "SPCT", a UInt32 version and frame count, then per frame
+// a Float64 timestamp, a UInt32 view count, and per view the projection and view matrices as 16 Float32s each,
+// column-major.
+public struct CameraTrajectory {
+    public enum Error: Swift.Error {
+        case invalidMagic
+        case unsupportedVersion(UInt32)
+        case unexpectedEndOfData
+    }
+
+    public struct Frame {
+        // Seconds since the first frame
+        public var timestamp: TimeInterval
+        // One per viewport
+        public var cameras: [CameraMatrices]
+
+        public init(timestamp: TimeInterval, cameras: [CameraMatrices]) {
+            self.timestamp = timestamp
+            self.cameras = cameras
+        }
+    }
+
+    static let magic: [UInt8] = Array("SPCT".utf8)
+    static let version: UInt32 = 1
+
+    public var frames: [Frame]
+
+    public init(frames: [Frame] = []) {
+        self.frames = frames
+    }
+
+    // A synthesized path, one view per frame, at the path's frame rate
+    public init(_ path: CameraPath, projection: Float4x4) {
+        frames = path.poses.enumerated().map { i, pose in
+            Frame(timestamp: Double(i) / path.framesPerSecond, cameras: [ (projection: projection, view: pose.view) ])
+        }
+    }
+
+    public init(contentsOf url: URL) throws {
+        try self.init(data: Data(contentsOf: url))
+    }
+
+    public init(data: Data) throws {
+        var reader = Reader(bytes: [UInt8](data))
+        guard Array(try reader.read(Self.magic.count)) == Self.magic else {
+            throw Error.invalidMagic
+        }
+        let version = try reader.uint32()
+        guard version == Self.version else {
+            throw Error.unsupportedVersion(version)
+        }
+        let frameCount = Int(try reader.uint32())
+        frames = []
+        frames.reserveCapacity(frameCount)
+        for _ in 0..<frameCount {
+            let timestamp = Double(bitPattern: try reader.uint64())
+            let viewCount = Int(try reader.uint32())
+            var cameras: [CameraMatrices] = []
+            for _ in 0..<viewCount {
+                cameras.append((projection: try reader.matrix(), view: try reader.matrix()))
+            }
+            frames.append(Frame(timestamp: timestamp, cameras: cameras))
+        }
+    }
+
+    public func data() -> Data {
+        var bytes = Self.magic
+        bytes.reserveCapacity(12 + frames.reduce(0) { $0 + 12 + $1.cameras.count * 128 })
+        func append<T: FixedWidthInteger>(_ value: T) {
+            withUnsafeBytes(of: value.littleEndian) { bytes.append(contentsOf: $0) }
+        }
+        func appendMatrix(_ matrix: Float4x4) {
+            for column in [ matrix.columns.0, matrix.columns.1, matrix.columns.2, matrix.columns.3 ] {
+                for i in 0..<4 {
+                    append(column[i].bitPattern)
+                }
+            }
+        }
+
+        append(Self.version)
+        append(UInt32(frames.count))
+        for frame in frames {
+            append(frame.timestamp.bitPattern)
+            append(UInt32(frame.cameras.count))
+            for camera in frame.cameras {
+                appendMatrix(camera.projection)
+                appendMatrix(camera.view)
+            }
+        }
+        return Data(bytes)
+    }
+
+    // Atomically, so a reader (or a crash) never sees a partly written file
+    public func write(to url: URL) throws {
+        try data().write(to: url, options: .atomic)
+    }
+
+    public var duration: TimeInterval {
+        frames.last?.timestamp ?? 0
+    }
+
+    // The frame on screen at the given time since the start: the last one recorded at or before it
+    public func frame(at time: TimeInterval) -> Frame? {
+        var low = 0
+        var high = frames.count
+        while low < high {
+            let middle = (low + high) / 2
+            if frames[middle].timestamp <= time {
+                low = middle + 1
+            } else {
+                high = middle
+            }
+        }
+        return low > 0 ? frames[low - 1] : frames.first
+    }
+
+    // The first view's poses, at the average frame rate, for tools which take a CameraPath
+    public var cameraPath: CameraPath {
+        let framesPerSecond = duration > 0 ? Double(frames.count - 1) / duration : 60
+        return CameraPath(framesPerSecond: framesPerSecond,
+                          poses: frames.compactMap { $0.cameras.first.map { CameraPose(view: $0.view) } })
+    }
+
+    private struct Reader {
+        let bytes: [UInt8]
+        var offset = 0
+
+        mutating func read(_ count: Int) throws -> ArraySlice<UInt8> {
+            guard offset + count <= bytes.count else {
+                throw Error.unexpectedEndOfData
+            }
+            defer { offset += count }
+            return bytes[offset ..< offset + count]
+        }
+
+        mutating func integer<T: FixedWidthInteger>(_ type: T.Type) throws -> T {
+            try read(MemoryLayout<T>.size).reversed().reduce(T(0)) { $0 << 8 | T($1) }
+        }
+
+        mutating func uint32() throws -> UInt32 {
+            try integer(UInt32.self)
+        }
+
+        mutating func uint64() throws -> UInt64 {
+            try integer(UInt64.self)
+        }
+
+        mutating func matrix() throws -> Float4x4 {
+            var columns: [SIMD4<Float>] = []
+            for _ in 0..<4 {
+                columns.append(SIMD4<Float>(Float(bitPattern: try uint32()), Float(bitPattern: try uint32()),
+                                            Float(bitPattern: try uint32()), Float(bitPattern: try uint32())))
+            }
+            return Float4x4(columns: (columns[0], columns[1], columns[2], columns[3]))
+        }
+    }
+}
+
+// Collects a CameraTrajectory from a render loop. Safe to call from any thread.
+public final class CameraTrajectoryRecorder {
+    private let lock = NSLock()
+    private var startTime: TimeInterval?
+    private var frames: [CameraTrajectory.Frame] = []
+
+    public init() {}
+
+    // time is in any monotonic clock's seconds; the first frame recorded is time zero
+    public func record(_ cameras: [CameraMatrices], at time: TimeInterval) {
+        lock.lock()
+        defer { lock.unlock() }
+        let startTime = self.startTime ?? time
+        self.startTime = startTime
+        frames.append(CameraTrajectory.Frame(timestamp: time - startTime, cameras: cameras))
+    }
+
+    public var trajectory: CameraTrajectory {
+        lock.lock()
+        defer { lock.unlock() }
+        return CameraTrajectory(frames: frames)
+    }
+
+    public var frameCount: Int {
+        lock.lock()
+        defer { lock.unlock() }
+        return frames.count
+    }
+}
+
+// Replays a CameraTrajectory one recorded frame per rendered frame, regardless of how long rendering takes, so every
+// run draws exactly the same sequence of cameras. Safe to call from any thread.
+public final class CameraTrajectoryPlayer {
+    public let trajectory: CameraTrajectory
+    public let loops: Bool
+    private let lock = NSLock()
+    private var nextIndex = 0
+
+    public init(_ trajectory: CameraTrajectory, loops: Bool = false) {
+        self.trajectory = trajectory
+        self.loops = loops
+    }
+
+    // The next frame, or nil once a non-looping trajectory has finished
+    public func nextFrame() -> CameraTrajectory.Frame? {
+        lock.lock()
+        defer { lock.unlock() }
+        guard !trajectory.frames.isEmpty else { return nil }
+        if nextIndex == trajectory.frames.count {
+            guard loops else { return nil }
+            nextIndex = 0
+        }
+        defer { nextIndex += 1 }
+        return trajectory.frames[nextIndex]
+    }
+
+    public var isFinished: Bool {
+        lock.lock()
+        defer { lock.unlock() }
+        return !loops && nextIndex == trajectory.frames.count
+    }
+}
@@ -0,0 +1,293 @@
+import Foundation
+
+// Orders splats by depth for blending, with a choice of algorithm. Depth is whatever the caller sorts by (distance
+// along the view direction, or squared distance from the camera); larger is farther. Back to front (the default)
+// puts the farthest first.
+//
+// A sorter keeps its scratch buffers between sorts, so reuse one per stream of frames rather than creating one
+// per sort. It isn't safe to use from more than one thread at a time.
+public final class DepthSorter {
+    public enum Strategy: String, CaseIterable, Codable {
+        // Array.sort on (index, depth) pairs, as SplatRenderer has always done
+        case comparison
+        // Least-significant-digit radix sort on the depth's bits, 8 bits per pass; exact and stable
+        case radix
+        // The radix sort, with each pass's counting and scattering split across cores
+        case parallelRadix
+        // Insertion sort starting from the previous order, which is nearly right when the camera has moved a
+        // little; falls back to the radix sort when that would take too many moves
+        case incremental
+        // One counting pass into bucketCount buckets spanning the depth range. Splats in the same bucket keep their
+        // previous relative order, so this is approximate.
+        case bucketed
+    }
+
+    public struct Accuracy: Equatable {
+        // Adjacent pairs in the wrong order
+        public var inversions: Int
+        public var inversionFraction: Double
+        // The most by which any splat is farther away than one drawn before it (back to front), or nearer (front
+        // to back); zero for an exact sort
+        public var maxDepthError: Float
+    }
+
+    public var strategy: Strategy
+    public var backToFront: Bool
+    // For .bucketed
+    public var bucketCount = 1 << 16
+    // For .incremental: the average number of places each splat may move before it gives up and radix sorts
+    public var incrementalMoveLimit = 4
+    // The class of the work .parallelRadix (and .incremental's fallback) gives SplatExecutor.shared
+    public var priority = SplatExecutor.Priority.frame
+
+    private var keys: [UInt32] = []
+    private var values: [UInt32] = []
+    private var scratchKeys: [UInt32] = []
+    private var scratchValues: [UInt32] = []
+    private var pairs: [(index: UInt32, depth: Float)] = []
+
+    public init(strategy: Strategy, backToFront: Bool = true) {
+        self.strategy = strategy
+        self.backToFront = backToFront
+    }
+
+    // Sorts order, which holds splat indices (all of them, or a subset), by depths[index]. For .incremental and
+    // .bucketed, order should be the result of the previous sort.
+    public func sort(_ order: inout [UInt32], depths: UnsafeBufferPointer<Float>) {
+        guard order.count > 1 else { return }
+        switch strategy {
+        case .comparison:
+            comparisonSort(&order, depths: depths)
+        case .radix:
+            loadKeys(order, depths: depths)
+            radixSort(parallel: false)
+            order = values
+        case .parallelRadix:
+            loadKeys(order, depths: depths)
+            radixSort(parallel: true)
+            order = values
+        case .incremental:
+            loadKeys(order, depths: depths)
+            if !insertionSort(moveLimit: order.count * incrementalMoveLimit) {
+                radixSort(parallel: true)
+            }
+            order = values
+        case .bucketed:
+            bucketSort(&order, depths: depths)
+        }
+    }
+
+    public func sort(_ order: inout [UInt32], depths: [Float]) {
+        depths.withUnsafeBufferPointer { sort(&order, depths: $0) }
+    }
+
+    // Depth along the view direction (or squared distance from the camera) of each position
+    public static func depths(of positions: UnsafeBufferPointer<SIMD3<Float>>,
+                              from pose: CameraPose,
+                              byDistance: Bool = false,
+                              into depths: inout [Float]) {
+        depths.removeAll(keepingCapacity: true)
+        depths.reserveCapacity(positions.count)
+        if byDistance {
+            depths.append(contentsOf: positions.lazy.map { ($0 - pose.position).lengthSquared })
+        } else {
+            depths.append(contentsOf: positions.lazy.map { $0.dot(pose.forward) })
+        }
+    }
+
+    // How far order is from being sorted
+    public static func accuracy(of order: [UInt32], depths: [Float], backToFront: Bool = true) -> Accuracy {
+        guard order.count > 1 else { return Accuracy(inversions: 0, inversionFraction: 0, maxDepthError: 0) }
+        var inversions = 0
+        var maxDepthError: Float = 0
+        // The nearest (back to front) or farthest (front to back) depth drawn so far
+        var extreme = depths[Int(order[0])]
+        for i in 1..<order.count {
+            let previous = depths[Int(order[i - 1])]
+            let depth = depths[Int(order[i])]
+            if backToFront {
+                if depth > previous { inversions += 1 }
+                maxDepthError = max(maxDepthError, depth - extreme)
+                extreme = min(extreme, depth)
+            } else {
+                if depth < previous { inversions += 1 }
+                maxDepthError = max(maxDepthError, extreme - depth)
+                extreme = max(extreme, depth)
+            }
+        }
+        return Accuracy(inversions: inversions,
+                        inversionFraction: Double(inversions) / Double(order.count - 1),
+                        maxDepthError: maxDepthError)
+    }
+
+    // Maps a float to an unsigned integer with the same ordering: flip the sign bit of positives, and every bit of
+    // negatives. Inverted for back to front, so that ascending keys are always the draw order.
+    @inline(__always)
+    private func key(_ depth: Float) -> UInt32 {
+        let bits = depth.bitPattern
+        let key = bits & 0x8000_0000 != 0 ? ~bits : bits | 0x8000_0000
+        return backToFront ? ~key : key
+    }
+
+    private func loadKeys(_ order: [UInt32], depths: UnsafeBufferPointer<Float>) {
+        keys.removeAll(keepingCapacity: true)
+        keys.append(contentsOf: order.lazy.map { self.key(depths[Int($0)]) })
+        values = order
+    }
+
+    private func comparisonSort(_ order: inout [UInt32], depths: UnsafeBufferPointer<Float>) {
+        pairs.removeAll(keepingCapacity: true)
+        pairs.append(contentsOf: order.lazy.map { (index: $0, depth: depths[Int($0)]) })
+        if backToFront {
+            pairs.sort { $0.depth > $1.depth }
+        } else {
+            pairs.sort { $0.depth < $1.depth }
+        }
+        for i in order.indices {
+            order[i] = pairs[i].index
+        }
+    }
+
+    // Sorts keys and values by key
+    private func radixSort(parallel: Bool) {
+        let count = keys.count
+        if scratchKeys.count != count || scratchValues.count != count {
+            scratchKeys = Array(repeating: 0, count: count)
+            scratchValues = Array(repeating: 0, count: count)
+        }
+        let chunkCount = parallel ? max(1, min((SplatExecutor.shared.workerCount + 1) * 4, count / 65536)) : 1
+        let chunkSize = (count + chunkCount - 1) / chunkCount
+        var histograms = [Int](repeating: 0, count: chunkCount * 256)
+        var resultIsInScratch = false
+
+        keys.withUnsafeMutableBufferPointer { keys in
+        values.withUnsafeMutableBufferPointer { values in
+        scratchKeys.withUnsafeMutableBufferPointer { scratchKeys in
+        scratchValues.withUnsafeMutableBufferPointer { scratchValues in
+        histograms.withUnsafeMutableBufferPointer { histograms in
+            var buffers = (keys: keys, values: values, scratchKeys: scratchKeys, scratchValues: scratchValues)
+            for shift in stride(from: 0 as UInt32, to: 32, by: 8) {
+                let (keys, values, scratchKeys, scratchValues) = buffers
+                let histogramsBase = histograms.baseAddress!
+                histogramsBase.initialize(repeating: 0, count: histograms.count)
+
+                forEachChunk(chunkCount: chunkCount, chunkSize: chunkSize, count: count) { chunk, range in
+                    let histogram = histogramsBase + chunk * 256
+                    for i in range {
+                        histogram[Int((keys[i] >> shift) & 0xFF)] += 1
+                    }
+                }
+
+                // A pass where every key has the same digit would leave the order as it is
+                let firstDigit = Int((keys[0] >> shift) & 0xFF)
+                if (0..<chunkCount).reduce(0, { $0 + histograms[$1 * 256 + firstDigit] }) == count {
+                    continue
+                }
+
+                // Turn counts into starting positions: digit-major, then chunk, so the sort stays stable
+                var offset = 0
+                for digit in 0..<256 {
+                    for chunk in 0..<chunkCount {
+                        let digitCount = histograms[chunk * 256 + digit]
+                        histograms[chunk * 256 + digit] = offset
+                        offset += digitCount
+                    }
+                }
+
+                forEachChunk(chunkCount: chunkCount, chunkSize: chunkSize, count: count) { chunk, range in
+                    let offsets = histogramsBase + chunk * 256
+                    for i in range {
+                        let digit = Int((keys[i] >> shift) & 0xFF)
+                        let destination = offsets[digit]
+                        offsets[digit] += 1
+                        scratchKeys[destination] = keys[i]
+                        scratchValues[destination] = values[i]
+                    }
+                }
+
+                buffers = (keys: scratchKeys, values: scratchValues, scratchKeys: keys, scratchValues: values)
+                resultIsInScratch.toggle()
+            }
+        }
+        }
+        }
+        }
+        }
+
+        if resultIsInScratch {
+            swap(&keys, &scratchKeys)
+            swap(&values, &scratchValues)
+        }
+    }
+
+    private func forEachChunk(chunkCount: Int, chunkSize: Int, count: Int, _ body: (Int, Range<Int>) -> Void) {
+        SplatExecutor.shared.parallelFor(iterations: chunkCount, priority: priority) { chunk in
+            body(chunk, chunk * chunkSize ..< min(count, (chunk + 1) * chunkSize))
+        }
+    }
+
+    // Sorts keys and values by key if it takes no more than moveLimit moves; returns false (leaving a valid, partly
+    // sorted permutation) otherwise
+    private func insertionSort(moveLimit: Int) -> Bool {
+        var moves = 0
+        return keys.withUnsafeMutableBufferPointer { keys in
+            values.withUnsafeMutableBufferPointer { values in
+                for i in 1..<keys.count {
+                    let key = keys[i]
+                    let value = values[i]
+                    var j = i
+                    while j > 0 && keys[j - 1] > key {
+                        keys[j] = keys[j - 1]
+                        values[j] = values[j - 1]
+                        j -= 1
+                    }
+                    keys[j] = key
+                    values[j] = value
+                    moves += i - j
+                    if moves > moveLimit {
+                        return false
+                    }
+                }
+                return true
+            }
+        }
+    }
+
+    private func bucketSort(_ order: inout [UInt32], depths: UnsafeBufferPointer<Float>) {
+        var minDepth = Float.infinity
+        var maxDepth = -Float.infinity
+        for index in order {
+            let depth = depths[Int(index)]
+            minDepth = min(minDepth, depth)
+            maxDepth = max(maxDepth, depth)
+        }
+        guard maxDepth > minDepth else { return }
+
+        let bucketCount = self.bucketCount
+        let scale = Float(bucketCount) / (maxDepth - minDepth)
+        let backToFront = self.backToFront
+        func bucketIndex(of index: UInt32) -> Int {
+            let bucket = min(bucketCount - 1, Int((depths[Int(index)] - minDepth) * scale))
+            return backToFront ? bucketCount - 1 - bucket : bucket
+        }
+
+        var offsets = [Int](repeating: 0, count: bucketCount)
+        for index in order {
+            offsets[bucketIndex(of: index)] += 1
+        }
+        var offset = 0
+        for i in 0..<bucketCount {
+            let bucketSize = offsets[i]
+            offsets[i] = offset
+            offset += bucketSize
+        }
+        scratchValues.removeAll(keepingCapacity: true)
+        scratchValues.append(contentsOf: repeatElement(0, count: order.count))
+        for index in order {
+            let bucket = bucketIndex(of: index)
+            scratchValues[offsets[bucket]] = index
+            offsets[bucket] += 1
+        }
+        swap(&order, &scratchValues)
+    }
+}
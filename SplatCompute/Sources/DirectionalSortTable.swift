@@ -0,0 +1,226 @@
+import Foundation
+
+// Depth orders of a scene's splats along a fixed set of directions spread evenly over the sphere. When sorting along
+// the view direction, rather than by distance from the camera, the order depends only on that direction, so the
+// order sampled nearest to it is nearly right wherever the camera is; an adaptive sort (DepthSorter's .incremental,
+// or Array.sort) then repairs it in close to linear time, however far the camera has turned since the last sort.
+//
+// Each direction's order takes 4 bytes per splat, so the direction count is best chosen to fit a memory budget (see
+// directionCount(splatCount:memoryBudget:)). Building is a radix sort per direction, spread across cores; tables
+// can be saved with a scene and loaded with it instead.
+//
+// Stored in a little-endian binary form: the magic "SPST", then UInt32 version, splat count, direction count and
+// back-to-front flag, then each direction as 3 Float32s, then each direction's order as splat count UInt32s.
+public struct DirectionalSortTable {
+    public enum Error: Swift.Error {
+        case invalidMagic
+        case unsupportedVersion(UInt32)
+        case unexpectedEndOfData
+        // An order holds an index out of range, or the same index twice, so isn't a permutation of the splats
+        case invalidIndex
+    }
+
+    public static let defaultDirectionCount = 128
+    // Below this, the nearest sample is too far off to be worth starting from
+    public static let minimumDirectionCount = 16
+    public static let maximumDirectionCount = 256
+
+    static let magic: [UInt8] = Array("SPST".utf8)
+    static let version: UInt32 = 1
+
+    public let directions: [SIMD3<Float>]
+    public let splatCount: Int
+    public let backToFront: Bool
+    private let orders: [[UInt32]]
+
+    public init(positions: UnsafeBufferPointer<SIMD3<Float>>,
+                directionCount: Int = defaultDirectionCount,
+                backToFront: Bool = true) {
+        let directions = Self.sphereDirections(count: directionCount)
+        var orders = Array(repeating: [UInt32](), count: directions.count)
+        orders.withUnsafeMutableBufferPointer { orders in
+            // A direction at a time, as background work, so building a table doesn't hold up frames' sorts
+            SplatExecutor.shared.parallelFor(iterations: directions.count, priority: .background) { i in
+                let sorter = DepthSorter(strategy: .radix, backToFront: backToFront)
+                var depths: [Float] = []
+                DepthSorter.depths(of: positions, from: CameraPose(position: .zero, forward: directions[i]), into: &depths)
+                var order = Array(0..<UInt32(positions.count))
+                sorter.sort(&order, depths: depths)
+                orders[i] = order
+            }
+        }
+        self.directions = directions
+        self.splatCount = positions.count
+        self.backToFront = backToFront
+        self.orders = orders
+    }
+
+    public init(positions: [SIMD3<Float>], directionCount: Int = defaultDirectionCount, backToFront: Bool = true) {
+        self = positions.withUnsafeBufferPointer {
+            DirectionalSortTable(positions: $0, directionCount: directionCount, backToFront: backToFront)
+        }
+    }
+
+    public init(contentsOf url: URL) throws {
+        try self.init(data: Data(contentsOf: url, options: .mappedIfSafe))
+    }
+
+    public init(data: Data) throws {
+        typealias Contents = (directions: [SIMD3<Float>], splatCount: Int, backToFront: Bool, orders: [[UInt32]])
+        let decoded = try data.withUnsafeBytes { (bytes: UnsafeRawBufferPointer) throws -> Contents in
+            var offset = 0
+            func uint32() throws -> UInt32 {
+                guard offset + 4 <= bytes.count else { throw Error.unexpectedEndOfData }
+                defer { offset += 4 }
+                return UInt32(littleEndian: bytes.loadUnaligned(fromByteOffset: offset, as: UInt32.self))
+            }
+
+            guard bytes.count >= Self.magic.count, Array(bytes[0..<Self.magic.count]) == Self.magic else {
+                throw Error.invalidMagic
+            }
+            offset = Self.magic.count
+            let version = try uint32()
+            guard version == Self.version else {
+                throw Error.unsupportedVersion(version)
+            }
+            let splatCount = Int(try uint32())
+            let directionCount = Int(try uint32())
+            let backToFront = try uint32() != 0
+            var directions: [SIMD3<Float>] = []
+            for _ in 0..<directionCount {
+                directions.append(SIMD3<Float>(Float(bitPattern: try uint32()), Float(bitPattern: try uint32()), Float(bitPattern: try uint32())))
+            }
+
+            // The counts come from the file, so their product may not even fit in an Int
+            let (orderCount, countOverflow) = directionCount.multipliedReportingOverflow(by: splatCount)
+            let (orderBytes, bytesOverflow) = orderCount.multipliedReportingOverflow(by: 4)
+            guard !countOverflow, !bytesOverflow, orderBytes <= bytes.count - offset else {
+                throw Error.unexpectedEndOfData
+            }
+            var orders: [[UInt32]] = []
+            var seen = [Bool](repeating: false, count: splatCount)
+            for _ in 0..<directionCount {
+                let order = [UInt32](unsafeUninitializedCapacity: splatCount) { buffer, count in
+                    for i in 0..<splatCount {
+                        buffer[i] = UInt32(littleEndian: bytes.loadUnaligned(fromByteOffset: offset + i * 4, as: UInt32.self))
+                    }
+                    count = splatCount
+                }
+                offset += splatCount * 4
+                // Sorts seeded from the order rely on it holding every index exactly once
+                for i in seen.indices {
+                    seen[i] = false
+                }
+                for index in order {
+                    guard index < splatCount, !seen[Int(index)] else {
+                        throw Error.invalidIndex
+                    }
+                    seen[Int(index)] = true
+                }
+                orders.append(order)
+            }
+            return (directions: directions, splatCount: splatCount, backToFront: backToFront, orders: orders)
+        }
+        directions = decoded.directions
+        splatCount = decoded.splatCount
+        backToFront = decoded.backToFront
+        orders = decoded.orders
+    }
+
+    public func data() -> Data {
+        var data = Data(capacity: 20 + directions.count * (12 + splatCount * 4))
+        func append(_ value: UInt32) {
+            withUnsafeBytes(of: value.littleEndian) { data.append(contentsOf: $0) }
+        }
+        data.append(contentsOf: Self.magic)
+        append(Self.version)
+        append(UInt32(splatCount))
+        append(UInt32(directions.count))
+        append(backToFront ? 1 : 0)
+        for direction in directions {
+            append(direction.x.bitPattern)
+            append(direction.y.bitPattern)
+            append(direction.z.bitPattern)
+        }
+        for order in orders {
+            order.map(\.littleEndian).withUnsafeBytes { data.append(contentsOf: $0) }
+        }
+        return data
+    }
+
+    // Atomically, like CameraTrajectory.write(to:), so a reader (or a crash) never sees a partly written file
+    public func write(to url: URL) throws {
+        try data().write(to: url, options: .atomic)
+    }
+
+    // Bytes held by the orders
+    public var memorySize: Int {
+        directions.count * splatCount * MemoryLayout<UInt32>.stride
+    }
+
+    // As many directions as fit in memoryBudget bytes, up to maximumDirectionCount, or 0 if fewer than
+    // minimumDirectionCount fit
+    public static func directionCount(splatCount: Int, memoryBudget: Int) -> Int {
+        let count = min(maximumDirectionCount, memoryBudget / max(1, splatCount * MemoryLayout<UInt32>.stride))
+        return count >= minimumDirectionCount ? count : 0
+    }
+
+    // Evenly spread unit vectors, on a Fibonacci spiral
+    public static func sphereDirections(count: Int) -> [SIMD3<Float>] {
+        let goldenAngle = Float.pi * (3 - Float(5).squareRoot())
+        return (0..<count).map { i in
+            let y = 1 - 2 * (Float(i) + 0.5) / Float(count)
+            let radius = max(0, 1 - y * y).squareRoot()
+            let angle = goldenAngle * Float(i)
+            return SIMD3<Float>(cos(angle) * radius, y, sin(angle) * radius)
+        }
+    }
+
+    // The sampled direction nearest to the given one, and the cosine of the angle between them
+    public func nearestDirection(to forward: SIMD3<Float>) -> (index: Int, cosine: Float) {
+        let forward = forward.normalized
+        var nearest = (index: 0, cosine: -Float.infinity)
+        for (i, direction) in directions.enumerated() {
+            let cosine = direction.dot(forward)
+            if cosine > nearest.cosine {
+                nearest = (index: i, cosine: cosine)
+            }
+        }
+        return nearest
+    }
+
+    public func order(forDirection index: Int) -> [UInt32] {
+        orders[index]
+    }
+
+    // The order sampled nearest to forward, unless previousForward (the direction the caller's current order was
+    // sorted along) is nearer still, in which case the current order is the better start and this returns nil
+    public func order(nearestTo forward: SIMD3<Float>, unlessNearer previousForward: SIMD3<Float>?) -> [UInt32]? {
+        guard !directions.isEmpty else { return nil }
+        let nearest = nearestDirection(to: forward)
+        if let previousForward, previousForward.normalized.dot(forward.normalized) >= nearest.cosine {
+            return nil
+        }
+        return orders[nearest.index]
+    }
+
+    // Sorts order (every splat's index) by depths along forward with the sorter, first replacing it with the nearest
+    // sampled order where that's a better start. Returns whether it did.
+    @discardableResult
+    public func sort(_ order: inout [UInt32],
+                     along forward: SIMD3<Float>,
+                     previousForward: SIMD3<Float>?,
+                     depths: UnsafeBufferPointer<Float>,
+                     sorter: DepthSorter) -> Bool {
+        var seeded = false
+        if order.count != splatCount {
+            order = orders.isEmpty ? Array(0..<UInt32(splatCount)) : orders[nearestDirection(to: forward).index]
+            seeded = !orders.isEmpty
+        } else if let nearest = self.order(nearestTo: forward, unlessNearer: previousForward) {
+            order = nearest
+            seeded = true
+        }
+        sorter.sort(&order, depths: depths)
+        return seeded
+    }
+}
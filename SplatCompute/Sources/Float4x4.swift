@@ -0,0 +1,142 @@
+import Foundation
+
+#if canImport(simd)
+
+import simd
+
+public typealias Float4x4 = simd_float4x4
+
+#else
+
+// A minimal stand-in for simd_float4x4 on platforms without the simd module, covering only what SplatCompute uses.
+// Column-major, like simd.
+public struct Float4x4: Equatable {
+    public var columns: (SIMD4<Float>, SIMD4<Float>, SIMD4<Float>, SIMD4<Float>)
+
+    public init(columns: (SIMD4<Float>, SIMD4<Float>, SIMD4<Float>, SIMD4<Float>)) {
+        self.columns = columns
+    }
+
+    public init(_ columns: [SIMD4<Float>]) {
+        precondition(columns.count == 4)
+        self.columns = (columns[0], columns[1], columns[2], columns[3])
+    }
+
+    public init(diagonal: SIMD4<Float>) {
+        self.columns = (SIMD4<Float>(diagonal.x, 0, 0, 0),
+                        SIMD4<Float>(0, diagonal.y, 0, 0),
+                        SIMD4<Float>(0, 0, diagonal.z, 0),
+                        SIMD4<Float>(0, 0, 0, diagonal.w))
+    }
+
+    public subscript(column: Int) -> SIMD4<Float> {
+        get {
+            switch column {
+            case 0: columns.0
+            case 1: columns.1
+            case 2: columns.2
+            case 3: columns.3
+            default: preconditionFailure("Column index out of range")
+            }
+        }
+        set {
+            switch column {
+            case 0: columns.0 = newValue
+            case 1: columns.1 = newValue
+            case 2: columns.2 = newValue
+            case 3: columns.3 = newValue
+            default: preconditionFailure("Column index out of range")
+            }
+        }
+    }
+
+    public var transpose: Float4x4 {
+        Float4x4(columns: (SIMD4<Float>(columns.0.x, columns.1.x, columns.2.x, columns.3.x),
+                           SIMD4<Float>(columns.0.y, columns.1.y, columns.2.y, columns.3.y),
+                           SIMD4<Float>(columns.0.z, columns.1.z, columns.2.z, columns.3.z),
+                           SIMD4<Float>(columns.0.w, columns.1.w, columns.2.w, columns.3.w)))
+    }
+
+    // Inverse via cofactor expansion. Singular matrices produce non-finite values, as they do with simd.
+    public var inverse: Float4x4 {
+        let m = [ columns.0, columns.1, columns.2, columns.3 ]
+        // a[row][column]
+        func a(_ row: Int, _ column: Int) -> Float { m[column][row] }
+
+        let s0 = a(0, 0) * a(1, 1) - a(1, 0) * a(0, 1)
+        let s1 = a(0, 0) * a(1, 2) - a(1, 0) * a(0, 2)
+        let s2 = a(0, 0) * a(1, 3) - a(1, 0) * a(0, 3)
+        let s3 = a(0, 1) * a(1, 2) - a(1, 1) * a(0, 2)
+        let s4 = a(0, 1) * a(1, 3) - a(1, 1) * a(0, 3)
+        let s5 = a(0, 2) * a(1, 3) - a(1, 2) * a(0, 3)
+
+        let c5 = a(2, 2) * a(3, 3) - a(3, 2) * a(2, 3)
+        let c4 = a(2, 1) * a(3, 3) - a(3, 1) * a(2, 3)
+        let c3 = a(2, 1) * a(3, 2) - a(3, 1) * a(2, 2)
+        let c2 = a(2, 0) * a(3, 3) - a(3, 0) * a(2, 3)
+        let c1 = a(2, 0) * a(3, 2) - a(3, 0) * a(2, 2)
+        let c0 = a(2, 0) * a(3, 1) - a(3, 0) * a(2, 1)
+
+        let determinant = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0
+        let inverseDeterminant = 1 / determinant
+
+        // b[row][column] of the inverse
+        var b = [[Float]](repeating: [Float](repeating: 0, count: 4), count: 4)
+        b[0][0] = ( a(1, 1) * c5 - a(1, 2) * c4 + a(1, 3) * c3) * inverseDeterminant
+        b[0][1] = (-a(0, 1) * c5 + a(0, 2) * c4 - a(0, 3) * c3) * inverseDeterminant
+        b[0][2] = ( a(3, 1) * s5 - a(3, 2) * s4 + a(3, 3) * s3) * inverseDeterminant
+        b[0][3] = (-a(2, 1) * s5 + a(2, 2) * s4 - a(2, 3) * s3) * inverseDeterminant
+
+        b[1][0] = (-a(1, 0) * c5 + a(1, 2) * c2 - a(1, 3) * c1) * inverseDeterminant
+        b[1][1] = ( a(0, 0) * c5 - a(0, 2) * c2 + a(0, 3) * c1) * inverseDeterminant
+        b[1][2] = (-a(3, 0) * s5 + a(3, 2) * s2 - a(3, 3) * s1) * inverseDeterminant
+        b[1][3] = ( a(2, 0) * s5 - a(2, 2) * s2 + a(2, 3) * s1) * inverseDeterminant
+
+        b[2][0] = ( a(1, 0) * c4 - a(1, 1) * c2 + a(1, 3) * c0) * inverseDeterminant
+        b[2][1] = (-a(0, 0) * c4 + a(0, 1) * c2 - a(0, 3) * c0) * inverseDeterminant
+        b[2][2] = ( a(3, 0) * s4 - a(3, 1) * s2 + a(3, 3) * s0) * inverseDeterminant
+        b[2][3] = (-a(2, 0) * s4 + a(2, 1) * s2 - a(2, 3) * s0) * inverseDeterminant
+
+        b[3][0] = (-a(1, 0) * c3 + a(1, 1) * c1 - a(1, 2) * c0) * inverseDeterminant
+        b[3][1] = ( a(0, 0) * c3 - a(0, 1) * c1 + a(0, 2) * c0) * inverseDeterminant
+        b[3][2] = (-a(3, 0) * s3 + a(3, 1) * s1 - a(3, 2) * s0) * inverseDeterminant
+        b[3][3] = ( a(2, 0) * s3 - a(2, 1) * s1 + a(2, 2) * s0) * inverseDeterminant
+
+        return Float4x4(columns: (SIMD4<Float>(b[0][0], b[1][0], b[2][0], b[3][0]),
+                                  SIMD4<Float>(b[0][1], b[1][1], b[2][1], b[3][1]),
+                                  SIMD4<Float>(b[0][2], b[1][2], b[2][2], b[3][2]),
+                                  SIMD4<Float>(b[0][3], b[1][3], b[2][3], b[3][3])))
+    }
+
+    public static func * (lhs: Float4x4, rhs: SIMD4<Float>) -> SIMD4<Float> {
+        lhs.columns.0 * rhs.x + lhs.columns.1 * rhs.y + lhs.columns.2 * rhs.z + lhs.columns.3 * rhs.w
+    }
+
+    public static func * (lhs: Float4x4, rhs: Float4x4) -> Float4x4 {
+        Float4x4(columns: (lhs * rhs.columns.0, lhs * rhs.columns.1, lhs * rhs.columns.2, lhs * rhs.columns.3))
+    }
+
+    public static func == (lhs: Float4x4, rhs: Float4x4) -> Bool {
+        lhs.columns.0 == rhs.columns.0 &&
+        lhs.columns.1 == rhs.columns.1 &&
+        lhs.columns.2 == rhs.columns.2 &&
+        lhs.columns.3 == rhs.columns.3
+    }
+}
+
+#endif // canImport(simd)
+
+public typealias CameraMatrices = ( projection: Float4x4, view: Float4x4 )
+
+extension Float4x4 {
+    // Right-handed perspective projection with depth mapped to 0...1, matching the sample app's
+    public static func perspective(fovyRadians fovy: Float, aspectRatio: Float, nearZ: Float, farZ: Float) -> Float4x4 {
+        let ys = 1 / tan(fovy * 0.5)
+        let xs = ys / aspectRatio
+        let zs = farZ / (nearZ - farZ)
+        return Float4x4(columns: (SIMD4<Float>(xs,  0, 0,   0),
+                                  SIMD4<Float>( 0, ys, 0,   0),
+                                  SIMD4<Float>( 0,  0, zs, -1),
+                                  SIMD4<Float>( 0,  0, zs * nearZ, 0)))
+    }
+}
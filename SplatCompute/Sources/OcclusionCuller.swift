@@ -0,0 +1,276 @@
+import Dispatch
+import Foundation
+#if canImport(simd)
+import simd
+#endif
+
+// Coarse software occlusion culling of splat chunks.
+//
+// Chunks are visited front-to-back (by the nearest point of their bounds). Each chunk is first tested against a
+// low-resolution buffer of accumulated opacity; if every cell its screen bounds touch is saturated by splats
+// which are all nearer than the chunk, it's rejected. Otherwise it's visible, and (while the budget lasts) its
+// splats are rasterized into the buffer as occluders for the chunks behind it.
+//
+// The test is conservative: an occluding splat only contributes to cells lying entirely inside the projection of
+// the sphere inscribed in its 1-sigma ellipsoid, with the opacity it has at that 1-sigma boundary, and a cell's
+// occluder depth is the farthest extent of any splat which contributed to it. Chunks which cross the near plane
+// are never rejected by occlusion.
+//
+// Chunks entirely outside the view frustum are rejected as well, since the bounds are at hand anyway.
+public class OcclusionCuller {
+    public struct Configuration {
+        // Resolution of the opacity buffer, covering the whole viewport
+        public var gridWidth: Int
+        public var gridHeight: Int
+        // Accumulated opacity at which a cell is considered opaque
+        public var saturationOpacity: Float
+        // Upper bound on the number of splats rasterized as occluders per cull
+        public var maxOccluderSplats: Int
+        // Once this much time has been spent, no more occluders are rasterized; the remaining chunks are only tested
+        public var timeBudget: TimeInterval
+
+        public init(gridWidth: Int = 64,
+                    gridHeight: Int = 64,
+                    saturationOpacity: Float = 0.99,
+                    maxOccluderSplats: Int = 256*1024,
+                    timeBudget: TimeInterval = 0.002) {
+            self.gridWidth = gridWidth
+            self.gridHeight = gridHeight
+            self.saturationOpacity = saturationOpacity
+            self.maxOccluderSplats = maxOccluderSplats
+            self.timeBudget = timeBudget
+        }
+    }
+
+    public struct Statistics {
+        public var chunkCount = 0
+        public var splatCount = 0
+        public var frustumCulledChunks = 0
+        public var frustumCulledSplats = 0
+        public var occludedChunks = 0
+        public var occludedSplats = 0
+        public var occluderSplats = 0
+        public var duration: TimeInterval = 0
+
+        public init() {}
+
+        // Fraction of splats rejected by the occlusion test (as opposed to frustum culling)
+        public var occlusionRate: Double {
+            splatCount == 0 ? 0 : Double(occludedSplats) / Double(splatCount)
+        }
+
+        public var cullRate: Double {
+            splatCount == 0 ? 0 : Double(occludedSplats + frustumCulledSplats) / Double(splatCount)
+        }
+    }
+
+    // Aggregate statistics over a sequence of frames, e.g. a recorded camera path
+    public struct Report {
+        public var frameCount = 0
+        public var meanOcclusionRate: Double = 0
+        public var minOcclusionRate: Double = 0
+        public var maxOcclusionRate: Double = 0
+        public var meanCullRate: Double = 0
+        public var meanDuration: TimeInterval = 0
+        public var maxDuration: TimeInterval = 0
+
+        public init() {}
+
+        public init(_ frames: [Statistics]) {
+            guard !frames.isEmpty else { return }
+            frameCount = frames.count
+            let occlusionRates = frames.map(\.occlusionRate)
+            meanOcclusionRate = occlusionRates.reduce(0, +) / Double(frameCount)
+            minOcclusionRate = occlusionRates.min() ?? 0
+            maxOcclusionRate = occlusionRates.max() ?? 0
+            meanCullRate = frames.map(\.cullRate).reduce(0, +) / Double(frameCount)
+            meanDuration = frames.map(\.duration).reduce(0, +) / Double(frameCount)
+            maxDuration = frames.map(\.duration).max() ?? 0
+        }
+    }
+
+    private struct ChunkProjection {
+        var chunkIndex: Int
+        var nearestDepth: Float
+        // Inclusive cell range covered by the chunk's bounds; nil if it crosses the near plane
+        var cells: (min: SIMD2<Int>, max: SIMD2<Int>)?
+    }
+
+    public var configuration: Configuration
+
+    // Per cell: 1 - accumulated opacity, and the farthest depth of any splat which contributed
+    private var transmittance: [Float] = []
+    private var occluderDepth: [Float] = []
+
+    public init(configuration: Configuration = Configuration()) {
+        self.configuration = configuration
+    }
+
+    // Returns, for each chunk, whether it may be visible from the given camera
+    public func cull(chunks: SplatChunks,
+                     splats: UnsafeBufferPointer<Splat>,
+                     viewpoint: Viewpoint) -> (visible: [Bool], statistics: Statistics) {
+        let startTime = DispatchTime.now()
+        let deadline = startTime.uptimeNanoseconds + UInt64(max(0, configuration.timeBudget) * 1_000_000_000)
+
+        let gridSize = SIMD2<Int>(configuration.gridWidth, configuration.gridHeight)
+        let cellCount = gridSize.x * gridSize.y
+        transmittance = Array(repeating: 1, count: cellCount)
+        occluderDepth = Array(repeating: 0, count: cellCount)
+        let transparencyThreshold = 1 - configuration.saturationOpacity
+
+        var statistics = Statistics()
+        statistics.chunkCount = chunks.chunks.count
+        statistics.splatCount = chunks.splatCount
+
+        var visible = Array(repeating: true, count: chunks.chunks.count)
+        var projections: [ChunkProjection] = []
+        projections.reserveCapacity(chunks.chunks.count)
+        for (chunkIndex, chunk) in chunks.chunks.enumerated() {
+            if let projection = project(chunk, index: chunkIndex, viewpoint: viewpoint, gridSize: gridSize) {
+                projections.append(projection)
+            } else {
+                visible[chunkIndex] = false
+                statistics.frustumCulledChunks += 1
+                statistics.frustumCulledSplats += chunk.range.count
+            }
+        }
+        projections.sort { $0.nearestDepth < $1.nearestDepth }
+
+        var rasterizing = configuration.maxOccluderSplats > 0
+        for projection in projections {
+            let chunk = chunks.chunks[projection.chunkIndex]
+            if let cells = projection.cells,
+               isOccluded(cells: cells, depth: projection.nearestDepth, gridWidth: gridSize.x, transparencyThreshold: transparencyThreshold) {
+                visible[projection.chunkIndex] = false
+                statistics.occludedChunks += 1
+                statistics.occludedSplats += chunk.range.count
+                continue
+            }
+
+            guard rasterizing else { continue }
+            for index in chunks.indices[chunk.range] {
+                rasterizeOccluder(splats[Int(index)], viewpoint: viewpoint, gridSize: gridSize, transparencyThreshold: transparencyThreshold)
+            }
+            statistics.occluderSplats += chunk.range.count
+            if statistics.occluderSplats >= configuration.maxOccluderSplats ||
+                DispatchTime.now().uptimeNanoseconds >= deadline {
+                rasterizing = false
+            }
+        }
+
+        statistics.duration = TimeInterval(DispatchTime.now().uptimeNanoseconds - startTime.uptimeNanoseconds) / 1_000_000_000
+        return (visible: visible, statistics: statistics)
+    }
+
+    public func cull(chunks: SplatChunks,
+                     splats: [Splat],
+                     viewpoint: Viewpoint) -> (visible: [Bool], statistics: Statistics) {
+        splats.withUnsafeBufferPointer { cull(chunks: chunks, splats: $0, viewpoint: viewpoint) }
+    }
+
+    // Culls each frame of a camera path in turn, and summarizes how much was rejected
+    public func report(chunks: SplatChunks,
+                       splats: [Splat],
+                       cameraPath: [CameraMatrices],
+                       screenSize: SIMD2<Float>) -> Report {
+        Report(cameraPath.map {
+            cull(chunks: chunks, splats: splats, viewpoint: Viewpoint($0, screenSize: screenSize)).statistics
+        })
+    }
+
+    // Returns nil if the chunk is entirely outside the view frustum
+    private func project(_ chunk: SplatChunks.Chunk, index: Int, viewpoint: Viewpoint, gridSize: SIMD2<Int>) -> ChunkProjection? {
+        var outsideLeft = true, outsideRight = true, outsideBottom = true, outsideTop = true, behind = true
+        var crossesNearPlane = false
+        var nearestDepth = Float.infinity
+        var ndcMin = SIMD2<Float>(repeating: .infinity)
+        var ndcMax = SIMD2<Float>(repeating: -.infinity)
+        for corner in chunk.bounds.corners {
+            let clip = viewpoint.clipPosition(corner)
+            outsideLeft = outsideLeft && clip.x < -clip.w
+            outsideRight = outsideRight && clip.x > clip.w
+            outsideBottom = outsideBottom && clip.y < -clip.w
+            outsideTop = outsideTop && clip.y > clip.w
+            behind = behind && clip.w <= 0
+            nearestDepth = min(nearestDepth, viewpoint.depth(corner))
+            if clip.w <= 0 {
+                crossesNearPlane = true
+            } else {
+                let ndc = SIMD2<Float>(clip.x, clip.y) / clip.w
+                ndcMin = pointwiseMin(ndcMin, ndc)
+                ndcMax = pointwiseMax(ndcMax, ndc)
+            }
+        }
+        if outsideLeft || outsideRight || outsideBottom || outsideTop || behind {
+            return nil
+        }
+
+        var projection = ChunkProjection(chunkIndex: index, nearestDepth: max(0, nearestDepth), cells: nil)
+        if !crossesNearPlane {
+            projection.cells = (min: cell(forNDC: ndcMin, gridSize: gridSize),
+                                max: cell(forNDC: ndcMax, gridSize: gridSize))
+        }
+        return projection
+    }
+
+    private func cell(forNDC ndc: SIMD2<Float>, gridSize: SIMD2<Int>) -> SIMD2<Int> {
+        let position = (ndc.clamped(lowerBound: SIMD2(repeating: -1), upperBound: SIMD2(repeating: 1)) * 0.5 + 0.5) * SIMD2<Float>(gridSize)
+        return pointwiseMin(SIMD2<Int>(position, rounding: .down), gridSize &- 1)
+    }
+
+    private func isOccluded(cells: (min: SIMD2<Int>, max: SIMD2<Int>), depth: Float, gridWidth: Int, transparencyThreshold: Float) -> Bool {
+        for y in cells.min.y...cells.max.y {
+            for x in cells.min.x...cells.max.x {
+                let cellIndex = y * gridWidth + x
+                if transmittance[cellIndex] > transparencyThreshold || occluderDepth[cellIndex] >= depth {
+                    return false
+                }
+            }
+        }
+        return true
+    }
+
+    private func rasterizeOccluder(_ splat: Splat, viewpoint: Viewpoint, gridSize: SIMD2<Int>, transparencyThreshold: Float) {
+        let minimumScale = splat.scale.min()
+        let depth = viewpoint.depth(splat.position)
+        guard depth > minimumScale, splat.opacity > 0 else { return }
+
+        // Radius in NDC units of the projected inscribed sphere
+        let radius = SIMD2<Float>(viewpoint.projection[0][0], viewpoint.projection[1][1]) * (minimumScale / depth)
+        let cellSize = 2 / SIMD2<Float>(gridSize)
+        // A disc narrower than a cell can't cover one
+        guard radius.x >= cellSize.x * 0.5 && radius.y >= cellSize.y * 0.5 else { return }
+
+        let clip = viewpoint.clipPosition(splat.position)
+        guard clip.w > 0 else { return }
+        let center = SIMD2<Float>(clip.x, clip.y) / clip.w
+
+        let alpha = min(0.99, splat.opacity * exp(-0.5))
+        let farDepth = depth + splat.boundingRadius
+
+        let lowerNDC = (center - radius).clamped(lowerBound: SIMD2(repeating: -1), upperBound: SIMD2(repeating: 1))
+        let upperNDC = (center + radius).clamped(lowerBound: SIMD2(repeating: -1), upperBound: SIMD2(repeating: 1))
+        let minCell = cell(forNDC: lowerNDC, gridSize: gridSize)
+        let maxCell = cell(forNDC: upperNDC, gridSize: gridSize)
+        guard minCell.x <= maxCell.x && minCell.y <= maxCell.y else { return }
+
+        for y in minCell.y...maxCell.y {
+            for x in minCell.x...maxCell.x {
+                // The cell is covered if its farthest corner from the center lies inside the (elliptical, in NDC) disc
+                let cellMin = SIMD2<Float>(Float(x), Float(y)) * cellSize - 1
+                let cellMax = cellMin + cellSize
+                let toMin = cellMin - center
+                let toMax = cellMax - center
+                let farthestSquared = pointwiseMax(toMin * toMin, toMax * toMax) / (radius * radius)
+                guard farthestSquared.sum() <= 1 else { continue }
+
+                let cellIndex = y * gridSize.x + x
+                // Once saturated, further occluders would only push the cell's depth back
+                guard transmittance[cellIndex] > transparencyThreshold else { continue }
+                transmittance[cellIndex] *= 1 - alpha
+                occluderDepth[cellIndex] = max(occluderDepth[cellIndex], farDepth)
+            }
+        }
+    }
+}
@@ -0,0 +1,202 @@
+import Foundation
+
+// Holds a target frame rate, within a thermal budget, by trading rendering quality for time. It's told how long each
+// frame took (and each sort, which runs alongside the frames), and steps down a ladder of quality levels when they
+// run over budget, or back up once they've had headroom for a while. Each level sets how often to sort, whether to
+// sort exactly or by depth bucket, how coarse a level of detail to draw, and how often to re-evaluate spherical
+// harmonics; the renderer applies whichever level is current.
+//
+// Stepping down takes a few slow frames in a row, stepping up many fast ones, and after any step it waits for the
+// smoothed timings to reflect it, so a level near the edge of the budget doesn't flip back and forth. The device's
+// thermal state puts a floor under how far down the ladder to be: a hot device renders more cheaply even if it's
+// still making its frame rate, to let it cool.
+//
+// Nothing here depends on a clock or platform: feed it timings from a trace to see what it'd do. Safe to use from
+// any thread.
+public final class QualityGovernor {
+    public struct Settings: Equatable {
+        // Start a sort at most every sortInterval frames
+        public var sortInterval: Int
+        // Sort exactly, or into depth buckets (approximate, but one linear pass)
+        public var exactSort: Bool
+        // Multiply the LOD selector's maxPixelError by this, and its splatBudget by splatBudgetScale
+        public var lodErrorScale: Float
+        public var splatBudgetScale: Float
+        // Re-evaluate spherical harmonics every sphericalHarmonicsInterval frames
+        public var sphericalHarmonicsInterval: Int
+
+        public init(sortInterval: Int,
+                    exactSort: Bool,
+                    lodErrorScale: Float,
+                    splatBudgetScale: Float,
+                    sphericalHarmonicsInterval: Int) {
+            self.sortInterval = sortInterval
+            self.exactSort = exactSort
+            self.lodErrorScale = lodErrorScale
+            self.splatBudgetScale = splatBudgetScale
+            self.sphericalHarmonicsInterval = sphericalHarmonicsInterval
+        }
+
+        // Best first
+        public static let defaultLevels = [
+            Settings(sortInterval: 1, exactSort: true, lodErrorScale: 1, splatBudgetScale: 1, sphericalHarmonicsInterval: 1),
+            Settings(sortInterval: 2, exactSort: true, lodErrorScale: 1.5, splatBudgetScale: 1, sphericalHarmonicsInterval: 2),
+            Settings(sortInterval: 2, exactSort: false, lodErrorScale: 2, splatBudgetScale: 0.75, sphericalHarmonicsInterval: 4),
+            Settings(sortInterval: 3, exactSort: false, lodErrorScale: 3, splatBudgetScale: 0.5, sphericalHarmonicsInterval: 8),
+            Settings(sortInterval: 4, exactSort: false, lodErrorScale: 4, splatBudgetScale: 0.35, sphericalHarmonicsInterval: 16),
+        ]
+    }
+
+    // Like ProcessInfo.ThermalState, which isn't available everywhere
+    public enum ThermalState: Int, CaseIterable, Comparable {
+        case nominal
+        case fair
+        case serious
+        case critical
+
+        public static func < (lhs: ThermalState, rhs: ThermalState) -> Bool {
+            lhs.rawValue < rhs.rawValue
+        }
+    }
+
+    public struct Configuration {
+        public var targetFrameDuration: TimeInterval = 1.0 / 60
+        // Quality levels, best first
+        public var levels = Settings.defaultLevels
+        // Weight of each new timing in the smoothed ones
+        public var smoothing = 0.2
+        // Step down after this many frames in a row over budget...
+        public var framesToStepDown = 5
+        // ...and up after this many in a row under headroom times the budget
+        public var framesToStepUp = 120
+        public var headroom = 0.75
+        // The best level allowed in each thermal state (indexed by rawValue), as an index into levels
+        public var bestLevelByThermalState = [ 0, 1, 2, 4 ]
+
+        public init() {}
+    }
+
+    public struct State: Equatable {
+        // Index into configuration.levels; larger is cheaper
+        public var level = 0
+        public var settings: Settings
+        public var thermalState = ThermalState.nominal
+        // Exponentially smoothed timings, nil until the first of each
+        public var smoothedFrameDuration: TimeInterval?
+        public var smoothedSortDuration: TimeInterval?
+        // The larger of the frames' and sorts' fractions of their budgets; above 1 is over budget
+        public var load: Double = 0
+        public var stepsDown = 0
+        public var stepsUp = 0
+    }
+
+    public let configuration: Configuration
+    private let lock = NSLock()
+    private var currentState: State
+    private var framesOverBudget = 0
+    private var framesWithHeadroom = 0
+    // Frames to go before the smoothed timings are trusted again, after a step
+    private var settlingFrames = 0
+
+    public init(configuration: Configuration = Configuration()) {
+        precondition(!configuration.levels.isEmpty)
+        self.configuration = configuration
+        currentState = State(settings: configuration.levels[0])
+    }
+
+    public var state: State {
+        lock.lock()
+        defer { lock.unlock() }
+        return currentState
+    }
+
+    public var settings: Settings {
+        state.settings
+    }
+
+    // Call once a frame, with how long it took; returns the settings for the next one
+    @discardableResult
+    public func recordFrame(duration: TimeInterval) -> Settings {
+        lock.lock()
+        defer { lock.unlock() }
+        currentState.smoothedFrameDuration = smoothed(currentState.smoothedFrameDuration, duration)
+        currentState.load = load()
+
+        if settlingFrames > 0 {
+            settlingFrames -= 1
+        } else if currentState.load > 1 {
+            framesWithHeadroom = 0
+            framesOverBudget += 1
+            if framesOverBudget >= configuration.framesToStepDown {
+                step(by: 1)
+            }
+        } else if currentState.load < configuration.headroom {
+            framesOverBudget = 0
+            framesWithHeadroom += 1
+            if framesWithHeadroom >= configuration.framesToStepUp {
+                step(by: -1)
+            }
+        } else {
+            framesOverBudget = 0
+            framesWithHeadroom = 0
+        }
+        return currentState.settings
+    }
+
+    // Call as each sort finishes, with how long it took
+    public func recordSort(duration: TimeInterval) {
+        lock.lock()
+        defer { lock.unlock() }
+        currentState.smoothedSortDuration = smoothed(currentState.smoothedSortDuration, duration)
+    }
+
+    public func setThermalState(_ thermalState: ThermalState) {
+        lock.lock()
+        defer { lock.unlock() }
+        currentState.thermalState = thermalState
+        let best = bestLevel
+        if currentState.level < best {
+            currentState.stepsDown += 1
+            setLevel(best)
+        }
+    }
+
+    private var bestLevel: Int {
+        let levels = configuration.bestLevelByThermalState
+        let best = currentState.thermalState.rawValue < levels.count ? levels[currentState.thermalState.rawValue] : 0
+        return min(max(0, best), configuration.levels.count - 1)
+    }
+
+    // A sort is over budget if it takes longer than the frames between the sorts it's started every
+    private func load() -> Double {
+        let target = configuration.targetFrameDuration
+        let frameLoad = (currentState.smoothedFrameDuration ?? 0) / target
+        let sortLoad = (currentState.smoothedSortDuration ?? 0) / (target * Double(currentState.settings.sortInterval))
+        return max(frameLoad, sortLoad)
+    }
+
+    private func smoothed(_ average: TimeInterval?, _ value: TimeInterval) -> TimeInterval {
+        guard let average else { return value }
+        return average + configuration.smoothing * (value - average)
+    }
+
+    private func step(by delta: Int) {
+        let level = min(max(bestLevel, currentState.level + delta), configuration.levels.count - 1)
+        framesOverBudget = 0
+        framesWithHeadroom = 0
+        guard level != currentState.level else { return }
+        if delta > 0 {
+            currentState.stepsDown += 1
+        } else {
+            currentState.stepsUp += 1
+        }
+        setLevel(level)
+    }
+
+    private func setLevel(_ level: Int) {
+        currentState.level = level
+        currentState.settings = configuration.levels[level]
+        // Long enough for the smoothed timings to mostly reflect the new level
+        settlingFrames = Int((1 / configuration.smoothing).rounded(.up)) * 2
+    }
+}
@@ -0,0 +1,47 @@
+import Foundation
+
+// SplatCompute avoids the simd module so that it builds on Linux; these cover the handful of
+// vector operations it needs on top of the standard library's SIMD types. They're package-visible
+// so the package's other modules share them rather than keeping their own copies.
+
+extension SIMD3 where Scalar == Float {
+    package var lengthSquared: Float {
+        x*x + y*y + z*z
+    }
+
+    package var length: Float {
+        lengthSquared.squareRoot()
+    }
+
+    package var normalized: SIMD3<Float> {
+        self / length
+    }
+
+    package func dot(_ other: SIMD3<Float>) -> Float {
+        x*other.x + y*other.y + z*other.z
+    }
+
+    package func cross(_ other: SIMD3<Float>) -> SIMD3<Float> {
+        SIMD3<Float>(y * other.z - z * other.y,
+                     z * other.x - x * other.z,
+                     x * other.y - y * other.x)
+    }
+}
+
+extension SIMD4 where Scalar == Float {
+    package var xyz: SIMD3<Float> {
+        .init(x: x, y: y, z: z)
+    }
+
+    package var lengthSquared: Float {
+        x*x + y*y + z*z + w*w
+    }
+
+    package var normalized: SIMD4<Float> {
+        self / lengthSquared.squareRoot()
+    }
+
+    package func dot(_ other: SIMD4<Float>) -> Float {
+        x*other.x + y*other.y + z*other.z + w*other.w
+    }
+}
@@ -0,0 +1,127 @@
+import Foundation
+
+// Finished draw orders keyed by quantized camera pose, for deployments which show the same camera paths over and
+// over (kiosks, turntables): a pose near one seen before gets that pose's order straight away, and a sort only has
+// to refine it (or nothing at all, for exactly the same pose). Entries are evicted least recently used first, once
+// they take more than memoryLimit. Safe to use from any thread.
+//
+// Orders are only valid for the scene they were sorted from, so keys include the splat count and an edit generation
+// (see SplatEditState.generation); entries for any other scene are dropped when one for a new scene is inserted.
+public final class SortOrderCache {
+    public struct Configuration {
+        // Poses whose positions fall in the same cell of this size share an entry
+        public var positionQuantum: Float = 0.05
+        // ...and whose forward vectors fall in the same cell of this size (per component, so roughly in radians)
+        public var forwardQuantum: Float = 0.01
+        // Bytes of orders to hold
+        public var memoryLimit = 256 << 20
+
+        public init() {}
+    }
+
+    public struct Key: Hashable {
+        public var position: SIMD3<Int32>
+        public var forward: SIMD3<Int32>
+        public var splatCount: Int
+        public var generation: Int
+    }
+
+    public struct Entry {
+        public let order: [UInt32]
+        // The pose the order was sorted for exactly
+        public let pose: CameraPose
+    }
+
+    public struct Statistics {
+        public var hits = 0
+        public var misses = 0
+        public var evictions = 0
+        public var entryCount = 0
+        public var memorySize = 0
+
+        public var hitRate: Double {
+            hits + misses == 0 ? 0 : Double(hits) / Double(hits + misses)
+        }
+    }
+
+    public let configuration: Configuration
+    private let lock = NSLock()
+    private var entries: [Key: (entry: Entry, lastUse: UInt64)] = [:]
+    private var useCount: UInt64 = 0
+    private var currentStatistics = Statistics()
+
+    public init(configuration: Configuration = Configuration()) {
+        self.configuration = configuration
+    }
+
+    public func key(for pose: CameraPose, splatCount: Int, generation: Int) -> Key {
+        Key(position: Self.quantize(pose.position, quantum: configuration.positionQuantum),
+            forward: Self.quantize(pose.forward, quantum: configuration.forwardQuantum),
+            splatCount: splatCount,
+            generation: generation)
+    }
+
+    // The entry for the key, if any, counted as a hit or a miss
+    public func lookUp(_ key: Key) -> Entry? {
+        lock.lock()
+        defer { lock.unlock() }
+        guard let cached = entries[key] else {
+            currentStatistics.misses += 1
+            return nil
+        }
+        useCount += 1
+        entries[key]?.lastUse = useCount
+        currentStatistics.hits += 1
+        return cached.entry
+    }
+
+    public func insert(_ order: [UInt32], for pose: CameraPose, key: Key) {
+        let size = order.count * MemoryLayout<UInt32>.stride
+        lock.lock()
+        defer { lock.unlock() }
+        guard size <= configuration.memoryLimit else { return }
+
+        if let existingKey = entries.keys.first, existingKey.splatCount != key.splatCount || existingKey.generation != key.generation {
+            currentStatistics.evictions += entries.count
+            entries.removeAll()
+            currentStatistics.memorySize = 0
+        }
+        if let existing = entries[key] {
+            currentStatistics.memorySize -= existing.entry.order.count * MemoryLayout<UInt32>.stride
+        }
+        useCount += 1
+        entries[key] = (entry: Entry(order: order, pose: pose), lastUse: useCount)
+        currentStatistics.memorySize += size
+
+        while currentStatistics.memorySize > configuration.memoryLimit,
+              let leastRecent = entries.min(by: { $0.value.lastUse < $1.value.lastUse }) {
+            entries[leastRecent.key] = nil
+            currentStatistics.memorySize -= leastRecent.value.entry.order.count * MemoryLayout<UInt32>.stride
+            currentStatistics.evictions += 1
+        }
+        currentStatistics.entryCount = entries.count
+    }
+
+    public func removeAll() {
+        lock.lock()
+        defer { lock.unlock() }
+        entries.removeAll()
+        currentStatistics.entryCount = 0
+        currentStatistics.memorySize = 0
+    }
+
+    public var statistics: Statistics {
+        lock.lock()
+        defer { lock.unlock() }
+        return currentStatistics
+    }
+
+    private static func quantize(_ value: SIMD3<Float>, quantum: Float) -> SIMD3<Int32> {
+        // Out of range values (or NaN) would trap in the conversion
+        let limit = SIMD3<Float>(repeating: Float(Int32.max / 2))
+        var cell = (value / quantum).rounded(.down)
+        cell.replace(with: 0, where: cell .!= cell)
+        cell.clamp(lowerBound: -limit, upperBound: limit)
+        return SIMD3<Int32>(cell, rounding: .towardZero)
+    }
+}
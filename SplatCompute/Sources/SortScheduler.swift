@@ -0,0 +1,181 @@
+import Foundation
+
+// Decides which of several renderers gets to sort next, when more than one is live (several windows, or several
+// assets each with a renderer of its own) and each would otherwise start a sort every frame and compete for the
+// cores. Renderers ask every frame whether they may start one; at most maxConcurrentSorts run at a time.
+//
+// Waiting renderers are ranked by how much a fresh order would help: how stale their last one is, times how much of
+// the screen they cover (if they're visible at all), times how far the view has moved since their last sort. So
+// visible content the camera's moving around gets fresh orders first, and the longer any renderer waits, the more
+// urgent it becomes. For fairness, any renderer which has waited longer than maxWait goes ahead of the ranking,
+// longest waiting first, so even offscreen content is sorted eventually.
+//
+// A renderer which stops asking (because it's stopped being drawn) drops out after expiry, rather than holding a
+// place at the front. Times are whatever clock the caller uses, in seconds, so it can be driven from a trace.
+// Safe to use from any thread.
+public final class SortScheduler {
+    public struct Configuration {
+        // Every sort already spreads across SplatExecutor.shared, so a few at once is enough to keep it busy
+        public var maxConcurrentSorts = 2
+        public var maxWait: TimeInterval = 0.5
+        public var expiry: TimeInterval = 1
+        // Weight of offscreen renderers, against a visible one's 1 + screenCoverage
+        public var invisibleWeight: Float = 0.05
+        // Extra weight per radian of view change
+        public var viewChangeWeight: Float = 4
+
+        public init() {}
+    }
+
+    public struct Request {
+        public var isVisible: Bool
+        // Fraction of the screen the content covers, 0...1
+        public var screenCoverage: Float
+        // How far the view has moved since the renderer's last sort, as an angle in radians (turning, plus moving
+        // relative to the content's distance); nil if it's never sorted
+        public var viewChange: Float?
+
+        public init(isVisible: Bool = true, screenCoverage: Float = 1, viewChange: Float? = nil) {
+            self.isVisible = isVisible
+            self.screenCoverage = screenCoverage
+            self.viewChange = viewChange
+        }
+    }
+
+    public struct Client: Hashable {
+        let id: Int
+    }
+
+    public struct Grant {
+        // From the renderer's first request since its last sort, to now
+        public var waited: TimeInterval
+        // Granted ahead of the ranking, having waited longer than maxWait
+        public var overdue: Bool
+    }
+
+    public struct Statistics {
+        public var grants = 0
+        public var overdueGrants = 0
+        // Requests refused, to be made again next frame
+        public var deferrals = 0
+        public var longestWait: TimeInterval = 0
+        public var runningSorts = 0
+    }
+
+    public static let shared = SortScheduler()
+
+    public let configuration: Configuration
+    private let lock = NSLock()
+    private var clients: [Client: ClientState] = [:]
+    private var nextClientID = 0
+    private var runningCount = 0
+    private var currentStatistics = Statistics()
+
+    public init(configuration: Configuration = Configuration()) {
+        precondition(configuration.maxConcurrentSorts > 0)
+        self.configuration = configuration
+    }
+
+    public func addClient() -> Client {
+        lock.lock()
+        defer { lock.unlock() }
+        nextClientID += 1
+        let client = Client(id: nextClientID)
+        clients[client] = ClientState()
+        return client
+    }
+
+    // A running sort still needs its didFinishSort
+    public func removeClient(_ client: Client) {
+        lock.lock()
+        defer { lock.unlock() }
+        if clients.removeValue(forKey: client)?.isSorting == true {
+            runningCount -= 1
+        }
+    }
+
+    // Call every frame the client would like to sort; if this returns a grant, start the sort, and call
+    // didFinishSort once it's done
+    public func requestSort(_ client: Client, _ request: Request, now: TimeInterval) -> Grant? {
+        lock.lock()
+        defer { lock.unlock() }
+        guard var state = clients[client], !state.isSorting else { return nil }
+        state.request = request
+        state.lastRequest = now
+        state.waitingSince = state.waitingSince ?? now
+        clients[client] = state
+
+        let freeSlots = configuration.maxConcurrentSorts - runningCount
+        guard freeSlots > 0, let ranking = waitingClients(now: now).prefix(freeSlots).first(where: { $0.client == client }) else {
+            currentStatistics.deferrals += 1
+            return nil
+        }
+
+        let waited = now - state.waitingSince!
+        state.isSorting = true
+        state.waitingSince = nil
+        state.lastSortStart = now
+        clients[client] = state
+        runningCount += 1
+        currentStatistics.grants += 1
+        if ranking.overdue {
+            currentStatistics.overdueGrants += 1
+        }
+        currentStatistics.longestWait = max(currentStatistics.longestWait, waited)
+        return Grant(waited: waited, overdue: ranking.overdue)
+    }
+
+    public func didFinishSort(_ client: Client) {
+        lock.lock()
+        defer { lock.unlock() }
+        guard clients[client]?.isSorting == true else { return }
+        clients[client]?.isSorting = false
+        runningCount -= 1
+    }
+
+    public var statistics: Statistics {
+        lock.lock()
+        defer { lock.unlock() }
+        var statistics = currentStatistics
+        statistics.runningSorts = runningCount
+        return statistics
+    }
+
+    // Clients waiting for a sort which are still asking, overdue ones first (longest waiting first), then by priority
+    private func waitingClients(now: TimeInterval) -> [(client: Client, overdue: Bool)] {
+        var overdue: [(client: Client, waitingSince: TimeInterval)] = []
+        var ranked: [(client: Client, priority: Float)] = []
+        for (client, state) in clients {
+            guard !state.isSorting, let waitingSince = state.waitingSince else { continue }
+            guard now - state.lastRequest <= configuration.expiry else { continue }
+            if now - waitingSince > configuration.maxWait {
+                overdue.append((client, waitingSince))
+            } else {
+                ranked.append((client, priority(of: state, now: now)))
+            }
+        }
+        overdue.sort { ($0.waitingSince, $0.client.id) < ($1.waitingSince, $1.client.id) }
+        ranked.sort { $0.priority != $1.priority ? $0.priority > $1.priority : $0.client.id < $1.client.id }
+        return overdue.map { ($0.client, true) } + ranked.map { ($0.client, false) }
+    }
+
+    private func priority(of state: ClientState, now: TimeInterval) -> Float {
+        // Never sorted: nothing sensible is drawn yet
+        guard let lastSortStart = state.lastSortStart, let viewChange = state.request.viewChange else {
+            return .infinity
+        }
+        let request = state.request
+        let weight = request.isVisible ? 1 + min(max(request.screenCoverage, 0), 1) : configuration.invisibleWeight
+        let staleness = Float(max(now - lastSortStart, 0))
+        return weight * (1 + configuration.viewChangeWeight * viewChange) * staleness
+    }
+}
+
+private struct ClientState {
+    var request = SortScheduler.Request()
+    var lastRequest: TimeInterval = 0
+    // Since the first request after the last sort started
+    var waitingSince: TimeInterval?
+    var lastSortStart: TimeInterval?
+    var isSorting = false
+}
@@ -0,0 +1,179 @@
+import Dispatch
+import Foundation
+
+// Evaluation of the view-dependent colour of gaussian splats, following the real spherical harmonics basis
+// (and sign conventions) used by the original 3DGS implementation, up to degree 3.
+//
+// Coefficient layout: the DC term is kept separately as an RGB triple; the remaining ("rest") coefficients for
+// each splat are stored coefficient-major, as RGB triples: [ c1.r, c1.g, c1.b, c2.r, c2.g, c2.b, ... ].
+// Note that this differs from PLY files, which store f_rest_* channel-major; see interleave(channelMajorRest:).
+public enum SphericalHarmonics {
+    public static let maxDegree = 3
+
+    public static let c0: Float = 0.28209479177387814
+    public static let c1: Float = 0.4886025119029199
+    public static let c2: [Float] = [
+        1.0925484305920792,
+        -1.0925484305920792,
+        0.31539156525252005,
+        -1.0925484305920792,
+        0.5462742152960396,
+    ]
+    public static let c3: [Float] = [
+        -0.5900435899266435,
+        2.890611442640554,
+        -0.4570457994644658,
+        0.3731763325901154,
+        -0.4570457994644658,
+        1.445305721320277,
+        -0.5900435899266435,
+    ]
+
+    // Splats per unit of work when evaluating a batch across threads
+    static let batchChunkSize = 4096
+
+    // Number of coefficients per colour channel, excluding the DC term: 0, 3, 8 or 15
+    public static func restCoefficientCount(degree: Int) -> Int {
+        (degree + 1) * (degree + 1) - 1
+    }
+
+    // The degree corresponding to the given number of non-DC coefficients per channel, or nil if there is none
+    public static func degree(restCoefficientCount: Int) -> Int? {
+        (0...maxDegree).first { self.restCoefficientCount(degree: $0) == restCoefficientCount }
+    }
+
+    // Converts channel-major coefficients (all red coefficients, then all green, then all blue -- the order of
+    // f_rest_* in PLY files) to the coefficient-major RGB triples used here.
+    public static func interleave(channelMajorRest values: [Float]) -> [Float] {
+        let coefficientCount = values.count / 3
+        var result = [Float](repeating: 0, count: coefficientCount * 3)
+        for coefficient in 0..<coefficientCount {
+            for channel in 0..<3 {
+                result[coefficient * 3 + channel] = values[channel * coefficientCount + coefficient]
+            }
+        }
+        return result
+    }
+
+    // The view-independent colour, which is all the renderer used before SH support
+    public static func color(dc: SIMD3<Float>) -> SIMD3<Float> {
+        clamp(0.5 + c0 * dc)
+    }
+
+    // Evaluates the colour of a single splat seen along the given normalized direction (from the viewer towards
+    // the splat). rest must point to at least 3 * restCoefficientCount(degree:) values.
+    public static func color(degree: Int,
+                             direction: SIMD3<Float>,
+                             dc: SIMD3<Float>,
+                             rest: UnsafePointer<Float>) -> SIMD3<Float> {
+        @inline(__always)
+        func coefficient(_ i: Int) -> SIMD3<Float> {
+            SIMD3<Float>(rest[3*i], rest[3*i + 1], rest[3*i + 2])
+        }
+
+        var result = c0 * dc
+        if degree > 0 {
+            let x = direction.x
+            let y = direction.y
+            let z = direction.z
+            result += -c1 * y * coefficient(0)
+            result +=  c1 * z * coefficient(1)
+            result += -c1 * x * coefficient(2)
+            if degree > 1 {
+                let xx = x * x, yy = y * y, zz = z * z
+                let xy = x * y, yz = y * z, xz = x * z
+                result += (c2[0] * xy) * coefficient(3)
+                result += (c2[1] * yz) * coefficient(4)
+                result += (c2[2] * (2 * zz - xx - yy)) * coefficient(5)
+                result += (c2[3] * xz) * coefficient(6)
+                result += (c2[4] * (xx - yy)) * coefficient(7)
+                if degree > 2 {
+                    result += (c3[0] * y * (3 * xx - yy)) * coefficient(8)
+                    result += (c3[1] * xy * z) * coefficient(9)
+                    result += (c3[2] * y * (4 * zz - xx - yy)) * coefficient(10)
+                    result += (c3[3] * z * (2 * zz - 3 * xx - 3 * yy)) * coefficient(11)
+                    result += (c3[4] * x * (4 * zz - xx - yy)) * coefficient(12)
+                    result += (c3[5] * z * (xx - yy)) * coefficient(13)
+                    result += (c3[6] * x * (xx - 3 * yy)) * coefficient(14)
+                }
+            }
+        }
+        return clamp(0.5 + result)
+    }
+
+    // Normalized direction from viewPosition to position, used as the SH lookup direction
+    public static func direction(from viewPosition: SIMD3<Float>, to position: SIMD3<Float>) -> SIMD3<Float> {
+        let delta = position - viewPosition
+        let lengthSquared = delta.lengthSquared
+        guard lengthSquared > 0 else { return SIMD3<Float>(0, 0, 1) }
+        return delta / lengthSquared.squareRoot()
+    }
+
+    // Evaluates the colours of the splats at the given indices into colors[index], splitting the work across
+    // SplatExecutor.shared as frame work. rest holds restCoefficientCount(degree:) RGB triples per splat.
+    public static func evaluate<Indices: RandomAccessCollection>(degree: Int,
+                                                                 positions: UnsafeBufferPointer<SIMD3<Float>>,
+                                                                 dc: UnsafeBufferPointer<SIMD3<Float>>,
+                                                                 rest: UnsafeBufferPointer<Float>,
+                                                                 viewPosition: SIMD3<Float>,
+                                                                 indices: Indices,
+                                                                 into colors: UnsafeMutableBufferPointer<SIMD3<Float>>)
+    where Indices.Element == Int, Indices.Index == Int {
+        precondition(positions.count == dc.count && colors.count == dc.count)
+        let stride = restCoefficientCount(degree: degree) * 3
+        precondition(rest.count >= dc.count * stride)
+
+        guard stride > 0, let restBase = rest.baseAddress else {
+            // Degree 0 has no view dependence
+            for i in indices {
+                colors[i] = color(dc: dc[i])
+            }
+            return
+        }
+
+        let evaluateChunk = { (chunk: Indices.SubSequence) in
+            for i in chunk {
+                let lookupDirection = Self.direction(from: viewPosition, to: positions[i])
+                colors[i] = Self.color(degree: degree, direction: lookupDirection, dc: dc[i], rest: restBase + i * stride)
+            }
+        }
+
+        let chunkCount = (indices.count + batchChunkSize - 1) / batchChunkSize
+        if chunkCount <= 1 {
+            evaluateChunk(indices[...])
+            return
+        }
+        SplatExecutor.shared.parallelFor(iterations: chunkCount, priority: .frame) { chunkIndex in
+            let start = indices.startIndex + chunkIndex * Self.batchChunkSize
+            evaluateChunk(indices[start..<min(start + Self.batchChunkSize, indices.endIndex)])
+        }
+    }
+
+    public static func evaluate(degree: Int,
+                                positions: [SIMD3<Float>],
+                                dc: [SIMD3<Float>],
+                                rest: [Float],
+                                viewPosition: SIMD3<Float>) -> [SIMD3<Float>] {
+        var colors = [SIMD3<Float>](repeating: .zero, count: dc.count)
+        positions.withUnsafeBufferPointer { positions in
+            dc.withUnsafeBufferPointer { dc in
+                rest.withUnsafeBufferPointer { rest in
+                    colors.withUnsafeMutableBufferPointer { colors in
+                        evaluate(degree: degree,
+                                 positions: positions,
+                                 dc: dc,
+                                 rest: rest,
+                                 viewPosition: viewPosition,
+                                 indices: 0..<dc.count,
+                                 into: colors)
+                    }
+                }
+            }
+        }
+        return colors
+    }
+
+    private static func clamp(_ color: SIMD3<Float>) -> SIMD3<Float> {
+        color.clamped(lowerBound: .zero, upperBound: .one)
+    }
+}
@@ -0,0 +1,192 @@
+import Foundation
+
+// Holds a baked, view-dependent colour for each splat, and re-evaluates its spherical harmonics only once the
+// direction from which the splat is seen has drifted by more than angularThreshold since its last bake.
+//
+// The work is spread across frames: each call to update(viewPosition:) checks at most scansPerFrame splats
+// (continuing round-robin from where the previous call left off) and re-bakes at most bakesPerFrame of them.
+// Distant splats barely change direction as the viewer moves, so most of them keep their colour for many frames.
+public class SphericalHarmonicsColorCache {
+    public struct Budget {
+        // Maximum number of splats whose view direction is checked per update
+        public var scansPerFrame: Int
+        // Maximum number of splats whose colour is re-evaluated per update
+        public var bakesPerFrame: Int
+
+        public init(scansPerFrame: Int, bakesPerFrame: Int) {
+            self.scansPerFrame = scansPerFrame
+            self.bakesPerFrame = bakesPerFrame
+        }
+
+        public static let `default` = Budget(scansPerFrame: 1024*1024, bakesPerFrame: 128*1024)
+    }
+
+    public let degree: Int
+    public var budget: Budget
+    public var angularThreshold: Float {
+        didSet {
+            cosAngularThreshold = cos(angularThreshold)
+        }
+    }
+    private var cosAngularThreshold: Float
+
+    private var positions: [SIMD3<Float>] = []
+    private var dc: [SIMD3<Float>] = []
+    private var rest: [Float] = []
+    // Direction used for each splat's most recent bake; zero if it has never been baked
+    private var bakedDirections: [SIMD3<Float>] = []
+    // Splats appended with a colour rather than coefficients, which are never baked
+    private var isFixed: [Bool] = []
+    // Baked colour of each splat, linear RGB
+    public private(set) var colors: [SIMD3<Float>] = []
+
+    // Index of the next splat to check
+    private var cursor = 0
+
+    public var count: Int { colors.count }
+
+    // angularThreshold is in radians
+    public init(degree: Int,
+                angularThreshold: Float = 2 * .pi / 180,
+                budget: Budget = .default) {
+        precondition((0...SphericalHarmonics.maxDegree).contains(degree))
+        self.degree = degree
+        self.angularThreshold = angularThreshold
+        self.cosAngularThreshold = cos(angularThreshold)
+        self.budget = budget
+    }
+
+    // rest holds the splat's non-DC coefficients as coefficient-major RGB triples; any coefficients of a
+    // degree higher than this cache's are ignored, and missing ones are treated as zero.
+    public func append(position: SIMD3<Float>, dc: SIMD3<Float>, rest: [Float]) {
+        let stride = SphericalHarmonics.restCoefficientCount(degree: degree) * 3
+        positions.append(position)
+        self.dc.append(dc)
+        if rest.count >= stride {
+            self.rest.append(contentsOf: rest[0..<stride])
+        } else {
+            self.rest.append(contentsOf: rest)
+            self.rest.append(contentsOf: repeatElement(0, count: stride - rest.count))
+        }
+        bakedDirections.append(.zero)
+        isFixed.append(false)
+        colors.append(SphericalHarmonics.color(dc: dc))
+    }
+
+    // Appends a splat with a view-independent colour (linear RGB), for one whose coefficients are no longer at hand.
+    // The colour is kept exactly as given, rather than round-tripped through a DC term.
+    public func append(position: SIMD3<Float>, color: SIMD3<Float>) {
+        let stride = SphericalHarmonics.restCoefficientCount(degree: degree) * 3
+        positions.append(position)
+        dc.append((color - 0.5) / SphericalHarmonics.c0)
+        rest.append(contentsOf: repeatElement(0, count: stride))
+        bakedDirections.append(.zero)
+        isFixed.append(true)
+        colors.append(color)
+    }
+
+    public func setPosition(_ position: SIMD3<Float>, at index: Int) {
+        positions[index] = position
+        bakedDirections[index] = .zero
+    }
+
+    // Replaces the splat's spherical harmonics with a constant (view-independent) colour
+    public func setColor(_ color: SIMD3<Float>, at index: Int) {
+        let stride = SphericalHarmonics.restCoefficientCount(degree: degree) * 3
+        dc[index] = (color - 0.5) / SphericalHarmonics.c0
+        for i in (index * stride)..<((index + 1) * stride) {
+            rest[i] = 0
+        }
+        colors[index] = color
+    }
+
+    // Drops splats and renumbers the rest: remap[i] is splat i's new index, or -1 to remove it.
+    // New indices must preserve the existing order (as SplatEditState.compactionRemap() does).
+    public func compact(remap: [Int32]) {
+        precondition(remap.count == count)
+        let stride = SphericalHarmonics.restCoefficientCount(degree: degree) * 3
+        var newCount = 0
+        for (oldIndex, newIndex) in remap.enumerated() where newIndex >= 0 {
+            let newIndex = Int(newIndex)
+            positions[newIndex] = positions[oldIndex]
+            dc[newIndex] = dc[oldIndex]
+            for i in 0..<stride {
+                rest[newIndex * stride + i] = rest[oldIndex * stride + i]
+            }
+            bakedDirections[newIndex] = bakedDirections[oldIndex]
+            isFixed[newIndex] = isFixed[oldIndex]
+            colors[newIndex] = colors[oldIndex]
+            newCount = newIndex + 1
+        }
+        positions.removeLast(positions.count - newCount)
+        dc.removeLast(dc.count - newCount)
+        rest.removeLast(rest.count - newCount * stride)
+        bakedDirections.removeLast(bakedDirections.count - newCount)
+        isFixed.removeLast(isFixed.count - newCount)
+        colors.removeLast(colors.count - newCount)
+        cursor = cursor < newCount ? cursor : 0
+    }
+
+    public func removeAll() {
+        positions = []
+        dc = []
+        rest = []
+        bakedDirections = []
+        isFixed = []
+        colors = []
+        cursor = 0
+    }
+
+    // Marks every splat as needing a new bake, e.g. after a discontinuous camera change
+    public func invalidateAll() {
+        for i in 0..<bakedDirections.count {
+            bakedDirections[i] = .zero
+        }
+    }
+
+    // Checks the next batch of splats against the current view position, re-bakes those which have drifted
+    // past the threshold, and returns the indices whose colour changed.
+    @discardableResult
+    public func update(viewPosition: SIMD3<Float>) -> [Int] {
+        let count = self.count
+        guard count > 0, degree > 0 else { return [] }
+
+        var staleIndices: [Int] = []
+        staleIndices.reserveCapacity(min(budget.bakesPerFrame, count))
+        var scanned = 0
+        let scanLimit = min(budget.scansPerFrame, count)
+        while scanned < scanLimit && staleIndices.count < budget.bakesPerFrame {
+            let index = cursor
+            if !isFixed[index] {
+                let direction = SphericalHarmonics.direction(from: viewPosition, to: positions[index])
+                // Never-baked splats have a zero direction, so their dot product is 0 and they're always stale
+                if direction.dot(bakedDirections[index]) < cosAngularThreshold {
+                    staleIndices.append(index)
+                    bakedDirections[index] = direction
+                }
+            }
+            scanned += 1
+            cursor = cursor + 1 == count ? 0 : cursor + 1
+        }
+
+        guard !staleIndices.isEmpty else { return [] }
+
+        positions.withUnsafeBufferPointer { positions in
+            dc.withUnsafeBufferPointer { dc in
+                rest.withUnsafeBufferPointer { rest in
+                    colors.withUnsafeMutableBufferPointer { colors in
+                        SphericalHarmonics.evaluate(degree: degree,
+                                                    positions: positions,
+                                                    dc: dc,
+                                                    rest: rest,
+                                                    viewPosition: viewPosition,
+                                                    indices: staleIndices,
+                                                    into: colors)
+                    }
+                }
+            }
+        }
+
+        return staleIndices
+    }
+}
@@ -0,0 +1,59 @@
+import Foundation
+
+// A single render-ready gaussian splat.
+// Keep in sync with MetalSplatter's Shaders.metal : Splat
+public struct Splat {
+    public var position: SIMD3<Float>
+    public var color: SIMD4<Float> // Linear R, G, B, opacity
+    public var scale: SIMD3<Float>
+    // Normalized, with the real part first: (r, i, j, k), matching the rot_0...rot_3 order of 3DGS PLY files
+    public var rotation: SIMD4<Float>
+
+    public init(position: SIMD3<Float>,
+                color: SIMD4<Float>,
+                scale: SIMD3<Float>,
+                rotation: SIMD4<Float>) {
+        self.position = position
+        self.color = color
+        self.scale = scale
+        self.rotation = rotation
+    }
+
+    // Converts the raw values stored by 3DGS training (log-scale, opacity logit, unnormalized rotation and
+    // the DC spherical harmonic coefficient) into their render-ready form.
+    public init(position: SIMD3<Float>,
+                sphericalHarmonicsDC: SIMD3<Float>,
+                opacityLogit: Float,
+                logScale: SIMD3<Float>,
+                rotation: SIMD4<Float>) {
+        let color = SphericalHarmonics.color(dc: sphericalHarmonicsDC)
+        let opacity = 1 / (1 + exp(-opacityLogit))
+        let rotationLength = rotation.lengthSquared.squareRoot()
+        self.init(position: position,
+                  color: .init(x: color.x, y: color.y, z: color.z, w: opacity),
+                  scale: .init(x: exp(logScale.x), y: exp(logScale.y), z: exp(logScale.z)),
+                  rotation: rotationLength > 0 ? rotation / rotationLength : .init(x: 1, y: 0, z: 0, w: 0))
+    }
+
+    public var opacity: Float {
+        get { color.w }
+        set { color.w = newValue }
+    }
+}
+
+extension Splat {
+    // Rows of the rotation matrix R, which takes the splat's local axes to world space
+    var rotationMatrixRows: (SIMD3<Float>, SIMD3<Float>, SIMD3<Float>) {
+        let (w, x, y, z) = (rotation.x, rotation.y, rotation.z, rotation.w)
+        return (SIMD3<Float>(1 - 2 * (y * y + z * z), 2 * (x * y - w * z), 2 * (x * z + w * y)),
+                SIMD3<Float>(2 * (x * y + w * z), 1 - 2 * (x * x + z * z), 2 * (y * z - w * x)),
+                SIMD3<Float>(2 * (x * z - w * y), 2 * (y * z + w * x), 1 - 2 * (x * x + y * y)))
+    }
+
+    // The world-space vector v expressed in the splat's local frame, in units of its standard deviations: S⁻¹ Rᵀ v
+    func localVector(_ v: SIMD3<Float>) -> SIMD3<Float> {
+        let (row0, row1, row2) = rotationMatrixRows
+        let rotated = row0 * v.x + row1 * v.y + row2 * v.z
+        return rotated / pointwiseMax(scale, SIMD3<Float>(repeating: .leastNormalMagnitude))
+    }
+}
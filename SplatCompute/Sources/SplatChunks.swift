@@ -0,0 +1,80 @@
+import Foundation
+
+// A partition of a set of splats into small, spatially coherent chunks, each with a bounding box, so that
+// CPU-side visibility decisions can be made per chunk rather than per splat.
+// Splats are ordered along a Morton (Z-order) curve and then cut into runs of chunkSize.
+public struct SplatChunks {
+    public struct Chunk {
+        // Range of positions in SplatChunks.indices
+        public var range: Range<Int>
+        // Bounds of the chunk's splats, including their footprint (see Splat.boundingRadius)
+        public var bounds: Bounds
+    }
+
+    public static let defaultChunkSize = 1024
+
+    // Splat indices, ordered so that each chunk's splats are contiguous
+    public let indices: [UInt32]
+    public let chunks: [Chunk]
+    public let bounds: Bounds
+
+    public var splatCount: Int { indices.count }
+
+    public init(splats: UnsafeBufferPointer<Splat>, chunkSize: Int = defaultChunkSize) {
+        precondition(chunkSize > 0)
+
+        var sceneBounds = Bounds.empty
+        for splat in splats {
+            sceneBounds.formUnion(splat.position)
+        }
+
+        let mortonBits: UInt32 = 10
+        let mortonMax = Float((1 << mortonBits) - 1)
+        let extent = sceneBounds.isEmpty ? SIMD3<Float>(repeating: 1) : pointwiseMax(sceneBounds.extent, SIMD3<Float>(repeating: .leastNormalMagnitude))
+        let keyedIndices: [(code: UInt32, index: UInt32)] = splats.indices.map { i in
+            let normalized = (splats[i].position - sceneBounds.min) / extent
+            let scaled = (normalized * mortonMax).clamped(lowerBound: .zero, upperBound: SIMD3<Float>(repeating: mortonMax))
+            let quantized = SIMD3<UInt32>(scaled, rounding: .down)
+            return (code: Self.mortonCode(quantized), index: UInt32(i))
+        }
+        let sortedIndices = keyedIndices.sorted { $0.code < $1.code }.map { $0.index }
+
+        var chunks: [Chunk] = []
+        chunks.reserveCapacity((sortedIndices.count + chunkSize - 1) / chunkSize)
+        var bounds = Bounds.empty
+        for start in stride(from: 0, to: sortedIndices.count, by: chunkSize) {
+            let range = start..<min(start + chunkSize, sortedIndices.count)
+            var chunkBounds = Bounds.empty
+            for index in sortedIndices[range] {
+                chunkBounds.formUnion(splats[Int(index)].bounds)
+            }
+            bounds.formUnion(chunkBounds)
+            chunks.append(Chunk(range: range, bounds: chunkBounds))
+        }
+
+        self.indices = sortedIndices
+        self.chunks = chunks
+        self.bounds = bounds
+    }
+
+    public init(splats: [Splat], chunkSize: Int = defaultChunkSize) {
+        self = splats.withUnsafeBufferPointer { SplatChunks(splats: $0, chunkSize: chunkSize) }
+    }
+
+    public func splatIndices(inChunk chunkIndex: Int) -> ArraySlice<UInt32> {
+        indices[chunks[chunkIndex].range]
+    }
+
+    // Interleave the bits of three 10-bit coordinates
+    static func mortonCode(_ coordinates: SIMD3<UInt32>) -> UInt32 {
+        func spread(_ value: UInt32) -> UInt32 {
+            var x = value & 0x3ff
+            x = (x | (x << 16)) & 0x030000ff
+            x = (x | (x <<  8)) & 0x0300f00f
+            x = (x | (x <<  4)) & 0x030c30c3
+            x = (x | (x <<  2)) & 0x09249249
+            return x
+        }
+        return spread(coordinates.x) | (spread(coordinates.y) << 1) | (spread(coordinates.z) << 2)
+    }
+}
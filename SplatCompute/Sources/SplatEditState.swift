@@ -0,0 +1,186 @@
+import Foundation
+
+// Bookkeeping for an editable splat store, kept alongside it and indexed the same way.
+//
+// Deleted splats are tombstoned rather than removed, so indices held elsewhere (sort orders, selections, caches)
+// stay valid; once enough have accumulated, the store is compacted using compactionRemap(). Hidden splats keep
+// their opacity here so it can be restored. Every modification is recorded in dirtyRanges, so that whatever
+// mirrors the store (GPU copies, spatial indices) only needs to revisit those ranges.
+public struct SplatEditState {
+    public struct Flags: OptionSet {
+        public let rawValue: UInt8
+
+        public init(rawValue: UInt8) {
+            self.rawValue = rawValue
+        }
+
+        public static let deleted = Flags(rawValue: 1 << 0)
+        public static let hidden  = Flags(rawValue: 1 << 1)
+    }
+
+    // Indexed like the store; empty flags mean the splat is drawn
+    public private(set) var flags: [Flags] = []
+    // Opacity of each hidden splat, to restore when it's shown again
+    private var hiddenOpacities: [Int: Float] = [:]
+    public private(set) var deletedCount = 0
+    public var dirtyRanges = DirtyRanges()
+    // Incremented on every change, so that work started from a snapshot (e.g. a background compaction) can tell
+    // whether it's still current
+    public private(set) var generation = 0
+
+    public init() {}
+
+    public var count: Int { flags.count }
+
+    public var hiddenCount: Int { hiddenOpacities.count }
+
+    // True if any splat is deleted or hidden, i.e. if some indices must be left out of the draw
+    public var hasUndrawnSplats: Bool {
+        deletedCount > 0 || !hiddenOpacities.isEmpty
+    }
+
+    public var deletedFraction: Double {
+        flags.isEmpty ? 0 : Double(deletedCount) / Double(flags.count)
+    }
+
+    public func isDrawn(_ index: Int) -> Bool {
+        flags[index].isEmpty
+    }
+
+    // Newly added splats; these aren't dirty, since the store has just written them anyway
+    public mutating func append(count: Int) {
+        flags.append(contentsOf: repeatElement([], count: count))
+        generation += 1
+    }
+
+    public mutating func removeAll() {
+        flags = []
+        hiddenOpacities = [:]
+        deletedCount = 0
+        dirtyRanges.removeAll()
+        generation += 1
+    }
+
+    public mutating func markDirty(_ index: Int) {
+        dirtyRanges.insert(index)
+        generation += 1
+    }
+
+    // Returns false if the splat was already deleted
+    @discardableResult
+    public mutating func markDeleted(_ index: Int) -> Bool {
+        guard !flags[index].contains(.deleted) else { return false }
+        flags[index].insert(.deleted)
+        hiddenOpacities[index] = nil
+        deletedCount += 1
+        markDirty(index)
+        return true
+    }
+
+    // Returns false if the splat was already hidden or deleted
+    @discardableResult
+    public mutating func markHidden(_ index: Int, opacity: Float) -> Bool {
+        guard flags[index].isEmpty else { return false }
+        flags[index].insert(.hidden)
+        hiddenOpacities[index] = opacity
+        markDirty(index)
+        return true
+    }
+
+    // Returns the opacity to restore, or nil if the splat wasn't hidden
+    public mutating func markShown(_ index: Int) -> Float? {
+        guard flags[index] == .hidden, let opacity = hiddenOpacities.removeValue(forKey: index) else { return nil }
+        flags[index].remove(.hidden)
+        markDirty(index)
+        return opacity
+    }
+
+    // The opacity a splat will have once shown, if it's hidden
+    public func hiddenOpacity(_ index: Int) -> Float? {
+        hiddenOpacities[index]
+    }
+
+    // For each splat, its index after compaction, or -1 if it's deleted. Surviving splats keep their relative order.
+    public func compactionRemap() -> [Int32] {
+        var nextIndex: Int32 = 0
+        return flags.map { flags in
+            guard !flags.contains(.deleted) else { return -1 }
+            defer { nextIndex += 1 }
+            return nextIndex
+        }
+    }
+
+    // Applies a compaction computed by compactionRemap(); the store must have been compacted the same way
+    public mutating func compact(remap: [Int32]) {
+        precondition(remap.count == flags.count)
+        var newFlags: [Flags] = []
+        newFlags.reserveCapacity(flags.count - deletedCount)
+        var newHiddenOpacities: [Int: Float] = [:]
+        for (oldIndex, newIndex) in remap.enumerated() where newIndex >= 0 {
+            newFlags.append(flags[oldIndex])
+            if let opacity = hiddenOpacities[oldIndex] {
+                newHiddenOpacities[Int(newIndex)] = opacity
+            }
+        }
+        flags = newFlags
+        hiddenOpacities = newHiddenOpacities
+        deletedCount = 0
+        dirtyRanges.removeAll()
+        generation += 1
+    }
+
+    // Renumbers a draw or sort order through a compaction remap, dropping removed splats and keeping the relative
+    // order of the rest, so a sorted order stays sorted
+    public static func apply<Index: FixedWidthInteger>(remap: [Int32], to order: inout [Index]) {
+        order = order.compactMap { index in
+            let newIndex = remap[Int(index)]
+            return newIndex >= 0 ? Index(newIndex) : nil
+        }
+    }
+}
+
+// A set of index ranges, for tracking which parts of a buffer have been modified.
+// Insertion is cheap (adjacent and repeated indices extend the last range); coalesced() sorts and merges.
+public struct DirtyRanges {
+    private var ranges: [Range<Int>] = []
+
+    public init() {}
+
+    public var isEmpty: Bool { ranges.isEmpty }
+
+    public mutating func insert(_ index: Int) {
+        insert(index..<(index + 1))
+    }
+
+    public mutating func insert(_ range: Range<Int>) {
+        guard !range.isEmpty else { return }
+        if let last = ranges.last, range.lowerBound <= last.upperBound && range.upperBound >= last.lowerBound {
+            ranges[ranges.count - 1] = min(last.lowerBound, range.lowerBound)..<max(last.upperBound, range.upperBound)
+        } else {
+            ranges.append(range)
+        }
+    }
+
+    public mutating func removeAll() {
+        ranges = []
+    }
+
+    // Sorted, non-overlapping, non-adjacent ranges covering everything inserted
+    public func coalesced() -> [Range<Int>] {
+        var result: [Range<Int>] = []
+        for range in ranges.sorted(by: { $0.lowerBound < $1.lowerBound }) {
+            if let last = result.last, range.lowerBound <= last.upperBound {
+                result[result.count - 1] = last.lowerBound..<max(last.upperBound, range.upperBound)
+            } else {
+                result.append(range)
+            }
+        }
+        return result
+    }
+
+    // Returns the coalesced ranges, and clears them
+    public mutating func take() -> [Range<Int>] {
+        defer { removeAll() }
+        return coalesced()
+    }
+}
@@ -0,0 +1,270 @@
+import Foundation
+
+// One pool of worker threads shared by the library's parallel algorithms (depth sorting, spherical harmonics baking,
+// sort table builds, loading, compaction), so they no longer each go wide across every core at once, as they did
+// with their own concurrentPerform calls and Tasks, and oversubscribe the device.
+//
+// Work comes in priority classes, and a worker always takes the most urgent work there is: background work split into
+// small pieces can hold up a frame's sort by no more than one piece. Each worker keeps a queue per class, taking its
+// own newest work first (while its data is still in cache) and, when it has none, stealing the oldest from the other
+// workers. Work submitted from outside the pool is spread across the workers' queues.
+//
+// parallelFor has the calling thread take part, so a loop makes progress even while every worker is busy, and a
+// parallelFor nested within another's iteration can't deadlock.
+public final class SplatExecutor {
+    public enum Priority: Int, CaseIterable, Comparable {
+        // Work the next frame waits on, like its depth sort
+        case frame
+        // Working out what's visible
+        case culling
+        // Loading, compaction and building sort tables
+        case background
+
+        public static func < (lhs: Priority, rhs: Priority) -> Bool {
+            lhs.rawValue < rhs.rawValue
+        }
+    }
+
+    public struct Statistics {
+        // Tasks run, per priority (indexed by rawValue)
+        public var tasksRun = Array(repeating: 0, count: Priority.allCases.count)
+        // Tasks a worker took from another's queue
+        public var steals = 0
+    }
+
+    // One core is left for the threads calling parallelFor, which take part in their loops
+    public static let defaultWorkerCount = max(1, ProcessInfo.processInfo.activeProcessorCount - 1)
+
+    // The executor the library uses. To use a different number of cores, replace it before starting any work.
+    public static var shared = SplatExecutor()
+
+    private static let workerKey = "SplatExecutor.worker"
+
+    public let workerCount: Int
+    private let workers: [Worker]
+    // Guards pendingCount, nextInjection, stopping and currentStatistics, and wakes idle workers
+    private let wake = NSCondition()
+    private var pendingCount = 0
+    private var nextInjection = 0
+    private var stopping = false
+    private var currentStatistics = Statistics()
+
+    public init(workerCount: Int = defaultWorkerCount) {
+        self.workerCount = max(1, workerCount)
+        workers = (0..<self.workerCount).map { _ in Worker() }
+        for index in 0..<self.workerCount {
+            let thread = Thread { [self] in
+                run(index)
+            }
+            thread.name = "SplatExecutor worker \(index)"
+            thread.qualityOfService = .userInitiated
+            thread.start()
+        }
+    }
+
+    // Runs body on a worker, some time later
+    public func async(priority: Priority, _ body: @escaping () -> Void) {
+        let index: Int
+        if let tag = Thread.current.threadDictionary[Self.workerKey] as? WorkerTag, tag.executor == ObjectIdentifier(self) {
+            index = tag.index
+        } else {
+            wake.lock()
+            nextInjection = (nextInjection + 1) % workerCount
+            index = nextInjection
+            wake.unlock()
+        }
+        workers[index].push(body, priority: priority)
+
+        wake.lock()
+        pendingCount += 1
+        wake.signal()
+        wake.unlock()
+    }
+
+    // Calls body with every index in 0..<iterations, spread across the workers and the calling thread, and returns
+    // once every call has, like DispatchQueue.concurrentPerform. Each iteration should be a chunk of work, not a
+    // single element.
+    public func parallelFor(iterations: Int, priority: Priority, _ body: (Int) -> Void) {
+        guard iterations > 1 else {
+            if iterations == 1 {
+                body(0)
+            }
+            return
+        }
+        withoutActuallyEscaping(body) { body in
+            let loop = ParallelLoop(iterations: iterations, body: body)
+            for _ in 0..<min(workerCount, iterations - 1) {
+                async(priority: priority) {
+                    loop.work()
+                }
+            }
+            loop.work()
+            // Helpers which haven't started yet will find nothing left to do, and don't need body
+            loop.finish()
+        }
+    }
+
+    // Stops the workers once they've run everything already submitted. The shared executor is never shut down.
+    public func shutdown() {
+        wake.lock()
+        defer { wake.unlock() }
+        stopping = true
+        wake.broadcast()
+    }
+
+    public var statistics: Statistics {
+        wake.lock()
+        defer { wake.unlock() }
+        return currentStatistics
+    }
+
+    private func run(_ index: Int) {
+        Thread.current.threadDictionary[Self.workerKey] = WorkerTag(executor: ObjectIdentifier(self), index: index)
+        while let task = nextTask(forWorker: index) {
+            task()
+        }
+    }
+
+    // Waits for the most urgent task there is, or returns nil once the executor's shut down and there are none left
+    private func nextTask(forWorker index: Int) -> (() -> Void)? {
+        while true {
+            if let taken = takeTask(forWorker: index) {
+                wake.lock()
+                pendingCount -= 1
+                currentStatistics.tasksRun[taken.priority.rawValue] += 1
+                if taken.stolen {
+                    currentStatistics.steals += 1
+                }
+                wake.unlock()
+                return taken.task
+            }
+
+            wake.lock()
+            if pendingCount == 0 {
+                if stopping {
+                    wake.unlock()
+                    return nil
+                }
+                wake.wait()
+            }
+            wake.unlock()
+        }
+    }
+
+    private func takeTask(forWorker index: Int) -> (task: () -> Void, priority: Priority, stolen: Bool)? {
+        for priority in Priority.allCases {
+            if let task = workers[index].popNewest(priority: priority) {
+                return (task, priority, false)
+            }
+            for offset in 1..<workerCount {
+                if let task = workers[(index + offset) % workerCount].popOldest(priority: priority) {
+                    return (task, priority, true)
+                }
+            }
+        }
+        return nil
+    }
+}
+
+private final class WorkerTag {
+    let executor: ObjectIdentifier
+    let index: Int
+
+    init(executor: ObjectIdentifier, index: Int) {
+        self.executor = executor
+        self.index = index
+    }
+}
+
+// A worker's queues, one per priority: the worker takes from the back, thieves from the front
+private final class Worker {
+    private struct Queue {
+        var tasks: [(() -> Void)?] = []
+        var head = 0
+
+        mutating func popLast() -> (() -> Void)? {
+            guard head < tasks.count else { return nil }
+            let task = tasks.removeLast()
+            resetIfEmpty()
+            return task
+        }
+
+        mutating func popFirst() -> (() -> Void)? {
+            guard head < tasks.count else { return nil }
+            let task = tasks[head]
+            tasks[head] = nil
+            head += 1
+            resetIfEmpty()
+            return task
+        }
+
+        private mutating func resetIfEmpty() {
+            if head == tasks.count {
+                tasks.removeAll(keepingCapacity: true)
+                head = 0
+            }
+        }
+    }
+
+    private let lock = NSLock()
+    private var queues = Array(repeating: Queue(), count: SplatExecutor.Priority.allCases.count)
+
+    func push(_ task: @escaping () -> Void, priority: SplatExecutor.Priority) {
+        lock.lock()
+        defer { lock.unlock() }
+        queues[priority.rawValue].tasks.append(task)
+    }
+
+    func popNewest(priority: SplatExecutor.Priority) -> (() -> Void)? {
+        lock.lock()
+        defer { lock.unlock() }
+        return queues[priority.rawValue].popLast()
+    }
+
+    func popOldest(priority: SplatExecutor.Priority) -> (() -> Void)? {
+        lock.lock()
+        defer { lock.unlock() }
+        return queues[priority.rawValue].popFirst()
+    }
+}
+
+// The shared state of one parallelFor: iterations are handed out one at a time to whichever thread asks next
+private final class ParallelLoop {
+    private let condition = NSCondition()
+    private let iterations: Int
+    private var body: ((Int) -> Void)?
+    private var next = 0
+    private var running = 0
+
+    init(iterations: Int, body: @escaping (Int) -> Void) {
+        self.iterations = iterations
+        self.body = body
+    }
+
+    func work() {
+        condition.lock()
+        while next < iterations, let body {
+            let index = next
+            next += 1
+            running += 1
+            condition.unlock()
+            body(index)
+            condition.lock()
+            running -= 1
+        }
+        if running == 0 {
+            condition.broadcast()
+        }
+        condition.unlock()
+    }
+
+    // Waits for iterations other threads are still running, then lets go of body
+    func finish() {
+        condition.lock()
+        defer { condition.unlock() }
+        while running > 0 {
+            condition.wait()
+        }
+        body = nil
+    }
+}
@@ -0,0 +1,149 @@
+import Foundation
+#if canImport(simd)
+import simd
+#endif
+
+// Places splat assets into a scene any number of times, each instance with its own transform, so that everything
+// can be sorted into a single depth order and blended correctly against everything else.
+//
+// Assets are ranges of a shared splat store, and instances of the same asset share its storage. The draw order is
+// made of "instanced splat" indices: each visible instance is given a contiguous block of them (see Layout), so
+// an (instance, splat) pair fits in one UInt32, and the instance can be found again by binary search.
+public struct SplatInstances {
+    public struct Instance {
+        public var asset: Int
+        public var transform: Float4x4
+        public var isHidden: Bool
+    }
+
+    // A visible instance's place in the draw order.
+    // Keep in sync with MetalSplatter's Shaders.metal : SplatInstance
+    public struct Placement {
+        public var transform: Float4x4
+        // Index in the store of the first splat of the instance's asset
+        public var splatOffset: UInt32
+        // First instanced splat index of the instance
+        public var orderOffset: UInt32
+        public var count: UInt32
+
+        public init(transform: Float4x4, splatOffset: UInt32, orderOffset: UInt32, count: UInt32) {
+            self.transform = transform
+            self.splatOffset = splatOffset
+            self.orderOffset = orderOffset
+            self.count = count
+        }
+    }
+
+    public struct Layout {
+        // Ordered by orderOffset, without gaps, and with no empty placements
+        public let placements: [Placement]
+        // The instance each placement came from, so their transforms can be refreshed without a new layout
+        public let instanceIndices: [Int]
+        public let instancedSplatCount: Int
+        // True for the single identity placement of a whole store, where instanced splat indices are store indices
+        public let isIdentity: Bool
+
+        init(placements: [Placement], instanceIndices: [Int], isIdentity: Bool) {
+            self.placements = placements
+            self.instanceIndices = instanceIndices
+            self.instancedSplatCount = placements.last.map { Int($0.orderOffset + $0.count) } ?? 0
+            self.isIdentity = isIdentity
+        }
+
+        // The whole store, once, untransformed
+        public static func identity(splatCount: Int) -> Layout {
+            let placements = splatCount == 0 ? [] : [ Placement(transform: Float4x4(diagonal: SIMD4<Float>(1, 1, 1, 1)),
+                                                                 splatOffset: 0,
+                                                                 orderOffset: 0,
+                                                                 count: UInt32(splatCount)) ]
+            return Layout(placements: placements, instanceIndices: [], isIdentity: true)
+        }
+
+        public func placementIndex(ofInstancedSplat index: Int) -> Int {
+            var lower = 0
+            var upper = placements.count
+            while upper - lower > 1 {
+                let middle = (lower + upper) / 2
+                if Int(placements[middle].orderOffset) <= index {
+                    lower = middle
+                } else {
+                    upper = middle
+                }
+            }
+            return lower
+        }
+
+        // The index in the store of an instanced splat
+        public func splatIndex(ofInstancedSplat index: Int) -> Int {
+            guard !isIdentity else { return index }
+            let placement = placements[placementIndex(ofInstancedSplat: index)]
+            return Int(placement.splatOffset) + index - Int(placement.orderOffset)
+        }
+
+        public func worldPosition(ofInstancedSplat index: Int, splats: UnsafeBufferPointer<Splat>) -> SIMD3<Float> {
+            guard !isIdentity else { return splats[index].position }
+            let placement = placements[placementIndex(ofInstancedSplat: index)]
+            let position = splats[Int(placement.splatOffset) + index - Int(placement.orderOffset)].position
+            return (placement.transform * SIMD4<Float>(position.x, position.y, position.z, 1)).xyz
+        }
+    }
+
+    public private(set) var assets: [Range<Int>] = []
+    public private(set) var instances: [Instance] = []
+
+    public init() {}
+
+    public var isEmpty: Bool { instances.isEmpty }
+
+    // Registers a range of the store as an asset, and returns its index
+    public mutating func addAsset(_ range: Range<Int>) -> Int {
+        assets.append(range)
+        return assets.count - 1
+    }
+
+    public mutating func addInstance(of asset: Int, transform: Float4x4) -> Int {
+        precondition(assets.indices.contains(asset))
+        instances.append(Instance(asset: asset, transform: transform, isHidden: false))
+        return instances.count - 1
+    }
+
+    public mutating func setTransform(_ transform: Float4x4, ofInstance instance: Int) {
+        instances[instance].transform = transform
+    }
+
+    public mutating func setHidden(_ isHidden: Bool, ofInstance instance: Int) {
+        instances[instance].isHidden = isHidden
+    }
+
+    public mutating func removeAll() {
+        assets = []
+        instances = []
+    }
+
+    // The current placements, with the given layout's offsets (so that they match a draw order built for it) but
+    // the instances' current transforms
+    public func placements(refreshing layout: Layout) -> [Placement] {
+        var placements = layout.placements
+        for (placementIndex, instanceIndex) in layout.instanceIndices.enumerated() where instances.indices.contains(instanceIndex) {
+            placements[placementIndex].transform = instances[instanceIndex].transform
+        }
+        return placements
+    }
+
+    public var layout: Layout {
+        var placements: [Placement] = []
+        var instanceIndices: [Int] = []
+        var orderOffset: UInt32 = 0
+        for (instanceIndex, instance) in instances.enumerated() where !instance.isHidden {
+            let range = assets[instance.asset]
+            guard !range.isEmpty else { continue }
+            placements.append(Placement(transform: instance.transform,
+                                        splatOffset: UInt32(range.lowerBound),
+                                        orderOffset: orderOffset,
+                                        count: UInt32(range.count)))
+            instanceIndices.append(instanceIndex)
+            orderOffset += UInt32(range.count)
+        }
+        return Layout(placements: placements, instanceIndices: instanceIndices, isIdentity: false)
+    }
+}
@@ -0,0 +1,267 @@
+import Foundation
+
+// A level-of-detail tree over a set of splats. Every node, leaf or interior, is represented by a single splat in
+// `splats`; an interior node's splat approximates all of its descendants, so any cut through the tree (a set of
+// nodes which covers every leaf exactly once) is a renderable version of the scene.
+//
+// SplatLODSelector relies on errors being monotonic: a node's geometricError must be at least that of each of
+// its children, and its bounds must contain theirs. The builder below guarantees this; hierarchies produced
+// elsewhere and passed to init(splats:nodes:childIndices:root:) must too.
+public struct SplatLODHierarchy {
+    public struct Node {
+        // Index into SplatLODHierarchy.splats of the splat which represents this node
+        public var splatIndex: UInt32
+        public var parent: Int?
+        // Range of positions in SplatLODHierarchy.childIndices; empty for leaves
+        public var children: Range<Int>
+        // Bounds of all the node's descendants' splats
+        public var bounds: Bounds
+        // World-space size of the detail lost by drawing this node instead of its descendants; zero for leaves
+        public var geometricError: Float
+
+        public init(splatIndex: UInt32, parent: Int?, children: Range<Int>, bounds: Bounds, geometricError: Float) {
+            self.splatIndex = splatIndex
+            self.parent = parent
+            self.children = children
+            self.bounds = bounds
+            self.geometricError = geometricError
+        }
+
+        public var isLeaf: Bool { children.isEmpty }
+    }
+
+    public static let defaultBranchingFactor = 8
+
+    public let splats: [Splat]
+    public let nodes: [Node]
+    public let childIndices: [Int]
+    // nil only for an empty hierarchy
+    public let root: Int?
+
+    public init(splats: [Splat], nodes: [Node], childIndices: [Int], root: Int?) {
+        self.splats = splats
+        self.nodes = nodes
+        self.childIndices = childIndices
+        self.root = root
+    }
+
+    // Builds a hierarchy bottom-up: each level is ordered along a Morton curve and cut into groups of
+    // branchingFactor, each of which is merged into a single parent splat. The leaves keep their indices, so
+    // splats[0..<leaves.count] == leaves; merged splats follow.
+    public init(leaves: [Splat], branchingFactor: Int = defaultBranchingFactor) {
+        precondition(branchingFactor >= 2)
+
+        var splats = leaves
+        var nodes = leaves.indices.map {
+            Node(splatIndex: UInt32($0), parent: nil, children: 0..<0, bounds: leaves[$0].bounds, geometricError: 0)
+        }
+        var childIndices: [Int] = []
+
+        var level = Array(nodes.indices)
+        while level.count > 1 {
+            let groups = SplatChunks(splats: level.map { splats[Int(nodes[$0].splatIndex)] }, chunkSize: branchingFactor)
+            var nextLevel: [Int] = []
+            nextLevel.reserveCapacity(groups.chunks.count)
+            for groupIndex in groups.chunks.indices {
+                let members = groups.splatIndices(inChunk: groupIndex).map { level[Int($0)] }
+                guard members.count > 1 else {
+                    nextLevel.append(members[0])
+                    continue
+                }
+
+                let merged = Self.merge(members.map { splats[Int(nodes[$0].splatIndex)] })
+                let parentIndex = nodes.count
+                let childStart = childIndices.count
+                var bounds = merged.bounds
+                var geometricError = merged.boundingRadius
+                for member in members {
+                    nodes[member].parent = parentIndex
+                    childIndices.append(member)
+                    bounds.formUnion(nodes[member].bounds)
+                    geometricError = max(geometricError, nodes[member].geometricError)
+                }
+                nodes.append(Node(splatIndex: UInt32(splats.count),
+                                  parent: nil,
+                                  children: childStart..<childIndices.count,
+                                  bounds: bounds,
+                                  geometricError: geometricError))
+                splats.append(merged)
+                nextLevel.append(parentIndex)
+            }
+            level = nextLevel
+        }
+
+        self.init(splats: splats, nodes: nodes, childIndices: childIndices, root: level.first)
+    }
+
+    public var leafCount: Int {
+        nodes.reduce(0) { $0 + ($1.isLeaf ? 1 : 0) }
+    }
+
+    public func children(of nodeIndex: Int) -> ArraySlice<Int> {
+        childIndices[nodes[nodeIndex].children]
+    }
+
+    // Moment-matching merge: the parent has the weighted mean position and colour of its children, and the
+    // covariance of their mixture (both their spread and their own extents), taken apart into the parent's own
+    // rotation and scale. Weights are opacity times (roughly) surface area, so small faint splats don't drag the
+    // parent around.
+    static func merge(_ splats: [Splat]) -> Splat {
+        var weights = splats.map { splat -> Float in
+            let s = splat.scale
+            return splat.opacity * (s.x * s.y + s.y * s.z + s.z * s.x)
+        }
+        var totalWeight = weights.reduce(0, +)
+        if !(totalWeight > 0) {
+            weights = Array(repeating: 1, count: splats.count)
+            totalWeight = Float(splats.count)
+        }
+
+        var position = SIMD3<Float>.zero
+        var color = SIMD3<Float>.zero
+        var opacity: Float = 0
+        for (splat, weight) in zip(splats, weights) {
+            position += splat.position * weight
+            color += splat.color.xyz * weight
+            opacity = max(opacity, splat.opacity)
+        }
+        position /= totalWeight
+        color /= totalWeight
+
+        var covariance = SymmetricMatrix3()
+        for (splat, weight) in zip(splats, weights) {
+            let offset = splat.position - position
+            covariance.add(splat.covariance, weight: weight)
+            covariance.add(SymmetricMatrix3(outerProductOf: offset), weight: weight)
+        }
+        covariance.scale(by: 1 / totalWeight)
+        let (variances, axes) = covariance.eigendecomposition()
+
+        return Splat(position: position,
+                     color: SIMD4<Float>(color.x, color.y, color.z, opacity),
+                     scale: pointwiseMax(variances, .zero).squareRoot(),
+                     rotation: SymmetricMatrix3.quaternion(rotatingTo: axes))
+    }
+}
+
+private extension Splat {
+    // The splat's world-space covariance, R S² Rᵀ
+    var covariance: SymmetricMatrix3 {
+        let (row0, row1, row2) = rotationMatrixRows
+        let scaleSquared = scale * scale
+        return SymmetricMatrix3(xx: (row0 * row0 * scaleSquared).sum(),
+                                yy: (row1 * row1 * scaleSquared).sum(),
+                                zz: (row2 * row2 * scaleSquared).sum(),
+                                xy: (row0 * row1 * scaleSquared).sum(),
+                                xz: (row0 * row2 * scaleSquared).sum(),
+                                yz: (row1 * row2 * scaleSquared).sum())
+    }
+}
+
+// Just enough of a symmetric 3x3 matrix for merging covariances
+private struct SymmetricMatrix3 {
+    var xx: Float = 0
+    var yy: Float = 0
+    var zz: Float = 0
+    var xy: Float = 0
+    var xz: Float = 0
+    var yz: Float = 0
+
+    init() {}
+
+    init(xx: Float, yy: Float, zz: Float, xy: Float, xz: Float, yz: Float) {
+        (self.xx, self.yy, self.zz, self.xy, self.xz, self.yz) = (xx, yy, zz, xy, xz, yz)
+    }
+
+    // v vᵀ
+    init(outerProductOf v: SIMD3<Float>) {
+        self.init(xx: v.x * v.x, yy: v.y * v.y, zz: v.z * v.z, xy: v.x * v.y, xz: v.x * v.z, yz: v.y * v.z)
+    }
+
+    mutating func add(_ other: SymmetricMatrix3, weight: Float) {
+        xx += other.xx * weight
+        yy += other.yy * weight
+        zz += other.zz * weight
+        xy += other.xy * weight
+        xz += other.xz * weight
+        yz += other.yz * weight
+    }
+
+    mutating func scale(by factor: Float) {
+        xx *= factor
+        yy *= factor
+        zz *= factor
+        xy *= factor
+        xz *= factor
+        yz *= factor
+    }
+
+    // Eigenvalues, and the corresponding unit eigenvectors as the columns of a rotation (rows[i][j] is row i,
+    // column j), by cyclic Jacobi rotations
+    func eigendecomposition() -> (values: SIMD3<Float>, rows: [SIMD3<Float>]) {
+        var a = [ SIMD3<Float>(xx, xy, xz), SIMD3<Float>(xy, yy, yz), SIMD3<Float>(xz, yz, zz) ]
+        var v = [ SIMD3<Float>(1, 0, 0), SIMD3<Float>(0, 1, 0), SIMD3<Float>(0, 0, 1) ]
+        for _ in 0..<16 {
+            let diagonal = abs(a[0][0]) + abs(a[1][1]) + abs(a[2][2])
+            var converged = true
+            for (p, q) in [ (0, 1), (0, 2), (1, 2) ] {
+                let apq = a[p][q]
+                guard abs(apq) > 1e-7 * diagonal, apq != 0 else { continue }
+                converged = false
+                // Zeroes a[p][q]; see Numerical Recipes, 11.1
+                let theta = (a[q][q] - a[p][p]) / (2 * apq)
+                let t = (theta >= 0 ? 1 : -1) / (abs(theta) + (theta * theta + 1).squareRoot())
+                let c = 1 / (t * t + 1).squareRoot()
+                let s = t * c
+                for k in 0..<3 {
+                    let (akp, akq) = (a[k][p], a[k][q])
+                    a[k][p] = c * akp - s * akq
+                    a[k][q] = s * akp + c * akq
+                }
+                for k in 0..<3 {
+                    let (apk, aqk) = (a[p][k], a[q][k])
+                    a[p][k] = c * apk - s * aqk
+                    a[q][k] = s * apk + c * aqk
+                }
+                for k in 0..<3 {
+                    let (vkp, vkq) = (v[k][p], v[k][q])
+                    v[k][p] = c * vkp - s * vkq
+                    v[k][q] = s * vkp + c * vkq
+                }
+            }
+            if converged {
+                break
+            }
+        }
+        // A proper rotation, rather than a reflection
+        if v[0].dot(v[1].cross(v[2])) < 0 {
+            for k in 0..<3 {
+                v[k][2] = -v[k][2]
+            }
+        }
+        return (values: SIMD3<Float>(a[0][0], a[1][1], a[2][2]), rows: v)
+    }
+
+    // The unit quaternion (r, i, j, k) of the rotation matrix with the given rows
+    static func quaternion(rotatingTo rows: [SIMD3<Float>]) -> SIMD4<Float> {
+        let (m00, m01, m02) = (rows[0].x, rows[0].y, rows[0].z)
+        let (m10, m11, m12) = (rows[1].x, rows[1].y, rows[1].z)
+        let (m20, m21, m22) = (rows[2].x, rows[2].y, rows[2].z)
+        let trace = m00 + m11 + m22
+        let q: SIMD4<Float>
+        if trace > 0 {
+            let s = (trace + 1).squareRoot() * 2
+            q = SIMD4<Float>(s / 4, (m21 - m12) / s, (m02 - m20) / s, (m10 - m01) / s)
+        } else if m00 > m11 && m00 > m22 {
+            let s = (1 + m00 - m11 - m22).squareRoot() * 2
+            q = SIMD4<Float>((m21 - m12) / s, s / 4, (m01 + m10) / s, (m02 + m20) / s)
+        } else if m11 > m22 {
+            let s = (1 + m11 - m00 - m22).squareRoot() * 2
+            q = SIMD4<Float>((m02 - m20) / s, (m01 + m10) / s, s / 4, (m12 + m21) / s)
+        } else {
+            let s = (1 + m22 - m00 - m11).squareRoot() * 2
+            q = SIMD4<Float>((m10 - m01) / s, (m02 + m20) / s, (m12 + m21) / s, s / 4)
+        }
+        return q / q.lengthSquared.squareRoot()
+    }
+}
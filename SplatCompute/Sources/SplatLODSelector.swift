@@ -0,0 +1,182 @@
+import Dispatch
+import Foundation
+
+// Chooses, each frame, a cut through a SplatLODHierarchy such that every node's projected error is under
+// maxPixelError pixels, while drawing no more than splatBudget splats. The resulting splatIndices (into
+// hierarchy.splats) are what should be sorted and drawn.
+//
+// The cut is kept between frames and adjusted incrementally: sibling groups whose parent is accurate enough are
+// merged, nodes which are too coarse are split (worst first), and when the budget binds, the least-needed groups
+// are merged so that worse nodes elsewhere can be split. Each update does at most maxPassesPerUpdate rounds of
+// this; after a large camera jump the cut converges over a few frames rather than stalling one.
+public class SplatLODSelector {
+    public struct Configuration {
+        public var maxPixelError: Float
+        public var splatBudget: Int
+        public var maxPassesPerUpdate: Int
+
+        public init(maxPixelError: Float = 2,
+                    splatBudget: Int = 2_000_000,
+                    maxPassesPerUpdate: Int = 8) {
+            self.maxPixelError = maxPixelError
+            self.splatBudget = splatBudget
+            self.maxPassesPerUpdate = maxPassesPerUpdate
+        }
+    }
+
+    public struct Statistics {
+        public var cutSize = 0
+        public var refinedNodes = 0
+        public var coarsenedNodes = 0
+        // Largest projected error of any node in the cut; above maxPixelError only when the budget binds
+        // (or the cut hasn't converged yet)
+        public var maxPixelError: Float = 0
+        public var duration: TimeInterval = 0
+
+        public init() {}
+    }
+
+    // Nearer than this, distances are clamped, so a camera inside a node's bounds sees a large but finite error
+    static let minimumDistance: Float = 1e-4
+
+    public let hierarchy: SplatLODHierarchy
+    public var configuration: Configuration
+
+    public private(set) var cut: [Int] = []
+    // Indexed like hierarchy.nodes
+    private var inCut: [Bool]
+
+    public init(hierarchy: SplatLODHierarchy, configuration: Configuration = Configuration()) {
+        self.hierarchy = hierarchy
+        self.configuration = configuration
+        self.inCut = Array(repeating: false, count: hierarchy.nodes.count)
+        reset()
+    }
+
+    // Restart from the root
+    public func reset() {
+        for node in cut {
+            inCut[node] = false
+        }
+        cut = hierarchy.root.map { [ $0 ] } ?? []
+        for node in cut {
+            inCut[node] = true
+        }
+    }
+
+    public var splatIndices: [UInt32] {
+        cut.map { hierarchy.nodes[$0].splatIndex }
+    }
+
+    // The largest error, in pixels, of drawing this node rather than its descendants, as seen from any viewpoint.
+    // Zero for leaves and for nodes outside every viewpoint's frustum.
+    public func pixelError(ofNode nodeIndex: Int, viewpoints: [Viewpoint]) -> Float {
+        let node = hierarchy.nodes[nodeIndex]
+        guard node.geometricError > 0 else { return 0 }
+        var result: Float = 0
+        for viewpoint in viewpoints where !viewpoint.isOutsideFrustum(node.bounds) {
+            let distance = max(node.bounds.distanceSquared(to: viewpoint.position).squareRoot(), Self.minimumDistance)
+            result = max(result, node.geometricError * viewpoint.focalLength.y / distance)
+        }
+        return result
+    }
+
+    @discardableResult
+    public func update(viewpoint: Viewpoint) -> Statistics {
+        update(viewpoints: [ viewpoint ])
+    }
+
+    @discardableResult
+    public func update(viewpoints: [Viewpoint]) -> Statistics {
+        let startTime = DispatchTime.now()
+        var statistics = Statistics()
+
+        let threshold = configuration.maxPixelError
+        let budget = max(1, configuration.splatBudget)
+        func error(_ nodeIndex: Int) -> Float {
+            pixelError(ofNode: nodeIndex, viewpoints: viewpoints)
+        }
+
+        for _ in 0..<max(1, configuration.maxPassesPerUpdate) {
+            var count = cut.count
+            var added: [Int] = []
+
+            // Merge groups whose parent is accurate enough, and then, cheapest first, any more it takes to get under budget
+            var mergeable = mergeableParents().map { (node: $0, error: error($0)) }.sorted { $0.error < $1.error }
+            var mergeCount = 0
+            for (parent, parentError) in mergeable {
+                guard parentError <= threshold || count > budget else { break }
+                merge(parent)
+                added.append(parent)
+                count -= hierarchy.nodes[parent].children.count - 1
+                mergeCount += 1
+            }
+            mergeable.removeFirst(mergeCount)
+            statistics.coarsenedNodes += mergeCount
+            if mergeCount > 0 {
+                cut = cut.filter { inCut[$0] } + added
+                added = []
+            }
+
+            // Split nodes which are too coarse, worst first. When one doesn't fit in the budget, merge groups with
+            // a lower error to make room. (Monotonic errors mean a group with a lower error can't contain the node.)
+            let candidates = cut.compactMap { nodeIndex -> (node: Int, error: Float)? in
+                guard !hierarchy.nodes[nodeIndex].isLeaf else { return nil }
+                let nodeError = error(nodeIndex)
+                return nodeError > threshold ? (node: nodeIndex, error: nodeError) : nil
+            }.sorted { $0.error > $1.error }
+            var tradeIndex = 0
+            var refineCount = 0
+            for (node, nodeError) in candidates {
+                // Merged away by a trade for a worse node
+                guard inCut[node] else { continue }
+                let growth = hierarchy.nodes[node].children.count - 1
+                while count + growth > budget && tradeIndex < mergeable.count && mergeable[tradeIndex].error < nodeError {
+                    let parent = mergeable[tradeIndex].node
+                    tradeIndex += 1
+                    merge(parent)
+                    added.append(parent)
+                    count -= hierarchy.nodes[parent].children.count - 1
+                    statistics.coarsenedNodes += 1
+                }
+                guard count + growth <= budget else { continue }
+                inCut[node] = false
+                for child in hierarchy.children(of: node) {
+                    inCut[child] = true
+                    added.append(child)
+                }
+                count += growth
+                refineCount += 1
+            }
+            statistics.refinedNodes += refineCount
+
+            guard mergeCount > 0 || refineCount > 0 || tradeIndex > 0 else { break }
+            cut = cut.filter { inCut[$0] } + added
+        }
+
+        statistics.cutSize = cut.count
+        statistics.maxPixelError = cut.reduce(0) { max($0, error($1)) }
+        statistics.duration = TimeInterval(DispatchTime.now().uptimeNanoseconds - startTime.uptimeNanoseconds) / 1_000_000_000
+        return statistics
+    }
+
+    // Parents all of whose children are in the cut
+    private func mergeableParents() -> [Int] {
+        var checked = Set<Int>()
+        var result: [Int] = []
+        for nodeIndex in cut {
+            guard let parent = hierarchy.nodes[nodeIndex].parent, checked.insert(parent).inserted else { continue }
+            if hierarchy.children(of: parent).allSatisfy({ inCut[$0] }) {
+                result.append(parent)
+            }
+        }
+        return result
+    }
+
+    private func merge(_ parent: Int) {
+        for child in hierarchy.children(of: parent) {
+            inCut[child] = false
+        }
+        inCut[parent] = true
+    }
+}
@@ -0,0 +1,321 @@
+import Foundation
+#if canImport(simd)
+import simd
+#endif
+
+// A plain CPU rasterizer which follows MetalSplatter's shaders step for step: the same per-splat preprocessing
+// (covariance projection, quad axes and culling, once per splat), the same quad around each splat, the same gaussian
+// falloff and cutoff, and the same blending. It also has a sort-free weighted blended mode, which the GPU renderer
+// doesn't (yet), so its quality can be judged against the sorted result scene by scene first. It's slow, but it runs
+// anywhere (including Linux, headless), so it serves as the reference that renderer changes are checked against,
+// and as the "first frame" for benchmarks without a GPU.
+//
+// Images are premultiplied RGBA, with the origin at the bottom-left, like NDC and Viewpoint.pixelPosition.
+public struct SplatReferenceRenderer {
+    // Keep in sync with Shaders.metal : kBoundsRadius. The quad spans at most this many "standard deviations" (in the
+    // shader's units, where the falloff is exp(-v·v)) each way.
+    public static let boundsRadius: Float = 2
+    // Keep in sync with Shaders.metal : kAlphaCutoff. Fragments fainter than this couldn't change an 8-bit channel.
+    public static let alphaCutoff: Float = 1 / 255
+
+    public struct Image: Equatable {
+        public let width: Int
+        public let height: Int
+        public var pixels: [SIMD4<Float>]
+
+        public init(width: Int, height: Int) {
+            self.width = width
+            self.height = height
+            pixels = Array(repeating: .zero, count: width * height)
+        }
+
+        public subscript(x: Int, y: Int) -> SIMD4<Float> {
+            get { pixels[y * width + x] }
+            set { pixels[y * width + x] = newValue }
+        }
+
+        // How far this image is from the reference, channel by channel
+        public func difference(from reference: Image) -> ImageDifference {
+            precondition(width == reference.width && height == reference.height)
+            var difference = ImageDifference()
+            var sum: Double = 0
+            var sumOfSquares: Double = 0
+            for (pixel, referencePixel) in zip(pixels, reference.pixels) {
+                for channel in 0..<4 {
+                    let error = Double(abs(pixel[channel] - referencePixel[channel]))
+                    sum += error
+                    sumOfSquares += error * error
+                    difference.maxError = max(difference.maxError, error)
+                }
+            }
+            let count = Double(max(1, pixels.count * 4))
+            difference.meanAbsoluteError = sum / count
+            difference.rootMeanSquareError = (sumOfSquares / count).squareRoot()
+            difference.peakSignalToNoiseRatio = sumOfSquares == 0 ? .infinity : -10 * log10(sumOfSquares / count)
+            return difference
+        }
+    }
+
+    // Per channel of premultiplied RGBA, where 1 is the full range
+    public struct ImageDifference: Encodable {
+        public var meanAbsoluteError: Double = 0
+        public var rootMeanSquareError: Double = 0
+        public var maxError: Double = 0
+        // In dB; infinite for identical images
+        public var peakSignalToNoiseRatio: Double = 0
+    }
+
+    public enum Blending {
+        // Over, in depth order (front to back or back to front, per frontToBack), as SplatRenderer blends
+        case sorted
+        // Weighted blended order-independent transparency (McGuire and Bavoil, 2013), which needs no sort: each
+        // pixel's coverage is exact, 1 - ∏(1 - alpha), and its colour is the mean of its fragments' colours, weighted
+        // by depth and alpha. Where fragments of very different colours overlap, the result is a blend rather than the
+        // nearest one.
+        case weighted(WeightedBlending)
+    }
+
+    // A fragment's weight is alpha * (depthScale / depth)^depthExponent, clamped to weightRange. McGuire and Bavoil's
+    // weights use a fixed depth scale; gaussian scenes are thick stacks of mostly faint fragments, so a steep falloff
+    // relative to the scene's own depth keeps the nearest surface from being washed out by the many layers behind it.
+    public struct WeightedBlending {
+        public var depthExponent: Float = 4
+        // The depth at which a fragment's weight is its alpha; nil for the median depth of the splats drawn
+        public var depthScale: Float?
+        public var weightRange: ClosedRange<Float> = 1e-2...3e3
+
+        public init() {}
+
+        func weight(alpha: Float, depth: Float, depthScale: Float) -> Float {
+            let falloff = pow(depthScale / max(depth, .leastNormalMagnitude), depthExponent)
+            return alpha * min(max(falloff, weightRange.lowerBound), weightRange.upperBound)
+        }
+    }
+
+    // A splat as the preprocessing pass places it on screen (Shaders.metal : PreprocessedSplat, which holds the same
+    // values in NDC)
+    public struct ProjectedSplat {
+        // In pixels
+        public var center: SIMD2<Float>
+        // Half the quad's extent along each of the 2D gaussian's principal axes, divided by boundsRadius: the
+        // eigenvectors scaled by sqrt(2 * eigenvalue), in pixels
+        public var axis1: SIMD2<Float>
+        public var axis2: SIMD2<Float>
+        // Distance in front of the camera
+        public var depth: Float
+        public var color: SIMD4<Float>
+        // How far the quad extends along each axis, in units of axis1 and axis2 (see tightBoundsRadius(opacity:)); 0
+        // for splats too faint to show, which the shaders cull
+        public var boundsRadius: Float
+    }
+
+    public struct Statistics {
+        public var splatCount = 0
+        // Outside the frustum, as the preprocessing pass rejects them
+        public var culledSplats = 0
+        // Pixels inside splats' quads, i.e. fragment shader invocations: the fill rate
+        public var fragments = 0
+        // Fragments not discarded for lying outside the ellipse
+        public var blendedFragments = 0
+        public var duration: TimeInterval = 0
+    }
+
+    public var frontToBack: Bool
+    // Size each splat's quad by where its alpha falls below alphaCutoff, as the shaders do, rather than the full
+    // boundsRadius for every splat; the images differ by less than alphaCutoff per splat, while faint splats cost
+    // far fewer fragments
+    public var tightBounds: Bool
+    public var blending: Blending
+
+    // The renderer blends front to back (see SplatRenderer.Constants.renderFrontToBack)
+    public init(frontToBack: Bool = true, tightBounds: Bool = true, blending: Blending = .sorted) {
+        self.frontToBack = frontToBack
+        self.tightBounds = tightBounds
+        self.blending = blending
+    }
+
+    // Renders the splats in the given order, which must be front to back or back to front to match frontToBack
+    // (unless blending is weighted, when any order gives the same image)
+    public func render(splats: UnsafeBufferPointer<Splat>,
+                       order: [UInt32],
+                       viewpoint: Viewpoint) -> (image: Image, statistics: Statistics) {
+        let startTime = DispatchTime.now()
+        var image = Image(width: Int(viewpoint.screenSize.x), height: Int(viewpoint.screenSize.y))
+        var statistics = Statistics()
+        statistics.splatCount = order.count
+        let preprocessed = Self.preprocess(splats: splats, order: order, viewpoint: viewpoint)
+        statistics.culledSplats = preprocessed.reduce(0) { $1 == nil ? $0 + 1 : $0 }
+
+        switch blending {
+        case .sorted:
+            for case let projected? in preprocessed {
+                rasterize(projected, width: image.width, height: image.height, statistics: &statistics) { index, alpha in
+                    let source = SIMD4<Float>(projected.color.x * alpha, projected.color.y * alpha, projected.color.z * alpha, alpha)
+                    let destination = image.pixels[index]
+                    image.pixels[index] = frontToBack ? destination + source * (1 - destination.w) : source + destination * (1 - alpha)
+                }
+            }
+        case .weighted(let weighting):
+            let depths = preprocessed.compactMap { $0?.depth }.sorted()
+            let depthScale = weighting.depthScale ?? (depths.isEmpty ? 1 : depths[depths.count / 2])
+            // Per pixel, the weighted sum of premultiplied colour and of alpha, and the product of 1 - alpha
+            var accumulation = Array(repeating: SIMD4<Float>.zero, count: image.pixels.count)
+            var revealage = Array(repeating: Float(1), count: image.pixels.count)
+            for case let projected? in preprocessed {
+                rasterize(projected, width: image.width, height: image.height, statistics: &statistics) { index, alpha in
+                    let weight = weighting.weight(alpha: alpha, depth: projected.depth, depthScale: depthScale)
+                    accumulation[index] += SIMD4<Float>(projected.color.x * alpha, projected.color.y * alpha, projected.color.z * alpha, alpha) * weight
+                    revealage[index] *= 1 - alpha
+                }
+            }
+            for index in image.pixels.indices where accumulation[index].w > 0 {
+                let coverage = 1 - revealage[index]
+                let color = accumulation[index] / accumulation[index].w
+                image.pixels[index] = SIMD4<Float>(color.x * coverage, color.y * coverage, color.z * coverage, coverage)
+            }
+        }
+
+        statistics.duration = TimeInterval(DispatchTime.now().uptimeNanoseconds - startTime.uptimeNanoseconds) / 1_000_000_000
+        return (image: image, statistics: statistics)
+    }
+
+    // Sorts the splats by their depth along the view direction (unless blending is weighted), then renders them
+    public func render(splats: [Splat], viewpoint: Viewpoint) -> (image: Image, statistics: Statistics) {
+        var order = Array(0..<UInt32(splats.count))
+        if case .weighted = blending {
+            return splats.withUnsafeBufferPointer { render(splats: $0, order: order, viewpoint: viewpoint) }
+        }
+        let positions = splats.map(\.position)
+        var depths: [Float] = []
+        positions.withUnsafeBufferPointer {
+            DepthSorter.depths(of: $0, from: CameraPose(view: viewpoint.view), into: &depths)
+        }
+        DepthSorter(strategy: .radix, backToFront: !frontToBack).sort(&order, depths: depths)
+        return splats.withUnsafeBufferPointer { render(splats: $0, order: order, viewpoint: viewpoint) }
+    }
+
+    // The preprocessing pass (Shaders.metal : splatPreprocessKernel): each splat in the order projected once, in
+    // order, or nil where it's culled. Spread across cores, as the GPU spreads it across threads.
+    public static func preprocess(splats: UnsafeBufferPointer<Splat>, order: [UInt32], viewpoint: Viewpoint) -> [ProjectedSplat?] {
+        let chunkSize = 4096
+        var projected = [ProjectedSplat?](repeating: nil, count: order.count)
+        projected.withUnsafeMutableBufferPointer { projected in
+            SplatExecutor.shared.parallelFor(iterations: (order.count + chunkSize - 1) / chunkSize, priority: .frame) { chunk in
+                for i in (chunk * chunkSize)..<min(order.count, (chunk + 1) * chunkSize) {
+                    projected[i] = project(splats[Int(order[i])], viewpoint: viewpoint)
+                }
+            }
+        }
+        return projected
+    }
+
+    // How far a splat of the given opacity reaches, in the units of boundsRadius, before its alpha falls below
+    // alphaCutoff: exp(-r²) * opacity = alphaCutoff. At most boundsRadius, and 0 for splats too faint to show at all.
+    // Keep in sync with Shaders.metal : splatBoundsRadius
+    public static func tightBoundsRadius(opacity: Float) -> Float {
+        let logAlpha = log(opacity / alphaCutoff)
+        return logAlpha > 0 ? min(Self.boundsRadius, logAlpha.squareRoot()) : 0
+    }
+
+    // The preprocessing pass's projection of one splat (calcCovariance3D, calcCovariance2D and decomposeCovariance),
+    // or nil where it culls the splat for lying outside the frustum
+    public static func project(_ splat: Splat, viewpoint: Viewpoint) -> ProjectedSplat? {
+        let clip = viewpoint.clipPosition(splat.position)
+        let bounds = 1.2 * clip.w
+        if clip.z < -clip.w || clip.x < -bounds || clip.x > bounds || clip.y < -bounds || clip.y > bounds {
+            return nil
+        }
+
+        // Σ = R S Sᵀ Rᵀ, by rows
+        let (r0, r1, r2) = splat.rotationMatrixRows
+        let scaleSquared = splat.scale * splat.scale
+        let sigma0 = SIMD3<Float>((r0 * r0 * scaleSquared).sum(), (r0 * r1 * scaleSquared).sum(), (r0 * r2 * scaleSquared).sum())
+        let sigma1 = SIMD3<Float>(sigma0.y, (r1 * r1 * scaleSquared).sum(), (r1 * r2 * scaleSquared).sum())
+        let sigma2 = SIMD3<Float>(sigma0.z, sigma1.z, (r2 * r2 * scaleSquared).sum())
+
+        let projection = viewpoint.projection
+        let view = viewpoint.view
+        var viewPosition = viewpoint.viewPosition(splat.position)
+        let limit = SIMD2<Float>(1.3 / projection[0][0], 1.3 / projection[1][1])
+        viewPosition.x = min(max(viewPosition.x / viewPosition.z, -limit.x), limit.x) * viewPosition.z
+        viewPosition.y = min(max(viewPosition.y / viewPosition.z, -limit.y), limit.y) * viewPosition.z
+
+        // The first two rows of T = J W, where W is the view matrix's rotation
+        let focal = viewpoint.focalLength
+        let z = viewPosition.z
+        let j0 = SIMD3<Float>(focal.x / z, 0, -(focal.x * viewPosition.x) / (z * z))
+        let j1 = SIMD3<Float>(0, focal.y / z, -(focal.y * viewPosition.y) / (z * z))
+        let w0 = SIMD3<Float>(view[0][0], view[1][0], view[2][0])
+        let w1 = SIMD3<Float>(view[0][1], view[1][1], view[2][1])
+        let w2 = SIMD3<Float>(view[0][2], view[1][2], view[2][2])
+        let t0 = w0 * j0.x + w1 * j0.y + w2 * j0.z
+        let t1 = w0 * j1.x + w1 * j1.y + w2 * j1.z
+
+        // T Σ Tᵀ, plus the low-pass filter: every gaussian at least a pixel across
+        let sigmaT0 = SIMD3<Float>((sigma0 * t0).sum(), (sigma1 * t0).sum(), (sigma2 * t0).sum())
+        let sigmaT1 = SIMD3<Float>((sigma0 * t1).sum(), (sigma1 * t1).sum(), (sigma2 * t1).sum())
+        let a = (t0 * sigmaT0).sum() + 0.3
+        let b = (t0 * sigmaT1).sum()
+        let d = (t1 * sigmaT1).sum() + 0.3
+
+        let determinant = a * d - b * b
+        let mean = 0.5 * (a + d)
+        let distance = max(0.1, (mean * mean - determinant).squareRoot())
+        let lambda1 = mean + distance
+        let lambda2 = mean - distance
+        let eigenvector1 = b == 0 ? (a > d ? SIMD2<Float>(1, 0) : SIMD2<Float>(0, 1)) : Self.normalize(SIMD2<Float>(b, d - lambda2))
+        let eigenvector2 = SIMD2<Float>(eigenvector1.y, -eigenvector1.x)
+
+        let ndc = SIMD2<Float>(clip.x, clip.y) / clip.w
+        return ProjectedSplat(center: viewpoint.pixelPosition(ndc: ndc),
+                              axis1: eigenvector1 * (2 * lambda1).squareRoot(),
+                              axis2: eigenvector2 * (2 * max(0, lambda2)).squareRoot(),
+                              depth: -viewPosition.z,
+                              color: splat.color,
+                              boundsRadius: tightBoundsRadius(opacity: splat.opacity))
+    }
+
+    // The fragment shader over every pixel whose centre lies in the splat's quad, calling blend with the index of each
+    // pixel it isn't discarded for, and its alpha there
+    private func rasterize(_ splat: ProjectedSplat,
+                           width: Int,
+                           height: Int,
+                           statistics: inout Statistics,
+                           blend: (Int, Float) -> Void) {
+        let radius = tightBounds ? splat.boundsRadius : Self.boundsRadius
+        guard radius > 0 else { return }
+        let corner1 = splat.axis1 * radius
+        let corner2 = splat.axis2 * radius
+        let extent = SIMD2<Float>(abs(corner1.x) + abs(corner2.x), abs(corner1.y) + abs(corner2.y))
+        let minimum = SIMD2<Int>(max(0, Int((splat.center.x - extent.x).rounded(.down))),
+                                 max(0, Int((splat.center.y - extent.y).rounded(.down))))
+        let maximum = SIMD2<Int>(min(width - 1, Int((splat.center.x + extent.x).rounded(.up))),
+                                 min(height - 1, Int((splat.center.y + extent.y).rounded(.up))))
+        guard minimum.x <= maximum.x && minimum.y <= maximum.y else { return }
+
+        let lengthSquared1 = (corner1 * corner1).sum()
+        let lengthSquared2 = (corner2 * corner2).sum()
+        guard lengthSquared1 > 0 && lengthSquared2 > 0 else { return }
+
+        for y in minimum.y...maximum.y {
+            for x in minimum.x...maximum.x {
+                let offset = SIMD2<Float>(Float(x) + 0.5, Float(y) + 0.5) - splat.center
+                // Position in the quad, -1...1 along each axis, as the interpolated texture coordinates give it
+                let u = (offset * corner1).sum() / lengthSquared1
+                let v = (offset * corner2).sum() / lengthSquared2
+                guard abs(u) <= 1 && abs(v) <= 1 else { continue }
+                statistics.fragments += 1
+
+                let vSquared = radius * radius * (u * u + v * v)
+                guard vSquared <= radius * radius else { continue }
+                statistics.blendedFragments += 1
+
+                blend(y * width + x, min(1, exp(-vSquared)) * splat.color.w)
+            }
+        }
+    }
+
+    private static func normalize(_ v: SIMD2<Float>) -> SIMD2<Float> {
+        v / (v * v).sum().squareRoot()
+    }
+}
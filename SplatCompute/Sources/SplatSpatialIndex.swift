@@ -0,0 +1,448 @@
+import Foundation
+#if canImport(simd)
+import simd
+#endif
+
+// A bounding volume hierarchy over a set of splats, for picking and region selection.
+//
+// Leaves are the chunks of a SplatChunks partition (so splats are in Morton order and each leaf holds a few of
+// them); interior nodes are built bottom-up by pairing neighbours. Because of the Morton order, every node's
+// splats are a contiguous range of `indices`, so a node which lies entirely inside a selection is taken whole.
+//
+// The index holds no reference to the splats; queries take the same buffer it was built from.
+public struct SplatSpatialIndex {
+    public struct Ray {
+        public var origin: SIMD3<Float>
+        // Normalized
+        public var direction: SIMD3<Float>
+
+        public init(origin: SIMD3<Float>, direction: SIMD3<Float>) {
+            self.origin = origin
+            self.direction = direction.normalized
+        }
+
+        // The ray from the camera through the given pixel (origin at the bottom-left, like NDC)
+        public init(viewpoint: Viewpoint, pixel: SIMD2<Float>) {
+            let ndc = pixel / viewpoint.screenSize * 2 - 1
+            let projection = viewpoint.projection
+            // Off-center projections (as on visionOS) shift x and y by the third column
+            let viewDirection = SIMD4<Float>((ndc.x + projection[2][0]) / projection[0][0],
+                                             (ndc.y + projection[2][1]) / projection[1][1],
+                                             -1,
+                                             0)
+            self.init(origin: viewpoint.position, direction: (viewpoint.view.inverse * viewDirection).xyz)
+        }
+
+        public func point(at distance: Float) -> SIMD3<Float> {
+            origin + direction * distance
+        }
+    }
+
+    public struct RayHit {
+        public var splatIndex: Int
+        // Distance along the ray at which the accumulated opacity reached the threshold
+        public var distance: Float
+        public var position: SIMD3<Float>
+        // Accumulated opacity up to and including the hit splat
+        public var opacity: Float
+    }
+
+    struct Node {
+        // Bounds of the node's splats, including their footprint
+        var bounds: Bounds
+        // Range of positions in indices
+        var range: Range<Int>
+        // -1 for leaves
+        var left: Int32
+        var right: Int32
+
+        var isLeaf: Bool { left < 0 }
+    }
+
+    public static let defaultLeafSize = 8
+    public static let defaultOpacityThreshold: Float = 0.5
+    // Splats contributing less than this along a ray are ignored, as the renderer discards them too
+    static let minimumAlpha: Float = 1 / 255
+
+    // Splat indices, ordered so that each node's splats are contiguous
+    public let indices: [UInt32]
+    // The inverse of indices: the position of each splat in it
+    let positionsInIndices: [UInt32]
+    let leafSize: Int
+    var nodes: [Node]
+    let root: Int?
+
+    public var splatCount: Int { indices.count }
+
+    public init(splats: UnsafeBufferPointer<Splat>, leafSize: Int = defaultLeafSize) {
+        let chunks = SplatChunks(splats: splats, chunkSize: leafSize)
+        var nodes = chunks.chunks.map { Node(bounds: $0.bounds, range: $0.range, left: -1, right: -1) }
+        nodes.reserveCapacity(nodes.count * 2)
+
+        var level = Array(nodes.indices)
+        while level.count > 1 {
+            var nextLevel: [Int] = []
+            nextLevel.reserveCapacity((level.count + 1) / 2)
+            for pairStart in stride(from: 0, to: level.count, by: 2) {
+                guard pairStart + 1 < level.count else {
+                    nextLevel.append(level[pairStart])
+                    continue
+                }
+                let left = nodes[level[pairStart]]
+                let right = nodes[level[pairStart + 1]]
+                var bounds = left.bounds
+                bounds.formUnion(right.bounds)
+                nextLevel.append(nodes.count)
+                nodes.append(Node(bounds: bounds,
+                                  range: left.range.lowerBound..<right.range.upperBound,
+                                  left: Int32(level[pairStart]),
+                                  right: Int32(level[pairStart + 1])))
+            }
+            level = nextLevel
+        }
+
+        var positionsInIndices = [UInt32](repeating: 0, count: chunks.indices.count)
+        for (position, index) in chunks.indices.enumerated() {
+            positionsInIndices[Int(index)] = UInt32(position)
+        }
+
+        self.indices = chunks.indices
+        self.positionsInIndices = positionsInIndices
+        self.leafSize = leafSize
+        self.nodes = nodes
+        self.root = level.first
+    }
+
+    // Updates the bounds of the leaves holding the given splats, and of every interior node, after those splats
+    // have moved or changed size. Cheaper than a rebuild, though the tree degrades if splats move far.
+    public mutating func refit(splats: UnsafeBufferPointer<Splat>, dirtyRanges: [Range<Int>]) {
+        var refitLeaves = Set<Int>()
+        for range in dirtyRanges {
+            for index in range where index < positionsInIndices.count {
+                // Leaves are the first nodes, and each covers leafSize consecutive positions
+                refitLeaves.insert(Int(positionsInIndices[index]) / leafSize)
+            }
+        }
+        guard !refitLeaves.isEmpty else { return }
+
+        for leaf in refitLeaves {
+            var bounds = Bounds.empty
+            for index in indices[nodes[leaf].range] {
+                bounds.formUnion(splats[Int(index)].bounds)
+            }
+            nodes[leaf].bounds = bounds
+        }
+        // Parents always come after their children
+        for nodeIndex in nodes.indices where !nodes[nodeIndex].isLeaf {
+            var bounds = nodes[Int(nodes[nodeIndex].left)].bounds
+            bounds.formUnion(nodes[Int(nodes[nodeIndex].right)].bounds)
+            nodes[nodeIndex].bounds = bounds
+        }
+    }
+
+    public init(splats: [Splat], leafSize: Int = defaultLeafSize) {
+        self = splats.withUnsafeBufferPointer { SplatSpatialIndex(splats: $0, leafSize: leafSize) }
+    }
+
+    // Finds the splat at which the opacity accumulated along the ray (front to back, as rendered) first reaches
+    // opacityThreshold. Each splat contributes its opacity times its gaussian falloff at the ray's point of
+    // closest approach (in the splat's own metric), at that point's distance along the ray.
+    //
+    // Nodes are visited nearest entry first. A splat only contributes within its bounds, so no node still to be
+    // visited can contribute nearer than the next one's entry: contributions up to there are accumulated as soon as
+    // they're found, and the search stops at the hit, without visiting anything behind it.
+    public func pick(ray: Ray,
+                     splats: UnsafeBufferPointer<Splat>,
+                     opacityThreshold: Float = defaultOpacityThreshold,
+                     maxDistance: Float = .infinity) -> RayHit? {
+        guard let root else { return nil }
+
+        let inverseDirection = 1 / ray.direction
+        // Both nearest first
+        var nodeQueue = MinimumQueue<Int>()
+        var contributions = MinimumQueue<(alpha: Float, splatIndex: Int)>()
+        if let entry = Self.rayEntry(ray, inverseDirection: inverseDirection, bounds: nodes[root].bounds, maxDistance: maxDistance) {
+            nodeQueue.insert(root, priority: entry)
+        }
+        var transmittance: Float = 1
+        while true {
+            let horizon = nodeQueue.minimumPriority ?? .infinity
+            while let contribution = contributions.popMinimum(notAbove: horizon) {
+                transmittance *= 1 - contribution.element.alpha
+                if 1 - transmittance >= opacityThreshold {
+                    return RayHit(splatIndex: contribution.element.splatIndex,
+                                  distance: contribution.priority,
+                                  position: ray.point(at: contribution.priority),
+                                  opacity: 1 - transmittance)
+                }
+            }
+            guard let next = nodeQueue.popMinimum(notAbove: .infinity) else { return nil }
+
+            let node = nodes[next.element]
+            if !node.isLeaf {
+                for child in [ Int(node.left), Int(node.right) ] {
+                    if let entry = Self.rayEntry(ray, inverseDirection: inverseDirection, bounds: nodes[child].bounds, maxDistance: maxDistance) {
+                        nodeQueue.insert(child, priority: entry)
+                    }
+                }
+                continue
+            }
+            for index in indices[node.range] {
+                let splat = splats[Int(index)]
+                let localOrigin = splat.localVector(ray.origin - splat.position)
+                let localDirection = splat.localVector(ray.direction)
+                let directionLengthSquared = localDirection.lengthSquared
+                guard directionLengthSquared > 0 else { continue }
+                let distance = -localOrigin.dot(localDirection) / directionLengthSquared
+                guard distance >= 0 && distance <= maxDistance else { continue }
+                let closest = localOrigin + localDirection * distance
+                // Beyond 3 standard deviations the point may lie outside the splat's bounds (and the renderer's
+                // quads stop well short of it)
+                let closestLengthSquared = closest.lengthSquared
+                guard closestLengthSquared <= 9 else { continue }
+                let alpha = min(0.99, splat.opacity * exp(-0.5 * closestLengthSquared))
+                guard alpha >= Self.minimumAlpha else { continue }
+                contributions.insert((alpha: alpha, splatIndex: Int(index)), priority: distance)
+            }
+        }
+    }
+
+    public func pick(ray: Ray,
+                     splats: [Splat],
+                     opacityThreshold: Float = defaultOpacityThreshold,
+                     maxDistance: Float = .infinity) -> RayHit? {
+        splats.withUnsafeBufferPointer {
+            pick(ray: ray, splats: $0, opacityThreshold: opacityThreshold, maxDistance: maxDistance)
+        }
+    }
+
+    // Slab test; returns the distance at which the ray enters the box (0 if it starts inside)
+    static func rayEntry(_ ray: Ray, inverseDirection: SIMD3<Float>, bounds: Bounds, maxDistance: Float) -> Float? {
+        let t0 = (bounds.min - ray.origin) * inverseDirection
+        let t1 = (bounds.max - ray.origin) * inverseDirection
+        // A zero direction component gives ±infinity, or NaN when the origin is on the slab's boundary; replacing
+        // NaN keeps such rays from being rejected
+        let near = pointwiseMin(t0, t1).replacing(with: -.infinity, where: .!(t0 .== t0) .| .!(t1 .== t1))
+        let far = pointwiseMax(t0, t1).replacing(with: .infinity, where: .!(t0 .== t0) .| .!(t1 .== t1))
+        let entry = max(near.max(), 0)
+        let exit = min(far.min(), maxDistance)
+        return entry <= exit ? entry : nil
+    }
+
+    // Splats whose centres lie inside the box
+    public func indices(in box: Bounds, splats: UnsafeBufferPointer<Splat>) -> [Int] {
+        var result: [Int] = []
+        guard let root else { return result }
+        var stack = [ root ]
+        while let nodeIndex = stack.popLast() {
+            let node = nodes[nodeIndex]
+            guard node.bounds.intersects(box) else { continue }
+            if box.contains(node.bounds.min) && box.contains(node.bounds.max) {
+                result.append(contentsOf: indices[node.range].lazy.map { Int($0) })
+            } else if node.isLeaf {
+                for index in indices[node.range] where box.contains(splats[Int(index)].position) {
+                    result.append(Int(index))
+                }
+            } else {
+                stack.append(Int(node.left))
+                stack.append(Int(node.right))
+            }
+        }
+        return result
+    }
+
+    public func indices(in box: Bounds, splats: [Splat]) -> [Int] {
+        splats.withUnsafeBufferPointer { indices(in: box, splats: $0) }
+    }
+
+    // Splats in front of the camera whose centres project inside the polygon (a lasso; pixel coordinates, any
+    // winding, may be non-convex; even-odd rule)
+    public func indices(inScreenPolygon polygon: [SIMD2<Float>],
+                        viewpoint: Viewpoint,
+                        splats: UnsafeBufferPointer<Splat>) -> [Int] {
+        var result: [Int] = []
+        guard let root, polygon.count >= 3 else { return result }
+        let lasso = ScreenPolygon(polygon)
+
+        var stack = [ root ]
+        while let nodeIndex = stack.popLast() {
+            let node = nodes[nodeIndex]
+            switch classify(node.bounds, viewpoint: viewpoint, lasso: lasso) {
+            case .outside:
+                continue
+            case .inside:
+                result.append(contentsOf: indices[node.range].lazy.map { Int($0) })
+            case .partial where node.isLeaf:
+                for index in indices[node.range] {
+                    let clip = viewpoint.clipPosition(splats[Int(index)].position)
+                    guard clip.w > 0 else { continue }
+                    let pixel = viewpoint.pixelPosition(ndc: SIMD2<Float>(clip.x, clip.y) / clip.w)
+                    if lasso.contains(pixel) {
+                        result.append(Int(index))
+                    }
+                }
+            case .partial:
+                stack.append(Int(node.left))
+                stack.append(Int(node.right))
+            }
+        }
+        return result
+    }
+
+    public func indices(inScreenPolygon polygon: [SIMD2<Float>], viewpoint: Viewpoint, splats: [Splat]) -> [Int] {
+        splats.withUnsafeBufferPointer { indices(inScreenPolygon: polygon, viewpoint: viewpoint, splats: $0) }
+    }
+
+    // Splats in front of the camera whose centres project inside the rectangle (pixel coordinates)
+    public func indices(inScreenRect min: SIMD2<Float>, _ max: SIMD2<Float>,
+                        viewpoint: Viewpoint,
+                        splats: UnsafeBufferPointer<Splat>) -> [Int] {
+        indices(inScreenPolygon: [ min, SIMD2<Float>(max.x, min.y), max, SIMD2<Float>(min.x, max.y) ],
+                viewpoint: viewpoint,
+                splats: splats)
+    }
+
+    private enum Classification {
+        case inside
+        case outside
+        case partial
+    }
+
+    private func classify(_ bounds: Bounds, viewpoint: Viewpoint, lasso: ScreenPolygon) -> Classification {
+        var pixelMin = SIMD2<Float>(repeating: .infinity)
+        var pixelMax = SIMD2<Float>(repeating: -.infinity)
+        var allInFront = true
+        var allBehind = true
+        for corner in bounds.corners {
+            let clip = viewpoint.clipPosition(corner)
+            if clip.w <= 0 {
+                allInFront = false
+                continue
+            }
+            allBehind = false
+            let pixel = viewpoint.pixelPosition(ndc: SIMD2<Float>(clip.x, clip.y) / clip.w)
+            pixelMin = pointwiseMin(pixelMin, pixel)
+            pixelMax = pointwiseMax(pixelMax, pixel)
+        }
+        if allBehind {
+            return .outside
+        }
+        // The projection of a box crossing the camera plane is unbounded
+        guard allInFront else { return .partial }
+
+        // The box's screen footprint lies within [pixelMin, pixelMax]
+        if !lasso.boundsIntersect(pixelMin, pixelMax) {
+            return .outside
+        }
+        if lasso.anyEdgeIntersects(pixelMin, pixelMax) {
+            return .partial
+        }
+        // No edge crosses the rectangle, so it's entirely inside or entirely outside
+        return lasso.contains(pixelMin) ? .inside : .outside
+    }
+}
+
+// A binary min-heap, for visiting nodes and contributions in order of distance along a ray
+private struct MinimumQueue<Element> {
+    private var entries: [(priority: Float, element: Element)] = []
+
+    var minimumPriority: Float? { entries.first?.priority }
+
+    mutating func insert(_ element: Element, priority: Float) {
+        entries.append((priority, element))
+        var child = entries.count - 1
+        while child > 0 {
+            let parent = (child - 1) / 2
+            guard entries[child].priority < entries[parent].priority else { break }
+            entries.swapAt(child, parent)
+            child = parent
+        }
+    }
+
+    // Removes and returns the entry with the lowest priority, if that's at most limit
+    mutating func popMinimum(notAbove limit: Float) -> (priority: Float, element: Element)? {
+        guard let first = entries.first, first.priority <= limit else { return nil }
+        let last = entries.removeLast()
+        guard !entries.isEmpty else { return first }
+        entries[0] = last
+        var parent = 0
+        while true {
+            var smallest = parent
+            for child in [ 2 * parent + 1, 2 * parent + 2 ] where child < entries.count && entries[child].priority < entries[smallest].priority {
+                smallest = child
+            }
+            guard smallest != parent else { break }
+            entries.swapAt(parent, smallest)
+            parent = smallest
+        }
+        return first
+    }
+}
+
+private struct ScreenPolygon {
+    let vertices: [SIMD2<Float>]
+    let min: SIMD2<Float>
+    let max: SIMD2<Float>
+
+    init(_ vertices: [SIMD2<Float>]) {
+        self.vertices = vertices
+        min = vertices.reduce(SIMD2<Float>(repeating: .infinity)) { pointwiseMin($0, $1) }
+        max = vertices.reduce(SIMD2<Float>(repeating: -.infinity)) { pointwiseMax($0, $1) }
+    }
+
+    func boundsIntersect(_ rectMin: SIMD2<Float>, _ rectMax: SIMD2<Float>) -> Bool {
+        all(rectMin .<= max) && all(rectMax .>= min)
+    }
+
+    // Even-odd rule
+    func contains(_ point: SIMD2<Float>) -> Bool {
+        var inside = false
+        var j = vertices.count - 1
+        for i in vertices.indices {
+            let a = vertices[i], b = vertices[j]
+            if (a.y > point.y) != (b.y > point.y) &&
+                point.x < (b.x - a.x) * (point.y - a.y) / (b.y - a.y) + a.x {
+                inside.toggle()
+            }
+            j = i
+        }
+        return inside
+    }
+
+    // Whether any edge touches the closed rectangle (Liang-Barsky clipping)
+    func anyEdgeIntersects(_ rectMin: SIMD2<Float>, _ rectMax: SIMD2<Float>) -> Bool {
+        var j = vertices.count - 1
+        for i in vertices.indices {
+            if Self.segment(vertices[j], vertices[i], intersects: rectMin, rectMax) {
+                return true
+            }
+            j = i
+        }
+        return false
+    }
+
+    private static func segment(_ a: SIMD2<Float>, _ b: SIMD2<Float>, intersects rectMin: SIMD2<Float>, _ rectMax: SIMD2<Float>) -> Bool {
+        let delta = b - a
+        var t0: Float = 0
+        var t1: Float = 1
+        for axis in 0..<2 {
+            if delta[axis] == 0 {
+                if a[axis] < rectMin[axis] || a[axis] > rectMax[axis] {
+                    return false
+                }
+                continue
+            }
+            var near = (rectMin[axis] - a[axis]) / delta[axis]
+            var far = (rectMax[axis] - a[axis]) / delta[axis]
+            if near > far {
+                swap(&near, &far)
+            }
+            t0 = Swift.max(t0, near)
+            t1 = Swift.min(t1, far)
+            if t0 > t1 {
+                return false
+            }
+        }
+        return true
+    }
+}
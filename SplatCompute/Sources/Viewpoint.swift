@@ -0,0 +1,157 @@
+import Foundation
+#if canImport(simd)
+import simd
+#endif
+
+// A camera, with the derived values that CPU-side culling, LOD selection and picking need. Conventions match
+// the renderer: right-handed view space looking down -z, and clip space x/y in -w...w.
+public struct Viewpoint {
+    public let view: Float4x4
+    public let projection: Float4x4
+    public let viewProjection: Float4x4
+    // Size of the render target in pixels
+    public let screenSize: SIMD2<Float>
+    public let position: SIMD3<Float>
+    public let forward: SIMD3<Float>
+
+    public init(_ camera: CameraMatrices, screenSize: SIMD2<Float>) {
+        view = camera.view
+        projection = camera.projection
+        viewProjection = camera.projection * camera.view
+        self.screenSize = screenSize
+        let inverseView = camera.view.inverse
+        position = (inverseView * SIMD4<Float>(0, 0, 0, 1)).xyz
+        forward = (inverseView * SIMD4<Float>(0, 0, -1, 0)).xyz.normalized
+    }
+
+    // Focal lengths in pixels
+    public var focalLength: SIMD2<Float> {
+        SIMD2<Float>(screenSize.x * projection[0][0] / 2, screenSize.y * projection[1][1] / 2)
+    }
+
+    public func clipPosition(_ worldPosition: SIMD3<Float>) -> SIMD4<Float> {
+        viewProjection * SIMD4<Float>(worldPosition.x, worldPosition.y, worldPosition.z, 1)
+    }
+
+    public func viewPosition(_ worldPosition: SIMD3<Float>) -> SIMD3<Float> {
+        (view * SIMD4<Float>(worldPosition.x, worldPosition.y, worldPosition.z, 1)).xyz
+    }
+
+    // Distance in front of the camera along the view direction
+    public func depth(_ worldPosition: SIMD3<Float>) -> Float {
+        -viewPosition(worldPosition).z
+    }
+
+    // True if the box is certainly not visible: all of its corners lie outside the same side plane of the frustum,
+    // or behind the camera. (Boxes near a frustum corner may be reported visible when they aren't.)
+    public func isOutsideFrustum(_ bounds: Bounds) -> Bool {
+        var outsideLeft = true, outsideRight = true, outsideBottom = true, outsideTop = true, behind = true
+        for corner in bounds.corners {
+            let clip = clipPosition(corner)
+            outsideLeft = outsideLeft && clip.x < -clip.w
+            outsideRight = outsideRight && clip.x > clip.w
+            outsideBottom = outsideBottom && clip.y < -clip.w
+            outsideTop = outsideTop && clip.y > clip.w
+            behind = behind && clip.w <= 0
+        }
+        return outsideLeft || outsideRight || outsideBottom || outsideTop || behind
+    }
+
+    // The fraction of the screen covered by the rectangle around the box's projected corners: 0 if it's certainly not
+    // visible, and 1 if it reaches behind the camera
+    public func screenCoverage(_ bounds: Bounds) -> Float {
+        guard !bounds.isEmpty, !isOutsideFrustum(bounds) else { return 0 }
+        var ndcMin = SIMD2<Float>(repeating: .infinity)
+        var ndcMax = SIMD2<Float>(repeating: -.infinity)
+        for corner in bounds.corners {
+            let clip = clipPosition(corner)
+            guard clip.w > 0 else { return 1 }
+            let ndc = SIMD2<Float>(clip.x, clip.y) / clip.w
+            ndcMin = pointwiseMin(ndcMin, ndc)
+            ndcMax = pointwiseMax(ndcMax, ndc)
+        }
+        let lower = SIMD2<Float>(repeating: -1), upper = SIMD2<Float>(repeating: 1)
+        let size = ndcMax.clamped(lowerBound: lower, upperBound: upper) - ndcMin.clamped(lowerBound: lower, upperBound: upper)
+        return size.x * size.y / 4
+    }
+
+    // Pixel coordinates (origin at the bottom-left, like NDC) of the given normalized device coordinates
+    public func pixelPosition(ndc: SIMD2<Float>) -> SIMD2<Float> {
+        (ndc * 0.5 + 0.5) * screenSize
+    }
+}
+
+// An axis-aligned bounding box
+public struct Bounds {
+    public var min: SIMD3<Float>
+    public var max: SIMD3<Float>
+
+    public init(min: SIMD3<Float>, max: SIMD3<Float>) {
+        self.min = min
+        self.max = max
+    }
+
+    public static let empty = Bounds(min: SIMD3<Float>(repeating: .infinity), max: SIMD3<Float>(repeating: -.infinity))
+
+    public var isEmpty: Bool {
+        min.x > max.x || min.y > max.y || min.z > max.z
+    }
+
+    public var center: SIMD3<Float> {
+        (min + max) * 0.5
+    }
+
+    public var extent: SIMD3<Float> {
+        max - min
+    }
+
+    public mutating func formUnion(_ point: SIMD3<Float>) {
+        min = pointwiseMin(min, point)
+        max = pointwiseMax(max, point)
+    }
+
+    public mutating func formUnion(_ other: Bounds) {
+        min = pointwiseMin(min, other.min)
+        max = pointwiseMax(max, other.max)
+    }
+
+    public func contains(_ point: SIMD3<Float>) -> Bool {
+        all(point .>= min) && all(point .<= max)
+    }
+
+    public func intersects(_ other: Bounds) -> Bool {
+        all(min .<= other.max) && all(max .>= other.min)
+    }
+
+    public var corners: [SIMD3<Float>] {
+        [
+            SIMD3<Float>(min.x, min.y, min.z),
+            SIMD3<Float>(max.x, min.y, min.z),
+            SIMD3<Float>(min.x, max.y, min.z),
+            SIMD3<Float>(max.x, max.y, min.z),
+            SIMD3<Float>(min.x, min.y, max.z),
+            SIMD3<Float>(max.x, min.y, max.z),
+            SIMD3<Float>(min.x, max.y, max.z),
+            SIMD3<Float>(max.x, max.y, max.z),
+        ]
+    }
+
+    // Squared distance from the point to the nearest point in the box; zero if inside
+    public func distanceSquared(to point: SIMD3<Float>) -> Float {
+        let nearest = pointwiseMin(pointwiseMax(point, min), max)
+        return (point - nearest).lengthSquared
+    }
+}
+
+public extension Splat {
+    // Radius of a sphere around the splat's position which contains all of its visible footprint, taken as
+    // 3 standard deviations along its largest axis
+    var boundingRadius: Float {
+        3 * scale.max()
+    }
+
+    var bounds: Bounds {
+        let radius = SIMD3<Float>(repeating: boundingRadius)
+        return Bounds(min: position - radius, max: position + radius)
+    }
+}
@@ -0,0 +1,41 @@
+import XCTest
+import SplatCompute
+
+final class CameraPathTests: XCTestCase {
+    func testViewMatrixRoundTrip() {
+        let pose = CameraPose(position: SIMD3<Float>(1, 2, 3), lookingAt: SIMD3<Float>(-2, 0, -5))
+        let view = pose.view
+        // The camera sits at the view-space origin, looking down -z
+        let origin = view * SIMD4<Float>(1, 2, 3, 1)
+        XCTAssertEqual(origin.x, 0, accuracy: 1e-5)
+        XCTAssertEqual(origin.y, 0, accuracy: 1e-5)
+        XCTAssertEqual(origin.z, 0, accuracy: 1e-5)
+        let ahead = view * SIMD4<Float>(1 + pose.forward.x, 2 + pose.forward.y, 3 + pose.forward.z, 1)
+        XCTAssertEqual(ahead.z, -1, accuracy: 1e-5)
+
+        let recovered = CameraPose(view: view)
+        for axis in 0..<3 {
+            XCTAssertEqual(recovered.position[axis], pose.position[axis], accuracy: 1e-4)
+            XCTAssertEqual(recovered.forward[axis], pose.forward[axis], accuracy: 1e-5)
+        }
+    }
+
+    func testSyntheticPathsAndJSON() throws {
+        let orbit = CameraPath.orbit(around: .zero, radius: 10, frameCount: 8)
+        XCTAssertEqual(orbit.poses.count, 8)
+        for pose in orbit.poses {
+            XCTAssertEqual(pose.position.x * pose.position.x + pose.position.z * pose.position.z, 100, accuracy: 1e-3)
+            // Looking at the centre
+            XCTAssertEqual(pose.forward.x * pose.position.x + pose.forward.z * pose.position.z, -10, accuracy: 1e-3)
+        }
+
+        let walk = CameraPath.walkThrough(Bounds(min: SIMD3<Float>(-1, -1, -10), max: SIMD3<Float>(1, 1, 10)), frameCount: 5)
+        XCTAssertEqual(walk.poses.first?.position.z, 10)
+        XCTAssertEqual(walk.poses.last?.position.z, -10)
+
+        let pan = CameraPath.fastPan(from: .zero, frameCount: 4, degreesPerFrame: 90)
+        XCTAssertEqual(pan.poses[1].forward.x, -1, accuracy: 1e-5)
+
+        XCTAssertEqual(try CameraPath(jsonData: orbit.jsonData()), orbit)
+    }
+}
@@ -0,0 +1,59 @@
+import XCTest
+import SplatCompute
+
+final class CameraTrajectoryTests: XCTestCase {
+    static let projection = Float4x4.perspective(fovyRadians: 1, aspectRatio: 1.5, nearZ: 0.1, farZ: 100)
+
+    func testBinaryRoundTrip() throws {
+        let recorder = CameraTrajectoryRecorder()
+        let path = CameraPath.orbit(around: .zero, radius: 5, frameCount: 10)
+        for (i, pose) in path.poses.enumerated() {
+            // Stereo, with the second eye offset
+            let eye = CameraPose(position: pose.position + SIMD3<Float>(0.06, 0, 0), forward: pose.forward)
+            recorder.record([ (projection: Self.projection, view: pose.view), (projection: Self.projection, view: eye.view) ],
+                            at: 1000 + Double(i) / 90)
+        }
+        let trajectory = recorder.trajectory
+        XCTAssertEqual(trajectory.frames.first?.timestamp, 0)
+        XCTAssertEqual(trajectory.duration, 9.0 / 90, accuracy: 1e-9)
+
+        let data = trajectory.data()
+        XCTAssertEqual(data.count, 12 + 10 * (12 + 2 * 128))
+        let decoded = try CameraTrajectory(data: data)
+        XCTAssertEqual(decoded.frames.count, 10)
+        for (a, b) in zip(decoded.frames, trajectory.frames) {
+            XCTAssertEqual(a.timestamp, b.timestamp)
+            XCTAssertEqual(a.cameras.count, 2)
+            for (cameraA, cameraB) in zip(a.cameras, b.cameras) {
+                XCTAssertEqual(cameraA.projection, cameraB.projection)
+                XCTAssertEqual(cameraA.view, cameraB.view)
+            }
+        }
+
+        XCTAssertEqual(decoded.cameraPath.framesPerSecond, 90, accuracy: 1e-6)
+        XCTAssertEqual(decoded.cameraPath.poses[3].position.x, path.poses[3].position.x, accuracy: 1e-4)
+    }
+
+    func testRejectsInvalidData() {
+        XCTAssertThrowsError(try CameraTrajectory(data: Data("nope".utf8)))
+        let data = CameraTrajectory(.orbit(around: .zero, radius: 5, frameCount: 3), projection: Self.projection).data()
+        XCTAssertThrowsError(try CameraTrajectory(data: data.prefix(data.count - 1)))
+    }
+
+    func testPlayback() {
+        let trajectory = CameraTrajectory(.orbit(around: .zero, radius: 5, frameCount: 3), projection: Self.projection)
+        XCTAssertEqual(trajectory.frame(at: -1)?.timestamp, 0)
+        XCTAssertEqual(trajectory.frame(at: 1.5 / 60)?.timestamp ?? 0, 1.0 / 60, accuracy: 1e-9)
+        XCTAssertEqual(trajectory.frame(at: 10)?.timestamp ?? 0, 2.0 / 60, accuracy: 1e-9)
+
+        let player = CameraTrajectoryPlayer(trajectory)
+        XCTAssertEqual((0..<4).compactMap { _ in player.nextFrame()?.timestamp }.count, 3)
+        XCTAssertTrue(player.isFinished)
+
+        let looping = CameraTrajectoryPlayer(trajectory, loops: true)
+        let timestamps = (0..<5).compactMap { _ in looping.nextFrame()?.timestamp }
+        XCTAssertEqual(timestamps.count, 5)
+        XCTAssertEqual(timestamps[3], 0)
+        XCTAssertFalse(looping.isFinished)
+    }
+}
@@ -0,0 +1,77 @@
+import XCTest
+import SplatCompute
+
+final class DepthSorterTests: XCTestCase {
+    static func randomDepths(count: Int, seed: UInt64 = 3) -> [Float] {
+        var generator = LinearCongruentialGenerator(seed: seed)
+        return (0..<count).map { _ in generator.next(in: -50..<50) }
+    }
+
+    // Compared as depths rather than indices, since splats at equal depths may be in either order
+    static func sortedDepths(_ order: [UInt32], depths: [Float], backToFront: Bool) -> [Float] {
+        order.map { depths[Int($0)] }.sorted(by: backToFront ? (>) : (<))
+    }
+
+    func testExactStrategiesMatchComparisonSort() {
+        // Large enough for the parallel sort to split into chunks
+        let depths = Self.randomDepths(count: 300_000)
+        for backToFront in [ true, false ] {
+            let expected = Self.sortedDepths(Array(0..<UInt32(depths.count)), depths: depths, backToFront: backToFront)
+            for strategy in [ DepthSorter.Strategy.comparison, .radix, .parallelRadix, .incremental ] {
+                var order = Array(0..<UInt32(depths.count))
+                DepthSorter(strategy: strategy, backToFront: backToFront).sort(&order, depths: depths)
+                XCTAssertEqual(Set(order).count, depths.count)
+                XCTAssertEqual(order.map { depths[Int($0)] }, expected, "\(strategy), backToFront \(backToFront)")
+                XCTAssertEqual(DepthSorter.accuracy(of: order, depths: depths, backToFront: backToFront).inversions, 0)
+            }
+        }
+    }
+
+    func testSortsSubsetOfSplats() {
+        let depths = Self.randomDepths(count: 1000)
+        let subset = stride(from: 0, to: 1000, by: 7).map { UInt32($0) }
+        for strategy in DepthSorter.Strategy.allCases where strategy != .bucketed {
+            var order = subset
+            DepthSorter(strategy: strategy).sort(&order, depths: depths)
+            XCTAssertEqual(Set(order), Set(subset))
+            XCTAssertEqual(order.map { depths[Int($0)] }, Self.sortedDepths(subset, depths: depths, backToFront: true), "\(strategy)")
+        }
+    }
+
+    // After a small camera move the previous order needs few moves, so the insertion sort finishes by itself
+    func testIncrementalSortRepairsPreviousOrder() {
+        var depths = Self.randomDepths(count: 10_000)
+        let sorter = DepthSorter(strategy: .incremental)
+        var order = Array(0..<UInt32(depths.count))
+        sorter.sort(&order, depths: depths)
+
+        var generator = LinearCongruentialGenerator(seed: 11)
+        for i in depths.indices {
+            depths[i] += generator.next(in: -0.005..<0.005)
+        }
+        sorter.sort(&order, depths: depths)
+        XCTAssertEqual(DepthSorter.accuracy(of: order, depths: depths).inversions, 0)
+    }
+
+    func testBucketedSortIsApproximate() {
+        let depths = Self.randomDepths(count: 100_000)
+        var order = Array(0..<UInt32(depths.count))
+        DepthSorter(strategy: .bucketed).sort(&order, depths: depths)
+
+        XCTAssertEqual(Set(order).count, depths.count)
+        let accuracy = DepthSorter.accuracy(of: order, depths: depths)
+        XCTAssertGreaterThan(accuracy.inversions, 0)
+        XCTAssertLessThan(accuracy.inversionFraction, 0.5)
+        // Never out by more than a bucket's width
+        XCTAssertLessThanOrEqual(accuracy.maxDepthError, 100 / Float(1 << 16) + 1e-5)
+    }
+
+    func testAccuracy() {
+        let depths: [Float] = [ 4, 3, 2, 1 ]
+        XCTAssertEqual(DepthSorter.accuracy(of: [ 0, 1, 2, 3 ], depths: depths),
+                       DepthSorter.Accuracy(inversions: 0, inversionFraction: 0, maxDepthError: 0))
+        let accuracy = DepthSorter.accuracy(of: [ 0, 2, 1, 3 ], depths: depths)
+        XCTAssertEqual(accuracy.inversions, 1)
+        XCTAssertEqual(accuracy.maxDepthError, 1)
+    }
+}
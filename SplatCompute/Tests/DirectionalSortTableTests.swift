@@ -0,0 +1,86 @@
+import XCTest
+import SplatCompute
+
+final class DirectionalSortTableTests: XCTestCase {
+    static func randomPositions(count: Int) -> [SIMD3<Float>] {
+        var generator = LinearCongruentialGenerator(seed: 11)
+        return (0..<count).map { _ in
+            SIMD3<Float>(generator.next(in: -10..<10), generator.next(in: -10..<10), generator.next(in: -10..<10))
+        }
+    }
+
+    func testSphereDirectionsCoverSphere() {
+        let directions = DirectionalSortTable.sphereDirections(count: 128)
+        for direction in directions {
+            XCTAssertEqual((direction * direction).sum(), 1, accuracy: 1e-5)
+        }
+        // Every direction is within ~20 degrees of a sample
+        let probes = DirectionalSortTable.sphereDirections(count: 1000)
+        for probe in probes {
+            let nearest = directions.map { ($0 * probe).sum() }.max() ?? -1
+            XCTAssertGreaterThan(nearest, cos(20 * Float.pi / 180))
+        }
+    }
+
+    func testStoredOrdersAreSorted() {
+        let positions = Self.randomPositions(count: 2000)
+        let table = DirectionalSortTable(positions: positions, directionCount: 16, backToFront: false)
+        for i in [ 0, 7, 15 ] {
+            let direction = table.directions[i]
+            let depths = positions.map { ($0 * direction).sum() }
+            XCTAssertEqual(DepthSorter.accuracy(of: table.order(forDirection: i), depths: depths, backToFront: false).inversions, 0)
+        }
+    }
+
+    // Starting from the nearest sample rather than the previous order, the result is still exact
+    func testSortFromNearestSample() {
+        let positions = Self.randomPositions(count: 5000)
+        let table = DirectionalSortTable(positions: positions, directionCount: 64)
+        let direction = SIMD3<Float>(0.3, -0.2, -1)
+        let forward = direction / (direction * direction).sum().squareRoot()
+        let depths = positions.map { ($0 * forward).sum() }
+        let sorter = DepthSorter(strategy: .incremental)
+
+        var order = Array(0..<UInt32(positions.count))
+        let seeded = depths.withUnsafeBufferPointer {
+            table.sort(&order, along: forward, previousForward: SIMD3<Float>(0, 0, 1), depths: $0, sorter: sorter)
+        }
+        XCTAssertTrue(seeded)
+        XCTAssertEqual(Set(order).count, positions.count)
+        XCTAssertEqual(DepthSorter.accuracy(of: order, depths: depths).inversions, 0)
+
+        // Having just sorted along forward, the current order is the better start
+        XCTAssertNil(table.order(nearestTo: forward, unlessNearer: forward))
+    }
+
+    func testMemoryBudget() {
+        XCTAssertEqual(DirectionalSortTable.directionCount(splatCount: 1_000_000, memoryBudget: 256 << 20), 67)
+        XCTAssertEqual(DirectionalSortTable.directionCount(splatCount: 1000, memoryBudget: 256 << 20), DirectionalSortTable.maximumDirectionCount)
+        XCTAssertEqual(DirectionalSortTable.directionCount(splatCount: 10_000_000, memoryBudget: 256 << 20), 0)
+    }
+
+    func testPersistence() throws {
+        let table = DirectionalSortTable(positions: Self.randomPositions(count: 500), directionCount: 20)
+        let data = table.data()
+        XCTAssertEqual(data.count, 20 + 20 * 12 + table.memorySize)
+
+        let decoded = try DirectionalSortTable(data: data)
+        XCTAssertEqual(decoded.splatCount, 500)
+        XCTAssertEqual(decoded.backToFront, true)
+        XCTAssertEqual(decoded.directions, table.directions)
+        for i in 0..<20 {
+            XCTAssertEqual(decoded.order(forDirection: i), table.order(forDirection: i))
+        }
+
+        XCTAssertThrowsError(try DirectionalSortTable(data: data.prefix(data.count - 4)))
+        var corrupted = data
+        corrupted[data.count - 1] = 0xff
+        XCTAssertThrowsError(try DirectionalSortTable(data: corrupted))
+
+        // The last order's first index repeated in place of its second: in range, but not a permutation
+        var duplicated = data
+        let lastOrder = data.count - table.memorySize / 20
+        duplicated.replaceSubrange(lastOrder + 4..<lastOrder + 8, with: data[lastOrder..<lastOrder + 4])
+        XCTAssertThrowsError(try DirectionalSortTable(data: duplicated))
+    }
+}
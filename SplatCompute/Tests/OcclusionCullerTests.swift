@@ -0,0 +1,63 @@
+import XCTest
+import SplatCompute
+
+final class OcclusionCullerTests: XCTestCase {
+    static let screenSize = SIMD2<Float>(1024, 1024)
+
+    // An opaque wall at z = -5, a cluster hidden behind it, a cluster off to the side which is visible past the
+    // wall's edge, and a cluster outside the view frustum
+    func testWallHidesClusterBehindIt() {
+        var splats: [Splat] = []
+        for y in -10...10 {
+            for x in -10...10 {
+                splats.append(TestSplat.isotropic(at: SIMD3<Float>(Float(x) * 0.2, Float(y) * 0.2, -5), scale: 0.5))
+            }
+        }
+        let wallCount = splats.count
+        func cluster(around center: SIMD3<Float>) -> [Splat] {
+            (0..<64).map { i in
+                TestSplat.isotropic(at: center + SIMD3<Float>(Float(i % 8) * 0.25 - 1, Float(i / 8) * 0.25 - 1, 0), scale: 0.05)
+            }
+        }
+        let hiddenRange = splats.count..<(splats.count + 64)
+        splats += cluster(around: SIMD3<Float>(0, 0, -20))
+        let visibleRange = splats.count..<(splats.count + 64)
+        splats += cluster(around: SIMD3<Float>(12, 0, -20))
+        let offscreenRange = splats.count..<(splats.count + 64)
+        splats += cluster(around: SIMD3<Float>(100, 0, -20))
+
+        // One splat per chunk, so the expected visibility of each is unambiguous
+        let chunks = SplatChunks(splats: splats, chunkSize: 1)
+        let culler = OcclusionCuller(configuration: .init(timeBudget: 1))
+        let camera: CameraMatrices = (projection: TestCamera.perspective(fovyRadians: .pi / 2, aspectRatio: 1, nearZ: 0.1, farZ: 100),
+                                      view: Float4x4(diagonal: SIMD4<Float>(1, 1, 1, 1)))
+        let (visible, statistics) = culler.cull(chunks: chunks, splats: splats, viewpoint: Viewpoint(camera, screenSize: Self.screenSize))
+
+        var splatVisible = Array(repeating: false, count: splats.count)
+        for (chunkIndex, isVisible) in visible.enumerated() {
+            for index in chunks.splatIndices(inChunk: chunkIndex) {
+                splatVisible[Int(index)] = isVisible
+            }
+        }
+
+        XCTAssertTrue(splatVisible[0..<wallCount].allSatisfy { $0 }, "The wall is visible")
+        XCTAssertTrue(splatVisible[hiddenRange].allSatisfy { !$0 }, "The cluster behind the wall is occluded")
+        XCTAssertTrue(splatVisible[visibleRange].allSatisfy { $0 }, "The cluster beside the wall is visible")
+        XCTAssertTrue(splatVisible[offscreenRange].allSatisfy { !$0 }, "The cluster outside the frustum is culled")
+
+        XCTAssertEqual(statistics.occludedSplats, 64)
+        XCTAssertEqual(statistics.frustumCulledSplats, 64)
+        XCTAssertEqual(statistics.occlusionRate, 64 / Double(splats.count), accuracy: 1e-9)
+    }
+
+    // Without occluders in front, nothing is rejected by occlusion
+    func testNothingOccludedWithoutOccluders() {
+        let splats = (0..<256).map { i in TestSplat.isotropic(at: SIMD3<Float>(Float(i % 16) - 8, Float(i / 16) - 8, -30), scale: 0.05) }
+        let chunks = SplatChunks(splats: splats, chunkSize: 16)
+        let camera: CameraMatrices = (projection: TestCamera.perspective(fovyRadians: .pi / 2, aspectRatio: 1, nearZ: 0.1, farZ: 100),
+                                      view: Float4x4(diagonal: SIMD4<Float>(1, 1, 1, 1)))
+        let report = OcclusionCuller().report(chunks: chunks, splats: splats, cameraPath: [ camera, camera ], screenSize: Self.screenSize)
+        XCTAssertEqual(report.frameCount, 2)
+        XCTAssertEqual(report.maxOcclusionRate, 0)
+    }
+}
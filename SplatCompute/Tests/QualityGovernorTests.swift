@@ -0,0 +1,79 @@
+import XCTest
+import SplatCompute
+
+final class QualityGovernorTests: XCTestCase {
+    static let target = 1.0 / 60
+
+    func testSlowFramesStepDown() {
+        let governor = QualityGovernor()
+        let levelCount = governor.configuration.levels.count
+        for _ in 0..<1000 {
+            governor.recordFrame(duration: 2 * Self.target)
+        }
+        XCTAssertEqual(governor.state.level, levelCount - 1)
+        XCTAssertEqual(governor.state.stepsDown, levelCount - 1)
+        XCTAssertEqual(governor.settings, governor.configuration.levels[levelCount - 1])
+        XCTAssertFalse(governor.settings.exactSort)
+    }
+
+    func testFastFramesStepBackUp() {
+        let governor = QualityGovernor()
+        for _ in 0..<100 {
+            governor.recordFrame(duration: 2 * Self.target)
+        }
+        XCTAssertGreaterThan(governor.state.level, 0)
+        for _ in 0..<1000 {
+            governor.recordFrame(duration: Self.target / 4)
+        }
+        XCTAssertEqual(governor.state.level, 0)
+        XCTAssertEqual(governor.state.stepsUp, governor.state.stepsDown)
+    }
+
+    // A trace noisy around the budget, and a scene whose cheaper level has only a little headroom, settle rather
+    // than flip between levels
+    func testHysteresis() {
+        let noisy = QualityGovernor()
+        for i in 0..<1000 {
+            noisy.recordFrame(duration: Self.target * (i % 2 == 0 ? 1.1 : 0.8))
+        }
+        XCTAssertEqual(noisy.state.level, 0)
+        XCTAssertEqual(noisy.state.stepsDown, 0)
+
+        let governor = QualityGovernor()
+        let frameDurations = [ 1.2, 0.85, 0.6, 0.5, 0.4 ].map { $0 * Self.target }
+        for _ in 0..<2000 {
+            governor.recordFrame(duration: frameDurations[governor.state.level])
+        }
+        XCTAssertEqual(governor.state.level, 1)
+        XCTAssertEqual(governor.state.stepsDown, 1)
+        XCTAssertEqual(governor.state.stepsUp, 0)
+    }
+
+    // Sorts may take several frames, but not more than the frames between them
+    func testSlowSortsStepDown() {
+        let governor = QualityGovernor()
+        for _ in 0..<1000 {
+            governor.recordSort(duration: 2.4 * Self.target)
+            governor.recordFrame(duration: Self.target / 4)
+        }
+        XCTAssertEqual(governor.settings.sortInterval, 3)
+        XCTAssertEqual(governor.state.level, 3)
+        XCTAssertEqual(governor.state.stepsUp, 0)
+    }
+
+    func testThermalStateLimitsQuality() {
+        let governor = QualityGovernor()
+        governor.setThermalState(.serious)
+        XCTAssertEqual(governor.state.level, 2)
+        for _ in 0..<1000 {
+            governor.recordFrame(duration: Self.target / 4)
+        }
+        XCTAssertEqual(governor.state.level, 2)
+
+        governor.setThermalState(.nominal)
+        for _ in 0..<1000 {
+            governor.recordFrame(duration: Self.target / 4)
+        }
+        XCTAssertEqual(governor.state.level, 0)
+    }
+}
@@ -0,0 +1,62 @@
+import XCTest
+import SplatCompute
+
+final class SortOrderCacheTests: XCTestCase {
+    // In the middle of a cell, so nearby poses fall in the same one
+    static let pose = CameraPose(position: SIMD3<Float>(1.02, 2.02, 3.02), forward: SIMD3<Float>(0, 0, -1))
+
+    func testNearbyPosesShareEntries() {
+        let cache = SortOrderCache()
+        let key = cache.key(for: Self.pose, splatCount: 3, generation: 0)
+        XCTAssertNil(cache.lookUp(key))
+        cache.insert([ 2, 0, 1 ], for: Self.pose, key: key)
+
+        let nearby = CameraPose(position: Self.pose.position + SIMD3<Float>(0.001, 0, 0), forward: SIMD3<Float>(0.0001, 0, -1))
+        let entry = cache.lookUp(cache.key(for: nearby, splatCount: 3, generation: 0))
+        XCTAssertEqual(entry?.order, [ 2, 0, 1 ])
+        XCTAssertEqual(entry?.pose, Self.pose)
+
+        let far = CameraPose(position: Self.pose.position + SIMD3<Float>(1, 0, 0), forward: Self.pose.forward)
+        XCTAssertNil(cache.lookUp(cache.key(for: far, splatCount: 3, generation: 0)))
+        // Same pose, but the scene has been edited since
+        XCTAssertNil(cache.lookUp(cache.key(for: Self.pose, splatCount: 3, generation: 1)))
+
+        let statistics = cache.statistics
+        XCTAssertEqual(statistics.hits, 1)
+        XCTAssertEqual(statistics.misses, 3)
+        XCTAssertEqual(statistics.hitRate, 0.25)
+        XCTAssertEqual(statistics.memorySize, 12)
+    }
+
+    func testEvictsLeastRecentlyUsed() {
+        var configuration = SortOrderCache.Configuration()
+        configuration.memoryLimit = 3 * 400
+        let cache = SortOrderCache(configuration: configuration)
+        let order = Array(0..<UInt32(100))
+        let keys = (0..<4).map { i in
+            cache.key(for: CameraPose(position: SIMD3<Float>(Float(i), 0, 0), forward: SIMD3<Float>(0, 0, -1)), splatCount: 100, generation: 0)
+        }
+        for key in keys.prefix(3) {
+            cache.insert(order, for: Self.pose, key: key)
+        }
+        // Using the first makes the second the least recently used
+        XCTAssertNotNil(cache.lookUp(keys[0]))
+        cache.insert(order, for: Self.pose, key: keys[3])
+
+        XCTAssertNotNil(cache.lookUp(keys[0]))
+        XCTAssertNil(cache.lookUp(keys[1]))
+        XCTAssertNotNil(cache.lookUp(keys[2]))
+        XCTAssertNotNil(cache.lookUp(keys[3]))
+        XCTAssertEqual(cache.statistics.evictions, 1)
+        XCTAssertEqual(cache.statistics.entryCount, 3)
+        XCTAssertLessThanOrEqual(cache.statistics.memorySize, configuration.memoryLimit)
+    }
+
+    func testNewSceneDropsOldEntries() {
+        let cache = SortOrderCache()
+        cache.insert([ 0, 1 ], for: Self.pose, key: cache.key(for: Self.pose, splatCount: 2, generation: 0))
+        cache.insert([ 1, 0, 2 ], for: Self.pose, key: cache.key(for: Self.pose, splatCount: 3, generation: 0))
+        XCTAssertEqual(cache.statistics.entryCount, 1)
+        XCTAssertEqual(cache.statistics.memorySize, 12)
+    }
+}
@@ -0,0 +1,128 @@
+import XCTest
+import SplatCompute
+
+final class SortSchedulerTests: XCTestCase {
+    static let frame = 1.0 / 60
+
+    static func scheduler(maxConcurrentSorts: Int) -> SortScheduler {
+        var configuration = SortScheduler.Configuration()
+        configuration.maxConcurrentSorts = maxConcurrentSorts
+        return SortScheduler(configuration: configuration)
+    }
+
+    func testCapsConcurrentSorts() {
+        let scheduler = Self.scheduler(maxConcurrentSorts: 2)
+        let clients = (0..<3).map { _ in scheduler.addClient() }
+        XCTAssertNotNil(scheduler.requestSort(clients[0], .init(), now: 0))
+        XCTAssertNotNil(scheduler.requestSort(clients[1], .init(), now: 0))
+        XCTAssertNil(scheduler.requestSort(clients[2], .init(), now: 0))
+        XCTAssertEqual(scheduler.statistics.runningSorts, 2)
+
+        scheduler.didFinishSort(clients[0])
+        let grant = scheduler.requestSort(clients[2], .init(), now: Self.frame)
+        XCTAssertEqual(grant?.waited ?? -1, Self.frame, accuracy: 1e-9)
+        XCTAssertEqual(scheduler.statistics.grants, 3)
+        XCTAssertEqual(scheduler.statistics.deferrals, 1)
+    }
+
+    // With one slot, a visible renderer whose view is turning goes ahead of a still one, and both ahead of an
+    // offscreen one, whatever order they ask in
+    func testVisibleMovingContentFirst() {
+        let scheduler = Self.scheduler(maxConcurrentSorts: 1)
+        let offscreen = scheduler.addClient()
+        let still = scheduler.addClient()
+        let moving = scheduler.addClient()
+        let blocker = scheduler.addClient()
+        // Everyone's sorted once, so they're ranked rather than first-come
+        for client in [ offscreen, still, moving ] {
+            XCTAssertNotNil(scheduler.requestSort(client, .init(), now: 0))
+            scheduler.didFinishSort(client)
+        }
+        XCTAssertNotNil(scheduler.requestSort(blocker, .init(), now: 0))
+
+        let requests: [(SortScheduler.Client, SortScheduler.Request)] = [
+            (offscreen, .init(isVisible: false, screenCoverage: 0, viewChange: 0.2)),
+            (still, .init(isVisible: true, screenCoverage: 0.5, viewChange: 0)),
+            (moving, .init(isVisible: true, screenCoverage: 0.5, viewChange: 0.2)),
+        ]
+        for (client, request) in requests {
+            XCTAssertNil(scheduler.requestSort(client, request, now: Self.frame))
+        }
+        scheduler.didFinishSort(blocker)
+
+        var order: [SortScheduler.Client] = []
+        var now = 2 * Self.frame
+        while order.count < 3 {
+            for (client, request) in requests where !order.contains(client) && scheduler.requestSort(client, request, now: now) != nil {
+                order.append(client)
+                scheduler.didFinishSort(client)
+                break
+            }
+            now += Self.frame
+        }
+        XCTAssertEqual(order, [ moving, still, offscreen ])
+    }
+
+    // Two busy renderers sorting back to back don't keep an offscreen one waiting for longer than maxWait
+    func testOffscreenContentIsSortedEventually() {
+        let scheduler = Self.scheduler(maxConcurrentSorts: 1)
+        let busy = [ scheduler.addClient(), scheduler.addClient() ]
+        let offscreen = scheduler.addClient()
+        let busyRequest = SortScheduler.Request(isVisible: true, screenCoverage: 1, viewChange: 1)
+        let offscreenRequest = SortScheduler.Request(isVisible: false, screenCoverage: 0, viewChange: 0)
+
+        var running: SortScheduler.Client?
+        var offscreenSorts = 0
+        for frame in 0..<600 {
+            let now = Double(frame) * Self.frame
+            // Each sort takes a frame
+            if let client = running {
+                scheduler.didFinishSort(client)
+                running = nil
+            }
+            for client in busy + [ offscreen ] {
+                let request = client == offscreen ? offscreenRequest : busyRequest
+                if scheduler.requestSort(client, request, now: now) != nil {
+                    running = client
+                }
+            }
+            if running == offscreen {
+                offscreenSorts += 1
+            }
+        }
+        XCTAssertGreaterThan(offscreenSorts, 5)
+        XCTAssertLessThanOrEqual(scheduler.statistics.longestWait,
+                                 scheduler.configuration.maxWait + 3 * Self.frame)
+        XCTAssertGreaterThan(scheduler.statistics.overdueGrants, 0)
+    }
+
+    // A renderer which stops asking doesn't hold its place at the front
+    func testClientsWhichStopAskingExpire() {
+        let scheduler = Self.scheduler(maxConcurrentSorts: 1)
+        let gone = scheduler.addClient()
+        let other = scheduler.addClient()
+        let blocker = scheduler.addClient()
+        XCTAssertNotNil(scheduler.requestSort(blocker, .init(), now: 0))
+        XCTAssertNil(scheduler.requestSort(gone, .init(), now: 0))
+        scheduler.didFinishSort(blocker)
+
+        XCTAssertNil(scheduler.requestSort(other, .init(viewChange: 0), now: 0.1))
+        let later = scheduler.configuration.expiry + 0.1
+        XCTAssertNotNil(scheduler.requestSort(other, .init(viewChange: 0), now: later))
+
+        scheduler.removeClient(other)
+        XCTAssertEqual(scheduler.statistics.runningSorts, 0)
+    }
+
+    func testScreenCoverage() {
+        let camera: CameraMatrices = (projection: TestCamera.perspective(fovyRadians: .pi / 2, aspectRatio: 1, nearZ: 0.1, farZ: 100),
+                                      view: Float4x4(diagonal: SIMD4<Float>(1, 1, 1, 1)))
+        let viewpoint = Viewpoint(camera, screenSize: SIMD2<Float>(1024, 1024))
+        let small = Bounds(min: SIMD3<Float>(-1, -1, -5), max: SIMD3<Float>(1, 1, -5))
+        XCTAssertEqual(viewpoint.screenCoverage(small), 0.04, accuracy: 1e-4)
+        let large = Bounds(min: SIMD3<Float>(-10, -10, -6), max: SIMD3<Float>(10, 10, -4))
+        XCTAssertEqual(viewpoint.screenCoverage(large), 1, accuracy: 1e-4)
+        let behind = Bounds(min: SIMD3<Float>(-1, -1, 4), max: SIMD3<Float>(1, 1, 6))
+        XCTAssertEqual(viewpoint.screenCoverage(behind), 0)
+    }
+}
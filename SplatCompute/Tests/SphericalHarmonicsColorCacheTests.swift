@@ -0,0 +1,69 @@
+import XCTest
+import SplatCompute
+
+final class SphericalHarmonicsColorCacheTests: XCTestCase {
+    func makeCache(count: Int, budget: SphericalHarmonicsColorCache.Budget) -> SphericalHarmonicsColorCache {
+        let cache = SphericalHarmonicsColorCache(degree: 1, angularThreshold: 5 * .pi / 180, budget: budget)
+        for i in 0..<count {
+            // A row of splats along x, with colour varying with the x component of the view direction
+            cache.append(position: SIMD3<Float>(Float(i), 0, 10), dc: .zero, rest: [ 0, 0, 0, 0, 0, 0, -1, -1, -1 ])
+        }
+        return cache
+    }
+
+    func testBakesOnlyWhenDirectionChanges() {
+        let cache = makeCache(count: 100, budget: .init(scansPerFrame: 1000, bakesPerFrame: 1000))
+
+        XCTAssertEqual(cache.update(viewPosition: .zero).count, 100, "Everything is baked initially")
+        XCTAssertEqual(cache.update(viewPosition: .zero).count, 0, "Nothing changes for a stationary viewer")
+        XCTAssertEqual(cache.update(viewPosition: SIMD3<Float>(0.01, 0, 0)).count, 0, "Small movements are below the threshold")
+
+        let moved = cache.update(viewPosition: SIMD3<Float>(0, 0, 9))
+        XCTAssertFalse(moved.isEmpty)
+        XCTAssertLessThan(moved.count, 100, "The splat straight ahead keeps its view direction")
+
+        // The baked colour should match a direct evaluation from the position it was baked at
+        let direction = SphericalHarmonics.direction(from: SIMD3<Float>(0, 0, 9), to: SIMD3<Float>(Float(moved[0]), 0, 10))
+        let expected = 0.5 + SphericalHarmonics.c1 * direction.x
+        XCTAssertEqual(cache.colors[moved[0]].x, expected, accuracy: 1e-5)
+    }
+
+    func testBudgetSpreadsWorkAcrossFrames() {
+        let cache = makeCache(count: 100, budget: .init(scansPerFrame: 1000, bakesPerFrame: 30))
+
+        XCTAssertEqual(cache.update(viewPosition: .zero).count, 30)
+        XCTAssertEqual(cache.update(viewPosition: .zero).count, 30)
+        XCTAssertEqual(cache.update(viewPosition: .zero).count, 30)
+        XCTAssertEqual(cache.update(viewPosition: .zero).count, 10)
+        XCTAssertEqual(cache.update(viewPosition: .zero).count, 0)
+    }
+
+    func testSetColorAndCompact() {
+        let cache = SphericalHarmonicsColorCache(degree: 1, angularThreshold: 5 * .pi / 180, budget: .default)
+        for i in 0..<4 {
+            cache.append(position: SIMD3<Float>(Float(i), 0, 10), dc: .zero, rest: [ 0, 0, 0, 0, 0, 0, -1, -1, -1 ])
+        }
+        cache.setColor(SIMD3<Float>(0.2, 0.4, 0.6), at: 3)
+        cache.compact(remap: [ 0, -1, 1, 2 ])
+        XCTAssertEqual(cache.count, 3)
+
+        cache.update(viewPosition: SIMD3<Float>(-5, 0, 0))
+        // The recoloured splat is view-independent now, so baking doesn't change it
+        XCTAssertEqual(cache.colors[2].x, 0.2, accuracy: 1e-5)
+        XCTAssertEqual(cache.colors[2].z, 0.6, accuracy: 1e-5)
+        XCTAssertNotEqual(cache.colors[1].x, 0.5, "Other splats are still view-dependent")
+    }
+
+    // Colours outside 0...1 (which a DC term would be clamped to) survive, and are never re-baked
+    func testFixedColorsAreKeptExactly() {
+        let cache = makeCache(count: 2, budget: .default)
+        cache.append(position: SIMD3<Float>(5, 0, 10), color: SIMD3<Float>(1.5, -0.25, 0.5))
+        XCTAssertEqual(cache.count, 3)
+        XCTAssertEqual(cache.update(viewPosition: .zero), [ 0, 1 ])
+        XCTAssertEqual(cache.colors[2], SIMD3<Float>(1.5, -0.25, 0.5))
+
+        cache.compact(remap: [ -1, 0, 1 ])
+        XCTAssertEqual(cache.update(viewPosition: SIMD3<Float>(0, 0, 9)), [ 0 ])
+        XCTAssertEqual(cache.colors[1], SIMD3<Float>(1.5, -0.25, 0.5))
+    }
+}
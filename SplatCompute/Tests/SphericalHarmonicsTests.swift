@@ -0,0 +1,143 @@
+import XCTest
+import SplatCompute
+
+final class SphericalHarmonicsTests: XCTestCase {
+    static let tolerance: Float = 1e-5
+
+    // The basis constants, derived from their closed forms
+    func testConstants() {
+        let sqrtPi = Double.pi.squareRoot()
+        XCTAssertEqual(SphericalHarmonics.c0, Float(1 / (2 * sqrtPi)), accuracy: Self.tolerance)
+        XCTAssertEqual(SphericalHarmonics.c1, Float(3.0.squareRoot() / (2 * sqrtPi)), accuracy: Self.tolerance)
+
+        let c2: [Double] = [
+            15.0.squareRoot() / (2 * sqrtPi),
+            -15.0.squareRoot() / (2 * sqrtPi),
+            5.0.squareRoot() / (4 * sqrtPi),
+            -15.0.squareRoot() / (2 * sqrtPi),
+            15.0.squareRoot() / (4 * sqrtPi),
+        ]
+        XCTAssertEqual(SphericalHarmonics.c2.count, c2.count)
+        for (actual, expected) in zip(SphericalHarmonics.c2, c2) {
+            XCTAssertEqual(actual, Float(expected), accuracy: Self.tolerance)
+        }
+
+        let c3: [Double] = [
+            -(35.0 / 2).squareRoot() / (4 * sqrtPi),
+            105.0.squareRoot() / (2 * sqrtPi),
+            -(21.0 / 2).squareRoot() / (4 * sqrtPi),
+            7.0.squareRoot() / (4 * sqrtPi),
+            -(21.0 / 2).squareRoot() / (4 * sqrtPi),
+            105.0.squareRoot() / (4 * sqrtPi),
+            -(35.0 / 2).squareRoot() / (4 * sqrtPi),
+        ]
+        XCTAssertEqual(SphericalHarmonics.c3.count, c3.count)
+        for (actual, expected) in zip(SphericalHarmonics.c3, c3) {
+            XCTAssertEqual(actual, Float(expected), accuracy: Self.tolerance)
+        }
+    }
+
+    func testCoefficientCounts() {
+        XCTAssertEqual((0...3).map { SphericalHarmonics.restCoefficientCount(degree: $0) }, [ 0, 3, 8, 15 ])
+        XCTAssertEqual(SphericalHarmonics.degree(restCoefficientCount: 15), 3)
+        XCTAssertNil(SphericalHarmonics.degree(restCoefficientCount: 4))
+    }
+
+    func testInterleave() {
+        // 2 coefficients per channel, channel-major
+        let channelMajor: [Float] = [ 1, 2, 10, 20, 100, 200 ]
+        XCTAssertEqual(SphericalHarmonics.interleave(channelMajorRest: channelMajor), [ 1, 10, 100, 2, 20, 200 ])
+    }
+
+    func testDegreeZero() {
+        let dc = SIMD3<Float>(0.3, -1.2, 0.8)
+        let color = SphericalHarmonics.color(dc: dc)
+        XCTAssertEqual(color.x, 0.5 + SphericalHarmonics.c0 * 0.3, accuracy: Self.tolerance)
+        XCTAssertEqual(color.y, 0.5 + SphericalHarmonics.c0 * -1.2, accuracy: Self.tolerance)
+        XCTAssertEqual(color.z, 0.5 + SphericalHarmonics.c0 * 0.8, accuracy: Self.tolerance)
+    }
+
+    // Each basis function, evaluated along +z (where x = y = 0, z = 1), with a single non-zero coefficient
+    func testBasisAlongZ() {
+        let direction = SIMD3<Float>(0, 0, 1)
+        let expectedBasis: [Float] = [
+            0, SphericalHarmonics.c1, 0,
+            0, 0, SphericalHarmonics.c2[2] * 2, 0, 0,
+            0, 0, 0, SphericalHarmonics.c3[3] * 2, 0, 0, 0,
+        ]
+        for (coefficientIndex, basis) in expectedBasis.enumerated() {
+            var rest = [Float](repeating: 0, count: 15 * 3)
+            rest[coefficientIndex * 3] = 0.25
+            let color = rest.withUnsafeBufferPointer {
+                SphericalHarmonics.color(degree: 3, direction: direction, dc: .zero, rest: $0.baseAddress!)
+            }
+            XCTAssertEqual(color.x, 0.5 + 0.25 * basis, accuracy: Self.tolerance, "Coefficient \(coefficientIndex)")
+            XCTAssertEqual(color.y, 0.5, accuracy: Self.tolerance)
+            XCTAssertEqual(color.z, 0.5, accuracy: Self.tolerance)
+        }
+    }
+
+    // A direction with all components non-zero, checked against values computed independently in double precision
+    func testBasisAlongDiagonal() {
+        let d = 1 / Float(3).squareRoot()
+        let direction = SIMD3<Float>(d, d, d)
+        // (x, y, z) = (d, d, d), so xx = yy = zz = xy = yz = xz = 1/3
+        let third: Float = 1.0 / 3.0
+        let expectedBasis: [Float] = [
+            -SphericalHarmonics.c1 * d, SphericalHarmonics.c1 * d, -SphericalHarmonics.c1 * d,
+            SphericalHarmonics.c2[0] * third,
+            SphericalHarmonics.c2[1] * third,
+            0,
+            SphericalHarmonics.c2[3] * third,
+            0,
+            SphericalHarmonics.c3[0] * d * 2 * third,
+            SphericalHarmonics.c3[1] * d * third,
+            SphericalHarmonics.c3[2] * d * 2 * third,
+            SphericalHarmonics.c3[3] * d * -4 * third,
+            SphericalHarmonics.c3[4] * d * 2 * third,
+            0,
+            SphericalHarmonics.c3[6] * d * -2 * third,
+        ]
+        for (coefficientIndex, basis) in expectedBasis.enumerated() {
+            var rest = [Float](repeating: 0, count: 15 * 3)
+            rest[coefficientIndex * 3 + 1] = 0.25
+            let color = rest.withUnsafeBufferPointer {
+                SphericalHarmonics.color(degree: 3, direction: direction, dc: .zero, rest: $0.baseAddress!)
+            }
+            XCTAssertEqual(color.y, 0.5 + 0.25 * basis, accuracy: Self.tolerance, "Coefficient \(coefficientIndex)")
+        }
+    }
+
+    func testLowerDegreeIgnoresHigherCoefficients() {
+        let rest = [Float](repeating: 0.2, count: 15 * 3)
+        let direction = SIMD3<Float>(0.6, 0, 0.8)
+        let degree1 = rest.withUnsafeBufferPointer {
+            SphericalHarmonics.color(degree: 1, direction: direction, dc: .zero, rest: $0.baseAddress!)
+        }
+        let expected = 0.5 + 0.2 * SphericalHarmonics.c1 * (0.8 - 0.6)
+        XCTAssertEqual(degree1.x, expected, accuracy: Self.tolerance)
+    }
+
+    // The multi-threaded batch evaluation must match evaluating each splat on its own
+    func testBatchMatchesSingle() {
+        let count = 20_000
+        let degree = 3
+        let stride = SphericalHarmonics.restCoefficientCount(degree: degree) * 3
+        var generator = LinearCongruentialGenerator(seed: 42)
+        let positions = (0..<count).map { _ in SIMD3<Float>(generator.next(in: -10..<10), generator.next(in: -10..<10), generator.next(in: -10..<10)) }
+        let dc = (0..<count).map { _ in SIMD3<Float>(generator.next(in: -2..<2), generator.next(in: -2..<2), generator.next(in: -2..<2)) }
+        let rest = (0..<(count * stride)).map { _ in generator.next(in: -0.3..<0.3) }
+        let viewPosition = SIMD3<Float>(1, 2, -20)
+
+        let colors = SphericalHarmonics.evaluate(degree: degree, positions: positions, dc: dc, rest: rest, viewPosition: viewPosition)
+        XCTAssertEqual(colors.count, count)
+
+        rest.withUnsafeBufferPointer { rest in
+            for i in Swift.stride(from: 0, to: count, by: 97) {
+                let direction = SphericalHarmonics.direction(from: viewPosition, to: positions[i])
+                let expected = SphericalHarmonics.color(degree: degree, direction: direction, dc: dc[i], rest: rest.baseAddress! + i * stride)
+                XCTAssertEqual(colors[i], expected)
+            }
+        }
+    }
+}
@@ -0,0 +1,61 @@
+import XCTest
+import SplatCompute
+
+final class SplatEditStateTests: XCTestCase {
+    func testDeleteHideAndShow() {
+        var state = SplatEditState()
+        state.append(count: 10)
+        XCTAssertFalse(state.hasUndrawnSplats)
+
+        XCTAssertTrue(state.markDeleted(2))
+        XCTAssertFalse(state.markDeleted(2), "Deleting twice is a no-op")
+        XCTAssertTrue(state.markHidden(5, opacity: 0.75))
+        XCTAssertFalse(state.markHidden(2, opacity: 1), "Deleted splats can't be hidden")
+
+        XCTAssertEqual(state.deletedCount, 1)
+        XCTAssertEqual(state.hiddenCount, 1)
+        XCTAssertTrue(state.hasUndrawnSplats)
+        XCTAssertFalse(state.isDrawn(2))
+        XCTAssertFalse(state.isDrawn(5))
+        XCTAssertTrue(state.isDrawn(0))
+
+        XCTAssertNil(state.markShown(2))
+        XCTAssertEqual(state.markShown(5), 0.75)
+        XCTAssertTrue(state.isDrawn(5))
+        XCTAssertEqual(state.dirtyRanges.coalesced(), [ 2..<3, 5..<6 ])
+    }
+
+    func testCompactionPreservesOrder() {
+        var state = SplatEditState()
+        state.append(count: 6)
+        state.markDeleted(1)
+        state.markDeleted(4)
+        state.markHidden(5, opacity: 0.5)
+
+        let remap = state.compactionRemap()
+        XCTAssertEqual(remap, [ 0, -1, 1, 2, -1, 3 ])
+
+        // A depth order over the old indices stays sorted after renumbering
+        var order: [UInt32] = [ 5, 4, 3, 2, 1, 0 ]
+        SplatEditState.apply(remap: remap, to: &order)
+        XCTAssertEqual(order, [ 3, 2, 1, 0 ])
+
+        let generation = state.generation
+        state.compact(remap: remap)
+        XCTAssertEqual(state.count, 4)
+        XCTAssertEqual(state.deletedCount, 0)
+        XCTAssertEqual(state.hiddenOpacity(3), 0.5, "Hidden splats keep their opacity through compaction")
+        XCTAssertTrue(state.dirtyRanges.isEmpty)
+        XCTAssertNotEqual(state.generation, generation)
+    }
+
+    func testDirtyRangesCoalesce() {
+        var ranges = DirtyRanges()
+        for index in [ 10, 11, 12, 3, 4, 12, 20 ] {
+            ranges.insert(index)
+        }
+        ranges.insert(5..<10)
+        XCTAssertEqual(ranges.take(), [ 3..<13, 20..<21 ])
+        XCTAssertTrue(ranges.isEmpty)
+    }
+}
@@ -0,0 +1,87 @@
+import XCTest
+import SplatCompute
+
+final class SplatExecutorTests: XCTestCase {
+    func testParallelForRunsEachIterationOnce() {
+        let executor = SplatExecutor(workerCount: 3)
+        defer { executor.shutdown() }
+        var counts = [Int](repeating: 0, count: 1000)
+        counts.withUnsafeMutableBufferPointer { counts in
+            executor.parallelFor(iterations: counts.count, priority: .frame) { i in
+                counts[i] += 1
+            }
+        }
+        XCTAssertEqual(counts, [Int](repeating: 1, count: 1000))
+    }
+
+    // Every worker busy in an outer loop still completes the inner loops, since their callers take part
+    func testNestedParallelFor() {
+        let executor = SplatExecutor(workerCount: 2)
+        defer { executor.shutdown() }
+        var sums = [Int](repeating: 0, count: 8)
+        sums.withUnsafeMutableBufferPointer { sums in
+            executor.parallelFor(iterations: sums.count, priority: .background) { i in
+                var inner = [Int](repeating: 0, count: 100)
+                inner.withUnsafeMutableBufferPointer { inner in
+                    executor.parallelFor(iterations: inner.count, priority: .frame) { j in
+                        inner[j] = j
+                    }
+                }
+                sums[i] = inner.reduce(0, +)
+            }
+        }
+        XCTAssertEqual(sums, [Int](repeating: 4950, count: 8))
+    }
+
+    func testMoreUrgentWorkRunsFirst() {
+        let executor = SplatExecutor(workerCount: 1)
+        defer { executor.shutdown() }
+        let release = DispatchSemaphore(value: 0)
+        let done = DispatchGroup()
+        let lock = NSLock()
+        var order: [String] = []
+        func submit(_ name: String, _ priority: SplatExecutor.Priority) {
+            done.enter()
+            executor.async(priority: priority) {
+                lock.lock()
+                order.append(name)
+                lock.unlock()
+                done.leave()
+            }
+        }
+
+        // Hold the only worker while work queues up behind it
+        done.enter()
+        executor.async(priority: .background) {
+            release.wait()
+            done.leave()
+        }
+        submit("background", .background)
+        submit("culling", .culling)
+        submit("frame", .frame)
+        release.signal()
+        done.wait()
+        XCTAssertEqual(order, [ "frame", "culling", "background" ])
+    }
+
+    func testIdleWorkersSteal() {
+        let executor = SplatExecutor(workerCount: 4)
+        defer { executor.shutdown() }
+        let done = DispatchGroup()
+        done.enter()
+        // Submitted from a worker, these all go on its own queue; the other workers can only get them by stealing
+        executor.async(priority: .background) {
+            for _ in 0..<64 {
+                done.enter()
+                executor.async(priority: .background) {
+                    usleep(1000)
+                    done.leave()
+                }
+            }
+            done.leave()
+        }
+        done.wait()
+        XCTAssertGreaterThan(executor.statistics.steals, 0)
+        XCTAssertEqual(executor.statistics.tasksRun[SplatExecutor.Priority.background.rawValue], 65)
+    }
+}
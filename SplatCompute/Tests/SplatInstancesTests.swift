@@ -0,0 +1,89 @@
+import XCTest
+import SplatCompute
+
+final class SplatInstancesTests: XCTestCase {
+    static func translation(_ offset: SIMD3<Float>) -> Float4x4 {
+        Float4x4(columns: (SIMD4<Float>(1, 0, 0, 0),
+                           SIMD4<Float>(0, 1, 0, 0),
+                           SIMD4<Float>(0, 0, 1, 0),
+                           SIMD4<Float>(offset.x, offset.y, offset.z, 1)))
+    }
+
+    func testLayoutOffsets() {
+        var instances = SplatInstances()
+        let a = instances.addAsset(0..<3)
+        let b = instances.addAsset(3..<8)
+        _ = instances.addInstance(of: b, transform: Self.translation(.zero))
+        _ = instances.addInstance(of: a, transform: Self.translation(.zero))
+        _ = instances.addInstance(of: b, transform: Self.translation(.zero))
+
+        let layout = instances.layout
+        XCTAssertFalse(layout.isIdentity)
+        XCTAssertEqual(layout.instancedSplatCount, 13)
+        XCTAssertEqual(layout.placements.map(\.orderOffset), [ 0, 5, 8 ])
+        XCTAssertEqual(layout.placements.map(\.splatOffset), [ 3, 0, 3 ])
+        XCTAssertEqual(layout.instanceIndices, [ 0, 1, 2 ])
+
+        XCTAssertEqual((0..<13).map { layout.placementIndex(ofInstancedSplat: $0) },
+                       [ 0, 0, 0, 0, 0, 1, 1, 1, 2, 2, 2, 2, 2 ])
+        XCTAssertEqual((0..<13).map { layout.splatIndex(ofInstancedSplat: $0) },
+                       [ 3, 4, 5, 6, 7, 0, 1, 2, 3, 4, 5, 6, 7 ])
+    }
+
+    func testHiddenInstancesAreLeftOut() {
+        var instances = SplatInstances()
+        let a = instances.addAsset(0..<4)
+        let first = instances.addInstance(of: a, transform: Self.translation(.zero))
+        let second = instances.addInstance(of: a, transform: Self.translation(.zero))
+        instances.setHidden(true, ofInstance: first)
+
+        let layout = instances.layout
+        XCTAssertEqual(layout.instancedSplatCount, 4)
+        XCTAssertEqual(layout.instanceIndices, [ second ])
+        XCTAssertEqual(layout.placements.first?.orderOffset, 0)
+
+        instances.setHidden(true, ofInstance: second)
+        XCTAssertEqual(instances.layout.instancedSplatCount, 0)
+    }
+
+    // Placements refreshed after a move keep their offsets, so an order built for the old layout stays valid
+    func testRefreshingTransforms() {
+        var instances = SplatInstances()
+        let a = instances.addAsset(0..<2)
+        let instance = instances.addInstance(of: a, transform: Self.translation(.zero))
+        let layout = instances.layout
+        instances.setTransform(Self.translation(SIMD3<Float>(0, 0, -4)), ofInstance: instance)
+
+        let placements = instances.placements(refreshing: layout)
+        XCTAssertEqual(placements.map(\.orderOffset), layout.placements.map(\.orderOffset))
+        XCTAssertEqual(placements[0].transform[3].z, -4)
+    }
+
+    // Two copies of the same asset, one pushed back between the other's splats, must interleave in a single
+    // depth order
+    func testGlobalOrderInterleavesInstances() {
+        let splats = [ TestSplat.isotropic(at: SIMD3<Float>(0, 0, -1)), TestSplat.isotropic(at: SIMD3<Float>(0, 0, -3)) ]
+        var instances = SplatInstances()
+        let asset = instances.addAsset(0..<2)
+        _ = instances.addInstance(of: asset, transform: Self.translation(.zero))
+        _ = instances.addInstance(of: asset, transform: Self.translation(SIMD3<Float>(0, 0, -1)))
+        let layout = instances.layout
+
+        let order = splats.withUnsafeBufferPointer { splats in
+            (0..<layout.instancedSplatCount).sorted {
+                layout.worldPosition(ofInstancedSplat: $0, splats: splats).z < layout.worldPosition(ofInstancedSplat: $1, splats: splats).z
+            }
+        }
+        // Back to front: (1, z -4), (0, z -3), (1, z -2), (0, z -1)
+        XCTAssertEqual(order, [ 3, 1, 2, 0 ])
+        XCTAssertEqual(order.map { layout.placementIndex(ofInstancedSplat: $0) }, [ 1, 0, 1, 0 ])
+    }
+
+    func testIdentityLayout() {
+        let layout = SplatInstances.Layout.identity(splatCount: 5)
+        XCTAssertTrue(layout.isIdentity)
+        XCTAssertEqual(layout.instancedSplatCount, 5)
+        XCTAssertEqual(layout.splatIndex(ofInstancedSplat: 4), 4)
+        XCTAssertEqual(SplatInstances.Layout.identity(splatCount: 0).instancedSplatCount, 0)
+    }
+}
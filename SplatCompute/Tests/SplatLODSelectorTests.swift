@@ -0,0 +1,140 @@
+import XCTest
+import SplatCompute
+
+final class SplatLODSelectorTests: XCTestCase {
+    static let screenSize = SIMD2<Float>(1024, 1024)
+
+    // A 32x32 grid of small splats in the z = 0 plane
+    static let hierarchy: SplatLODHierarchy = {
+        let leaves = (0..<1024).map { i in
+            Splat(position: SIMD3<Float>(Float(i % 32) - 16, Float(i / 32) - 16, 0),
+                  color: SIMD4<Float>(1, 1, 1, 1),
+                  scale: SIMD3<Float>(repeating: 0.1),
+                  rotation: SIMD4<Float>(1, 0, 0, 0))
+        }
+        return SplatLODHierarchy(leaves: leaves)
+    }()
+
+    // Looking down -z from (x, 0, distance)
+    static func viewpoint(x: Float = 0, distance: Float) -> Viewpoint {
+        let camera: CameraMatrices = (projection: TestCamera.perspective(fovyRadians: .pi / 2, aspectRatio: 1, nearZ: 0.1, farZ: 1000),
+                                      view: Float4x4(columns: (SIMD4<Float>(1, 0, 0, 0),
+                                                               SIMD4<Float>(0, 1, 0, 0),
+                                                               SIMD4<Float>(0, 0, 1, 0),
+                                                               SIMD4<Float>(-x, 0, -distance, 1))))
+        return Viewpoint(camera, screenSize: screenSize)
+    }
+
+    // Every leaf should be covered by exactly one node in the cut
+    func assertValidCut(_ cut: [Int], file: StaticString = #filePath, line: UInt = #line) {
+        let hierarchy = Self.hierarchy
+        let cutSet = Set(cut)
+        XCTAssertEqual(cutSet.count, cut.count, "No duplicates", file: file, line: line)
+        for (nodeIndex, node) in hierarchy.nodes.enumerated() where node.isLeaf {
+            var coverCount = 0
+            var current: Int? = nodeIndex
+            while let index = current {
+                if cutSet.contains(index) { coverCount += 1 }
+                current = hierarchy.nodes[index].parent
+            }
+            XCTAssertEqual(coverCount, 1, "Leaf \(nodeIndex)", file: file, line: line)
+        }
+    }
+
+    func testHierarchyStructure() {
+        let hierarchy = Self.hierarchy
+        XCTAssertEqual(hierarchy.leafCount, 1024)
+        XCTAssertEqual(hierarchy.splats.count, hierarchy.nodes.count)
+        XCTAssertNotNil(hierarchy.root)
+        for (nodeIndex, node) in hierarchy.nodes.enumerated() {
+            for child in hierarchy.children(of: nodeIndex) {
+                XCTAssertEqual(hierarchy.nodes[child].parent, nodeIndex)
+                XCTAssertGreaterThanOrEqual(node.geometricError, hierarchy.nodes[child].geometricError)
+                XCTAssertTrue(node.bounds.contains(hierarchy.nodes[child].bounds.min) && node.bounds.contains(hierarchy.nodes[child].bounds.max))
+            }
+        }
+        assertValidCut([ hierarchy.root! ])
+    }
+
+    // The rotation (r, i, j, k) applied to v
+    static func rotate(_ v: SIMD3<Float>, by rotation: SIMD4<Float>) -> SIMD3<Float> {
+        func cross(_ a: SIMD3<Float>, _ b: SIMD3<Float>) -> SIMD3<Float> {
+            SIMD3<Float>(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x)
+        }
+        let u = SIMD3<Float>(rotation.y, rotation.z, rotation.w)
+        return v + 2 * rotation.x * cross(u, v) + 2 * cross(u, cross(u, v))
+    }
+
+    // The world-space direction of the merged splat's largest axis
+    static func majorAxis(of splat: Splat) -> SIMD3<Float> {
+        let axis = splat.scale.x >= max(splat.scale.y, splat.scale.z) ? SIMD3<Float>(1, 0, 0) :
+            splat.scale.y >= splat.scale.z ? SIMD3<Float>(0, 1, 0) : SIMD3<Float>(0, 0, 1)
+        return rotate(axis, by: splat.rotation)
+    }
+
+    // Parents follow their children's orientation and spread, rather than an axis-aligned box around them
+    func testMergeKeepsOrientation() {
+        let diagonal = SIMD3<Float>(1, 1, 0) / 2.squareRoot()
+        let quarterTurn = SIMD4<Float>(cos(.pi / 8), 0, 0, sin(.pi / 8))
+        let elongated = Splat(position: .zero, color: SIMD4<Float>(1, 1, 1, 1), scale: SIMD3<Float>(1, 0.1, 0.05), rotation: quarterTurn)
+        let merged = SplatLODHierarchy(leaves: [ elongated, elongated ]).splats[2]
+        XCTAssertEqual(merged.scale.max(), 1, accuracy: 1e-4)
+        XCTAssertEqual(merged.scale.min(), 0.05, accuracy: 1e-4)
+        var axis = Self.majorAxis(of: merged)
+        XCTAssertEqual(abs(axis.x * diagonal.x + axis.y * diagonal.y + axis.z * diagonal.z), 1, accuracy: 1e-4)
+
+        let spread = SplatLODHierarchy(leaves: [ TestSplat.isotropic(at: diagonal), TestSplat.isotropic(at: -diagonal) ]).splats[2]
+        // Variance 0.01 across the diagonal, and 1 + 0.01 along it
+        XCTAssertEqual(spread.scale.max(), 1.01.squareRoot(), accuracy: 1e-4)
+        XCTAssertEqual(spread.scale.min(), 0.1, accuracy: 1e-4)
+        axis = Self.majorAxis(of: spread)
+        XCTAssertEqual(abs(axis.x * diagonal.x + axis.y * diagonal.y + axis.z * diagonal.z), 1, accuracy: 1e-4)
+    }
+
+    func testRefinesWithProximity() {
+        let configuration = SplatLODSelector.Configuration(maxPixelError: 2, splatBudget: .max, maxPassesPerUpdate: 64)
+
+        let far = SplatLODSelector(hierarchy: Self.hierarchy, configuration: configuration)
+        let farStatistics = far.update(viewpoint: Self.viewpoint(distance: 500))
+        assertValidCut(far.cut)
+        XCTAssertLessThanOrEqual(farStatistics.maxPixelError, 2)
+
+        let near = SplatLODSelector(hierarchy: Self.hierarchy, configuration: configuration)
+        let nearStatistics = near.update(viewpoint: Self.viewpoint(distance: 5))
+        assertValidCut(near.cut)
+        XCTAssertLessThanOrEqual(nearStatistics.maxPixelError, 2)
+
+        XCTAssertLessThan(far.cut.count, near.cut.count)
+        XCTAssertEqual(near.splatIndices.count, near.cut.count)
+    }
+
+    func testRespectsBudget() {
+        let selector = SplatLODSelector(hierarchy: Self.hierarchy,
+                                        configuration: .init(maxPixelError: 0.5, splatBudget: 100, maxPassesPerUpdate: 64))
+        let statistics = selector.update(viewpoint: Self.viewpoint(distance: 5))
+        assertValidCut(selector.cut)
+        XCTAssertLessThanOrEqual(selector.cut.count, 100)
+        XCTAssertGreaterThan(statistics.maxPixelError, 0.5, "The budget, not the error, limits the cut")
+
+        // Lowering the budget coarsens the existing cut
+        selector.configuration.splatBudget = 20
+        selector.update(viewpoint: Self.viewpoint(distance: 5))
+        assertValidCut(selector.cut)
+        XCTAssertLessThanOrEqual(selector.cut.count, 20)
+    }
+
+    // Updating from the previous frame's cut should end up where a selection from scratch does
+    func testIncrementalUpdateMatchesFreshSelection() {
+        let configuration = SplatLODSelector.Configuration(maxPixelError: 2, splatBudget: .max, maxPassesPerUpdate: 64)
+        let incremental = SplatLODSelector(hierarchy: Self.hierarchy, configuration: configuration)
+        for step in 0..<10 {
+            let viewpoint = Self.viewpoint(x: Float(step) * 3 - 15, distance: 20 - Float(step) * 1.5)
+            incremental.update(viewpoint: viewpoint)
+            assertValidCut(incremental.cut)
+
+            let fresh = SplatLODSelector(hierarchy: Self.hierarchy, configuration: configuration)
+            fresh.update(viewpoint: viewpoint)
+            XCTAssertEqual(Set(incremental.cut), Set(fresh.cut), "Step \(step)")
+        }
+    }
+}
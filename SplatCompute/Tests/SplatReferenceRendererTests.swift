@@ -0,0 +1,289 @@
+import XCTest
+import SplatCompute
+
+final class SplatReferenceRendererTests: XCTestCase {
+    static let screenSize = SIMD2<Float>(256, 256)
+
+    static let viewpoint: Viewpoint = {
+        let camera: CameraMatrices = (projection: Float4x4.perspective(fovyRadians: .pi / 2, aspectRatio: 1, nearZ: 0.1, farZ: 100),
+                                      view: Float4x4(diagonal: SIMD4<Float>(1, 1, 1, 1)))
+        return Viewpoint(camera, screenSize: screenSize)
+    }()
+
+    static let translucent = SIMD4<Float>(1, 1, 1, 0.8)
+
+    // An isotropic splat projects to a circular gaussian with σ = focal length * scale / distance, widened by the
+    // low-pass filter, and is cut off at boundsRadius (its opacity is high enough to reach that far). Like the shader, the eigenvalues are kept at least 0.2 apart,
+    // the larger along y when the covariance is diagonal.
+    func testSingleSplatMatchesGaussian() {
+        let splat = TestSplat.isotropic(at: SIMD3<Float>(0, 0, -10), scale: 0.5, color: Self.translucent)
+        let (image, statistics) = SplatReferenceRenderer().render(splats: [ splat ], viewpoint: Self.viewpoint)
+        XCTAssertEqual(statistics.culledSplats, 0)
+        XCTAssertGreaterThan(statistics.blendedFragments, 0)
+        XCTAssertGreaterThanOrEqual(statistics.fragments, statistics.blendedFragments)
+
+        let center = SIMD2<Float>(128, 128)
+        let sigma = Float(128 * 0.5 / 10)
+        let variance = SIMD2<Float>(sigma * sigma + 0.3 - 0.1, sigma * sigma + 0.3 + 0.1)
+        for (x, y) in [ (128, 128), (131, 128), (128, 121), (137, 134), (140, 128) ] {
+            let offset = SIMD2<Float>(Float(x) + 0.5, Float(y) + 0.5) - center
+            let exponent = (offset * offset / (2 * variance)).sum()
+            let expected = exponent <= 4 ? 0.8 * exp(-exponent) : 0
+            XCTAssertEqual(image[x, y].w, expected, accuracy: 1e-4, "at (\(x), \(y))")
+            XCTAssertEqual(image[x, y].x, expected, accuracy: 1e-4)
+        }
+        // Well outside the cutoff
+        XCTAssertEqual(image[128, 160], .zero)
+    }
+
+    func testCullsSplatsOutsideFrustum() {
+        let splats = [
+            TestSplat.isotropic(at: SIMD3<Float>(0, 0, 10), scale: 0.5, color: Self.translucent),
+            TestSplat.isotropic(at: SIMD3<Float>(50, 0, -10), scale: 0.5, color: Self.translucent),
+        ]
+        let (image, statistics) = SplatReferenceRenderer().render(splats: splats, viewpoint: Self.viewpoint)
+        XCTAssertEqual(statistics.culledSplats, 2)
+        XCTAssertEqual(statistics.fragments, 0)
+        XCTAssertTrue(image.pixels.allSatisfy { $0 == .zero })
+    }
+
+    // Front-to-back and back-to-front blending of the same sorted splats agree
+    func testBlendOrdersAgree() {
+        let splats = Self.randomScene(seed: 3, count: 200)
+        let frontToBack = SplatReferenceRenderer(frontToBack: true).render(splats: splats, viewpoint: Self.viewpoint)
+        let backToFront = SplatReferenceRenderer(frontToBack: false).render(splats: splats, viewpoint: Self.viewpoint)
+        XCTAssertEqual(frontToBack.statistics.blendedFragments, backToFront.statistics.blendedFragments)
+        for (a, b) in zip(frontToBack.image.pixels, backToFront.image.pixels) {
+            XCTAssertEqual(a.w, b.w, accuracy: 1e-4)
+            XCTAssertEqual(a.x, b.x, accuracy: 1e-4)
+        }
+    }
+
+    static func randomScene(seed: UInt64, count: Int) -> [Splat] {
+        var generator = LinearCongruentialGenerator(seed: seed)
+        return (0..<count).map { _ in
+            TestSplat.isotropic(at: SIMD3<Float>(generator.next(in: -4..<4), generator.next(in: -4..<4), generator.next(in: -20 ..< -5)),
+                                 scale: generator.next(in: 0.05..<0.5),
+                                 color: SIMD4<Float>(generator.next(in: 0..<1), generator.next(in: 0..<1), generator.next(in: 0..<1), generator.next(in: 0.2..<1)))
+        }
+    }
+
+    // With a single layer, there's nothing to get out of order
+    func testWeightedBlendingMatchesSortedForOneSplat() {
+        let splats = [ TestSplat.isotropic(at: SIMD3<Float>(0, 0, -10), scale: 0.5, color: SIMD4<Float>(0.2, 0.6, 0.9, 0.7)) ]
+        let sorted = SplatReferenceRenderer().render(splats: splats, viewpoint: Self.viewpoint).image
+        let weighted = SplatReferenceRenderer(blending: .weighted(.init())).render(splats: splats, viewpoint: Self.viewpoint).image
+        XCTAssertLessThan(weighted.difference(from: sorted).maxError, 1e-5)
+    }
+
+    func testWeightedBlendingIgnoresOrder() {
+        let splats = Self.randomScene(seed: 4, count: 200)
+        let renderer = SplatReferenceRenderer(blending: .weighted(.init()))
+        let order = Array(0..<UInt32(splats.count))
+        let forwards = splats.withUnsafeBufferPointer { renderer.render(splats: $0, order: order, viewpoint: Self.viewpoint).image }
+        let backwards = splats.withUnsafeBufferPointer { renderer.render(splats: $0, order: order.reversed(), viewpoint: Self.viewpoint).image }
+        XCTAssertLessThan(backwards.difference(from: forwards).maxError, 1e-4)
+    }
+
+    // Coverage is exact either way; colour is approximate where splats of different colours overlap
+    func testWeightedBlendingError() {
+        let splats = Self.randomScene(seed: 3, count: 200)
+        let sorted = SplatReferenceRenderer().render(splats: splats, viewpoint: Self.viewpoint).image
+        let weighted = SplatReferenceRenderer(blending: .weighted(.init())).render(splats: splats, viewpoint: Self.viewpoint).image
+        for (a, b) in zip(weighted.pixels, sorted.pixels) {
+            XCTAssertEqual(a.w, b.w, accuracy: 1e-4)
+        }
+        let difference = weighted.difference(from: sorted)
+        XCTAssertGreaterThan(difference.meanAbsoluteError, 0)
+        XCTAssertLessThan(difference.meanAbsoluteError, 0.05)
+        XCTAssertLessThanOrEqual(difference.rootMeanSquareError, difference.maxError)
+        XCTAssertTrue(difference.peakSignalToNoiseRatio.isFinite)
+
+        XCTAssertEqual(sorted.difference(from: sorted).peakSignalToNoiseRatio, .infinity)
+    }
+
+    func testTightBoundsRadius() {
+        XCTAssertEqual(SplatReferenceRenderer.tightBoundsRadius(opacity: 1), SplatReferenceRenderer.boundsRadius)
+        XCTAssertEqual(SplatReferenceRenderer.tightBoundsRadius(opacity: 0.1), log(25.5).squareRoot(), accuracy: 1e-5)
+        XCTAssertEqual(SplatReferenceRenderer.tightBoundsRadius(opacity: 0.5 / 255), 0)
+        XCTAssertEqual(SplatReferenceRenderer.tightBoundsRadius(opacity: 0), 0)
+        // At the edge, alpha is at the cutoff
+        let radius = SplatReferenceRenderer.tightBoundsRadius(opacity: 0.05)
+        XCTAssertEqual(exp(-radius * radius) * 0.05, SplatReferenceRenderer.alphaCutoff, accuracy: 1e-6)
+    }
+
+    // Faint splats cost far fewer fragments with tight bounds, for an image which differs by less than the cutoff
+    // per splat
+    func testTightBoundsReduceFragments() {
+        var generator = LinearCongruentialGenerator(seed: 5)
+        let splats = (0..<100).map { _ in
+            TestSplat.isotropic(at: SIMD3<Float>(generator.next(in: -6..<6), generator.next(in: -6..<6), -10),
+                                 scale: generator.next(in: 0.1..<0.3),
+                                 color: SIMD4<Float>(1, 1, 1, generator.next(in: 0.004..<0.02)))
+        }
+        let tight = SplatReferenceRenderer(tightBounds: true).render(splats: splats, viewpoint: Self.viewpoint)
+        let fixed = SplatReferenceRenderer(tightBounds: false).render(splats: splats, viewpoint: Self.viewpoint)
+        XCTAssertLessThan(Double(tight.statistics.fragments), 0.5 * Double(fixed.statistics.fragments))
+
+        var overlaps = Array(repeating: 0, count: fixed.image.pixels.count)
+        for splat in splats {
+            guard let projected = SplatReferenceRenderer.project(splat, viewpoint: Self.viewpoint) else { continue }
+            let reach = Int((projected.axis1 * projected.axis1).sum().squareRoot() * SplatReferenceRenderer.boundsRadius) + 2
+            let center = SIMD2<Int>(Int(projected.center.x), Int(projected.center.y))
+            for y in max(0, center.y - reach)...min(fixed.image.height - 1, center.y + reach) {
+                for x in max(0, center.x - reach)...min(fixed.image.width - 1, center.x + reach) {
+                    overlaps[y * fixed.image.width + x] += 1
+                }
+            }
+        }
+        for (i, (a, b)) in zip(tight.image.pixels, fixed.image.pixels).enumerated() {
+            XCTAssertLessThanOrEqual(abs(a.w - b.w), Float(overlaps[i]) * SplatReferenceRenderer.alphaCutoff + 1e-6)
+        }
+    }
+
+    // A literal port of splatPreprocessKernel (with an identity instance transform), matrix for matrix, against which
+    // the reference renderer's reformulation of it is checked. Matrices are column-major, as in Metal.
+    enum ShaderMath {
+        typealias Float3x3 = (SIMD3<Float>, SIMD3<Float>, SIMD3<Float>)
+
+        static func multiply(_ m: Float3x3, _ v: SIMD3<Float>) -> SIMD3<Float> {
+            m.0 * v.x + m.1 * v.y + m.2 * v.z
+        }
+
+        static func multiply(_ a: Float3x3, _ b: Float3x3) -> Float3x3 {
+            (multiply(a, b.0), multiply(a, b.1), multiply(a, b.2))
+        }
+
+        static func transpose(_ m: Float3x3) -> Float3x3 {
+            (SIMD3<Float>(m.0.x, m.1.x, m.2.x), SIMD3<Float>(m.0.y, m.1.y, m.2.y), SIMD3<Float>(m.0.z, m.1.z, m.2.z))
+        }
+
+        // The PreprocessedSplat values (in NDC), or nil where the shader culls the splat
+        static func preprocess(_ splat: Splat, viewpoint: Viewpoint) -> (center: SIMD2<Float>, axis1: SIMD2<Float>, axis2: SIMD2<Float>, boundsRadius: Float)? {
+            let view = viewpoint.view
+            let projection = viewpoint.projection
+            let position = SIMD4<Float>(splat.position.x, splat.position.y, splat.position.z, 1)
+            let projectedCenter = projection * (view * position)
+            let boundsRadius = SplatReferenceRenderer.tightBoundsRadius(opacity: splat.opacity)
+            let bounds = 1.2 * projectedCenter.w
+            if boundsRadius <= 0 || projectedCenter.z < -projectedCenter.w ||
+                projectedCenter.x < -bounds || projectedCenter.x > bounds || projectedCenter.y < -bounds || projectedCenter.y > bounds {
+                return nil
+            }
+
+            // calcCovariance3D
+            let q = splat.rotation
+            let rotation: Float3x3 = (
+                SIMD3<Float>(1 - 2 * (q.z * q.z + q.w * q.w), 2 * (q.y * q.z + q.x * q.w), 2 * (q.y * q.w - q.x * q.z)),
+                SIMD3<Float>(2 * (q.y * q.z - q.x * q.w), 1 - 2 * (q.y * q.y + q.w * q.w), 2 * (q.z * q.w + q.x * q.y)),
+                SIMD3<Float>(2 * (q.y * q.w + q.x * q.z), 2 * (q.z * q.w - q.x * q.y), 1 - 2 * (q.y * q.y + q.z * q.z)))
+            let scale: Float3x3 = (SIMD3<Float>(splat.scale.x, 0, 0), SIMD3<Float>(0, splat.scale.y, 0), SIMD3<Float>(0, 0, splat.scale.z))
+            let transform = multiply(rotation, scale)
+            let cov3D = multiply(transform, transpose(transform))
+            let cov3Da = cov3D.0
+            let cov3Db = SIMD3<Float>(cov3D.1.y, cov3D.1.z, cov3D.2.z)
+
+            // calcCovariance2D
+            var viewPosition = SIMD3<Float>((view * position).x, (view * position).y, (view * position).z)
+            let limX = 1.3 / projection[0][0]
+            let limY = 1.3 / projection[1][1]
+            viewPosition.x = min(max(viewPosition.x / viewPosition.z, -limX), limX) * viewPosition.z
+            viewPosition.y = min(max(viewPosition.y / viewPosition.z, -limY), limY) * viewPosition.z
+            let focalX = viewpoint.screenSize.x * projection[0][0] / 2
+            let focalY = viewpoint.screenSize.y * projection[1][1] / 2
+            let z = viewPosition.z
+            let J: Float3x3 = (SIMD3<Float>(focalX / z, 0, 0),
+                               SIMD3<Float>(0, focalY / z, 0),
+                               SIMD3<Float>(-(focalX * viewPosition.x) / (z * z), -(focalY * viewPosition.y) / (z * z), 0))
+            let W: Float3x3 = (SIMD3<Float>(view[0].x, view[0].y, view[0].z),
+                               SIMD3<Float>(view[1].x, view[1].y, view[1].z),
+                               SIMD3<Float>(view[2].x, view[2].y, view[2].z))
+            let T = multiply(J, W)
+            let Vrk: Float3x3 = (SIMD3<Float>(cov3Da.x, cov3Da.y, cov3Da.z),
+                                 SIMD3<Float>(cov3Da.y, cov3Db.x, cov3Db.y),
+                                 SIMD3<Float>(cov3Da.z, cov3Db.y, cov3Db.z))
+            let cov = multiply(multiply(T, transpose(Vrk)), transpose(T))
+            let a = cov.0.x + 0.3
+            let b = cov.0.y
+            let d = cov.1.y + 0.3
+
+            // decomposeCovariance
+            let det = a * d - b * b
+            let mean = 0.5 * (a + d)
+            let dist = max(0.1, (mean * mean - det).squareRoot())
+            let lambda1 = 2 * (mean + dist)
+            let lambda2 = 2 * (mean - dist)
+            var eigenvector1 = b == 0 ? (a > d ? SIMD2<Float>(1, 0) : SIMD2<Float>(0, 1)) : SIMD2<Float>(b, d - (mean - dist))
+            eigenvector1 /= (eigenvector1 * eigenvector1).sum().squareRoot()
+            let eigenvector2 = SIMD2<Float>(eigenvector1.y, -eigenvector1.x)
+
+            let toNDC = 2 * boundsRadius / viewpoint.screenSize
+            return (center: SIMD2<Float>(projectedCenter.x, projectedCenter.y) / projectedCenter.w,
+                    axis1: eigenvector1 * lambda1.squareRoot() * toNDC,
+                    axis2: eigenvector2 * lambda2.squareRoot() * toNDC,
+                    boundsRadius: boundsRadius)
+        }
+    }
+
+    // The preprocessing pass's output, converted to NDC as the shader stores it, matches the shader's own math for
+    // randomly placed, rotated and stretched splats, seen from an arbitrary camera
+    func testPreprocessMatchesShaderMath() {
+        var generator = LinearCongruentialGenerator(seed: 9)
+        let pose = CameraPose(position: SIMD3<Float>(3, 2, 6), lookingAt: SIMD3<Float>(0, 0, -2))
+        let camera: CameraMatrices = (projection: Float4x4.perspective(fovyRadians: 1, aspectRatio: 1.5, nearZ: 0.1, farZ: 100),
+                                      view: pose.view)
+        let viewpoint = Viewpoint(camera, screenSize: SIMD2<Float>(960, 640))
+        let splats = (0..<500).map { _ in
+            var rotation = SIMD4<Float>(generator.next(in: -1..<1), generator.next(in: -1..<1), generator.next(in: -1..<1), generator.next(in: -1..<1))
+            rotation /= (rotation * rotation).sum().squareRoot()
+            let size = generator.next(in: 0.05..<0.3)
+            return Splat(position: SIMD3<Float>(generator.next(in: -8..<8), generator.next(in: -6..<6), generator.next(in: -12..<4)),
+                         color: SIMD4<Float>(1, 0.5, 0.25, generator.next(in: 0..<1)),
+                         scale: SIMD3<Float>(size, size * generator.next(in: 1..<3), size * generator.next(in: 0.3..<1)),
+                         rotation: rotation)
+        }
+        let order = Array(0..<UInt32(splats.count))
+        let preprocessed = splats.withUnsafeBufferPointer { SplatReferenceRenderer.preprocess(splats: $0, order: order, viewpoint: viewpoint) }
+
+        var checked = 0
+        for (splat, projected) in zip(splats, preprocessed) {
+            let expected = ShaderMath.preprocess(splat, viewpoint: viewpoint)
+            guard let projected, projected.boundsRadius > 0 else {
+                XCTAssertNil(expected)
+                continue
+            }
+            guard let expected else {
+                XCTFail("Culled by the shader but not the reference renderer")
+                continue
+            }
+            checked += 1
+            let toNDC = 2 * projected.boundsRadius / viewpoint.screenSize
+            let center = projected.center / viewpoint.screenSize * 2 - 1
+            let axis1 = projected.axis1 * toNDC
+            let axis2 = projected.axis2 * toNDC
+            XCTAssertEqual(projected.boundsRadius, expected.boundsRadius)
+            XCTAssertEqual(center.x, expected.center.x, accuracy: 1e-4)
+            XCTAssertEqual(center.y, expected.center.y, accuracy: 1e-4)
+            // The axes' lengths (the eigenvalues) are well conditioned; their directions only where the eigenvalues
+            // differ enough to pin them down
+            let length1 = (axis1 * axis1).sum().squareRoot()
+            let length2 = (axis2 * axis2).sum().squareRoot()
+            let expectedLength1 = (expected.axis1 * expected.axis1).sum().squareRoot()
+            let expectedLength2 = (expected.axis2 * expected.axis2).sum().squareRoot()
+            XCTAssertEqual(length1, expectedLength1, accuracy: 2e-3 * expectedLength1)
+            XCTAssertEqual(length2, expectedLength2, accuracy: 2e-3 * expectedLength2)
+            if expectedLength1 > 1.2 * expectedLength2 {
+                XCTAssertGreaterThan(abs((axis1 * expected.axis1).sum()) / (length1 * expectedLength1), 0.999)
+            }
+        }
+        XCTAssertGreaterThan(checked, 50)
+    }
+
+    func testProjectMatchesViewpoint() throws {
+        let splat = TestSplat.isotropic(at: SIMD3<Float>(2, -1, -8), scale: 0.2, color: Self.translucent)
+        let projected = try XCTUnwrap(SplatReferenceRenderer.project(splat, viewpoint: Self.viewpoint))
+        XCTAssertEqual(projected.depth, 8, accuracy: 1e-5)
+        XCTAssertEqual(projected.center.x, 128 + 128 * 2 / 8, accuracy: 1e-3)
+        XCTAssertEqual(projected.center.y, 128 - 128 * 1 / 8, accuracy: 1e-3)
+    }
+}
@@ -0,0 +1,123 @@
+import XCTest
+import SplatCompute
+
+final class SplatSpatialIndexTests: XCTestCase {
+    static let screenSize = SIMD2<Float>(1024, 1024)
+
+    static func randomSplats(count: Int) -> [Splat] {
+        var generator = LinearCongruentialGenerator(seed: 7)
+        return (0..<count).map { _ in
+            TestSplat.isotropic(at: SIMD3<Float>(generator.next(in: -10..<10), generator.next(in: -10..<10), generator.next(in: -30 ..< -5)),
+                                scale: generator.next(in: 0.01..<0.2))
+        }
+    }
+
+    static let viewpoint: Viewpoint = {
+        let camera: CameraMatrices = (projection: TestCamera.perspective(fovyRadians: .pi / 2, aspectRatio: 1, nearZ: 0.1, farZ: 100),
+                                      view: Float4x4(diagonal: SIMD4<Float>(1, 1, 1, 1)))
+        return Viewpoint(camera, screenSize: screenSize)
+    }()
+
+    func testPickFindsFrontmostOpaqueSplat() {
+        let splats = [
+            TestSplat.isotropic(at: SIMD3<Float>(0, 0, -10)),
+            TestSplat.isotropic(at: SIMD3<Float>(0, 0, -5)),
+            TestSplat.isotropic(at: SIMD3<Float>(3, 0, -2)),
+        ]
+        let index = SplatSpatialIndex(splats: splats)
+
+        let hit = index.pick(ray: .init(origin: .zero, direction: SIMD3<Float>(0, 0, -1)), splats: splats)
+        XCTAssertEqual(hit?.splatIndex, 1)
+        XCTAssertEqual(hit?.distance ?? 0, 5, accuracy: 1e-4)
+        XCTAssertEqual(hit?.position.z ?? 0, -5, accuracy: 1e-4)
+
+        XCTAssertNil(index.pick(ray: .init(origin: .zero, direction: SIMD3<Float>(0, 1, 0)), splats: splats))
+        XCTAssertNil(index.pick(ray: .init(origin: .zero, direction: SIMD3<Float>(0, 0, -1)), splats: splats, maxDistance: 4))
+    }
+
+    // Faint splats only stop the ray once enough of them have accumulated
+    func testPickAccumulatesOpacity() {
+        let splats = (1...4).map { TestSplat.isotropic(at: SIMD3<Float>(0, 0, -Float($0)), color: SIMD4<Float>(1, 1, 1, 0.3)) }
+        let index = SplatSpatialIndex(splats: splats)
+        let hit = index.pick(ray: .init(origin: .zero, direction: SIMD3<Float>(0, 0, -1)), splats: splats, opacityThreshold: 0.6)
+        // 1 - 0.7^2 = 0.51, 1 - 0.7^3 = 0.657
+        XCTAssertEqual(hit?.splatIndex, 2)
+        XCTAssertEqual(hit?.opacity ?? 0, 0.657, accuracy: 1e-4)
+    }
+
+    func testPickThroughPixel() {
+        let splats = [ TestSplat.isotropic(at: SIMD3<Float>(5, 0, -10)) ]
+        let index = SplatSpatialIndex(splats: splats)
+        // x = 5 at depth 10 with a 90° field of view is halfway to the right edge
+        let ray = SplatSpatialIndex.Ray(viewpoint: Self.viewpoint, pixel: SIMD2<Float>(768, 512))
+        XCTAssertEqual(index.pick(ray: ray, splats: splats)?.splatIndex, 0)
+    }
+
+    // Visiting nodes nearest first, and stopping at the hit, finds the same splat as gathering every contribution
+    // along the ray from a single leaf
+    func testPickMatchesBruteForce() {
+        let splats = Self.randomSplats(count: 5000).map { splat in
+            var splat = splat
+            splat.scale *= 5
+            splat.color.w = 0.3
+            return splat
+        }
+        let index = SplatSpatialIndex(splats: splats)
+        let bruteForce = SplatSpatialIndex(splats: splats, leafSize: splats.count)
+
+        var hits = 0
+        for y in stride(from: Float(0), to: 1024, by: 64) {
+            for x in stride(from: Float(0), to: 1024, by: 64) {
+                let ray = SplatSpatialIndex.Ray(viewpoint: Self.viewpoint, pixel: SIMD2<Float>(x, y))
+                let expected = bruteForce.pick(ray: ray, splats: splats)
+                let hit = index.pick(ray: ray, splats: splats)
+                XCTAssertEqual(hit?.splatIndex, expected?.splatIndex)
+                XCTAssertEqual(hit?.opacity ?? 0, expected?.opacity ?? 0, accuracy: 1e-5)
+                hits += hit == nil ? 0 : 1
+            }
+        }
+        XCTAssertGreaterThan(hits, 0)
+    }
+
+    func testBoxSelectionMatchesBruteForce() {
+        let splats = Self.randomSplats(count: 5000)
+        let index = SplatSpatialIndex(splats: splats)
+        let box = Bounds(min: SIMD3<Float>(-3, -2, -20), max: SIMD3<Float>(4, 6, -8))
+
+        let expected = splats.indices.filter { box.contains(splats[$0].position) }
+        XCTAssertEqual(index.indices(in: box, splats: splats).sorted(), expected)
+    }
+
+    func testLassoSelectionMatchesBruteForce() {
+        let splats = Self.randomSplats(count: 5000)
+        let index = SplatSpatialIndex(splats: splats)
+        // A non-convex L shape
+        let lasso: [SIMD2<Float>] = [
+            SIMD2(200, 200), SIMD2(800, 200), SIMD2(800, 400), SIMD2(400, 400), SIMD2(400, 800), SIMD2(200, 800),
+        ]
+
+        let expected = splats.indices.filter { i in
+            let clip = Self.viewpoint.clipPosition(splats[i].position)
+            guard clip.w > 0 else { return false }
+            let pixel = Self.viewpoint.pixelPosition(ndc: SIMD2<Float>(clip.x, clip.y) / clip.w)
+            let inLower = pixel.x >= 200 && pixel.x <= 800 && pixel.y >= 200 && pixel.y <= 400
+            let inLeft = pixel.x >= 200 && pixel.x <= 400 && pixel.y >= 200 && pixel.y <= 800
+            return inLower || inLeft
+        }
+        XCTAssertFalse(expected.isEmpty)
+        XCTAssertEqual(index.indices(inScreenPolygon: lasso, viewpoint: Self.viewpoint, splats: splats).sorted(), expected)
+    }
+
+    func testRefitAfterMove() {
+        var splats = Self.randomSplats(count: 1000)
+        var index = SplatSpatialIndex(splats: splats)
+        splats[123].position = SIMD3<Float>(50, 50, 50)
+        splats[124].position = SIMD3<Float>(50, 50, 50)
+        splats.withUnsafeBufferPointer { index.refit(splats: $0, dirtyRanges: [ 123..<125 ]) }
+
+        let box = Bounds(min: SIMD3<Float>(repeating: 49), max: SIMD3<Float>(repeating: 51))
+        XCTAssertEqual(index.indices(in: box, splats: splats).sorted(), [ 123, 124 ])
+        let hit = index.pick(ray: .init(origin: SIMD3<Float>(50, 50, 60), direction: SIMD3<Float>(0, 0, -1)), splats: splats)
+        XCTAssertEqual(hit.map { $0.splatIndex == 123 || $0.splatIndex == 124 }, true)
+    }
+}
@@ -0,0 +1,43 @@
+import Foundation
+import SplatCompute
+
+enum TestCamera {
+    // Right-handed perspective projection, as used by the sample app
+    static func perspective(fovyRadians fovy: Float, aspectRatio: Float, nearZ: Float, farZ: Float) -> Float4x4 {
+        let ys = 1 / tan(fovy * 0.5)
+        let xs = ys / aspectRatio
+        let zs = farZ / (nearZ - farZ)
+        return Float4x4(columns: (SIMD4<Float>(xs,  0, 0,   0),
+                                  SIMD4<Float>( 0, ys, 0,   0),
+                                  SIMD4<Float>( 0,  0, zs, -1),
+                                  SIMD4<Float>( 0,  0, zs * nearZ, 0)))
+    }
+}
+
+enum TestSplat {
+    // An unrotated splat, the same size along every axis
+    static func isotropic(at position: SIMD3<Float>,
+                          scale: Float = 0.1,
+                          color: SIMD4<Float> = SIMD4<Float>(1, 1, 1, 1)) -> Splat {
+        Splat(position: position, color: color, scale: SIMD3<Float>(repeating: scale), rotation: SIMD4<Float>(1, 0, 0, 0))
+    }
+}
+
+// Deterministic source of test values
+struct LinearCongruentialGenerator {
+    var state: UInt64
+
+    init(seed: UInt64) {
+        state = seed
+    }
+
+    mutating func next() -> UInt64 {
+        state = state &* 6364136223846793005 &+ 1442695040888963407
+        return state
+    }
+
+    mutating func next(in range: Range<Float>) -> Float {
+        let unit = Float(next() >> 40) / Float(1 << 24)
+        return range.lowerBound + unit * (range.upperBound - range.lowerBound)
+    }
+}
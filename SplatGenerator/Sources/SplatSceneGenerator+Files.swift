@@ -0,0 +1,81 @@
+import Foundation
+import PLYIO
+import SplatCompute
+
+extension SplatSceneGenerator {
+    // The bytes per splat of a .splat file: position and scale as floats, then RGBA and the rotation as bytes
+    public static let dotSplatStride = 32
+
+    // Writes the scene as a 3DGS PLY file, with the same properties as SplatIO's SplatPLYSceneWriter (and so
+    // readable by SplatPLYSceneReader, which needs degree 0 or 3 spherical harmonics)
+    public func writePLY(to url: URL, format: PLYHeader.Format = .binaryLittleEndian) throws {
+        let restCount = 3 * SphericalHarmonics.restCoefficientCount(degree: configuration.sphericalHarmonicsDegree)
+        let propertyNames = [ "x", "y", "z", "nx", "ny", "nz", "f_dc_0", "f_dc_1", "f_dc_2" ] +
+            (0..<restCount).map { "f_rest_\($0)" } +
+            [ "opacity", "scale_0", "scale_1", "scale_2", "rot_0", "rot_1", "rot_2", "rot_3" ]
+        let header = PLYHeader(format: format, version: "1.0", elements: [
+            PLYHeader.Element(name: "vertex",
+                              count: UInt32(configuration.splatCount),
+                              properties: propertyNames.map { PLYHeader.Property(name: $0, type: .primitive(.float32)) }),
+        ])
+
+        let writer = try PLYWriter(url)
+        try writer.write(header)
+        try generate { batch in
+            for splat in batch {
+                let opacity = min(max(splat.opacity, 1e-6), 1 - 1e-6)
+                let values = [ splat.position.x, splat.position.y, splat.position.z,
+                               splat.normal.x, splat.normal.y, splat.normal.z,
+                               splat.sphericalHarmonicsDC.x, splat.sphericalHarmonicsDC.y, splat.sphericalHarmonicsDC.z ] +
+                    splat.sphericalHarmonicsRest +
+                    [ log(opacity / (1 - opacity)),
+                      log(splat.scale.x), log(splat.scale.y), log(splat.scale.z),
+                      splat.rotation.x, splat.rotation.y, splat.rotation.z, splat.rotation.w ]
+                try writer.write(PLYElement(properties: values.map { .float32($0) }))
+            }
+        }
+        try writer.close()
+    }
+
+    // Writes the scene in the .splat format used by web viewers: no spherical harmonics, colour and opacity as
+    // bytes, and the rotation quantized to bytes
+    public func writeDotSplat(to url: URL) throws {
+        guard FileManager.default.createFile(atPath: url.path, contents: nil) else {
+            throw CocoaError(.fileWriteUnknown, userInfo: [ NSURLErrorKey: url ])
+        }
+        let file = try FileHandle(forWritingTo: url)
+        defer { try? file.close() }
+        try generate { batch in
+            try file.write(contentsOf: Self.dotSplatData(batch))
+        }
+    }
+
+    // The whole scene as a .splat file's contents
+    public func dotSplatData() -> Data {
+        var data = Data(capacity: configuration.splatCount * Self.dotSplatStride)
+        generate { data.append(Self.dotSplatData($0)) }
+        return data
+    }
+
+    static func dotSplatData(_ splats: [GeneratedSplat]) -> Data {
+        var data = Data(count: splats.count * dotSplatStride)
+        data.withUnsafeMutableBytes { bytes in
+            for (i, splat) in splats.enumerated() {
+                let offset = i * dotSplatStride
+                let floats = [ splat.position.x, splat.position.y, splat.position.z, splat.scale.x, splat.scale.y, splat.scale.z ]
+                for (j, value) in floats.enumerated() {
+                    bytes.storeBytes(of: value.bitPattern.littleEndian, toByteOffset: offset + j * 4, as: UInt32.self)
+                }
+                let color = SphericalHarmonics.color(dc: splat.sphericalHarmonicsDC)
+                let rgba = [ color.x, color.y, color.z, splat.opacity ].map { UInt8(min(max($0 * 255, 0), 255).rounded()) }
+                let rotation = [ splat.rotation.x, splat.rotation.y, splat.rotation.z, splat.rotation.w ].map {
+                    UInt8(min(max($0 * 128 + 128, 0), 255).rounded(.down))
+                }
+                for (j, byte) in (rgba + rotation).enumerated() {
+                    bytes[offset + 24 + j] = byte
+                }
+            }
+        }
+        return data
+    }
+}
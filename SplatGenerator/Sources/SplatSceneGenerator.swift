@@ -0,0 +1,260 @@
+import Foundation
+import SplatCompute
+
+// Generates plausible splat scenes of any size from a seed, so that tests and benchmarks can work at the sizes
+// that matter without shipping gigabytes of captures.
+//
+// Most splats lie on small, gently curved surface patches scattered through a cube, flattened along the surface
+// normal as trained splats are, with a colour per patch; a few float freely through the volume. Scale and opacity
+// follow configurable distributions, and higher-order spherical harmonics are optional.
+//
+// Generation is in fixed-size batches, each seeded from the scene's seed and its index, so a scene is the same
+// however it's consumed (streamed batch by batch, or built in memory in parallel).
+public struct SplatSceneGenerator {
+    public enum ScaleDistribution {
+        // Every splat the same size, along its longest axis
+        case constant(Float)
+        // Log-normal, as trained scenes are roughly: the median size, and the standard deviation of its logarithm
+        case logNormal(median: Float, spread: Float)
+    }
+
+    public enum OpacityDistribution {
+        case constant(Float)
+        case uniform(ClosedRange<Float>)
+        // Trained scenes have mostly opaque splats and a long tail of faint ones
+        case bimodal(opaqueFraction: Float)
+    }
+
+    public struct Configuration {
+        public var splatCount: Int
+        public var seed: UInt64
+        // Defaults to one patch per 2000 splats
+        public var surfaceCount: Int?
+        // Side of the cube the scene fills, centred on the origin
+        public var extent: Float = 100
+        public var surfaceRadius: Float = 2
+        // Fraction of splats scattered through the volume rather than on a surface
+        public var floaterFraction: Float = 0.002
+        public var scale: ScaleDistribution = .logNormal(median: 0.02, spread: 0.6)
+        // Size along the surface normal relative to the longest axis
+        public var flattening: Float = 0.1
+        public var opacity: OpacityDistribution = .bimodal(opaqueFraction: 0.6)
+        // 0 (colour only) to SphericalHarmonics.maxDegree
+        public var sphericalHarmonicsDegree = 0
+
+        public init(splatCount: Int, seed: UInt64 = 1) {
+            self.splatCount = splatCount
+            self.seed = seed
+        }
+    }
+
+    // A splat in the terms a PLY file stores it, but with scale and opacity linear
+    public struct GeneratedSplat {
+        public var position: SIMD3<Float>
+        // Of the surface the splat lies on; zero for floaters
+        public var normal: SIMD3<Float>
+        public var sphericalHarmonicsDC: SIMD3<Float>
+        // Channel-major, as in f_rest_*: 3 * SphericalHarmonics.restCoefficientCount(degree:) values
+        public var sphericalHarmonicsRest: [Float]
+        public var opacity: Float
+        public var scale: SIMD3<Float>
+        // Normalized, with the real part first, like Splat.rotation
+        public var rotation: SIMD4<Float>
+
+        public var splat: Splat {
+            let color = SphericalHarmonics.color(dc: sphericalHarmonicsDC)
+            return Splat(position: position,
+                         color: SIMD4<Float>(color.x, color.y, color.z, opacity),
+                         scale: scale,
+                         rotation: rotation)
+        }
+    }
+
+    struct Surface {
+        var center: SIMD3<Float>
+        var normal: SIMD3<Float>
+        var tangent: SIMD3<Float>
+        var bitangent: SIMD3<Float>
+        var radius: Float
+        var curvature: Float
+        var sphericalHarmonicsDC: SIMD3<Float>
+    }
+
+    public static let batchSize = 65536
+
+    public let configuration: Configuration
+    let surfaces: [Surface]
+
+    public init(_ configuration: Configuration) {
+        precondition(configuration.splatCount >= 0)
+        precondition((0...SphericalHarmonics.maxDegree).contains(configuration.sphericalHarmonicsDegree))
+        self.configuration = configuration
+
+        var random = SplitMix64(seed: configuration.seed)
+        let surfaceCount = max(1, configuration.surfaceCount ?? configuration.splatCount / 2000)
+        surfaces = (0..<surfaceCount).map { _ in
+            let normal = random.nextUnitVector()
+            let tangent = normal.cross(abs(normal.x) < 0.9 ? SIMD3<Float>(1, 0, 0) : SIMD3<Float>(0, 1, 0)).normalized
+            return Surface(center: (random.nextVector() - 0.5) * configuration.extent,
+                           normal: normal,
+                           tangent: tangent,
+                           bitangent: normal.cross(tangent),
+                           radius: configuration.surfaceRadius * (0.5 + random.nextFloat()),
+                           curvature: (random.nextFloat() - 0.5) * 0.5 / configuration.surfaceRadius,
+                           sphericalHarmonicsDC: (random.nextVector() - 0.5) * 3)
+        }
+    }
+
+    public var batchCount: Int {
+        (configuration.splatCount + Self.batchSize - 1) / Self.batchSize
+    }
+
+    public func batch(_ index: Int) -> [GeneratedSplat] {
+        precondition((0..<batchCount).contains(index))
+        var random = SplitMix64(seed: configuration.seed &+ 0x632B_E59B_D9B4_E019 &* UInt64(index + 1))
+        let count = min(Self.batchSize, configuration.splatCount - index * Self.batchSize)
+        return (0..<count).map { _ in generateSplat(&random) }
+    }
+
+    // Calls body with each batch in turn, for writing scenes too big to hold in memory
+    public func generate(_ body: ([GeneratedSplat]) throws -> Void) rethrows {
+        for index in 0..<batchCount {
+            try body(batch(index))
+        }
+    }
+
+    // The whole scene, render-ready, generated in parallel
+    public func splats() -> [Splat] {
+        gather { $0.splat }
+    }
+
+    public func positions() -> [SIMD3<Float>] {
+        gather { $0.position }
+    }
+
+    private func gather<T>(_ transform: (GeneratedSplat) -> T) -> [T] {
+        let splatCount = configuration.splatCount
+        return Array(unsafeUninitializedCapacity: splatCount) { buffer, initializedCount in
+            let base = buffer.baseAddress
+            SplatExecutor.shared.parallelFor(iterations: batchCount, priority: .background) { index in
+                for (offset, splat) in batch(index).enumerated() {
+                    (base! + index * Self.batchSize + offset).initialize(to: transform(splat))
+                }
+            }
+            initializedCount = splatCount
+        }
+    }
+
+    private func generateSplat(_ random: inout SplitMix64) -> GeneratedSplat {
+        let size = sampleScale(&random)
+        let scale = SIMD3<Float>(size, size * (0.3 + 0.7 * random.nextFloat()), size * configuration.flattening)
+        let opacity = sampleOpacity(&random)
+        let restCount = 3 * SphericalHarmonics.restCoefficientCount(degree: configuration.sphericalHarmonicsDegree)
+        // Small next to the DC term, as in trained scenes
+        let rest = (0..<restCount).map { _ in random.nextGaussian() * 0.1 }
+
+        if random.nextFloat() < configuration.floaterFraction {
+            return GeneratedSplat(position: (random.nextVector() - 0.5) * configuration.extent,
+                                  normal: .zero,
+                                  sphericalHarmonicsDC: (random.nextVector() - 0.5) * 3,
+                                  sphericalHarmonicsRest: rest,
+                                  opacity: opacity,
+                                  scale: scale * 3,
+                                  rotation: Self.quaternion(aligningZWith: random.nextUnitVector(), spin: random.nextFloat() * 2 * .pi))
+        }
+
+        let surface = surfaces[Int(random.next() % UInt64(surfaces.count))]
+        // Uniform over the disc, bent into a paraboloid, with a little noise along the normal
+        let radius = surface.radius * random.nextFloat().squareRoot()
+        let angle = random.nextFloat() * 2 * .pi
+        let (u, v) = (radius * cos(angle), radius * sin(angle))
+        let height = surface.curvature * (u * u + v * v) + random.nextGaussian() * size * configuration.flattening
+        let position = surface.center + surface.tangent * u + surface.bitangent * v + surface.normal * height
+        // The paraboloid's normal, so splats follow the curve
+        let normal = (surface.normal - 2 * surface.curvature * (surface.tangent * u + surface.bitangent * v)).normalized
+        return GeneratedSplat(position: position,
+                              normal: normal,
+                              sphericalHarmonicsDC: surface.sphericalHarmonicsDC + SIMD3<Float>(random.nextGaussian(), random.nextGaussian(), random.nextGaussian()) * 0.2,
+                              sphericalHarmonicsRest: rest,
+                              opacity: opacity,
+                              scale: scale,
+                              rotation: Self.quaternion(aligningZWith: normal, spin: random.nextFloat() * 2 * .pi))
+    }
+
+    private func sampleScale(_ random: inout SplitMix64) -> Float {
+        switch configuration.scale {
+        case .constant(let scale): scale
+        case .logNormal(let median, let spread): median * exp(random.nextGaussian() * spread)
+        }
+    }
+
+    private func sampleOpacity(_ random: inout SplitMix64) -> Float {
+        switch configuration.opacity {
+        case .constant(let opacity):
+            return opacity
+        case .uniform(let range):
+            return range.lowerBound + random.nextFloat() * (range.upperBound - range.lowerBound)
+        case .bimodal(let opaqueFraction):
+            let opaque = random.nextFloat() < opaqueFraction
+            return opaque ? 0.9 + 0.1 * random.nextFloat() : 0.02 + 0.38 * random.nextFloat()
+        }
+    }
+
+    // The rotation (real part first) taking +z to the given unit vector, after spinning by the given angle about z
+    static func quaternion(aligningZWith direction: SIMD3<Float>, spin: Float) -> SIMD4<Float> {
+        let z = SIMD3<Float>(0, 0, 1)
+        let cosine = z.dot(direction)
+        let align: SIMD4<Float>
+        if cosine < -0.9999 {
+            // Opposite: half a turn about x
+            align = SIMD4<Float>(0, 1, 0, 0)
+        } else {
+            let axis = z.cross(direction)
+            align = SIMD4<Float>(1 + cosine, axis.x, axis.y, axis.z).normalized
+        }
+        let twist = SIMD4<Float>(cos(spin / 2), 0, 0, sin(spin / 2))
+        // Hamilton product align * twist
+        let (a, b) = (align, twist)
+        return SIMD4<Float>(a.x * b.x - a.y * b.y - a.z * b.z - a.w * b.w,
+                            a.x * b.y + a.y * b.x + a.z * b.w - a.w * b.z,
+                            a.x * b.z - a.y * b.w + a.z * b.x + a.w * b.y,
+                            a.x * b.w + a.y * b.z - a.z * b.y + a.w * b.x)
+    }
+}
+
+// A small, fast, seedable random number generator; the same seed gives the same sequence on every platform, so
+// benchmarks and tests built on it are reproducible
+public struct SplitMix64 {
+    public var state: UInt64
+
+    public init(seed: UInt64) {
+        state = seed
+    }
+
+    public mutating func next() -> UInt64 {
+        state &+= 0x9E3779B97F4A7C15
+        var z = state
+        z = (z ^ (z >> 30)) &* 0xBF58476D1CE4E5B9
+        z = (z ^ (z >> 27)) &* 0x94D049BB133111EB
+        return z ^ (z >> 31)
+    }
+
+    // In 0..<1
+    public mutating func nextFloat() -> Float {
+        Float(next() >> 40) / Float(1 << 24)
+    }
+
+    public mutating func nextGaussian() -> Float {
+        let u = max(nextFloat(), .leastNormalMagnitude)
+        return (-2 * log(u)).squareRoot() * cos(2 * .pi * nextFloat())
+    }
+
+    // In the unit cube
+    public mutating func nextVector() -> SIMD3<Float> {
+        SIMD3<Float>(nextFloat(), nextFloat(), nextFloat())
+    }
+
+    public mutating func nextUnitVector() -> SIMD3<Float> {
+        SIMD3<Float>(nextGaussian(), nextGaussian(), nextGaussian()).normalized
+    }
+}
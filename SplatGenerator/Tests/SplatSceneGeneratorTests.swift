@@ -0,0 +1,122 @@
+import XCTest
+import PLYIO
+import SplatCompute
+import SplatGenerator
+
+final class SplatSceneGeneratorTests: XCTestCase {
+    // More than one batch, with a partial last batch
+    static let splatCount = SplatSceneGenerator.batchSize * 2 + 100
+
+    func testDeterministic() {
+        let a = SplatSceneGenerator(.init(splatCount: Self.splatCount, seed: 5)).positions()
+        let b = SplatSceneGenerator(.init(splatCount: Self.splatCount, seed: 5)).positions()
+        let c = SplatSceneGenerator(.init(splatCount: Self.splatCount, seed: 6)).positions()
+        XCTAssertEqual(a.count, Self.splatCount)
+        XCTAssertEqual(a, b)
+        XCTAssertNotEqual(a, c)
+    }
+
+    // Streaming and building in parallel produce the same scene
+    func testBatchesMatchInMemoryScene() {
+        let generator = SplatSceneGenerator(.init(splatCount: Self.splatCount))
+        var streamed: [SIMD3<Float>] = []
+        generator.generate { batch in
+            streamed.append(contentsOf: batch.map(\.position))
+        }
+        XCTAssertEqual(streamed, generator.positions())
+        XCTAssertEqual(generator.splats().map(\.position), streamed)
+    }
+
+    func testDistributions() {
+        var configuration = SplatSceneGenerator.Configuration(splatCount: 20_000)
+        configuration.opacity = .bimodal(opaqueFraction: 0.75)
+        configuration.scale = .logNormal(median: 0.05, spread: 0.5)
+        configuration.sphericalHarmonicsDegree = 3
+        let generator = SplatSceneGenerator(configuration)
+        var splats: [SplatSceneGenerator.GeneratedSplat] = []
+        generator.generate { splats.append(contentsOf: $0) }
+
+        let opaqueFraction = Float(splats.filter { $0.opacity >= 0.9 }.count) / Float(splats.count)
+        XCTAssertEqual(opaqueFraction, 0.75, accuracy: 0.02)
+        let largestScales = splats.map { $0.scale.max() }.sorted()
+        // Floaters are made larger, but there are too few to move the median
+        XCTAssertEqual(largestScales[largestScales.count / 2], 0.05, accuracy: 0.005)
+
+        for splat in splats.prefix(100) {
+            XCTAssertEqual(splat.sphericalHarmonicsRest.count, 45)
+            XCTAssertEqual((splat.rotation * splat.rotation).sum(), 1, accuracy: 1e-4)
+            XCTAssertTrue(splat.position.x.magnitude <= 60 && splat.position.y.magnitude <= 60 && splat.position.z.magnitude <= 60)
+        }
+    }
+
+    // Surface splats are flattened along the surface normal: the rotation takes local z to the normal
+    func testSplatsLieAlongSurfaces() {
+        var configuration = SplatSceneGenerator.Configuration(splatCount: 1000)
+        configuration.floaterFraction = 0
+        for splat in SplatSceneGenerator(configuration).batch(0) {
+            let (w, x, y, z) = (splat.rotation.x, splat.rotation.y, splat.rotation.z, splat.rotation.w)
+            let localZ = SIMD3<Float>(2 * (x * z + w * y), 2 * (y * z - w * x), 1 - 2 * (x * x + y * y))
+            XCTAssertEqual((localZ * splat.normal).sum(), 1, accuracy: 1e-3)
+            XCTAssertLessThan(splat.scale.z, splat.scale.y)
+        }
+    }
+
+    func testWritePLY() throws {
+        var configuration = SplatSceneGenerator.Configuration(splatCount: 1000)
+        configuration.sphericalHarmonicsDegree = 3
+        let generator = SplatSceneGenerator(configuration)
+        let url = FileManager.default.temporaryDirectory.appendingPathComponent("\(UUID().uuidString).ply")
+        defer { try? FileManager.default.removeItem(at: url) }
+        try generator.writePLY(to: url)
+
+        let delegate = ElementCollector()
+        PLYReader(url).read(to: delegate)
+        XCTAssertNil(delegate.error)
+        XCTAssertEqual(delegate.header?.elements.first?.properties.count, 62)
+        XCTAssertEqual(delegate.elements.count, 1000)
+        let expected = generator.batch(0)[0]
+        guard case .float32(let x) = delegate.elements[0].properties[0],
+              case .float32(let logScale) = delegate.elements[0].properties[55] else {
+            return XCTFail("Expected float properties")
+        }
+        XCTAssertEqual(x, expected.position.x)
+        XCTAssertEqual(logScale, log(expected.scale.x), accuracy: 1e-6)
+    }
+
+    func testDotSplat() throws {
+        let generator = SplatSceneGenerator(.init(splatCount: 1000))
+        let data = generator.dotSplatData()
+        XCTAssertEqual(data.count, 1000 * SplatSceneGenerator.dotSplatStride)
+
+        let expected = generator.batch(0)[1]
+        let stride = SplatSceneGenerator.dotSplatStride
+        let x = data.withUnsafeBytes { Float(bitPattern: UInt32(littleEndian: $0.loadUnaligned(fromByteOffset: stride, as: UInt32.self))) }
+        XCTAssertEqual(x, expected.position.x)
+        XCTAssertEqual(data[stride + 27], UInt8((expected.opacity * 255).rounded()))
+
+        let url = FileManager.default.temporaryDirectory.appendingPathComponent("\(UUID().uuidString).splat")
+        defer { try? FileManager.default.removeItem(at: url) }
+        try generator.writeDotSplat(to: url)
+        XCTAssertEqual(try Data(contentsOf: url), data)
+    }
+}
+
+final class ElementCollector: PLYReaderDelegate {
+    var header: PLYHeader?
+    var elements: [PLYElement] = []
+    var error: Swift.Error?
+
+    func didStartReading(withHeader header: PLYHeader) {
+        self.header = header
+    }
+
+    func didRead(element: PLYElement, typeIndex: Int, withHeader elementHeader: PLYHeader.Element) {
+        elements.append(element)
+    }
+
+    func didFinishReading() {}
+
+    func didFailReading(withError error: Swift.Error?) {
+        self.error = error ?? CocoaError(.fileReadUnknown)
+    }
+}
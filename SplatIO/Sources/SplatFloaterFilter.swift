@@ -0,0 +1,215 @@
+import Foundation
+import SplatKNN
+
+// Removes "floaters", the isolated splats which training leaves scattered around a scene, by statistical outlier
+// removal: each splat's mean distance to its k nearest neighbours is compared with the distribution of that
+// distance over the whole scene, and splats more than `sigma` standard deviations above the mean are removed.
+//
+// Filtering streams between a reader and a writer in two passes. The first keeps only positions to compute the
+// statistics; the second copies the surviving splats straight through to the writer. The reader must therefore be
+// able to read the scene twice, as SplatPLYSceneReader can.
+//
+// The first pass is not tiled: every position is held at once, with the k-d tree's ordering over them and each
+// splat's mean neighbour distance, for about 24 bytes per splat (2.4 GB for 100M splats) on top of whatever the
+// reader buffers. The second pass holds only a batch at a time.
+public struct SplatFloaterFilter {
+    public struct Configuration {
+        public var neighborCount: Int
+        public var sigma: Float
+
+        public init(neighborCount: Int = 16, sigma: Float = 2) {
+            self.neighborCount = neighborCount
+            self.sigma = sigma
+        }
+    }
+
+    public struct Report {
+        public var configuration: Configuration
+        public var pointCount: Int
+        // Ascending
+        public var removedIndices: [Int]
+        // Mean and standard deviation, over all splats, of the mean distance to their neighbours
+        public var meanNeighborDistance: Float
+        public var neighborDistanceStandardDeviation: Float
+        // Splats whose mean neighbour distance is above this are removed
+        public var threshold: Float
+
+        public var removedCount: Int { removedIndices.count }
+        public var keptCount: Int { pointCount - removedIndices.count }
+    }
+
+    enum Error: Swift.Error {
+        case readFailed(Swift.Error?)
+        case pointCountChanged
+    }
+
+    static let writeBatchSize = 1024
+
+    public var configuration: Configuration
+
+    public init(configuration: Configuration = .init()) {
+        precondition(configuration.neighborCount >= 1)
+        self.configuration = configuration
+    }
+
+    public func analyze(positions: [SIMD3<Float>]) -> Report {
+        var report = Report(configuration: configuration,
+                            pointCount: positions.count,
+                            removedIndices: [],
+                            meanNeighborDistance: 0,
+                            neighborDistanceStandardDeviation: 0,
+                            threshold: .infinity)
+        // Too few splats for meaningful statistics
+        guard positions.count > configuration.neighborCount else { return report }
+
+        let meanDistances = KDTree(points: positions).meanNeighborDistanceOfEachPoint(count: configuration.neighborCount)
+
+        var sum: Double = 0
+        var sumOfSquares: Double = 0
+        for distance in meanDistances {
+            sum += Double(distance)
+            sumOfSquares += Double(distance) * Double(distance)
+        }
+        let mean = sum / Double(meanDistances.count)
+        let variance = max(0, sumOfSquares / Double(meanDistances.count) - mean * mean)
+
+        report.meanNeighborDistance = Float(mean)
+        report.neighborDistanceStandardDeviation = Float(variance.squareRoot())
+        report.threshold = Float(mean + Double(configuration.sigma) * variance.squareRoot())
+        report.removedIndices = meanDistances.indices.filter { meanDistances[$0] > report.threshold }
+        return report
+    }
+
+    // A dry run: reads the scene once, and reports what filter(_:to:) would remove
+    public func analyze(_ reader: SplatSceneReader) throws -> Report {
+        let positions = PositionCollector()
+        reader.read(to: positions)
+        if let error = positions.error {
+            throw error
+        }
+        return analyze(positions: positions.positions)
+    }
+
+    // Writes every splat the reader provides, except floaters, to the writer, which is then closed
+    @discardableResult
+    public func filter(_ reader: SplatSceneReader, to writer: SplatSceneWriter) throws -> Report {
+        let report = try analyze(reader)
+
+        let forwarder = FilteringForwarder(reader: reader, writer: writer, report: report)
+        reader.read(to: forwarder)
+        if let error = forwarder.error {
+            throw error
+        }
+        try writer.close()
+        return report
+    }
+}
+
+extension SplatFloaterFilter.Report: CustomStringConvertible {
+    public var description: String {
+        let percentage = pointCount == 0 ? 0 : 100 * Double(removedCount) / Double(pointCount)
+        return "Removing \(removedCount) of \(pointCount) splats (\(String(format: "%.3f", percentage))%): " +
+            "mean distance to \(configuration.neighborCount) nearest neighbours " +
+            "\(meanNeighborDistance) ± \(neighborDistanceStandardDeviation), " +
+            "threshold \(threshold) (\(configuration.sigma) σ)"
+    }
+}
+
+private class PositionCollector: SplatSceneReaderDelegate {
+    var positions: [SIMD3<Float>] = []
+    var error: Swift.Error?
+
+    func didStartReading(withPointCount pointCount: UInt32) {
+        positions.reserveCapacity(Int(pointCount))
+    }
+
+    func didRead(points: [SplatScenePoint]) {
+        for point in points {
+            positions.append(point.position)
+        }
+    }
+
+    func didFinishReading() {}
+
+    func didFailReading(withError error: Swift.Error?) {
+        self.error = SplatFloaterFilter.Error.readFailed(error)
+    }
+}
+
+// Stops at the first error, keeping it: nothing more is written, and the read is cancelled rather than run to the end
+private class FilteringForwarder: SplatSceneReaderDelegate {
+    private let reader: SplatSceneReader
+    private let writer: SplatSceneWriter
+    private let report: SplatFloaterFilter.Report
+    private var pointIndex = 0
+    private var nextRemovedIndex = 0
+    private var batch: [SplatScenePoint] = []
+    var error: Swift.Error?
+
+    init(reader: SplatSceneReader, writer: SplatSceneWriter, report: SplatFloaterFilter.Report) {
+        self.reader = reader
+        self.writer = writer
+        self.report = report
+        batch.reserveCapacity(SplatFloaterFilter.writeBatchSize)
+    }
+
+    func didStartReading(withPointCount pointCount: UInt32) {
+        guard error == nil else { return }
+        guard Int(pointCount) == report.pointCount else {
+            fail(SplatFloaterFilter.Error.pointCountChanged)
+            return
+        }
+        do {
+            try writer.start(pointCount: UInt32(report.keptCount))
+        } catch {
+            fail(error)
+        }
+    }
+
+    func didRead(points: [SplatScenePoint]) {
+        guard error == nil else { return }
+        for point in points {
+            // removedIndices is ascending, so it's walked alongside the points
+            if nextRemovedIndex < report.removedIndices.count && report.removedIndices[nextRemovedIndex] == pointIndex {
+                nextRemovedIndex += 1
+            } else {
+                batch.append(point)
+            }
+            pointIndex += 1
+        }
+        if batch.count >= SplatFloaterFilter.writeBatchSize {
+            flush()
+        }
+    }
+
+    func didFinishReading() {
+        guard error == nil else { return }
+        guard pointIndex == report.pointCount else {
+            fail(SplatFloaterFilter.Error.pointCountChanged)
+            return
+        }
+        flush()
+    }
+
+    func didFailReading(withError error: Swift.Error?) {
+        // Including the cancellation which fail(_:) asks for
+        guard self.error == nil else { return }
+        self.error = SplatFloaterFilter.Error.readFailed(error)
+    }
+
+    private func flush() {
+        do {
+            try writer.write(batch)
+        } catch {
+            fail(error)
+        }
+        batch.removeAll(keepingCapacity: true)
+    }
+
+    private func fail(_ error: Swift.Error) {
+        guard self.error == nil else { return }
+        self.error = error
+        batch.removeAll()
+        reader.cancel()
+    }
+}
@@ -1,5 +1,6 @@
 import Foundation
 import PLYIO
+import SplatMetrics
 
 public class SplatPLYSceneReader: SplatSceneReader {
     enum Error: Swift.Error {
@@ -22,9 +23,19 @@ public class SplatPLYSceneReader: SplatSceneReader {
     public func read(to delegate: SplatSceneReaderDelegate) {
         SplatPLYSceneReaderStream().read(ply, to: delegate)
     }
+
+    public func cancel() {
+        ply.cancel()
+    }
 }
 
 private class SplatPLYSceneReaderStream {
+    enum Metric {
+        static let pointsDecoded = Metrics.shared.counter("splatio.pointsDecoded")
+        // Points are counted locally and added in batches, to keep the counter's lock out of the per-point path
+        static let batchSize: UInt32 = 64 * 1024
+    }
+
     private weak var delegate: SplatSceneReaderDelegate? = nil
     private var active = false
     private var pointElementMapping: PointElementMapping?
@@ -78,6 +89,9 @@ extension SplatPLYSceneReaderStream: PLYReaderDelegate {
         do {
             try pointElementMapping.apply(from: element, to: &reusablePoint)
             pointCount += 1
+            if pointCount % Metric.batchSize == 0 {
+                Metric.pointsDecoded.increment(by: Int64(Metric.batchSize))
+            }
             delegate?.didRead(points: [ reusablePoint ])
         } catch {
             delegate?.didFailReading(withError: error)
@@ -88,6 +102,7 @@ extension SplatPLYSceneReaderStream: PLYReaderDelegate {
 
     func didFinishReading() {
         guard active else { return }
+        Metric.pointsDecoded.increment(by: Int64(pointCount % Metric.batchSize))
         guard expectedPointCount == pointCount else {
             delegate?.didFailReading(withError: SplatPLYSceneReader.Error.unexpectedPointCountDiscrepancy)
             active = false
@@ -103,6 +118,11 @@ extension SplatPLYSceneReaderStream: PLYReaderDelegate {
         delegate?.didFailReading(withError: error)
         active = false
     }
+
+    func didReadBytes(_ bytesRead: Int, of totalBytes: Int?) {
+        guard active else { return }
+        delegate?.didReadBytes(bytesRead, of: totalBytes)
+    }
 }
 
 private struct PointElementMapping {
@@ -0,0 +1,94 @@
+import Foundation
+import PLYIO
+
+// Writes splats in the layout SplatPLYSceneReader reads (that of the original 3D Gaussian Splatting PLY files).
+// Spherical harmonics are written only if the first point has them, and then every point must.
+public class SplatPLYSceneWriter: SplatSceneWriter {
+    enum Error: Swift.Error {
+        case notStarted
+        case alreadyStarted
+        case sphericalHarmonicsCountMismatch
+    }
+
+    private let ply: PLYWriter
+    private let format: PLYHeader.Format
+    private var pointCount: UInt32?
+    private var sphericalHarmonicsCount: Int?
+    private var reusableElement = PLYElement(properties: [])
+
+    public convenience init(_ url: URL, format: PLYHeader.Format = .binaryLittleEndian) throws {
+        self.init(try PLYWriter(url), format: format)
+    }
+
+    public init(_ ply: PLYWriter, format: PLYHeader.Format = .binaryLittleEndian) {
+        self.ply = ply
+        self.format = format
+    }
+
+    public func start(pointCount: UInt32) throws {
+        guard self.pointCount == nil else { throw Error.alreadyStarted }
+        self.pointCount = pointCount
+    }
+
+    public func write(_ points: [SplatScenePoint]) throws {
+        guard !points.isEmpty else { return }
+        guard let pointCount else { throw Error.notStarted }
+        if sphericalHarmonicsCount == nil {
+            // The header waits for the first point, which tells us whether there are spherical harmonics
+            let sphericalHarmonicsCount = points[0].sphericalHarmonics?.count ?? 0
+            self.sphericalHarmonicsCount = sphericalHarmonicsCount
+            try ply.write(Self.header(format: format, pointCount: pointCount, sphericalHarmonicsCount: sphericalHarmonicsCount))
+        }
+
+        for point in points {
+            guard (point.sphericalHarmonics?.count ?? 0) == sphericalHarmonicsCount else {
+                throw Error.sphericalHarmonicsCountMismatch
+            }
+            Self.apply(point, to: &reusableElement)
+            try ply.write(reusableElement)
+        }
+    }
+
+    public func close() throws {
+        guard let pointCount else { throw Error.notStarted }
+        if sphericalHarmonicsCount == nil {
+            try ply.write(Self.header(format: format, pointCount: pointCount, sphericalHarmonicsCount: 0))
+        }
+        try ply.close()
+    }
+
+    private static func header(format: PLYHeader.Format, pointCount: UInt32, sphericalHarmonicsCount: Int) -> PLYHeader {
+        let names = [ "x", "y", "z", "nx", "ny", "nz", "f_dc_0", "f_dc_1", "f_dc_2" ] +
+            (0..<sphericalHarmonicsCount).map { "f_rest_\($0)" } +
+            [ "opacity", "scale_0", "scale_1", "scale_2", "rot_0", "rot_1", "rot_2", "rot_3" ]
+        let properties = names.map { PLYHeader.Property(name: $0, type: .primitive(.float32)) }
+        return PLYHeader(format: format,
+                         version: "1.0",
+                         elements: [ PLYHeader.Element(name: "vertex", count: pointCount, properties: properties) ])
+    }
+
+    // Property order matches header(format:pointCount:sphericalHarmonicsCount:)
+    private static func apply(_ point: SplatScenePoint, to element: inout PLYElement) {
+        element.properties.removeAll(keepingCapacity: true)
+        element.properties.append(.float32(point.position.x))
+        element.properties.append(.float32(point.position.y))
+        element.properties.append(.float32(point.position.z))
+        element.properties.append(.float32(point.normal.x))
+        element.properties.append(.float32(point.normal.y))
+        element.properties.append(.float32(point.normal.z))
+        element.properties.append(.float32(point.color.x))
+        element.properties.append(.float32(point.color.y))
+        element.properties.append(.float32(point.color.z))
+        for value in point.sphericalHarmonics ?? [] {
+            element.properties.append(.float32(value))
+        }
+        element.properties.append(.float32(point.opacity))
+        element.properties.append(.float32(point.scale.x))
+        element.properties.append(.float32(point.scale.y))
+        element.properties.append(.float32(point.scale.z))
+        element.properties.append(.float32(point.rotation.vector.x))
+        element.properties.append(.float32(point.rotation.vector.y))
+        element.properties.append(.float32(point.rotation.vector.z))
+        element.properties.append(.float32(point.rotation.vector.w))
+    }
+}
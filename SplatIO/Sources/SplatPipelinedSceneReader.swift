@@ -0,0 +1,150 @@
+import Foundation
+import PLYIO
+
+// Reads a scene a stage ahead of its delegate: the wrapped reader runs on a thread of its own, its points gathered into
+// batches and handed over through a bounded queue, while the delegate is called on the calling thread. Decoding then
+// overlaps whatever the delegate does with the points, and the delegate gets them batchSize at a time rather than one
+// by one. Progress (didReadBytes) is reported just before each batch.
+public class SplatPipelinedSceneReader: SplatSceneReader {
+    public static let defaultBatchSize = 16 * 1024
+    public static let defaultQueueCapacity = 4
+
+    fileprivate enum Event {
+        case start(pointCount: UInt32)
+        case points([SplatScenePoint], bytesRead: Int, totalBytes: Int?)
+        case finish
+        case fail(Swift.Error?)
+    }
+
+    private let reader: SplatSceneReader
+    private let batchSize: Int
+    private let queueCapacity: Int
+    private let lock = NSLock()
+    private var queue: BoundedQueue<Event>?
+    private var cancelled = false
+
+    public init(_ reader: SplatSceneReader,
+                batchSize: Int = defaultBatchSize,
+                queueCapacity: Int = defaultQueueCapacity) {
+        self.reader = reader
+        self.batchSize = max(1, batchSize)
+        self.queueCapacity = queueCapacity
+    }
+
+    public func read(to delegate: SplatSceneReaderDelegate) {
+        let queue = BoundedQueue<Event>(capacity: queueCapacity, metricName: "splatio.decode")
+        lock.lock()
+        self.queue = queue
+        let cancelled = self.cancelled
+        lock.unlock()
+        guard !cancelled else {
+            delegate.didFailReading(withError: CancellationError())
+            return
+        }
+
+        let batcher = PointBatcher(queue, batchSize: batchSize, reader: reader)
+        let finished = DispatchSemaphore(value: 0)
+        let thread = Thread { [reader] in
+            reader.read(to: batcher)
+            queue.close()
+            finished.signal()
+        }
+        thread.name = "SplatPipelinedSceneReader decode"
+        thread.start()
+        // The wrapped reader is done with by the time this returns, even if the read was cancelled
+        defer { finished.wait() }
+
+        while let event = queue.pop() {
+            if Task.isCancelled {
+                cancel()
+                break
+            }
+            switch event {
+            case .start(let pointCount):
+                delegate.didStartReading(withPointCount: pointCount)
+            case .points(let points, let bytesRead, let totalBytes):
+                delegate.didReadBytes(bytesRead, of: totalBytes)
+                delegate.didRead(points: points)
+            case .finish:
+                delegate.didFinishReading()
+                return
+            case .fail(let error):
+                delegate.didFailReading(withError: error)
+                return
+            }
+        }
+        // Only cancelling closes the queue before the wrapped reader's finished or failed
+        delegate.didFailReading(withError: CancellationError())
+    }
+
+    public func cancel() {
+        lock.lock()
+        cancelled = true
+        let queue = self.queue
+        lock.unlock()
+        queue?.cancel()
+        reader.cancel()
+    }
+}
+
+// Gathers the wrapped reader's points into batches and queues them, on the decoding thread
+private class PointBatcher: SplatSceneReaderDelegate {
+    private let queue: BoundedQueue<SplatPipelinedSceneReader.Event>
+    private let batchSize: Int
+    private let reader: SplatSceneReader
+    private var batch: [SplatScenePoint] = []
+    private var bytesRead = 0
+    private var totalBytes: Int?
+    private var stopped = false
+
+    init(_ queue: BoundedQueue<SplatPipelinedSceneReader.Event>, batchSize: Int, reader: SplatSceneReader) {
+        self.queue = queue
+        self.batchSize = batchSize
+        self.reader = reader
+        batch.reserveCapacity(batchSize)
+    }
+
+    func didStartReading(withPointCount pointCount: UInt32) {
+        push(.start(pointCount: pointCount))
+    }
+
+    func didRead(points: [SplatScenePoint]) {
+        guard !stopped else { return }
+        batch.append(contentsOf: points)
+        if batch.count >= batchSize {
+            flush()
+        }
+    }
+
+    func didReadBytes(_ bytesRead: Int, of totalBytes: Int?) {
+        self.bytesRead = bytesRead
+        self.totalBytes = totalBytes
+    }
+
+    func didFinishReading() {
+        flush()
+        push(.finish)
+    }
+
+    func didFailReading(withError error: Swift.Error?) {
+        batch = []
+        push(.fail(error))
+    }
+
+    private func flush() {
+        guard !batch.isEmpty else { return }
+        push(.points(batch, bytesRead: bytesRead, totalBytes: totalBytes))
+        batch = []
+        batch.reserveCapacity(batchSize)
+    }
+
+    // Once the queue's been cancelled, there's no one left to read for, so the wrapped reader is stopped too
+    private func push(_ event: SplatPipelinedSceneReader.Event) {
+        guard !stopped else { return }
+        if !queue.push(event) {
+            stopped = true
+            batch = []
+            reader.cancel()
+        }
+    }
+}
@@ -5,8 +5,21 @@ public protocol SplatSceneReaderDelegate: AnyObject {
     func didRead(points: [SplatScenePoint])
     func didFinishReading()
     func didFailReading(withError error: Error?)
+    // Called as the source is read; totalBytes is its size, where known
+    func didReadBytes(_ bytesRead: Int, of totalBytes: Int?)
+}
+
+extension SplatSceneReaderDelegate {
+    public func didReadBytes(_ bytesRead: Int, of totalBytes: Int?) {}
 }
 
 public protocol SplatSceneReader {
     func read(to delegate: SplatSceneReaderDelegate)
+    // Stops a read in progress, from any thread; the delegate is told it failed, with CancellationError
+    func cancel()
+}
+
+extension SplatSceneReader {
+    // For readers which can't stop early: a cancelled read then runs to the end as usual
+    public func cancel() {}
 }
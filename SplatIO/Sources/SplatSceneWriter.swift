@@ -0,0 +1,8 @@
+import Foundation
+
+public protocol SplatSceneWriter {
+    // Must be called once, before any points are written; exactly pointCount points must then be written
+    func start(pointCount: UInt32) throws
+    func write(_ points: [SplatScenePoint]) throws
+    func close() throws
+}
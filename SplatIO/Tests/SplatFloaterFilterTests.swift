@@ -0,0 +1,147 @@
+import XCTest
+import simd
+import SplatIO
+
+final class SplatFloaterFilterTests: XCTestCase {
+    class PointCollector: SplatSceneReaderDelegate {
+        var points: [SplatScenePoint] = []
+        var didFinish = false
+        var didFail = false
+
+        func didStartReading(withPointCount pointCount: UInt32) {}
+
+        func didRead(points: [SplatScenePoint]) {
+            self.points.append(contentsOf: points)
+        }
+
+        func didFinishReading() {
+            didFinish = true
+        }
+
+        func didFailReading(withError error: Error?) {
+            didFail = true
+        }
+    }
+
+    class FailingWriter: SplatSceneWriter {
+        struct WriteFailed: Error {}
+
+        var writeCount = 0
+
+        func start(pointCount: UInt32) throws {}
+
+        func write(_ points: [SplatScenePoint]) throws {
+            writeCount += 1
+            throw WriteFailed()
+        }
+
+        func close() throws {}
+    }
+
+    static let floaterIndices = [ 100, 500, 1000, 1234, 1700 ]
+
+    // A 12x12x12 grid of unit spacing, with a few of its splats moved far away from it and from each other
+    static func sceneWithFloaters() -> [SplatScenePoint] {
+        var points: [SplatScenePoint] = []
+        for x in 0..<12 {
+            for y in 0..<12 {
+                for z in 0..<12 {
+                    points.append(SplatScenePoint(position: SIMD3<Float>(Float(x), Float(y), Float(z)),
+                                                  normal: .zero,
+                                                  color: SIMD3<Float>(0.5, 0.5, 0.5),
+                                                  opacity: 1,
+                                                  scale: SIMD3<Float>(repeating: -3),
+                                                  rotation: simd_quatf(vector: SIMD4<Float>(0, 0, 0, 1))))
+                }
+            }
+        }
+        for (i, index) in floaterIndices.enumerated() {
+            points[index].position = SIMD3<Float>(Float(i) * 100 + 100, -100, 50)
+        }
+        return points
+    }
+
+    func temporaryURL(_ name: String) -> URL {
+        let url = FileManager.default.temporaryDirectory.appendingPathComponent("SplatFloaterFilterTests-\(name).ply")
+        addTeardownBlock { try? FileManager.default.removeItem(at: url) }
+        return url
+    }
+
+    func write(_ points: [SplatScenePoint], to url: URL) throws {
+        let writer = try SplatPLYSceneWriter(url)
+        try writer.start(pointCount: UInt32(points.count))
+        try writer.write(points)
+        try writer.close()
+    }
+
+    func read(_ url: URL) -> PointCollector {
+        let collector = PointCollector()
+        SplatPLYSceneReader(url).read(to: collector)
+        return collector
+    }
+
+    func testWriterRoundTrip() throws {
+        let points = Self.sceneWithFloaters()
+        let url = temporaryURL("round-trip")
+        try write(points, to: url)
+
+        let collector = read(url)
+        XCTAssertTrue(collector.didFinish)
+        XCTAssertEqual(collector.points.map(\.position), points.map(\.position))
+        XCTAssertEqual(collector.points.map(\.rotation.vector), points.map(\.rotation.vector))
+    }
+
+    func testAnalyzeFindsFloaters() {
+        let points = Self.sceneWithFloaters()
+        let report = SplatFloaterFilter().analyze(positions: points.map(\.position))
+        XCTAssertEqual(report.pointCount, 12 * 12 * 12)
+        XCTAssertEqual(report.removedIndices, Self.floaterIndices)
+        XCTAssertGreaterThan(report.threshold, report.meanNeighborDistance)
+
+        // A stricter threshold can only remove more
+        let strict = SplatFloaterFilter(configuration: .init(sigma: 0.1)).analyze(positions: points.map(\.position))
+        XCTAssertTrue(Set(strict.removedIndices).isSuperset(of: report.removedIndices))
+    }
+
+    func testDryRunDoesNotWrite() throws {
+        let url = temporaryURL("dry-run")
+        try write(Self.sceneWithFloaters(), to: url)
+
+        let report = try SplatFloaterFilter().analyze(SplatPLYSceneReader(url))
+        XCTAssertEqual(report.removedIndices, Self.floaterIndices)
+        XCTAssertEqual(report.keptCount, 12 * 12 * 12 - Self.floaterIndices.count)
+        XCTAssertFalse(report.description.isEmpty)
+    }
+
+    func testFilterStreamsSurvivorsToWriter() throws {
+        let points = Self.sceneWithFloaters()
+        let inputURL = temporaryURL("input")
+        let outputURL = temporaryURL("output")
+        try write(points, to: inputURL)
+
+        let report = try SplatFloaterFilter().filter(SplatPLYSceneReader(inputURL), to: SplatPLYSceneWriter(outputURL))
+        XCTAssertEqual(report.removedCount, Self.floaterIndices.count)
+
+        let collector = read(outputURL)
+        XCTAssertTrue(collector.didFinish)
+        let expected = points.indices.filter { !Self.floaterIndices.contains($0) }.map { points[$0].position }
+        XCTAssertEqual(collector.points.map(\.position), expected)
+    }
+
+    // The survivors span two write batches; the first failure is thrown, and nothing more is written after it
+    func testFilterStopsAtFirstWriteError() throws {
+        let inputURL = temporaryURL("failing-write")
+        try write(Self.sceneWithFloaters(), to: inputURL)
+
+        let writer = FailingWriter()
+        XCTAssertThrowsError(try SplatFloaterFilter().filter(SplatPLYSceneReader(inputURL), to: writer)) { error in
+            XCTAssertTrue(error is FailingWriter.WriteFailed)
+        }
+        XCTAssertEqual(writer.writeCount, 1)
+    }
+
+    func testTooFewPointsAreKept() {
+        let positions = (0..<5).map { SIMD3<Float>(Float($0) * 1000, 0, 0) }
+        XCTAssertEqual(SplatFloaterFilter().analyze(positions: positions).removedCount, 0)
+    }
+}
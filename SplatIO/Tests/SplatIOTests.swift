@@ -47,6 +47,29 @@ final class SplatIOTests: XCTestCase {
         try testRead(trainURL)
     }
 
+    func testPipelinedRead() throws {
+        let direct = ContentCounter()
+        SplatPLYSceneReader(trainURL).read(to: direct)
+
+        // A batch size smaller than the scene, so points arrive over several batches
+        let content = ContentCounter()
+        SplatPipelinedSceneReader(SplatPLYSceneReader(trainURL), batchSize: 2, queueCapacity: 1).read(to: content)
+        XCTAssertTrue(content.didFinish)
+        XCTAssertFalse(content.didFail)
+        XCTAssertEqual(content.expectedPointCount, direct.expectedPointCount)
+        XCTAssertEqual(content.pointCount, direct.pointCount)
+    }
+
+    func testPipelinedReadCancel() throws {
+        let reader = SplatPipelinedSceneReader(SplatPLYSceneReader(trainURL))
+        reader.cancel()
+        let content = ContentCounter()
+        reader.read(to: content)
+        XCTAssertTrue(content.didFail)
+        XCTAssertFalse(content.didFinish)
+        XCTAssertEqual(content.pointCount, 0)
+    }
+
     func testRead(_ url: URL) throws {
         let reader = SplatPLYSceneReader(url)
 
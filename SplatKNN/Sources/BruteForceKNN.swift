@@ -0,0 +1,52 @@
+import Foundation
+
+// Exhaustive search, as the reference for KDTree's tests and benchmarks. Parallelised the same way, so comparisons
+// measure the algorithm rather than the core count.
+public enum BruteForceKNN {
+    static let queryChunkSize = 64
+
+    public static func neighbors(of query: SIMD3<Float>,
+                                 in points: [SIMD3<Float>],
+                                 count k: Int,
+                                 maxDistance: Float = .infinity,
+                                 excluding excludedIndex: Int? = nil) -> [Neighbor] {
+        var result = KNNResult(queryCount: 1, k: k)
+        result.fill(chunkSize: 1, maxDistance: maxDistance) { _, candidates in
+            search(query, points: points, excluding: excludedIndex.map { Int32($0) }, into: &candidates)
+        }
+        return result.neighbors(ofQuery: 0)
+    }
+
+    public static func neighbors(ofQueries queries: [SIMD3<Float>],
+                                 in points: [SIMD3<Float>],
+                                 count k: Int,
+                                 maxDistance: Float = .infinity) -> KNNResult {
+        var result = KNNResult(queryCount: queries.count, k: k)
+        result.fill(chunkSize: queryChunkSize, maxDistance: maxDistance) { query, candidates in
+            search(queries[query], points: points, excluding: nil, into: &candidates)
+        }
+        return result
+    }
+
+    // The k nearest other points to each point
+    public static func neighborsOfEachPoint(_ points: [SIMD3<Float>],
+                                            count k: Int,
+                                            maxDistance: Float = .infinity) -> KNNResult {
+        var result = KNNResult(queryCount: points.count, k: k)
+        result.fill(chunkSize: queryChunkSize, maxDistance: maxDistance) { query, candidates in
+            search(points[query], points: points, excluding: Int32(query), into: &candidates)
+        }
+        return result
+    }
+
+    private static func search(_ query: SIMD3<Float>,
+                               points: [SIMD3<Float>],
+                               excluding excludedIndex: Int32?,
+                               into candidates: inout NeighborCandidates) {
+        points.withUnsafeBufferPointer { points in
+            for i in points.indices where Int32(i) != excludedIndex {
+                candidates.insert(index: Int32(i), distanceSquared: distanceSquared(points[i], query))
+            }
+        }
+    }
+}
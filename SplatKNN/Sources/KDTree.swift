@@ -0,0 +1,234 @@
+import Foundation
+
+// A k-d tree over a fixed set of points (typically splat centres), for k-nearest-neighbour and radius queries.
+//
+// The tree is implicit: every node splits its range of `order` at the midpoint, so the shape depends only on the
+// point count, all leaves are at the same depth, and a node's range can be recomputed on the way down rather than
+// stored. Only the split axis and value of each interior node are kept, in heap order (children of node i are
+// 2i + 1 and 2i + 2). That keeps the tree to about 9 bytes per point plus the points themselves.
+//
+// Building is done a level at a time, the nodes of each level partitioning disjoint ranges in parallel. Batch
+// queries are spread across cores in chunks; queries over the tree's own points are issued in tree order, so
+// neighbouring queries touch the same leaves.
+public struct KDTree {
+    public static let defaultLeafSize = 16
+    static let queryChunkSize = 256
+
+    public let points: [SIMD3<Float>]
+    // A permutation of point indices; each node covers a contiguous range of it
+    let order: [Int32]
+    let splitAxes: [UInt8]
+    let splitValues: [Float]
+    // Levels of interior nodes; 0 for a tree which is a single leaf
+    let depth: Int
+
+    public init(points: [SIMD3<Float>], leafSize: Int = defaultLeafSize) {
+        precondition(leafSize >= 1)
+        precondition(points.count <= Int(Int32.max))
+
+        var depth = 0
+        while (points.count + (1 << depth) - 1) >> depth > leafSize {
+            depth += 1
+        }
+        let interiorNodeCount = (1 << depth) - 1
+
+        var order = (0..<points.count).map { Int32($0) }
+        var splitAxes = [UInt8](repeating: 0, count: interiorNodeCount)
+        var splitValues = [Float](repeating: 0, count: interiorNodeCount)
+
+        points.withUnsafeBufferPointer { points in
+            order.withUnsafeMutableBufferPointer { order in
+                splitAxes.withUnsafeMutableBufferPointer { splitAxes in
+                    splitValues.withUnsafeMutableBufferPointer { splitValues in
+                        var ranges = [ 0..<points.count ]
+                        for level in 0..<depth {
+                            let firstNode = (1 << level) - 1
+                            DispatchQueue.concurrentPerform(iterations: ranges.count) { i in
+                                let range = ranges[i]
+                                let axis = Self.widestAxis(of: range, order: order, points: points)
+                                let mid = range.lowerBound + range.count / 2
+                                Self.select(nth: mid, in: range, along: axis, order: order, points: points)
+                                splitAxes[firstNode + i] = UInt8(axis)
+                                splitValues[firstNode + i] = points[Int(order[mid])][axis]
+                            }
+                            ranges = ranges.flatMap { range -> [Range<Int>] in
+                                let mid = range.lowerBound + range.count / 2
+                                return [ range.lowerBound..<mid, mid..<range.upperBound ]
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        self.points = points
+        self.order = order
+        self.splitAxes = splitAxes
+        self.splitValues = splitValues
+        self.depth = depth
+    }
+
+    public var count: Int { points.count }
+
+    // The k nearest points to query, nearest first. excludedIndex is skipped, for querying a point's own neighbours.
+    public func neighbors(of query: SIMD3<Float>,
+                          count k: Int,
+                          maxDistance: Float = .infinity,
+                          excluding excludedIndex: Int? = nil) -> [Neighbor] {
+        var result = KNNResult(queryCount: 1, k: k)
+        result.fill(chunkSize: 1, maxDistance: maxDistance) { _, candidates in
+            search(query, excluding: excludedIndex.map { Int32($0) }, into: &candidates)
+        }
+        return result.neighbors(ofQuery: 0)
+    }
+
+    public func neighbors(ofQueries queries: [SIMD3<Float>], count k: Int, maxDistance: Float = .infinity) -> KNNResult {
+        var result = KNNResult(queryCount: queries.count, k: k)
+        result.fill(chunkSize: Self.queryChunkSize, maxDistance: maxDistance) { query, candidates in
+            search(queries[query], excluding: nil, into: &candidates)
+        }
+        return result
+    }
+
+    // The k nearest other points to each of the tree's points; row i of the result is for points[i]
+    public func neighborsOfEachPoint(count k: Int, maxDistance: Float = .infinity) -> KNNResult {
+        var result = KNNResult(queryCount: points.count, k: k)
+        result.fill(chunkSize: Self.queryChunkSize, maxDistance: maxDistance, queryOrder: { Int(order[$0]) }) { query, candidates in
+            search(points[query], excluding: Int32(query), into: &candidates)
+        }
+        return result
+    }
+
+    // The mean distance from each point to its k nearest other points, or .infinity for a point with none within
+    // maxDistance. Unlike neighborsOfEachPoint, this needs only k entries of scratch space per thread rather than
+    // per point, so it suits scenes with tens of millions of points.
+    public func meanNeighborDistanceOfEachPoint(count k: Int, maxDistance: Float = .infinity) -> [Float] {
+        var means = [Float](repeating: .infinity, count: points.count)
+        guard k > 0, !points.isEmpty else { return means }
+        let radiusSquared = maxDistance * maxDistance
+        let chunkSize = Self.queryChunkSize
+        let chunkCount = (points.count + chunkSize - 1) / chunkSize
+        means.withUnsafeMutableBufferPointer { means in
+            DispatchQueue.concurrentPerform(iterations: chunkCount) { chunkIndex in
+                let indices = UnsafeMutablePointer<Int32>.allocate(capacity: k)
+                let distancesSquared = UnsafeMutablePointer<Float>.allocate(capacity: k)
+                defer {
+                    indices.deallocate()
+                    distancesSquared.deallocate()
+                }
+                for i in chunkIndex * chunkSize ..< min((chunkIndex + 1) * chunkSize, points.count) {
+                    let query = Int(order[i])
+                    var candidates = NeighborCandidates(indices: indices,
+                                                        distancesSquared: distancesSquared,
+                                                        capacity: k,
+                                                        radiusSquared: radiusSquared)
+                    search(points[query], excluding: Int32(query), into: &candidates)
+                    guard candidates.count > 0 else { continue }
+                    var sum: Float = 0
+                    for j in 0..<candidates.count {
+                        sum += distancesSquared[j].squareRoot()
+                    }
+                    means[query] = sum / Float(candidates.count)
+                }
+            }
+        }
+        return means
+    }
+
+    // Indices of all points within radius of query, in no particular order
+    public func indices(within radius: Float, of query: SIMD3<Float>) -> [Int] {
+        var result: [Int] = []
+        guard !points.isEmpty else { return result }
+        let radiusSquared = radius * radius
+        visit(node: 0, level: 0, range: 0..<points.count, query: query, bound: { radiusSquared }) { index, distanceSquared in
+            if distanceSquared <= radiusSquared {
+                result.append(Int(index))
+            }
+        }
+        return result
+    }
+
+    private func search(_ query: SIMD3<Float>, excluding excludedIndex: Int32?, into candidates: inout NeighborCandidates) {
+        guard !points.isEmpty else { return }
+        visit(node: 0, level: 0, range: 0..<points.count, query: query, bound: { candidates.worstDistanceSquared }) { index, distanceSquared in
+            if index != excludedIndex {
+                candidates.insert(index: index, distanceSquared: distanceSquared)
+            }
+        }
+    }
+
+    // Depth-first, nearer child first; a far child is skipped if the splitting plane is beyond bound(), which
+    // shrinks as the search finds closer points
+    private func visit(node: Int,
+                       level: Int,
+                       range: Range<Int>,
+                       query: SIMD3<Float>,
+                       bound: () -> Float,
+                       _ body: (_ index: Int32, _ distanceSquared: Float) -> Void) {
+        if level == depth {
+            for i in range {
+                let index = order[i]
+                body(index, distanceSquared(points[Int(index)], query))
+            }
+            return
+        }
+
+        let mid = range.lowerBound + range.count / 2
+        let offset = query[Int(splitAxes[node])] - splitValues[node]
+        let (near, nearRange, far, farRange) = offset < 0
+            ? (2 * node + 1, range.lowerBound..<mid, 2 * node + 2, mid..<range.upperBound)
+            : (2 * node + 2, mid..<range.upperBound, 2 * node + 1, range.lowerBound..<mid)
+        visit(node: near, level: level + 1, range: nearRange, query: query, bound: bound, body)
+        if offset * offset <= bound() {
+            visit(node: far, level: level + 1, range: farRange, query: query, bound: bound, body)
+        }
+    }
+
+    private static func widestAxis(of range: Range<Int>,
+                                   order: UnsafeMutableBufferPointer<Int32>,
+                                   points: UnsafeBufferPointer<SIMD3<Float>>) -> Int {
+        var minimum = SIMD3<Float>(repeating: .infinity)
+        var maximum = SIMD3<Float>(repeating: -.infinity)
+        for i in range {
+            let point = points[Int(order[i])]
+            minimum = pointwiseMin(minimum, point)
+            maximum = pointwiseMax(maximum, point)
+        }
+        let extent = maximum - minimum
+        return extent.x >= extent.y ? (extent.x >= extent.z ? 0 : 2) : (extent.y >= extent.z ? 1 : 2)
+    }
+
+    // Hoare's selection: partially orders range so that order[nth] holds the point which would be there if the
+    // range were sorted along axis, with nothing greater before it and nothing less after
+    private static func select(nth: Int,
+                               in range: Range<Int>,
+                               along axis: Int,
+                               order: UnsafeMutableBufferPointer<Int32>,
+                               points: UnsafeBufferPointer<SIMD3<Float>>) {
+        func key(_ i: Int) -> Float { points[Int(order[i])][axis] }
+
+        var lower = range.lowerBound
+        var upper = range.upperBound - 1
+        while upper > lower {
+            let pivot = key(lower + (upper - lower) / 2)
+            var i = lower
+            var j = upper
+            while i <= j {
+                while key(i) < pivot { i += 1 }
+                while key(j) > pivot { j -= 1 }
+                if i <= j {
+                    order.swapAt(i, j)
+                    i += 1
+                    j -= 1
+                }
+            }
+            if nth <= j {
+                upper = j
+            } else if nth >= i {
+                lower = i
+            } else {
+                return
+            }
+        }
+    }
+}
@@ -0,0 +1,122 @@
+import Foundation
+
+public struct Neighbor: Equatable {
+    public var index: Int
+    public var distanceSquared: Float
+
+    public init(index: Int, distanceSquared: Float) {
+        self.index = index
+        self.distanceSquared = distanceSquared
+    }
+
+    public var distance: Float { distanceSquared.squareRoot() }
+}
+
+// The neighbours found by a batch query, k per query, stored flat so tens of millions of queries don't mean tens of
+// millions of arrays. Each query's neighbours are nearest first; if fewer than k were found (e.g. because of a
+// maximum distance), the rest are padded with index -1 and distance .infinity.
+public struct KNNResult {
+    public let k: Int
+    public let queryCount: Int
+    // queryCount * k entries
+    public internal(set) var indices: [Int32]
+    public internal(set) var distancesSquared: [Float]
+
+    init(queryCount: Int, k: Int) {
+        self.k = k
+        self.queryCount = queryCount
+        indices = Array(repeating: -1, count: queryCount * k)
+        distancesSquared = Array(repeating: .infinity, count: queryCount * k)
+    }
+
+    public func neighbors(ofQuery query: Int) -> [Neighbor] {
+        (query * k ..< (query + 1) * k).compactMap { i in
+            indices[i] < 0 ? nil : Neighbor(index: Int(indices[i]), distanceSquared: distancesSquared[i])
+        }
+    }
+
+    // Mean distance from each query to its neighbours, or nil for queries with none; the usual input to
+    // statistical outlier detection
+    public func meanDistances() -> [Float?] {
+        (0..<queryCount).map { query in
+            var sum: Float = 0
+            var count = 0
+            for i in query * k ..< (query + 1) * k where indices[i] >= 0 {
+                sum += distancesSquared[i].squareRoot()
+                count += 1
+            }
+            return count == 0 ? nil : sum / Float(count)
+        }
+    }
+}
+
+// The best k candidates so far for one query, kept sorted in caller-provided storage (a row of a KNNResult, or a
+// single query's arrays). k is small in practice, so insertion into a sorted list beats a heap.
+struct NeighborCandidates {
+    let indices: UnsafeMutablePointer<Int32>
+    let distancesSquared: UnsafeMutablePointer<Float>
+    let capacity: Int
+    let radiusSquared: Float
+    private(set) var count = 0
+
+    init(indices: UnsafeMutablePointer<Int32>, distancesSquared: UnsafeMutablePointer<Float>, capacity: Int, radiusSquared: Float) {
+        self.indices = indices
+        self.distancesSquared = distancesSquared
+        self.capacity = capacity
+        self.radiusSquared = radiusSquared
+    }
+
+    // Anything at this distance or beyond can't be added
+    var worstDistanceSquared: Float {
+        count < capacity ? radiusSquared : distancesSquared[capacity - 1]
+    }
+
+    mutating func insert(index: Int32, distanceSquared: Float) {
+        guard distanceSquared < worstDistanceSquared else { return }
+        var position = min(count, capacity - 1)
+        while position > 0 && distancesSquared[position - 1] > distanceSquared {
+            indices[position] = indices[position - 1]
+            distancesSquared[position] = distancesSquared[position - 1]
+            position -= 1
+        }
+        indices[position] = index
+        distancesSquared[position] = distanceSquared
+        count = min(count + 1, capacity)
+    }
+}
+
+extension KNNResult {
+    // Runs body for each query in parallel chunks, with candidates writing into that query's row
+    mutating func fill(chunkSize: Int,
+                       maxDistance: Float,
+                       queryOrder: ((Int) -> Int)? = nil,
+                       _ body: (_ query: Int, _ candidates: inout NeighborCandidates) -> Void) {
+        guard k > 0, queryCount > 0 else { return }
+        let k = k
+        let queryCount = queryCount
+        let radiusSquared = maxDistance * maxDistance
+        indices.withUnsafeMutableBufferPointer { indices in
+            distancesSquared.withUnsafeMutableBufferPointer { distancesSquared in
+                let indicesBase = indices.baseAddress!
+                let distancesBase = distancesSquared.baseAddress!
+                let chunkCount = (queryCount + chunkSize - 1) / chunkSize
+                DispatchQueue.concurrentPerform(iterations: chunkCount) { chunkIndex in
+                    for i in chunkIndex * chunkSize ..< min((chunkIndex + 1) * chunkSize, queryCount) {
+                        let query = queryOrder?(i) ?? i
+                        var candidates = NeighborCandidates(indices: indicesBase + query * k,
+                                                            distancesSquared: distancesBase + query * k,
+                                                            capacity: k,
+                                                            radiusSquared: radiusSquared)
+                        body(query, &candidates)
+                    }
+                }
+            }
+        }
+    }
+}
+
+@inline(__always)
+func distanceSquared(_ a: SIMD3<Float>, _ b: SIMD3<Float>) -> Float {
+    let d = a - b
+    return d.x*d.x + d.y*d.y + d.z*d.z
+}
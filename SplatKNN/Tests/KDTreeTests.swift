@@ -0,0 +1,120 @@
+import XCTest
+import SplatKNN
+
+final class KDTreeTests: XCTestCase {
+    static func randomPoints(count: Int, seed: UInt64 = 3) -> [SIMD3<Float>] {
+        var generator = LinearCongruentialGenerator(seed: seed)
+        return (0..<count).map { _ in
+            SIMD3<Float>(generator.next(in: -10..<10), generator.next(in: -5..<5), generator.next(in: -1..<1))
+        }
+    }
+
+    // Ties may be broken differently, so results are compared by distance
+    func assertEqualDistances(_ result: KNNResult, _ expected: KNNResult, file: StaticString = #filePath, line: UInt = #line) {
+        XCTAssertEqual(result.queryCount, expected.queryCount, file: file, line: line)
+        XCTAssertEqual(result.distancesSquared, expected.distancesSquared, file: file, line: line)
+        XCTAssertEqual(result.indices.map { $0 < 0 }, expected.indices.map { $0 < 0 }, file: file, line: line)
+    }
+
+    func testSingleQueryMatchesBruteForce() {
+        let points = Self.randomPoints(count: 2000)
+        let tree = KDTree(points: points)
+        let query = SIMD3<Float>(1, 2, 0.5)
+        let neighbors = tree.neighbors(of: query, count: 10)
+        XCTAssertEqual(neighbors, BruteForceKNN.neighbors(of: query, in: points, count: 10))
+        XCTAssertEqual(neighbors.map(\.distanceSquared), neighbors.map(\.distanceSquared).sorted())
+    }
+
+    func testBatchQueriesMatchBruteForce() {
+        let points = Self.randomPoints(count: 5000)
+        let queries = Self.randomPoints(count: 1000, seed: 11)
+        for leafSize in [ 1, 7, KDTree.defaultLeafSize ] {
+            let tree = KDTree(points: points, leafSize: leafSize)
+            assertEqualDistances(tree.neighbors(ofQueries: queries, count: 8),
+                                 BruteForceKNN.neighbors(ofQueries: queries, in: points, count: 8))
+        }
+    }
+
+    func testNeighborsOfEachPointExcludeThemselves() {
+        let points = Self.randomPoints(count: 3000)
+        let result = KDTree(points: points).neighborsOfEachPoint(count: 5)
+        assertEqualDistances(result, BruteForceKNN.neighborsOfEachPoint(points, count: 5))
+        for i in stride(from: 0, to: points.count, by: 37) {
+            XCTAssertFalse(result.neighbors(ofQuery: i).contains { $0.index == i })
+        }
+    }
+
+    func testMeanNeighborDistancesMatchFullResults() {
+        let points = Self.randomPoints(count: 3000)
+        let tree = KDTree(points: points)
+        let expected = tree.neighborsOfEachPoint(count: 6, maxDistance: 0.3).meanDistances()
+        let means = tree.meanNeighborDistanceOfEachPoint(count: 6, maxDistance: 0.3)
+        XCTAssertEqual(means.count, points.count)
+        for (mean, expectedMean) in zip(means, expected) {
+            if let expectedMean {
+                XCTAssertEqual(mean, expectedMean, accuracy: 1e-6)
+            } else {
+                XCTAssertEqual(mean, .infinity)
+            }
+        }
+    }
+
+    func testMaxDistancePadsResults() {
+        let points: [SIMD3<Float>] = [ .zero, SIMD3(1, 0, 0), SIMD3(0, 2, 0), SIMD3(0, 0, 3) ]
+        let tree = KDTree(points: points, leafSize: 1)
+        XCTAssertEqual(tree.neighbors(of: .zero, count: 3, maxDistance: 2.5).map(\.index), [ 0, 1, 2 ])
+        XCTAssertEqual(tree.neighbors(of: .zero, count: 3, maxDistance: 2.5, excluding: 0).map(\.index), [ 1, 2 ])
+
+        let result = tree.neighborsOfEachPoint(count: 2, maxDistance: 1.5)
+        XCTAssertEqual(result.neighbors(ofQuery: 0).map(\.index), [ 1 ])
+        XCTAssertEqual(result.indices[1], -1)
+        XCTAssertEqual(result.distancesSquared[1], .infinity)
+        XCTAssertEqual(result.meanDistances()[0], 1)
+        XCTAssertNil(result.meanDistances()[3])
+    }
+
+    func testDuplicatePoints() {
+        let points = Array(repeating: SIMD3<Float>(1, 1, 1), count: 100) + Self.randomPoints(count: 100)
+        let tree = KDTree(points: points, leafSize: 4)
+        let neighbors = tree.neighbors(of: SIMD3<Float>(1, 1, 1), count: 20)
+        XCTAssertEqual(neighbors.count, 20)
+        XCTAssertTrue(neighbors.allSatisfy { $0.distanceSquared == 0 && $0.index < 100 })
+    }
+
+    func testRadiusQueryMatchesBruteForce() {
+        let points = Self.randomPoints(count: 4000)
+        let tree = KDTree(points: points)
+        let query = SIMD3<Float>(-3, 1, 0)
+        let expected = points.indices.filter {
+            let d = points[$0] - query
+            return d.x*d.x + d.y*d.y + d.z*d.z <= 1.5 * 1.5
+        }
+        XCTAssertFalse(expected.isEmpty)
+        XCTAssertEqual(tree.indices(within: 1.5, of: query).sorted(), expected)
+    }
+
+    func testSmallAndEmptyTrees() {
+        XCTAssertEqual(KDTree(points: []).neighbors(of: .zero, count: 4), [])
+        XCTAssertEqual(KDTree(points: []).neighborsOfEachPoint(count: 4).queryCount, 0)
+        XCTAssertEqual(KDTree(points: [ SIMD3(1, 0, 0) ]).neighbors(of: .zero, count: 4).map(\.index), [ 0 ])
+        XCTAssertEqual(KDTree(points: Self.randomPoints(count: 10)).neighbors(of: .zero, count: 0), [])
+    }
+}
+
+struct LinearCongruentialGenerator {
+    var state: UInt64
+
+    init(seed: UInt64) {
+        state = seed
+    }
+
+    mutating func next() -> UInt64 {
+        state = state &* 6364136223846793005 &+ 1442695040888963407
+        return state
+    }
+
+    mutating func next(in range: Range<Float>) -> Float {
+        let unit = Float(next() >> 40) / Float(1 << 24)
+        return range.lowerBound + unit * (range.upperBound - range.lowerBound)
+    }
+}
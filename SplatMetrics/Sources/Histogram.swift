@@ -0,0 +1,124 @@
+import Foundation
+
+// A distribution of durations (in seconds), or other positive values. Values go into logarithmic buckets, four
+// per doubling from 100ns to about 100s, so percentiles are accurate to within 19% at any scale while recording
+// stays constant time and space.
+public final class Histogram {
+    static let smallestBucketBound = 1e-7
+    static let bucketsPerDoubling = 4.0
+    static let bucketCount = 120
+
+    public let name: String
+    private let trace: TraceRecorder
+    private let lock = NSLock()
+    private var buckets = [UInt64](repeating: 0, count: Histogram.bucketCount)
+    private var count: UInt64 = 0
+    private var sum: Double = 0
+    private var minimum: Double = .infinity
+    private var maximum: Double = -.infinity
+
+    init(name: String, trace: TraceRecorder) {
+        self.name = name
+        self.trace = trace
+    }
+
+    public func record(_ value: Double) {
+        let bucket = Self.bucket(for: value)
+        lock.synchronized {
+            buckets[bucket] += 1
+            count += 1
+            sum += value
+            minimum = min(minimum, value)
+            maximum = max(maximum, value)
+        }
+    }
+
+    // Starts timing a span, which is recorded here (and in the trace, if enabled) when it ends
+    public func begin() -> Span {
+        Span(histogram: self, trace: trace, start: DispatchTime.now().uptimeNanoseconds)
+    }
+
+    @discardableResult
+    public func time<T>(_ body: () throws -> T) rethrows -> T {
+        let span = begin()
+        defer { span.end() }
+        return try body()
+    }
+
+    public func snapshot() -> HistogramSnapshot {
+        lock.synchronized {
+            HistogramSnapshot(count: count,
+                              sum: sum,
+                              minimum: count == 0 ? 0 : minimum,
+                              maximum: count == 0 ? 0 : maximum,
+                              p50: percentile(0.5),
+                              p90: percentile(0.9),
+                              p99: percentile(0.99))
+        }
+    }
+
+    func reset() {
+        lock.synchronized {
+            buckets = Array(repeating: 0, count: Self.bucketCount)
+            count = 0
+            sum = 0
+            minimum = .infinity
+            maximum = -.infinity
+        }
+    }
+
+    // The upper bound of the bucket holding the given fraction of values, clamped to the range seen; assumes lock
+    private func percentile(_ fraction: Double) -> Double {
+        guard count > 0 else { return 0 }
+        let target = UInt64((fraction * Double(count)).rounded(.up))
+        var cumulative: UInt64 = 0
+        for (bucket, bucketCount) in buckets.enumerated() {
+            cumulative += bucketCount
+            if cumulative >= max(target, 1) {
+                return min(max(Self.upperBound(ofBucket: bucket), minimum), maximum)
+            }
+        }
+        return maximum
+    }
+
+    static func bucket(for value: Double) -> Int {
+        guard value > smallestBucketBound else { return 0 }
+        let bucket = Int((log2(value / smallestBucketBound) * bucketsPerDoubling).rounded(.down)) + 1
+        return min(bucket, bucketCount - 1)
+    }
+
+    static func upperBound(ofBucket bucket: Int) -> Double {
+        smallestBucketBound * exp2(Double(bucket) / bucketsPerDoubling)
+    }
+}
+
+public struct HistogramSnapshot: Codable, Equatable {
+    public var count: UInt64
+    public var sum: Double
+    public var minimum: Double
+    public var maximum: Double
+    public var p50: Double
+    public var p90: Double
+    public var p99: Double
+
+    public var mean: Double {
+        count == 0 ? 0 : sum / Double(count)
+    }
+}
+
+// A timed section of work; end() it exactly once
+public struct Span {
+    let histogram: Histogram
+    let trace: TraceRecorder
+    let start: UInt64
+
+    // Returns the duration, in seconds
+    @discardableResult
+    public func end() -> Double {
+        let end = DispatchTime.now().uptimeNanoseconds
+        let duration = Double(end - start) / 1e9
+        histogram.record(duration)
+        trace.recordSpan(name: histogram.name, start: start, end: end)
+        return duration
+    }
+}
@@ -0,0 +1,140 @@
+import Foundation
+
+// A registry of named counters, gauges and histograms, and a trace of timed spans, for seeing where time goes
+// while loading, sorting and rendering. Portable (Foundation only), so the platform-independent modules can
+// report through it too.
+//
+// Metrics are meant to be left on: look each one up once (typically into a static) and then updating it costs an
+// uncontended lock. Tracing records every span, so it's off until trace.isEnabled is set.
+public final class Metrics {
+    public static let shared = Metrics()
+
+    private let lock = NSLock()
+    private var counters: [String: Counter] = [:]
+    private var gauges: [String: Gauge] = [:]
+    private var histograms: [String: Histogram] = [:]
+
+    public let trace = TraceRecorder()
+
+    public init() {}
+
+    public func counter(_ name: String) -> Counter {
+        lock.synchronized {
+            if let counter = counters[name] { return counter }
+            let counter = Counter(name: name, trace: trace)
+            counters[name] = counter
+            return counter
+        }
+    }
+
+    public func gauge(_ name: String) -> Gauge {
+        lock.synchronized {
+            if let gauge = gauges[name] { return gauge }
+            let gauge = Gauge(name: name, trace: trace)
+            gauges[name] = gauge
+            return gauge
+        }
+    }
+
+    public func histogram(_ name: String) -> Histogram {
+        lock.synchronized {
+            if let histogram = histograms[name] { return histogram }
+            let histogram = Histogram(name: name, trace: trace)
+            histograms[name] = histogram
+            return histogram
+        }
+    }
+
+    // The current value of everything, for polling
+    public func snapshot() -> MetricsSnapshot {
+        let (counters, gauges, histograms) = lock.synchronized { (self.counters, self.gauges, self.histograms) }
+        return MetricsSnapshot(counters: counters.mapValues(\.value),
+                               gauges: gauges.mapValues(\.value),
+                               histograms: histograms.mapValues { $0.snapshot() })
+    }
+
+    // Zeroes every metric (keeping them registered, so held references stay valid) and clears the trace
+    public func reset() {
+        let (counters, gauges, histograms) = lock.synchronized { (self.counters, self.gauges, self.histograms) }
+        counters.values.forEach { $0.reset() }
+        gauges.values.forEach { $0.set(0) }
+        histograms.values.forEach { $0.reset() }
+        trace.clear()
+    }
+}
+
+// A monotonically increasing count, e.g. of bytes read or events seen
+public final class Counter {
+    public let name: String
+    private let trace: TraceRecorder
+    private let lock = NSLock()
+    private var storedValue: Int64 = 0
+
+    init(name: String, trace: TraceRecorder) {
+        self.name = name
+        self.trace = trace
+    }
+
+    public var value: Int64 {
+        lock.synchronized { storedValue }
+    }
+
+    public func increment(by amount: Int64 = 1) {
+        let value = lock.synchronized {
+            storedValue += amount
+            return storedValue
+        }
+        trace.recordValue(name: name, value: Double(value))
+    }
+
+    public func increment(by amount: Int) {
+        increment(by: Int64(amount))
+    }
+
+    func reset() {
+        lock.synchronized { storedValue = 0 }
+    }
+}
+
+// A value which goes up and down, e.g. a rate or a size
+public final class Gauge {
+    public let name: String
+    private let trace: TraceRecorder
+    private let lock = NSLock()
+    private var storedValue: Double = 0
+
+    init(name: String, trace: TraceRecorder) {
+        self.name = name
+        self.trace = trace
+    }
+
+    public var value: Double {
+        lock.synchronized { storedValue }
+    }
+
+    public func set(_ value: Double) {
+        lock.synchronized { storedValue = value }
+        trace.recordValue(name: name, value: value)
+    }
+}
+
+public struct MetricsSnapshot: Codable, Equatable {
+    public var counters: [String: Int64]
+    public var gauges: [String: Double]
+    public var histograms: [String: HistogramSnapshot]
+
+    public func jsonData() throws -> Data {
+        let encoder = JSONEncoder()
+        encoder.outputFormatting = [ .prettyPrinted, .sortedKeys ]
+        return try encoder.encode(self)
+    }
+}
+
+extension NSLock {
+    // NSLocking.withLock isn't available in every Foundation we build against
+    func synchronized<T>(_ body: () throws -> T) rethrows -> T {
+        lock()
+        defer { unlock() }
+        return try body()
+    }
+}
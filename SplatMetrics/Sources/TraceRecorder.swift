@@ -0,0 +1,138 @@
+import Foundation
+
+// Records spans and metric values over time, for viewing in a trace viewer (chrome://tracing, Perfetto). Events go
+// into a fixed-size ring buffer, so a long session keeps only its most recent events.
+public final class TraceRecorder {
+    public static let defaultCapacity = 1 << 16
+
+    struct Event {
+        enum Kind {
+            case span(end: UInt64)
+            case value(Double)
+        }
+
+        var name: String
+        var start: UInt64
+        var kind: Kind
+        var threadIndex: Int
+    }
+
+    private let lock = NSLock()
+    private var enabled = false
+    private var capacity = TraceRecorder.defaultCapacity
+    private var events: [Event] = []
+    // Position in events of the oldest event, once it's full
+    private var nextEventIndex = 0
+    // Small, stable thread numbers for the trace, in order of first appearance
+    private var threadIndices: [ObjectIdentifier: Int] = [:]
+    private let origin = DispatchTime.now().uptimeNanoseconds
+
+    public init() {}
+
+    public var isEnabled: Bool {
+        get { lock.synchronized { enabled } }
+        set { lock.synchronized { enabled = newValue } }
+    }
+
+    // Changing the capacity clears the trace
+    public func setCapacity(_ capacity: Int) {
+        precondition(capacity > 0)
+        lock.synchronized {
+            self.capacity = capacity
+            events = []
+            nextEventIndex = 0
+        }
+    }
+
+    public func clear() {
+        lock.synchronized {
+            events = []
+            nextEventIndex = 0
+        }
+    }
+
+    public var eventCount: Int {
+        lock.synchronized { events.count }
+    }
+
+    func recordSpan(name: String, start: UInt64, end: UInt64) {
+        record(name: name, start: start, kind: .span(end: end))
+    }
+
+    func recordValue(name: String, value: Double) {
+        record(name: name, start: DispatchTime.now().uptimeNanoseconds, kind: .value(value))
+    }
+
+    private func record(name: String, start: UInt64, kind: Event.Kind) {
+        lock.synchronized {
+            guard enabled else { return }
+            let thread = ObjectIdentifier(Thread.current)
+            let threadIndex: Int
+            if let index = threadIndices[thread] {
+                threadIndex = index
+            } else {
+                threadIndex = threadIndices.count + 1
+                threadIndices[thread] = threadIndex
+            }
+            let event = Event(name: name, start: start, kind: kind, threadIndex: threadIndex)
+            if events.count < capacity {
+                events.append(event)
+            } else {
+                events[nextEventIndex] = event
+                nextEventIndex = (nextEventIndex + 1) % capacity
+            }
+        }
+    }
+
+    // The trace in Chrome's Trace Event Format: spans are complete ("X") events and metric values are counter ("C")
+    // events, with timestamps in microseconds since this recorder was created
+    public func chromeTraceJSON() throws -> Data {
+        let events = lock.synchronized { Array(self.events[nextEventIndex...] + self.events[..<nextEventIndex]) }
+        let processID = Int(ProcessInfo.processInfo.processIdentifier)
+        let traceEvents = events.map { event -> ChromeTraceEvent in
+            let timestamp = Double(Int64(event.start) - Int64(origin)) / 1000
+            switch event.kind {
+            case .span(let end):
+                return ChromeTraceEvent(name: event.name,
+                                        cat: Self.category(of: event.name),
+                                        ph: "X",
+                                        ts: timestamp,
+                                        dur: Double(end - event.start) / 1000,
+                                        pid: processID,
+                                        tid: event.threadIndex,
+                                        args: nil)
+            case .value(let value):
+                return ChromeTraceEvent(name: event.name,
+                                        cat: Self.category(of: event.name),
+                                        ph: "C",
+                                        ts: timestamp,
+                                        dur: nil,
+                                        pid: processID,
+                                        tid: event.threadIndex,
+                                        args: [ "value": value ])
+            }
+        }
+        return try JSONEncoder().encode(ChromeTrace(traceEvents: traceEvents, displayTimeUnit: "ms"))
+    }
+
+    // Metric names are dotted, with the first component naming the stage ("sort.depth" is in "sort")
+    private static func category(of name: String) -> String {
+        String(name.prefix { $0 != "." })
+    }
+}
+
+private struct ChromeTrace: Encodable {
+    var traceEvents: [ChromeTraceEvent]
+    var displayTimeUnit: String
+}
+
+private struct ChromeTraceEvent: Encodable {
+    var name: String
+    var cat: String
+    var ph: String
+    var ts: Double
+    var dur: Double?
+    var pid: Int
+    var tid: Int
+    var args: [String: Double]?
+}
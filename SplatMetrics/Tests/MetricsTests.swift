@@ -0,0 +1,100 @@
+import XCTest
+import SplatMetrics
+
+final class MetricsTests: XCTestCase {
+    func testCountersAndGauges() {
+        let metrics = Metrics()
+        let counter = metrics.counter("load.points")
+        counter.increment()
+        counter.increment(by: 41)
+        XCTAssertTrue(metrics.counter("load.points") === counter)
+        metrics.gauge("load.throughput").set(12.5)
+
+        let snapshot = metrics.snapshot()
+        XCTAssertEqual(snapshot.counters["load.points"], 42)
+        XCTAssertEqual(snapshot.gauges["load.throughput"], 12.5)
+
+        metrics.reset()
+        XCTAssertEqual(counter.value, 0)
+        XCTAssertEqual(metrics.snapshot().gauges["load.throughput"], 0)
+    }
+
+    func testConcurrentIncrements() {
+        let counter = Metrics().counter("test.concurrent")
+        DispatchQueue.concurrentPerform(iterations: 8) { _ in
+            for _ in 0..<10_000 {
+                counter.increment()
+            }
+        }
+        XCTAssertEqual(counter.value, 80_000)
+    }
+
+    func testHistogramPercentiles() {
+        let histogram = Metrics().histogram("sort.sort")
+        // 1ms to 100ms
+        for i in 1...100 {
+            histogram.record(Double(i) / 1000)
+        }
+        let snapshot = histogram.snapshot()
+        XCTAssertEqual(snapshot.count, 100)
+        XCTAssertEqual(snapshot.minimum, 0.001)
+        XCTAssertEqual(snapshot.maximum, 0.1)
+        XCTAssertEqual(snapshot.mean, 0.0505, accuracy: 1e-9)
+        // Buckets are within 19% of each other
+        XCTAssertEqual(snapshot.p50, 0.05, accuracy: 0.05 * 0.19)
+        XCTAssertEqual(snapshot.p90, 0.09, accuracy: 0.09 * 0.19)
+        XCTAssertLessThanOrEqual(snapshot.p99, snapshot.maximum)
+        XCTAssertGreaterThanOrEqual(snapshot.p50, snapshot.minimum)
+    }
+
+    func testEmptyHistogram() {
+        let snapshot = Metrics().histogram("frame.encode").snapshot()
+        XCTAssertEqual(snapshot, HistogramSnapshot(count: 0, sum: 0, minimum: 0, maximum: 0, p50: 0, p90: 0, p99: 0))
+    }
+
+    func testSnapshotJSONRoundTrip() throws {
+        let metrics = Metrics()
+        metrics.counter("ply.bytesRead").increment(by: 1024)
+        metrics.histogram("sort.depth").record(0.002)
+        let snapshot = metrics.snapshot()
+        let decoded = try JSONDecoder().decode(MetricsSnapshot.self, from: snapshot.jsonData())
+        XCTAssertEqual(decoded, snapshot)
+    }
+
+    func testSpansAreTracedOnlyWhenEnabled() throws {
+        let metrics = Metrics()
+        let histogram = metrics.histogram("sort.copy")
+        histogram.time { _ = (0..<1000).reduce(0, +) }
+        XCTAssertEqual(metrics.trace.eventCount, 0)
+        XCTAssertEqual(histogram.snapshot().count, 1)
+
+        metrics.trace.isEnabled = true
+        histogram.time { _ = (0..<1000).reduce(0, +) }
+        metrics.gauge("sort.splats").set(1000)
+
+        let json = try JSONSerialization.jsonObject(with: metrics.trace.chromeTraceJSON()) as? [String: Any]
+        let events = try XCTUnwrap(json?["traceEvents"] as? [[String: Any]])
+        XCTAssertEqual(events.count, 2)
+        XCTAssertEqual(events[0]["name"] as? String, "sort.copy")
+        XCTAssertEqual(events[0]["cat"] as? String, "sort")
+        XCTAssertEqual(events[0]["ph"] as? String, "X")
+        XCTAssertNotNil(events[0]["dur"] as? Double)
+        XCTAssertEqual(events[1]["ph"] as? String, "C")
+        XCTAssertEqual((events[1]["args"] as? [String: Any])?["value"] as? Double, 1000)
+    }
+
+    func testTraceKeepsMostRecentEvents() throws {
+        let metrics = Metrics()
+        metrics.trace.isEnabled = true
+        metrics.trace.setCapacity(3)
+        let gauge = metrics.gauge("test.value")
+        for value in 0..<5 {
+            gauge.set(Double(value))
+        }
+        XCTAssertEqual(metrics.trace.eventCount, 3)
+
+        let json = try JSONSerialization.jsonObject(with: metrics.trace.chromeTraceJSON()) as? [String: Any]
+        let events = try XCTUnwrap(json?["traceEvents"] as? [[String: Any]])
+        XCTAssertEqual(events.compactMap { ($0["args"] as? [String: Any])?["value"] as? Double }, [ 2, 3, 4 ])
+    }
+}